@@ -8,6 +8,97 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include "Fat.h"
 
+/**
+
+  Find the cache page that holds the specified PageNo.
+
+  @param  DiskCache             - The disk cache to search.
+  @param  PageNo                - PageNo to match with the cache.
+
+  @return The Cache Tag of the cache page, or NULL if the page is not cached.
+
+**/
+STATIC
+CACHE_TAG *
+FatFindCacheTag (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageNo
+  )
+{
+  UINTN       GroupCount;
+  UINTN       Way;
+  CACHE_TAG   *CacheTag;
+
+  GroupCount = DiskCache->GroupMask + 1;
+  CacheTag   = &DiskCache->CacheTag[PageNo & DiskCache->GroupMask];
+  for (Way = 0; Way < DiskCache->WayCount; Way++, CacheTag += GroupCount) {
+    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
+      return CacheTag;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+
+  Get the address of the cache page described by a Cache Tag.
+
+  @param  DiskCache             - The disk cache of the Cache Tag.
+  @param  CacheTag              - The Cache Tag of the cache page.
+
+  @return The address of the cache page.
+
+**/
+STATIC
+UINT8 *
+FatGetCachePageAddress (
+  IN DISK_CACHE         *DiskCache,
+  IN CACHE_TAG          *CacheTag
+  )
+{
+  return DiskCache->CacheBase + ((UINTN) (CacheTag - DiskCache->CacheTag) << DiskCache->PageAlignment);
+}
+
+/**
+
+  Select the cache page of the group of PageNo that is replaced when PageNo is
+  loaded: an unused page if there is one, the least recently used page otherwise.
+
+  @param  DiskCache             - The disk cache.
+  @param  PageNo                - PageNo to load into the cache.
+
+  @return The Cache Tag of the cache page to replace.
+
+**/
+STATIC
+CACHE_TAG *
+FatSelectVictimCacheTag (
+  IN DISK_CACHE         *DiskCache,
+  IN UINTN              PageNo
+  )
+{
+  UINTN       GroupCount;
+  UINTN       Way;
+  CACHE_TAG   *CacheTag;
+  CACHE_TAG   *Victim;
+
+  GroupCount = DiskCache->GroupMask + 1;
+  CacheTag   = &DiskCache->CacheTag[PageNo & DiskCache->GroupMask];
+  Victim     = CacheTag;
+  for (Way = 0; Way < DiskCache->WayCount; Way++, CacheTag += GroupCount) {
+    if (CacheTag->RealSize == 0) {
+      return CacheTag;
+    }
+
+    if (CacheTag->LastAccess < Victim->LastAccess) {
+      Victim = CacheTag;
+    }
+  }
+
+  return Victim;
+}
+
 /**
 
   This function is used by the Data Cache.
@@ -38,24 +129,18 @@ FatFlushDataCacheRange (
   )
 {
   UINTN       PageNo;
-  UINTN       GroupNo;
-  UINTN       GroupMask;
   UINTN       PageSize;
   UINT8       PageAlignment;
   DISK_CACHE  *DiskCache;
   CACHE_TAG   *CacheTag;
-  UINT8       *BaseAddress;
 
   DiskCache     = &Volume->DiskCache[CacheData];
-  BaseAddress   = DiskCache->CacheBase;
-  GroupMask     = DiskCache->GroupMask;
   PageAlignment = DiskCache->PageAlignment;
   PageSize      = (UINTN)1 << PageAlignment;
 
   for (PageNo = StartPageNo; PageNo < EndPageNo; PageNo++) {
-    GroupNo   = PageNo & GroupMask;
-    CacheTag  = &DiskCache->CacheTag[GroupNo];
-    if (CacheTag->RealSize > 0 && CacheTag->PageNo == PageNo) {
+    CacheTag = FatFindCacheTag (DiskCache, PageNo);
+    if (CacheTag != NULL) {
       //
       // When reading data form disk directly, if some dirty data
       // in cache is in this rang, this data in the Buffer need to
@@ -65,7 +150,7 @@ FatFlushDataCacheRange (
         if (CacheTag->Dirty) {
           CopyMem (
             Buffer + ((PageNo - StartPageNo) << PageAlignment),
-            BaseAddress + (GroupNo << PageAlignment),
+            FatGetCachePageAddress (DiskCache, CacheTag),
             PageSize
             );
         }
@@ -81,57 +166,38 @@ FatFlushDataCacheRange (
 
 /**
 
-  Exchange the cache page with the image on the disk
+  Write a dirty cache page back to the disk.
 
   @param  Volume                - FAT file system volume.
   @param  DataType              - Indicate the cache type.
-  @param  IoMode                - Indicate whether to load this page from disk or store this page to disk.
   @param  CacheTag              - The Cache Tag for the current cache page.
   @param  Task                    point to task instance.
 
-  @retval EFI_SUCCESS           - Cache page exchanged successfully.
-  @return Others                - An error occurred when exchanging cache page.
+  @retval EFI_SUCCESS           - Cache page written successfully.
+  @return Others                - An error occurred when writing cache page.
 
 **/
 STATIC
 EFI_STATUS
-FatExchangeCachePage (
+FatWriteCachePage (
   IN FAT_VOLUME         *Volume,
   IN CACHE_DATA_TYPE    DataType,
-  IN IO_MODE            IoMode,
   IN CACHE_TAG          *CacheTag,
   IN FAT_TASK           *Task
   )
 {
   EFI_STATUS  Status;
-  UINTN       GroupNo;
-  UINTN       PageNo;
   UINTN       WriteCount;
-  UINTN       RealSize;
   UINT64      EntryPos;
-  UINT64      MaxSize;
   DISK_CACHE  *DiskCache;
   VOID        *PageAddress;
-  UINT8       PageAlignment;
 
   DiskCache     = &Volume->DiskCache[DataType];
-  PageNo        = CacheTag->PageNo;
-  GroupNo       = PageNo & DiskCache->GroupMask;
-  PageAlignment = DiskCache->PageAlignment;
-  PageAddress   = DiskCache->CacheBase + (GroupNo << PageAlignment);
-  EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
-  RealSize      = CacheTag->RealSize;
-  if (IoMode == ReadDisk) {
-    RealSize  = (UINTN)1 << PageAlignment;
-    MaxSize   = DiskCache->LimitAddress - EntryPos;
-    if (MaxSize < RealSize) {
-      DEBUG ((EFI_D_INFO, "FatDiskIo: Cache Page OutBound occurred! \n"));
-      RealSize = (UINTN) MaxSize;
-    }
-  }
+  PageAddress   = FatGetCachePageAddress (DiskCache, CacheTag);
+  EntryPos      = DiskCache->BaseAddress + LShiftU64 (CacheTag->PageNo, DiskCache->PageAlignment);
 
   WriteCount = 1;
-  if (DataType == CacheFat && IoMode == WriteDisk) {
+  if (DataType == CacheFat) {
     WriteCount = Volume->NumFats;
   }
 
@@ -139,7 +205,7 @@ FatExchangeCachePage (
     //
     // Only fat table writing will execute more than once
     //
-    Status = FatDiskIo (Volume, IoMode, EntryPos, RealSize, PageAddress, Task);
+    Status = FatDiskIo (Volume, WriteDisk, EntryPos, CacheTag->RealSize, PageAddress, Task);
     if (EFI_ERROR (Status)) {
       return Status;
     }
@@ -147,8 +213,87 @@ FatExchangeCachePage (
     EntryPos += Volume->FatSize;
   } while (--WriteCount > 0);
 
-  CacheTag->Dirty     = FALSE;
-  CacheTag->RealSize  = RealSize;
+  CacheTag->Dirty = FALSE;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Load PageCount consecutive pages from the disk into one way of the cache,
+  with a single disk read. The dirty pages replaced are written back first.
+
+  @param  Volume                - FAT file system volume.
+  @param  DataType              - Indicate the cache type.
+  @param  PageNo                - The first page to load.
+  @param  PageCount             - The number of pages to load. The pages must
+                                  not wrap around the last group of the cache.
+  @param  CacheTag              - The Cache Tag of the cache page that receives PageNo.
+
+  @retval EFI_SUCCESS           - The pages were loaded successfully.
+  @return Others                - An error occurred when accessing the disk.
+
+**/
+STATIC
+EFI_STATUS
+FatLoadCachePages (
+  IN FAT_VOLUME         *Volume,
+  IN CACHE_DATA_TYPE    DataType,
+  IN UINTN              PageNo,
+  IN UINTN              PageCount,
+  IN CACHE_TAG          *CacheTag
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       PageSize;
+  UINTN       RealSize;
+  UINT64      EntryPos;
+  UINT64      MaxSize;
+  DISK_CACHE  *DiskCache;
+  UINT8       PageAlignment;
+
+  DiskCache     = &Volume->DiskCache[DataType];
+  PageAlignment = DiskCache->PageAlignment;
+  PageSize      = (UINTN)1 << PageAlignment;
+  EntryPos      = DiskCache->BaseAddress + LShiftU64 (PageNo, PageAlignment);
+  RealSize      = PageCount << PageAlignment;
+  MaxSize       = DiskCache->LimitAddress - EntryPos;
+  if (MaxSize < RealSize) {
+    DEBUG ((EFI_D_INFO, "FatDiskIo: Cache Page OutBound occurred! \n"));
+    RealSize  = (UINTN) MaxSize;
+    PageCount = (RealSize + PageSize - 1) >> PageAlignment;
+  }
+
+  //
+  // Write dirty cache pages back to disk
+  //
+  for (Index = 0; Index < PageCount; Index++) {
+    if (CacheTag[Index].RealSize > 0 && CacheTag[Index].Dirty) {
+      Status = FatWriteCachePage (Volume, DataType, &CacheTag[Index], NULL);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    }
+
+    CacheTag[Index].RealSize = 0;
+  }
+
+  //
+  // Load new data from disk
+  //
+  Status = FatDiskIo (Volume, ReadDisk, EntryPos, RealSize, FatGetCachePageAddress (DiskCache, CacheTag), NULL);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < PageCount; Index++) {
+    CacheTag[Index].PageNo      = PageNo + Index;
+    CacheTag[Index].RealSize    = MIN (RealSize, PageSize);
+    CacheTag[Index].Dirty       = FALSE;
+    CacheTag[Index].LastAccess  = DiskCache->AccessCount;
+    RealSize                   -= CacheTag[Index].RealSize;
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -156,10 +301,17 @@ FatExchangeCachePage (
 
   Get one cache page by specified PageNo.
 
+  On a miss of a read of the data cache that follows the previous miss, the
+  pages after PageNo are read ahead in the same disk read. The read-ahead
+  window doubles on every sequential miss, up to FAT_DATACACHE_READ_AHEAD_MAX_PAGES.
+  It never goes past the end of the disk run being read, past a page that is
+  already cached or past a page whose group would keep the page replaced.
+
   @param  Volume                - FAT file system volume.
   @param  CacheDataType         - The cache type: CACHE_FAT or CACHE_DATA.
+  @param  IoMode                - Indicate the type of disk access.
   @param  PageNo                - PageNo to match with the cache.
-  @param  CacheTag              - The Cache Tag for the current cache page.
+  @param  CacheTag              - Returns the Cache Tag for the cache page.
 
   @retval EFI_SUCCESS           - Get the cache page successfully.
   @return other                 - An error occurred when accessing data.
@@ -168,37 +320,67 @@ FatExchangeCachePage (
 STATIC
 EFI_STATUS
 FatGetCachePage (
-  IN FAT_VOLUME         *Volume,
-  IN CACHE_DATA_TYPE    CacheDataType,
-  IN UINTN              PageNo,
-  IN CACHE_TAG          *CacheTag
+  IN  FAT_VOLUME         *Volume,
+  IN  CACHE_DATA_TYPE    CacheDataType,
+  IN  IO_MODE            IoMode,
+  IN  UINTN              PageNo,
+  OUT CACHE_TAG          **CacheTag
   )
 {
   EFI_STATUS  Status;
-  UINTN       OldPageNo;
+  DISK_CACHE  *DiskCache;
+  UINTN       GroupNo;
+  UINTN       PageCount;
+  UINTN       LimitPageNo;
+  UINTN       Index;
+
+  DiskCache = &Volume->DiskCache[CacheDataType];
+  DiskCache->AccessCount++;
 
-  OldPageNo = CacheTag->PageNo;
-  if (CacheTag->RealSize > 0 && OldPageNo == PageNo) {
+  *CacheTag = FatFindCacheTag (DiskCache, PageNo);
+  if (*CacheTag != NULL) {
     //
     // Cache Hit occurred
     //
+    (*CacheTag)->LastAccess = DiskCache->AccessCount;
     return EFI_SUCCESS;
   }
 
-  //
-  // Write dirty cache page back to disk
-  //
-  if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
-    Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, NULL);
-    if (EFI_ERROR (Status)) {
-      return Status;
+  *CacheTag = FatSelectVictimCacheTag (DiskCache, PageNo);
+  PageCount = 1;
+  if (IoMode == ReadDisk && DiskCache->ReadAheadLimit > DiskCache->BaseAddress) {
+    if (PageNo == DiskCache->ReadAheadPageNo && DiskCache->ReadAheadPages > 0) {
+      DiskCache->ReadAheadPages = MIN (DiskCache->ReadAheadPages * 2, FAT_DATACACHE_READ_AHEAD_MAX_PAGES);
+    } else {
+      DiskCache->ReadAheadPages = 1;
     }
+
+    //
+    // Stay within the disk run being read and within the last group
+    //
+    GroupNo     = PageNo & DiskCache->GroupMask;
+    LimitPageNo = (UINTN) RShiftU64 (DiskCache->ReadAheadLimit - DiskCache->BaseAddress - 1, DiskCache->PageAlignment) + 1;
+    PageCount   = MIN (DiskCache->ReadAheadPages, DiskCache->GroupMask + 1 - GroupNo);
+    if (LimitPageNo < PageNo + PageCount) {
+      PageCount = LimitPageNo > PageNo ? LimitPageNo - PageNo : 1;
+    }
+
+    //
+    // Only replace the pages that would be replaced anyway
+    //
+    for (Index = 1; Index < PageCount; Index++) {
+      if (FatFindCacheTag (DiskCache, PageNo + Index) != NULL ||
+          ((*CacheTag)[Index].RealSize > 0 &&
+           FatSelectVictimCacheTag (DiskCache, PageNo + Index) != *CacheTag + Index)) {
+        PageCount = Index;
+        break;
+      }
+    }
+
+    DiskCache->ReadAheadPageNo = PageNo + PageCount;
   }
-  //
-  // Load new data from disk;
-  //
-  CacheTag->PageNo  = PageNo;
-  Status            = FatExchangeCachePage (Volume, CacheDataType, ReadDisk, CacheTag, NULL);
+
+  Status = FatLoadCachePages (Volume, CacheDataType, PageNo, PageCount, *CacheTag);
 
   return Status;
 }
@@ -237,14 +419,11 @@ FatAccessUnalignedCachePage (
   VOID        *Destination;
   DISK_CACHE  *DiskCache;
   CACHE_TAG   *CacheTag;
-  UINTN       GroupNo;
 
   DiskCache = &Volume->DiskCache[CacheDataType];
-  GroupNo   = PageNo & DiskCache->GroupMask;
-  CacheTag  = &DiskCache->CacheTag[GroupNo];
-  Status    = FatGetCachePage (Volume, CacheDataType, PageNo, CacheTag);
+  Status    = FatGetCachePage (Volume, CacheDataType, IoMode, PageNo, &CacheTag);
   if (!EFI_ERROR (Status)) {
-    Source      = DiskCache->CacheBase + (GroupNo << DiskCache->PageAlignment) + Offset;
+    Source      = FatGetCachePageAddress (DiskCache, CacheTag) + Offset;
     Destination = Buffer;
     if (IoMode != ReadDisk) {
       CacheTag->Dirty   = TRUE;
@@ -309,6 +488,7 @@ FatAccessCache (
   UINTN       AlignedPageCount;
   UINTN       OverRunPageNo;
   DISK_CACHE  *DiskCache;
+  CACHE_TAG   *CacheTag;
   UINT64      EntryPos;
   UINT8       PageAlignment;
 
@@ -338,6 +518,24 @@ FatAccessCache (
     PageNo++;
   }
 
+  //
+  // Copy the leading pages that were read ahead from the cache
+  //
+  if (IoMode == ReadDisk && CacheDataType == CacheData) {
+    while (BufferSize >= PageSize) {
+      CacheTag = FatFindCacheTag (DiskCache, PageNo);
+      if (CacheTag == NULL || CacheTag->RealSize < PageSize) {
+        break;
+      }
+
+      CacheTag->LastAccess = ++DiskCache->AccessCount;
+      CopyMem (Buffer, FatGetCachePageAddress (DiskCache, CacheTag), PageSize);
+      Buffer     += PageSize;
+      BufferSize -= PageSize;
+      PageNo++;
+    }
+  }
+
   AlignedPageCount  = BufferSize >> PageAlignment;
   OverRunPageNo     = PageNo + AlignedPageCount;
   //
@@ -396,8 +594,8 @@ FatVolumeFlushCache (
 {
   EFI_STATUS      Status;
   CACHE_DATA_TYPE CacheDataType;
-  UINTN           GroupIndex;
-  UINTN           GroupMask;
+  UINTN           TagIndex;
+  UINTN           TagCount;
   DISK_CACHE      *DiskCache;
   CACHE_TAG       *CacheTag;
 
@@ -407,14 +605,14 @@ FatVolumeFlushCache (
       //
       // Data cache or fat cache is dirty, write the dirty data back
       //
-      GroupMask = DiskCache->GroupMask;
-      for (GroupIndex = 0; GroupIndex <= GroupMask; GroupIndex++) {
-        CacheTag = &DiskCache->CacheTag[GroupIndex];
+      TagCount = (DiskCache->GroupMask + 1) * DiskCache->WayCount;
+      for (TagIndex = 0; TagIndex < TagCount; TagIndex++) {
+        CacheTag = &DiskCache->CacheTag[TagIndex];
         if (CacheTag->RealSize > 0 && CacheTag->Dirty) {
           //
           // Write back all Dirty Data Cache Page to disk
           //
-          Status = FatExchangeCachePage (Volume, CacheDataType, WriteDisk, CacheTag, Task);
+          Status = FatWriteCachePage (Volume, CacheDataType, CacheTag, Task);
           if (EFI_ERROR (Status)) {
             return Status;
           }
@@ -435,6 +633,9 @@ FatVolumeFlushCache (
 
   Initialize the disk cache according to Volume's FatType.
 
+  The FAT cache is direct mapped. The data cache is FAT_DATACACHE_WAY_COUNT-way
+  set associative and uses about PcdFatDataCacheSize bytes of page buffers.
+
   @param  Volume                - FAT file system volume.
 
   @retval EFI_SUCCESS           - The disk cache is successfully initialized.
@@ -448,9 +649,12 @@ FatInitializeDiskCache (
 {
   DISK_CACHE  *DiskCache;
   UINTN       FatCacheGroupCount;
+  UINTN       DataCacheGroupCount;
   UINTN       DataCacheSize;
   UINTN       FatCacheSize;
+  UINTN       TagCount;
   UINT8       *CacheBuffer;
+  CACHE_TAG   *CacheTag;
 
   DiskCache = Volume->DiskCache;
   //
@@ -466,24 +670,39 @@ FatInitializeDiskCache (
     DiskCache[CacheData].PageAlignment = FAT_DATACACHE_PAGE_MAX_ALIGNMENT;
   }
 
-  DiskCache[CacheData].GroupMask     = FAT_DATACACHE_GROUP_COUNT - 1;
+  //
+  // The group count must be a power of 2
+  //
+  DataCacheGroupCount = (PcdGet32 (PcdFatDataCacheSize) >> DiskCache[CacheData].PageAlignment) / FAT_DATACACHE_WAY_COUNT;
+  if (DataCacheGroupCount < FAT_DATACACHE_GROUP_MIN_COUNT) {
+    DataCacheGroupCount = FAT_DATACACHE_GROUP_MIN_COUNT;
+  }
+  DataCacheGroupCount = GetPowerOfTwo32 ((UINT32) DataCacheGroupCount);
+
+  DiskCache[CacheData].GroupMask     = DataCacheGroupCount - 1;
+  DiskCache[CacheData].WayCount      = FAT_DATACACHE_WAY_COUNT;
   DiskCache[CacheData].BaseAddress   = Volume->RootPos;
   DiskCache[CacheData].LimitAddress  = Volume->VolumeSize;
   DiskCache[CacheFat].GroupMask      = FatCacheGroupCount - 1;
+  DiskCache[CacheFat].WayCount       = 1;
   DiskCache[CacheFat].BaseAddress    = Volume->FatPos;
   DiskCache[CacheFat].LimitAddress   = Volume->FatPos + Volume->FatSize;
   FatCacheSize                        = FatCacheGroupCount << DiskCache[CacheFat].PageAlignment;
-  DataCacheSize                       = FAT_DATACACHE_GROUP_COUNT << DiskCache[CacheData].PageAlignment;
+  DataCacheSize                       = (DataCacheGroupCount * FAT_DATACACHE_WAY_COUNT) << DiskCache[CacheData].PageAlignment;
+  TagCount                            = FatCacheGroupCount + DataCacheGroupCount * FAT_DATACACHE_WAY_COUNT;
   //
-  // Allocate the Fat Cache buffer
+  // Allocate the Fat Cache buffer, followed by the Cache Tags
   //
-  CacheBuffer = AllocateZeroPool (FatCacheSize + DataCacheSize);
+  CacheBuffer = AllocateZeroPool (FatCacheSize + DataCacheSize + TagCount * sizeof (CACHE_TAG));
   if (CacheBuffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
+  CacheTag                        = (CACHE_TAG *) (CacheBuffer + FatCacheSize + DataCacheSize);
   Volume->CacheBuffer             = CacheBuffer;
   DiskCache[CacheFat].CacheBase  = CacheBuffer;
+  DiskCache[CacheFat].CacheTag   = CacheTag;
   DiskCache[CacheData].CacheBase = CacheBuffer + FatCacheSize;
+  DiskCache[CacheData].CacheTag  = CacheTag + FatCacheGroupCount;
   return EFI_SUCCESS;
 }
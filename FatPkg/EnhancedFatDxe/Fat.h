@@ -80,10 +80,18 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define FAT_FATCACHE_PAGE_MAX_ALIGNMENT   15
 #define FAT_DATACACHE_PAGE_MIN_ALIGNMENT  13
 #define FAT_DATACACHE_PAGE_MAX_ALIGNMENT  16
-#define FAT_DATACACHE_GROUP_COUNT         64
 #define FAT_FATCACHE_GROUP_MIN_COUNT      1
 #define FAT_FATCACHE_GROUP_MAX_COUNT      16
 
+//
+// The data cache is set associative, its number of groups is derived from
+// PcdFatDataCacheSize. Sequential reads load up to
+// FAT_DATACACHE_READ_AHEAD_MAX_PAGES pages at once.
+//
+#define FAT_DATACACHE_WAY_COUNT             4
+#define FAT_DATACACHE_GROUP_MIN_COUNT       4
+#define FAT_DATACACHE_READ_AHEAD_MAX_PAGES  16
+
 //
 // Used in 8.3 generation algorithm
 //
@@ -105,6 +113,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MAX_LANG_CODE_SIZE      100
 
 #define FAT_MAX_DIR_CACHE_COUNT 8
+#define FAT_MIN_EXTENT_COUNT    8
 #define FAT_MAX_DIRENTRY_COUNT  0xFFFF
 typedef CHAR8                   LC_ISO_639_2;
 
@@ -147,8 +156,14 @@ typedef struct {
   UINTN   PageNo;
   UINTN   RealSize;
   BOOLEAN Dirty;
+  UINT64  LastAccess;       // Value of AccessCount when last used
 } CACHE_TAG;
 
+//
+// The cache pages of way W, group G are at index (W * (GroupMask + 1) + G) of
+// CacheTag and of the page buffer, so consecutive pages of one way are
+// contiguous in memory and can be loaded with a single disk read.
+//
 typedef struct {
   UINT64    BaseAddress;
   UINT64    LimitAddress;
@@ -156,7 +171,15 @@ typedef struct {
   BOOLEAN   Dirty;
   UINT8     PageAlignment;
   UINTN     GroupMask;
-  CACHE_TAG CacheTag[FAT_DATACACHE_GROUP_COUNT];
+  UINTN     WayCount;
+  CACHE_TAG *CacheTag;
+  UINT64    AccessCount;
+  //
+  // Sequential read-ahead state
+  //
+  UINT64    ReadAheadLimit;   // End of the disk run being read, 0 if unknown
+  UINTN     ReadAheadPageNo;  // Page expected by the next sequential miss
+  UINTN     ReadAheadPages;   // Current read-ahead window in pages
 } DISK_CACHE;
 
 //
@@ -229,6 +252,15 @@ typedef struct {
   LIST_ENTRY          Link;
 } FAT_SUBTASK;
 
+//
+// A run of consecutive clusters of a file
+//
+typedef struct {
+  UINTN               FileClusterNo;  // Index of the first cluster of the run in the file
+  UINTN               Cluster;        // First cluster of the run on the volume
+  UINTN               ClusterCount;
+} FAT_EXTENT;
+
 //
 // FAT_OFILE - Each opened file
 //
@@ -253,6 +285,17 @@ struct _FAT_OFILE {
   UINTN               FileCurrentCluster;
   UINTN               FileLastCluster;
 
+  //
+  // The cluster runs of the file, built lazily from the cluster chain.
+  // Extents covers the first MappedClusters clusters of the file, the
+  // whole file once ExtentsComplete is set.
+  //
+  FAT_EXTENT          *Extents;
+  UINTN               ExtentCount;
+  UINTN               MaxExtentCount;
+  UINTN               MappedClusters;
+  BOOLEAN             ExtentsComplete;
+
   //
   // Dirty is set if there have been any updates to the
   // file
@@ -335,6 +378,7 @@ struct _FAT_VOLUME {
   FAT_INFO_SECTOR                 FatInfoSector;  // Free cluster info
   UINTN                           FreeInfoPos;    // Pos with the free cluster info
   BOOLEAN                         FreeInfoValid;  // If free cluster info is valid
+  UINT32                          *FreeBitmap;    // One bit set per free cluster, built on first allocation
   //
   // Unpacked Fat BPB info
   //
@@ -893,6 +937,19 @@ FatGrowEof (
   IN UINT64             NewSizeInBytes
   );
 
+/**
+
+  Free the cluster run map of the open file. The map is built again from
+  the cluster chain when the file is accessed.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatFreeExtentMap (
+  IN FAT_OFILE          *OFile
+  );
+
 /**
 
   Get the size of directory of the open file.
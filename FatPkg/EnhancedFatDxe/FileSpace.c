@@ -121,6 +121,177 @@ FatGetFatEntry (
   return Accum;
 }
 
+/**
+
+  Check whether a cluster is free in the free cluster bitmap of the volume.
+
+  @param  Volume                - FAT file system volume.
+  @param  Cluster               - The cluster to check.
+
+  @retval TRUE                  - The cluster is free.
+  @retval FALSE                 - The cluster is in use.
+
+**/
+STATIC
+BOOLEAN
+FatIsClusterFree (
+  IN FAT_VOLUME       *Volume,
+  IN UINTN            Cluster
+  )
+{
+  return (BOOLEAN) ((Volume->FreeBitmap[Cluster / 32] & (1U << (Cluster % 32))) != 0);
+}
+
+/**
+
+  Mark a cluster free or in use in the free cluster bitmap of the volume.
+
+  @param  Volume                - FAT file system volume.
+  @param  Cluster               - The cluster to mark.
+  @param  Free                  - TRUE if the cluster is free.
+
+**/
+STATIC
+VOID
+FatMarkClusterFree (
+  IN FAT_VOLUME       *Volume,
+  IN UINTN            Cluster,
+  IN BOOLEAN          Free
+  )
+{
+  if (Free) {
+    Volume->FreeBitmap[Cluster / 32] |= 1U << (Cluster % 32);
+  } else {
+    Volume->FreeBitmap[Cluster / 32] &= ~(1U << (Cluster % 32));
+  }
+}
+
+/**
+
+  Build the free cluster bitmap of the volume from the FAT, and recompute
+  the free cluster info from it. The bitmap is not built if there is not
+  enough memory for it or if the FAT cannot be read.
+
+  @param  Volume                - FAT file system volume.
+
+**/
+STATIC
+VOID
+FatBuildFreeBitmap (
+  IN FAT_VOLUME       *Volume
+  )
+{
+  UINTN Index;
+  UINTN ClusterCount;
+
+  Volume->FreeBitmap = AllocateZeroPool ((Volume->MaxCluster + 2 + 31) / 32 * sizeof (UINT32));
+  if (Volume->FreeBitmap == NULL) {
+    return;
+  }
+
+  ClusterCount = 0;
+  for (Index = Volume->MaxCluster + 1; Index >= FAT_MIN_CLUSTER; Index--) {
+    if (Volume->DiskError) {
+      FreePool (Volume->FreeBitmap);
+      Volume->FreeBitmap = NULL;
+      return;
+    }
+
+    if (FatGetFatEntry (Volume, Index) == FAT_CLUSTER_FREE) {
+      FatMarkClusterFree (Volume, Index, TRUE);
+      ClusterCount += 1;
+      Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
+    }
+  }
+
+  Volume->FreeInfoValid                        = TRUE;
+  Volume->FatInfoSector.FreeInfo.ClusterCount  = (UINT32) ClusterCount;
+  Volume->FatInfoSector.Signature              = FAT_INFO_SIGNATURE;
+  Volume->FatInfoSector.InfoBeginSignature     = FAT_INFO_BEGIN_SIGNATURE;
+  Volume->FatInfoSector.InfoEndSignature       = FAT_INFO_END_SIGNATURE;
+}
+
+/**
+
+  Search the free cluster bitmap for a run of ClusterCount free clusters,
+  from the free cluster hint to the end of the volume, then from the start
+  of the volume to the hint.
+
+  @param  Volume                - FAT file system volume.
+  @param  ClusterCount          - On input, the length of the run to find.
+                                  On output, the length of the run found if
+                                  it is shorter.
+
+  @return The first cluster of the first run long enough, else of the longest
+          run found, or FAT_CLUSTER_LAST if the volume is full.
+
+**/
+STATIC
+UINTN
+FatFindFreeRun (
+  IN     FAT_VOLUME   *Volume,
+  IN OUT UINTN        *ClusterCount
+  )
+{
+  UINTN Hint;
+  UINTN Cluster;
+  UINTN End;
+  UINTN Pass;
+  UINTN RunStart;
+  UINTN RunLength;
+  UINTN BestStart;
+  UINTN BestLength;
+
+  Hint = Volume->FatInfoSector.FreeInfo.NextCluster;
+  if (Hint < FAT_MIN_CLUSTER || Hint > Volume->MaxCluster + 1) {
+    Hint = FAT_MIN_CLUSTER;
+  }
+
+  BestStart  = (UINTN) FAT_CLUSTER_LAST;
+  BestLength = 0;
+  for (Pass = 0; Pass < 2; Pass++) {
+    Cluster   = (Pass == 0) ? Hint : FAT_MIN_CLUSTER;
+    End       = (Pass == 0) ? Volume->MaxCluster + 2 : Hint;
+    RunStart  = 0;
+    RunLength = 0;
+    while (Cluster < End) {
+      //
+      // Skip 32 clusters in use at once
+      //
+      if ((Cluster % 32) == 0 && Volume->FreeBitmap[Cluster / 32] == 0) {
+        Cluster  += 32;
+        RunLength = 0;
+        continue;
+      }
+
+      if (FatIsClusterFree (Volume, Cluster)) {
+        if (RunLength == 0) {
+          RunStart = Cluster;
+        }
+
+        RunLength += 1;
+        if (RunLength > BestLength) {
+          BestStart  = RunStart;
+          BestLength = RunLength;
+          if (BestLength >= *ClusterCount) {
+            return BestStart;
+          }
+        }
+      } else {
+        RunLength = 0;
+      }
+
+      Cluster += 1;
+    }
+  }
+
+  if (BestLength != 0) {
+    *ClusterCount = BestLength;
+  }
+
+  return BestStart;
+}
+
 /**
 
   Set the FAT entry value of the volume, which is identified with the Index.
@@ -160,10 +331,18 @@ FatSetFatEntry (
     if (Index < Volume->FatInfoSector.FreeInfo.NextCluster) {
       Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) Index;
     }
+
+    if (Volume->FreeBitmap != NULL && Index <= Volume->MaxCluster + 1) {
+      FatMarkClusterFree (Volume, Index, TRUE);
+    }
   } else if (Value != FAT_CLUSTER_FREE && OriginalVal == FAT_CLUSTER_FREE) {
     if (Volume->FatInfoSector.FreeInfo.ClusterCount != 0) {
       Volume->FatInfoSector.FreeInfo.ClusterCount -= 1;
     }
+
+    if (Volume->FreeBitmap != NULL && Index <= Volume->MaxCluster + 1) {
+      FatMarkClusterFree (Volume, Index, FALSE);
+    }
   }
   //
   // Make sure the entry is in memory
@@ -260,7 +439,16 @@ FatFreeClusters (
 
   Allocate a free cluster and return the cluster index.
 
+  The cluster that follows PreferredCluster is allocated if it is free, so
+  that a growing file stays contiguous. Otherwise, the free cluster bitmap is
+  searched for a run of ClusterCount free clusters. If the bitmap could not
+  be built, the FAT is scanned from the free cluster hint.
+
   @param  Volume                - FAT file system volume.
+  @param  PreferredCluster      - The last cluster of the file, or 0.
+  @param  ClusterCount          - On input, the number of clusters the file still needs.
+                                  On output, lowered to the length of the longest free
+                                  run if no free run was long enough.
 
   @return The index of the free cluster
 
@@ -268,7 +456,9 @@ FatFreeClusters (
 STATIC
 UINTN
 FatAllocateCluster (
-  IN FAT_VOLUME   *Volume
+  IN     FAT_VOLUME   *Volume,
+  IN     UINTN        PreferredCluster,
+  IN OUT UINTN        *ClusterCount
   )
 {
   UINTN Cluster;
@@ -280,6 +470,29 @@ FatAllocateCluster (
     return (UINTN) FAT_CLUSTER_LAST;
   }
 
+  if (Volume->FreeBitmap == NULL) {
+    FatBuildFreeBitmap (Volume);
+  }
+
+  if (Volume->FreeBitmap != NULL) {
+    Cluster = PreferredCluster + 1;
+    if (PreferredCluster < FAT_MIN_CLUSTER || Cluster > Volume->MaxCluster + 1 ||
+        !FatIsClusterFree (Volume, Cluster)) {
+      Cluster = FatFindFreeRun (Volume, ClusterCount);
+      if (FAT_END_OF_FAT_CHAIN (Cluster)) {
+        return Cluster;
+      }
+    }
+
+    Volume->FatInfoSector.FreeInfo.NextCluster = (UINT32) (Cluster + 1);
+    return Cluster;
+  }
+
+  if (PreferredCluster >= FAT_MIN_CLUSTER && PreferredCluster < Volume->MaxCluster + 1 &&
+      FatGetFatEntry (Volume, PreferredCluster + 1) == FAT_CLUSTER_FREE) {
+    return PreferredCluster + 1;
+  }
+
   for (;;) {
     //
     // If the end of the list, return no available cluster
@@ -337,6 +550,143 @@ FatSizeToClusters (
   return Clusters;
 }
 
+/**
+
+  Free the cluster run map of the open file. The map is built again from
+  the cluster chain when the file is accessed.
+
+  @param  OFile                 - The open file.
+
+**/
+VOID
+FatFreeExtentMap (
+  IN FAT_OFILE            *OFile
+  )
+{
+  if (OFile->Extents != NULL) {
+    FreePool (OFile->Extents);
+  }
+
+  OFile->Extents          = NULL;
+  OFile->ExtentCount      = 0;
+  OFile->MaxExtentCount   = 0;
+  OFile->MappedClusters   = 0;
+  OFile->ExtentsComplete  = FALSE;
+}
+
+/**
+
+  Add the next cluster of the file to the cluster run map of the open file.
+
+  @param  OFile                 - The open file.
+  @param  Cluster               - The cluster that follows the mapped clusters.
+
+  @retval EFI_SUCCESS           - The cluster was added to the map.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to grow the map.
+
+**/
+STATIC
+EFI_STATUS
+FatAppendExtent (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                Cluster
+  )
+{
+  FAT_EXTENT  *Extent;
+  FAT_EXTENT  *NewExtents;
+  UINTN       NewMaxExtentCount;
+
+  if (OFile->ExtentCount > 0) {
+    Extent = &OFile->Extents[OFile->ExtentCount - 1];
+    if (Extent->Cluster + Extent->ClusterCount == Cluster) {
+      Extent->ClusterCount++;
+      OFile->MappedClusters++;
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (OFile->ExtentCount == OFile->MaxExtentCount) {
+    NewMaxExtentCount = MAX (FAT_MIN_EXTENT_COUNT, OFile->MaxExtentCount * 2);
+    NewExtents        = ReallocatePool (
+                          OFile->MaxExtentCount * sizeof (FAT_EXTENT),
+                          NewMaxExtentCount * sizeof (FAT_EXTENT),
+                          OFile->Extents
+                          );
+    if (NewExtents == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    OFile->Extents        = NewExtents;
+    OFile->MaxExtentCount = NewMaxExtentCount;
+  }
+
+  Extent                = &OFile->Extents[OFile->ExtentCount];
+  Extent->FileClusterNo = OFile->MappedClusters;
+  Extent->Cluster       = Cluster;
+  Extent->ClusterCount  = 1;
+  OFile->ExtentCount++;
+  OFile->MappedClusters++;
+  return EFI_SUCCESS;
+}
+
+/**
+
+  Follow the cluster chain of the open file until the cluster run map covers
+  the first ClusterCount clusters of the file, or the whole file.
+
+  @param  OFile                 - The open file.
+  @param  ClusterCount          - The number of clusters the map must cover.
+
+  @retval EFI_SUCCESS           - The map covers ClusterCount clusters or the whole file.
+  @retval EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to grow the map.
+
+**/
+STATIC
+EFI_STATUS
+FatMapOFileClusters (
+  IN FAT_OFILE            *OFile,
+  IN UINTN                ClusterCount
+  )
+{
+  FAT_VOLUME  *Volume;
+  FAT_EXTENT  *Extent;
+  UINTN       Cluster;
+  EFI_STATUS  Status;
+
+  Volume = OFile->Volume;
+  while (!OFile->ExtentsComplete && OFile->MappedClusters < ClusterCount) {
+    if (OFile->ExtentCount == 0) {
+      Cluster = OFile->FileCluster;
+      if (Cluster == FAT_CLUSTER_FREE) {
+        OFile->ExtentsComplete = TRUE;
+        break;
+      }
+    } else {
+      Extent  = &OFile->Extents[OFile->ExtentCount - 1];
+      Cluster = FatGetFatEntry (Volume, Extent->Cluster + Extent->ClusterCount - 1);
+    }
+
+    if (FAT_END_OF_FAT_CHAIN (Cluster)) {
+      OFile->ExtentsComplete = TRUE;
+      break;
+    }
+
+    if (Cluster < FAT_MIN_CLUSTER || Cluster > Volume->MaxCluster + 1 ||
+        OFile->MappedClusters > Volume->MaxCluster) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatMapOFileClusters: cluster chain corrupt\n"));
+      return EFI_VOLUME_CORRUPTED;
+    }
+
+    Status = FatAppendExtent (OFile, Cluster);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
 
   Shrink the end of the open file base on the file size.
@@ -361,6 +711,7 @@ FatShrinkEof (
   Volume  = OFile->Volume;
   ASSERT_VOLUME_LOCKED (Volume);
 
+  FatFreeExtentMap (OFile);
   NewSize = FatSizeToClusters (Volume, OFile->FileSize);
 
   //
@@ -430,12 +781,13 @@ FatGrowEof (
 {
   FAT_VOLUME  *Volume;
   EFI_STATUS  Status;
-  UINTN       Cluster;
   UINTN       CurSize;
   UINTN       NewSize;
   UINTN       LastCluster;
   UINTN       NewCluster;
   UINTN       ClusterCount;
+  UINTN       RunLength;
+  FAT_EXTENT  *Extent;
 
   //
   // For FAT file system, the max file is 4GB.
@@ -457,23 +809,19 @@ FatGrowEof (
     // If we haven't found the files last cluster do it now
     //
     if ((OFile->FileCluster != 0) && (OFile->FileLastCluster == 0)) {
-      Cluster       = OFile->FileCluster;
-      ClusterCount  = 0;
-
-      while (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-        if (Cluster < FAT_MIN_CLUSTER || Cluster > Volume->MaxCluster + 1) {
-
-          DEBUG (
-            (EFI_D_INIT | EFI_D_ERROR,
-            "FatGrowEof: cluster chain corrupt\n")
-            );
-          Status = EFI_VOLUME_CORRUPTED;
-          goto Done;
-        }
+      Status = FatMapOFileClusters (OFile, MAX_UINTN);
+      if (EFI_ERROR (Status)) {
+        DEBUG (
+          (EFI_D_INIT | EFI_D_ERROR,
+          "FatGrowEof: cluster chain corrupt\n")
+          );
+        goto Done;
+      }
 
-        ClusterCount++;
-        OFile->FileLastCluster  = Cluster;
-        Cluster                 = FatGetFatEntry (Volume, Cluster);
+      ClusterCount = OFile->MappedClusters;
+      if (OFile->ExtentCount > 0) {
+        Extent                  = &OFile->Extents[OFile->ExtentCount - 1];
+        OFile->FileLastCluster  = Extent->Cluster + Extent->ClusterCount - 1;
       }
 
       if (ClusterCount != CurSize) {
@@ -490,9 +838,11 @@ FatGrowEof (
     // Loop until we've allocated enough space
     //
     LastCluster = OFile->FileLastCluster;
+    RunLength   = NewSize - CurSize;
 
     while (CurSize < NewSize) {
-      NewCluster = FatAllocateCluster (Volume);
+      RunLength  = MIN (RunLength, NewSize - CurSize);
+      NewCluster = FatAllocateCluster (Volume, LastCluster, &RunLength);
       if (FAT_END_OF_FAT_CHAIN (NewCluster)) {
         if (LastCluster != FAT_CLUSTER_FREE) {
           FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
@@ -531,6 +881,14 @@ FatGrowEof (
       //
       FatSetFatEntry (Volume, LastCluster, (UINTN) FAT_CLUSTER_LAST);
       OFile->FileLastCluster = LastCluster;
+
+      //
+      // Keep a complete cluster run map up to date, an incomplete one
+      // finds the new clusters in the cluster chain
+      //
+      if (OFile->ExtentsComplete && EFI_ERROR (FatAppendExtent (OFile, LastCluster))) {
+        FatFreeExtentMap (OFile);
+      }
     }
   }
 
@@ -548,12 +906,16 @@ Done:
   Seek OFile to requested position, and calculate the number of
   consecutive clusters from the position in the file
 
+  The clusters of the file are looked up in the cluster run map of the file,
+  which is extended from the cluster chain as far as PosLimit requires.
+
   @param  OFile                 - The open file.
   @param  Position              - The file's position which will be accessed.
   @param  PosLimit              - The maximum length current reading/writing may access
 
   @retval EFI_SUCCESS           - Set the info successfully.
   @retval EFI_VOLUME_CORRUPTED  - Cluster chain corrupt.
+  @retval EFI_OUT_OF_RESOURCES  - Not enough memory to map the cluster chain.
 
 **/
 EFI_STATUS
@@ -566,8 +928,14 @@ FatOFilePosition (
   FAT_VOLUME  *Volume;
   UINTN       ClusterSize;
   UINTN       Cluster;
-  UINTN       StartPos;
+  UINTN       ClusterNo;
+  UINTN       LastClusterNo;
+  UINTN       Low;
+  UINTN       High;
+  UINTN       Middle;
   UINTN       Run;
+  FAT_EXTENT  *Extent;
+  EFI_STATUS  Status;
 
   Volume      = OFile->Volume;
   ClusterSize = Volume->ClusterSize;
@@ -583,54 +951,50 @@ FatOFilePosition (
     Run             = OFile->FileSize - Position;
   } else {
     //
-    // Run the file's cluster chain to find the current position
-    // If possible, run from the current cluster rather than
-    // start from beginning
-    // Assumption: OFile->Position is always consistent with
-    // OFile->FileCurrentCluster.
-    // OFile->Position is not modified outside this function;
-    // OFile->FileCurrentCluster is modified outside this function
-    // to be the same as OFile->FileCluster
-    // when OFile->FileCluster is updated, so make a check of this
-    // and invalidate the original OFile->Position in this case
+    // Map the clusters of the file up to the last one the access may touch
     //
-    Cluster     = OFile->FileCurrentCluster;
-    StartPos    = OFile->Position;
-    if (Position < StartPos || OFile->FileCluster == Cluster) {
-      StartPos  = 0;
-      Cluster   = OFile->FileCluster;
+    ClusterNo     = Position >> Volume->ClusterAlignment;
+    LastClusterNo = ClusterNo;
+    if (PosLimit > 0) {
+      LastClusterNo += ((Position & (ClusterSize - 1)) + PosLimit - 1) >> Volume->ClusterAlignment;
     }
 
-    while (StartPos + ClusterSize <= Position) {
-      StartPos += ClusterSize;
-      if (Cluster == FAT_CLUSTER_FREE || (Cluster >= FAT_CLUSTER_SPECIAL)) {
-        DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
-        return EFI_VOLUME_CORRUPTED;
-      }
-
-      Cluster = FatGetFatEntry (Volume, Cluster);
+    Status = FatMapOFileClusters (OFile, LastClusterNo + 1);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
 
-    if (Cluster < FAT_MIN_CLUSTER || Cluster > Volume->MaxCluster + 1) {
+    if (ClusterNo >= OFile->MappedClusters) {
+      DEBUG ((EFI_D_INIT | EFI_D_ERROR, "FatOFilePosition:"" cluster chain corrupt\n"));
       return EFI_VOLUME_CORRUPTED;
     }
 
+    //
+    // Binary search the run that holds the position
+    //
+    Low  = 0;
+    High = OFile->ExtentCount - 1;
+    while (Low < High) {
+      Middle = (Low + High + 1) / 2;
+      if (OFile->Extents[Middle].FileClusterNo <= ClusterNo) {
+        Low = Middle;
+      } else {
+        High = Middle - 1;
+      }
+    }
+
+    Extent                    = &OFile->Extents[Low];
+    Cluster                   = Extent->Cluster + ClusterNo - Extent->FileClusterNo;
     OFile->PosDisk            = Volume->FirstClusterPos +
                                 LShiftU64 (Cluster - FAT_MIN_CLUSTER, Volume->ClusterAlignment) +
-                                Position - StartPos;
+                                (Position & (ClusterSize - 1));
     OFile->FileCurrentCluster = Cluster;
-    OFile->Position           = StartPos;
+    OFile->Position           = ClusterNo << Volume->ClusterAlignment;
 
     //
-    // Compute the number of consecutive clusters in the file
+    // The consecutive clusters run to the end of the extent
     //
-    Run = StartPos + ClusterSize - Position;
-    if (!FAT_END_OF_FAT_CHAIN (Cluster)) {
-      while ((FatGetFatEntry (Volume, Cluster) == Cluster + 1) && Run < PosLimit) {
-        Run     += ClusterSize;
-        Cluster += 1;
-      }
-    }
+    Run = ((Extent->FileClusterNo + Extent->ClusterCount) << Volume->ClusterAlignment) - Position;
   }
 
   OFile->PosRem = Run;
@@ -720,8 +1084,13 @@ FatComputeFreeInfo (
   UINTN Index;
 
   //
-  // If we don't have valid info, compute it now
+  // If we don't have valid info, compute it now, keeping a free cluster
+  // bitmap for the allocations to come
   //
+  if (!Volume->FreeInfoValid && Volume->FreeBitmap == NULL) {
+    FatBuildFreeBitmap (Volume);
+  }
+
   if (!Volume->FreeInfoValid) {
 
     Volume->FreeInfoValid                        = TRUE;
@@ -462,20 +462,29 @@ FatAccessOFile (
   )
 {
   FAT_VOLUME  *Volume;
+  DISK_CACHE  *DataCache;
   UINTN       Len;
   EFI_STATUS  Status;
   UINTN       BufferSize;
+  UINTN       PosLimit;
 
   BufferSize  = *DataBufferSize;
   Volume      = OFile->Volume;
+  DataCache   = &Volume->DiskCache[CacheData];
   ASSERT_VOLUME_LOCKED (Volume);
 
   Status = EFI_SUCCESS;
   while (BufferSize > 0) {
     //
-    // Seek the OFile to the file position
+    // Seek the OFile to the file position. For reads, look far enough
+    // along the cluster chain for the data cache to read ahead.
     //
-    Status = FatOFilePosition (OFile, Position, BufferSize);
+    PosLimit = BufferSize;
+    if (IoMode == ReadData) {
+      PosLimit = MAX (BufferSize, (UINTN) FAT_DATACACHE_READ_AHEAD_MAX_PAGES << DataCache->PageAlignment);
+    }
+
+    Status = FatOFilePosition (OFile, Position, PosLimit);
     if (EFI_ERROR (Status)) {
       break;
     }
@@ -485,9 +494,14 @@ FatAccessOFile (
     Len = BufferSize > OFile->PosRem ? OFile->PosRem : BufferSize;
 
     //
-    // Write the data
+    // Access the data, the data cache may read ahead up to the end of the run
     //
+    if (IoMode == ReadData) {
+      DataCache->ReadAheadLimit = OFile->PosDisk + OFile->PosRem;
+    }
+
     Status = FatDiskIo (Volume, IoMode, OFile->PosDisk, Len, UserBuffer, Task);
+    DataCache->ReadAheadLimit = 0;
     if (EFI_ERROR (Status)) {
       break;
     }
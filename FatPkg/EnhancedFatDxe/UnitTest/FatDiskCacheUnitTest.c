@@ -0,0 +1,479 @@
+/** @file
+  Unit tests of the data cache in DiskCache.c
+
+  The tests back FatDiskIo with a disk image in memory and count the raw disk
+  reads that reach the image. They check the data read through the cache
+  against a shadow copy of the image, the read-ahead of sequential reads, and
+  the replacement of the pages of the set associative data cache.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../Fat.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "FAT Disk Cache Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Geometry of the test volume
+//
+#define TEST_FAT_POS              SIZE_16KB
+#define TEST_FAT_SIZE             SIZE_64KB
+#define TEST_ROOT_POS             SIZE_1MB
+#define TEST_DATA_SIZE            SIZE_16MB
+#define TEST_VOLUME_SIZE          (TEST_ROOT_POS + TEST_DATA_SIZE)
+
+#define TEST_RANDOM_STEP_COUNT    4000
+#define TEST_RANDOM_AREA_SIZE     SIZE_8MB
+#define TEST_READ_SIZE            SIZE_4KB
+
+EFI_LOCK               FatFsLock   = EFI_INITIALIZE_LOCK_VARIABLE (TPL_CALLBACK);
+
+STATIC FAT_VOLUME      mVolume;
+STATIC UINT8           *mDisk;
+STATIC UINT8           *mShadow;
+STATIC UINT8           *mBuffer;
+STATIC UINT32          mRandomState;
+
+//
+// Raw disk reads of the data area
+//
+STATIC UINTN           mRawReadCount;
+STATIC UINT64          mRawReadEnd;
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Flush the block device of the test volume, there is nothing to flush.
+
+  @param  This                  - The block I/O protocol.
+
+  @retval EFI_SUCCESS           - Always.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+TestFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_BLOCK_IO_PROTOCOL  mBlockIo = {
+  EFI_BLOCK_IO_PROTOCOL_REVISION,
+  NULL,
+  NULL,
+  NULL,
+  NULL,
+  TestFlushBlocks
+};
+
+/**
+  Access the disk image through the cache, or directly for the raw accesses
+  made by the cache itself.
+
+  @param  Volume                - FAT file system volume.
+  @param  IoMode                - The access mode.
+  @param  Offset                - The starting byte offset to access.
+  @param  BufferSize            - Size of Buffer.
+  @param  Buffer                - Buffer containing the data.
+  @param  Task                  - Unused, the accesses are blocking.
+
+  @retval EFI_SUCCESS           - The data was accessed.
+  @retval EFI_VOLUME_CORRUPTED  - The access is outside of the volume.
+  @return Others                - The status of FatAccessCache.
+
+**/
+EFI_STATUS
+FatDiskIo (
+  IN FAT_VOLUME         *Volume,
+  IN IO_MODE            IoMode,
+  IN UINT64             Offset,
+  IN UINTN              BufferSize,
+  IN OUT VOID           *Buffer,
+  IN FAT_TASK           *Task
+  )
+{
+  if (Offset + BufferSize > Volume->VolumeSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (CACHE_ENABLED (IoMode)) {
+    return FatAccessCache (Volume, CACHE_TYPE (IoMode), RAW_ACCESS (IoMode), Offset, BufferSize, Buffer, Task);
+  }
+
+  if (IoMode == ReadDisk) {
+    if (Offset >= Volume->RootPos) {
+      mRawReadCount++;
+      mRawReadEnd = MAX (mRawReadEnd, Offset + BufferSize);
+    }
+    CopyMem (Buffer, mDisk + (UINTN) Offset, BufferSize);
+  } else {
+    CopyMem (mDisk + (UINTN) Offset, Buffer, BufferSize);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Fill the disk image with random data and set up the cache of the volume.
+
+  @param  FatType               - The FAT type, which selects the page size.
+
+  @retval UNIT_TEST_PASSED      - The volume was set up.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET - Out of memory.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+TestSetUpVolume (
+  IN FAT_VOLUME_TYPE    FatType
+  )
+{
+  UINTN  Index;
+
+  if (mVolume.CacheBuffer != NULL) {
+    FreePool (mVolume.CacheBuffer);
+  }
+
+  ZeroMem (&mVolume, sizeof (mVolume));
+  mVolume.FatType    = FatType;
+  mVolume.FatPos     = TEST_FAT_POS;
+  mVolume.FatSize    = TEST_FAT_SIZE;
+  mVolume.NumFats    = 1;
+  mVolume.RootPos    = TEST_ROOT_POS;
+  mVolume.VolumeSize = TEST_VOLUME_SIZE;
+  mVolume.BlockIo    = &mBlockIo;
+
+  mRandomState = (UINT32) FatType + 1;
+  for (Index = 0; Index < TEST_VOLUME_SIZE; Index++) {
+    mDisk[Index] = (UINT8) TestRandom ();
+  }
+  CopyMem (mShadow, mDisk, TEST_VOLUME_SIZE);
+
+  if (EFI_ERROR (FatInitializeDiskCache (&mVolume))) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  mRawReadCount = 0;
+  mRawReadEnd   = 0;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Read a range of the disk through the data cache, as FatAccessOFile does.
+
+  @param  Offset                - The disk offset to read from.
+  @param  Size                  - The number of bytes to read.
+  @param  RunEnd                - The end of the disk run being read, 0 if
+                                  unknown.
+
+  @retval TRUE                  - The data read matches the shadow image.
+  @retval FALSE                 - The read failed or returned other data.
+
+**/
+STATIC
+BOOLEAN
+TestRead (
+  IN UINT64             Offset,
+  IN UINTN              Size,
+  IN UINT64             RunEnd
+  )
+{
+  EFI_STATUS  Status;
+
+  mVolume.DiskCache[CacheData].ReadAheadLimit = RunEnd;
+  Status = FatDiskIo (&mVolume, ReadData, Offset, Size, mBuffer, NULL);
+  mVolume.DiskCache[CacheData].ReadAheadLimit = 0;
+
+  return (BOOLEAN) (!EFI_ERROR (Status) && CompareMem (mBuffer, mShadow + (UINTN) Offset, Size) == 0);
+}
+
+/**
+  Read and write random ranges through the data cache, and check that reads
+  return the data last written, and that flushing the cache leaves the disk
+  image equal to the shadow image.
+
+  @param[in]  Context           The FAT type, which selects the page size.
+
+  @retval UNIT_TEST_PASSED      All reads returned the expected data.
+  @retval UNIT_TEST_ERROR_TEST_FAILED A read returned stale data, or the disk
+                                image differs after the flush.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomAccessShouldMatchShadow (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             Step;
+  UINTN             Size;
+  UINTN             Index;
+  UINT64            Offset;
+  UINT64            RunEnd;
+
+  Status = TestSetUpVolume ((FAT_VOLUME_TYPE) (UINTN) Context);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  for (Step = 0; Step < TEST_RANDOM_STEP_COUNT; Step++) {
+    Offset = TEST_ROOT_POS + MultU64x32 (TestRandom (), TEST_RANDOM_AREA_SIZE / 0x8000) + TestRandom () % 512;
+    Size   = 1 + (TestRandom () * 8) % SIZE_256KB;
+
+    if (TestRandom () % 3 == 0) {
+      for (Index = 0; Index < Size; Index++) {
+        mBuffer[Index] = (UINT8) TestRandom ();
+      }
+      CopyMem (mShadow + (UINTN) Offset, mBuffer, Size);
+      UT_ASSERT_NOT_EFI_ERROR (FatDiskIo (&mVolume, WriteData, Offset, Size, mBuffer, NULL));
+    } else {
+      RunEnd = 0;
+      if ((TestRandom () & 1) != 0) {
+        RunEnd = MIN (Offset + Size + (TestRandom () % 4) * SIZE_64KB + TestRandom () % 512, TEST_VOLUME_SIZE);
+      }
+      UT_ASSERT_TRUE (TestRead (Offset, Size, RunEnd));
+    }
+
+    if (Step % 500 == 499) {
+      UT_ASSERT_NOT_EFI_ERROR (FatVolumeFlushCache (&mVolume, NULL));
+      UT_ASSERT_MEM_EQUAL (mDisk, mShadow, TEST_VOLUME_SIZE);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Read a disk run sequentially in small pieces, and check that the cache reads
+  ahead within the run only, and not at all when the run is unknown.
+
+  @param[in]  Context           The FAT type, which selects the page size.
+
+  @retval UNIT_TEST_PASSED      The run was read with few disk reads, none of
+                                them past the run.
+  @retval UNIT_TEST_ERROR_TEST_FAILED Too many disk reads, or a disk read past
+                                the run.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SequentialReadShouldReadAhead (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             PageSize;
+  UINTN             PageCount;
+  UINT64            RunStart;
+  UINT64            RunEnd;
+  UINT64            Offset;
+
+  Status = TestSetUpVolume ((FAT_VOLUME_TYPE) (UINTN) Context);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // A run of 40 pages that ends within a page
+  //
+  PageSize  = (UINTN) 1 << mVolume.DiskCache[CacheData].PageAlignment;
+  PageCount = 40;
+  RunStart  = TEST_ROOT_POS + 5 * PageSize;
+  RunEnd    = RunStart + (PageCount - 1) * PageSize + 1000;
+
+  for (Offset = RunStart; Offset < RunEnd; Offset += TEST_READ_SIZE) {
+    UT_ASSERT_TRUE (TestRead (Offset, (UINTN) MIN (TEST_READ_SIZE, RunEnd - Offset), RunEnd));
+  }
+
+  //
+  // The window doubles up to FAT_DATACACHE_READ_AHEAD_MAX_PAGES, and is cut
+  // at the last group of the cache
+  //
+  UT_ASSERT_TRUE (mRawReadCount <= 8);
+  UT_ASSERT_TRUE (mRawReadEnd <= RunStart + PageCount * PageSize);
+
+  //
+  // Without the end of the run, every page is read on its own
+  //
+  Status = TestSetUpVolume ((FAT_VOLUME_TYPE) (UINTN) Context);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  for (Offset = RunStart; Offset < RunEnd; Offset += TEST_READ_SIZE) {
+    UT_ASSERT_TRUE (TestRead (Offset, (UINTN) MIN (TEST_READ_SIZE, RunEnd - Offset), 0));
+  }
+
+  UT_ASSERT_EQUAL (mRawReadCount, PageCount);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Read pages that fall in the same group of the data cache, and check that up
+  to FAT_DATACACHE_WAY_COUNT of them stay cached, and that the least recently
+  used one is replaced.
+
+  @param[in]  Context           The FAT type, which selects the page size.
+
+  @retval UNIT_TEST_PASSED      The pages were replaced in LRU order.
+  @retval UNIT_TEST_ERROR_TEST_FAILED A page was replaced too early, or the
+                                wrong page was replaced.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+GroupShouldReplaceLeastRecentlyUsed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             PageSize;
+  UINTN             GroupStride;
+  UINTN             Way;
+
+  Status = TestSetUpVolume ((FAT_VOLUME_TYPE) (UINTN) Context);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  PageSize    = (UINTN) 1 << mVolume.DiskCache[CacheData].PageAlignment;
+  GroupStride = (mVolume.DiskCache[CacheData].GroupMask + 1) * PageSize;
+
+  //
+  // Fill all the ways of group 0, then read them all again
+  //
+  for (Way = 0; Way < FAT_DATACACHE_WAY_COUNT; Way++) {
+    UT_ASSERT_TRUE (TestRead (TEST_ROOT_POS + Way * GroupStride, TEST_READ_SIZE, 0));
+  }
+  UT_ASSERT_EQUAL (mRawReadCount, FAT_DATACACHE_WAY_COUNT);
+
+  for (Way = 0; Way < FAT_DATACACHE_WAY_COUNT; Way++) {
+    UT_ASSERT_TRUE (TestRead (TEST_ROOT_POS + Way * GroupStride + TEST_READ_SIZE, TEST_READ_SIZE, 0));
+  }
+  UT_ASSERT_EQUAL (mRawReadCount, FAT_DATACACHE_WAY_COUNT);
+
+  //
+  // Use way 0 again, so way 1 is the least recently used, then load one more
+  // page of the group
+  //
+  UT_ASSERT_TRUE (TestRead (TEST_ROOT_POS, TEST_READ_SIZE, 0));
+  UT_ASSERT_TRUE (TestRead (TEST_ROOT_POS + FAT_DATACACHE_WAY_COUNT * GroupStride, TEST_READ_SIZE, 0));
+  UT_ASSERT_EQUAL (mRawReadCount, FAT_DATACACHE_WAY_COUNT + 1);
+
+  UT_ASSERT_TRUE (TestRead (TEST_ROOT_POS, TEST_READ_SIZE, 0));
+  UT_ASSERT_EQUAL (mRawReadCount, FAT_DATACACHE_WAY_COUNT + 1);
+  UT_ASSERT_TRUE (TestRead (TEST_ROOT_POS + GroupStride, TEST_READ_SIZE, 0));
+  UT_ASSERT_EQUAL (mRawReadCount, FAT_DATACACHE_WAY_COUNT + 2);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the data
+  cache and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      CacheTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  mDisk   = AllocatePool (TEST_VOLUME_SIZE);
+  mShadow = AllocatePool (TEST_VOLUME_SIZE);
+  mBuffer = AllocatePool (SIZE_256KB);
+  if ((mDisk == NULL) || (mShadow == NULL) || (mBuffer == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&CacheTests, Framework, "FAT Data Cache Tests", "Fat.DiskCache", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CacheTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // FAT12 volumes use the smallest cache pages, the others the largest
+  //
+  AddTestCase (CacheTests, "FAT12 random access should match the shadow image", "Fat12Random", RandomAccessShouldMatchShadow, NULL, NULL, (UNIT_TEST_CONTEXT) Fat12);
+  AddTestCase (CacheTests, "FAT32 random access should match the shadow image", "Fat32Random", RandomAccessShouldMatchShadow, NULL, NULL, (UNIT_TEST_CONTEXT) Fat32);
+  AddTestCase (CacheTests, "FAT12 sequential read should read ahead", "Fat12ReadAhead", SequentialReadShouldReadAhead, NULL, NULL, (UNIT_TEST_CONTEXT) Fat12);
+  AddTestCase (CacheTests, "FAT32 sequential read should read ahead", "Fat32ReadAhead", SequentialReadShouldReadAhead, NULL, NULL, (UNIT_TEST_CONTEXT) Fat32);
+  AddTestCase (CacheTests, "FAT32 group should replace the least recently used page", "Fat32Lru", GroupShouldReplaceLeastRecentlyUsed, NULL, NULL, (UNIT_TEST_CONTEXT) Fat32);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+  if (mVolume.CacheBuffer != NULL) {
+    FreePool (mVolume.CacheBuffer);
+  }
+  if (mBuffer != NULL) {
+    FreePool (mBuffer);
+  }
+  if (mShadow != NULL) {
+    FreePool (mShadow);
+  }
+  if (mDisk != NULL) {
+    FreePool (mDisk);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
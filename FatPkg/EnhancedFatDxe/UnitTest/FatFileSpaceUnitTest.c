@@ -0,0 +1,769 @@
+/** @file
+  Unit tests of the free cluster bitmap allocator in FileSpace.c
+
+  The tests generate FAT12, FAT16 and FAT32 tables in memory, with used
+  cluster chains and free gaps of random length, and check the allocation
+  results and the free cluster counts of the bitmap allocator against a
+  linear scan of the FAT entries.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../Fat.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "FAT File Space Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Geometry of the generated volumes, only the first FAT is kept in memory
+//
+#define TEST_FAT_POS              0x4000
+#define TEST_CLUSTER_ALIGNMENT    12
+#define TEST_MAX_FILES            256
+#define TEST_MAX_FILE_CLUSTERS    64
+
+typedef struct {
+  FAT_VOLUME_TYPE   FatType;
+  UINTN             MaxCluster;
+  UINT32            Seed;
+} FAT_TEST_IMAGE;
+
+STATIC FAT_TEST_IMAGE  mFat12Image = { Fat12, 4000,   0x12 };
+STATIC FAT_TEST_IMAGE  mFat16Image = { Fat16, 30000,  0x16 };
+STATIC FAT_TEST_IMAGE  mFat32Image = { Fat32, 70000,  0x32 };
+
+EFI_LOCK               FatFsLock   = EFI_INITIALIZE_LOCK_VARIABLE (TPL_CALLBACK);
+
+STATIC FAT_VOLUME      mVolume;
+STATIC UINT8           *mFat;
+STATIC UINT8           *mFatSnapshot;
+STATIC UINTN           mFatSize;
+STATIC FAT_OFILE       mFiles[TEST_MAX_FILES];
+STATIC UINT32          mRandomState;
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Decode a FAT entry of the generated FAT.
+
+  @param  Fat                   - The FAT to decode the entry from.
+  @param  Index                 - The index of the FAT entry.
+
+  @return The raw value of the FAT entry.
+
+**/
+STATIC
+UINTN
+TestGetFatEntry (
+  IN UINT8              *Fat,
+  IN UINTN              Index
+  )
+{
+  UINTN Accum;
+
+  switch (mVolume.FatType) {
+  case Fat12:
+    Accum = Fat[Index * 3 / 2] | (Fat[Index * 3 / 2 + 1] << 8);
+    return ((Index & 1) != 0) ? (Accum >> 4) : (Accum & 0xFFF);
+
+  case Fat16:
+    return Fat[Index * 2] | (Fat[Index * 2 + 1] << 8);
+
+  default:
+    return ReadUnaligned32 ((UINT32 *) &Fat[Index * 4]) & 0x0FFFFFFF;
+  }
+}
+
+/**
+  Encode a FAT entry of the generated FAT.
+
+  @param  Index                 - The index of the FAT entry.
+  @param  Value                 - The raw value of the FAT entry.
+
+**/
+STATIC
+VOID
+TestSetFatEntry (
+  IN UINTN              Index,
+  IN UINTN              Value
+  )
+{
+  UINTN Pos;
+
+  switch (mVolume.FatType) {
+  case Fat12:
+    Pos = Index * 3 / 2;
+    if ((Index & 1) != 0) {
+      mFat[Pos]     = (UINT8) ((mFat[Pos] & 0x0F) | ((Value << 4) & 0xF0));
+      mFat[Pos + 1] = (UINT8) (Value >> 4);
+    } else {
+      mFat[Pos]     = (UINT8) Value;
+      mFat[Pos + 1] = (UINT8) ((mFat[Pos + 1] & 0xF0) | ((Value >> 8) & 0x0F));
+    }
+    break;
+
+  case Fat16:
+    mFat[Index * 2]     = (UINT8) Value;
+    mFat[Index * 2 + 1] = (UINT8) (Value >> 8);
+    break;
+
+  default:
+    WriteUnaligned32 ((UINT32 *) &mFat[Index * 4], (UINT32) Value);
+  }
+}
+
+/**
+  Return the end of chain marker of the generated FAT.
+
+  @return The raw value of the end of chain marker.
+
+**/
+STATIC
+UINTN
+TestEndOfChain (
+  VOID
+  )
+{
+  switch (mVolume.FatType) {
+  case Fat12:
+    return 0xFFF;
+
+  case Fat16:
+    return 0xFFFF;
+
+  default:
+    return 0x0FFFFFFF;
+  }
+}
+
+/**
+  Count the free clusters of the volume with a linear scan of the FAT.
+
+  @return The number of free clusters.
+
+**/
+STATIC
+UINTN
+TestCountFreeClusters (
+  VOID
+  )
+{
+  UINTN Index;
+  UINTN Count;
+
+  Count = 0;
+  for (Index = FAT_MIN_CLUSTER; Index <= mVolume.MaxCluster + 1; Index++) {
+    if (TestGetFatEntry (mFat, Index) == FAT_CLUSTER_FREE) {
+      Count++;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Find the first run of ClusterCount free clusters with a linear scan of the
+  FAT, from Hint to the end of the volume, then from the start of the volume
+  to Hint. For a single cluster this is the cluster the FAT scan allocator
+  returns.
+
+  @param  Hint                  - The free cluster hint of the volume.
+  @param  ClusterCount          - The length of the run to find.
+  @param  RunLength             - The length of the run found, at most ClusterCount.
+
+  @return The first cluster of the first run long enough, else of the longest
+          run, or FAT_CLUSTER_LAST if the volume is full.
+
+**/
+STATIC
+UINTN
+TestFindFreeRun (
+  IN  UINTN             Hint,
+  IN  UINTN             ClusterCount,
+  OUT UINTN             *RunLength
+  )
+{
+  UINTN Pass;
+  UINTN Cluster;
+  UINTN End;
+  UINTN Start;
+  UINTN Length;
+  UINTN BestStart;
+
+  if (Hint < FAT_MIN_CLUSTER || Hint > mVolume.MaxCluster + 1) {
+    Hint = FAT_MIN_CLUSTER;
+  }
+
+  BestStart  = (UINTN) FAT_CLUSTER_LAST;
+  *RunLength = 0;
+  for (Pass = 0; Pass < 2; Pass++) {
+    End    = (Pass == 0) ? mVolume.MaxCluster + 2 : Hint;
+    Start  = 0;
+    Length = 0;
+    for (Cluster = (Pass == 0) ? Hint : FAT_MIN_CLUSTER; Cluster < End; Cluster++) {
+      if (TestGetFatEntry (mFat, Cluster) != FAT_CLUSTER_FREE) {
+        Length = 0;
+        continue;
+      }
+
+      if (Length == 0) {
+        Start = Cluster;
+      }
+
+      Length++;
+      if (Length > *RunLength) {
+        BestStart  = Start;
+        *RunLength = Length;
+        if (Length == ClusterCount) {
+          return BestStart;
+        }
+      }
+    }
+  }
+
+  return BestStart;
+}
+
+/**
+  Check the free cluster info and the free cluster bitmap of the volume
+  against a linear scan of the FAT.
+
+  @retval TRUE                  - They match the FAT.
+  @retval FALSE                 - They do not.
+
+**/
+STATIC
+BOOLEAN
+TestFreeInfoMatchesFat (
+  VOID
+  )
+{
+  UINTN   Index;
+  BOOLEAN Free;
+
+  if (mVolume.FatInfoSector.FreeInfo.ClusterCount != TestCountFreeClusters ()) {
+    return FALSE;
+  }
+
+  for (Index = FAT_MIN_CLUSTER; Index <= mVolume.MaxCluster + 1; Index++) {
+    Free = (BOOLEAN) ((mVolume.FreeBitmap[Index / 32] & (1U << (Index % 32))) != 0);
+    if (Free != (TestGetFatEntry (mFat, Index) == FAT_CLUSTER_FREE)) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Check the cluster chain of a file that was grown from empty.
+
+  @param  OFile                 - The file.
+  @param  ClusterCount          - The number of clusters of the file.
+  @param  RunLength             - The number of clusters at the start of the
+                                  chain that must be contiguous.
+
+  @retval TRUE                  - The chain has ClusterCount clusters, all of
+                                  them were free before the file was grown, and
+                                  the first RunLength of them are contiguous.
+  @retval FALSE                 - The chain is wrong.
+
+**/
+STATIC
+BOOLEAN
+TestCheckChain (
+  IN FAT_OFILE          *OFile,
+  IN UINTN              ClusterCount,
+  IN UINTN              RunLength
+  )
+{
+  UINTN Cluster;
+  UINTN Next;
+  UINTN Index;
+
+  Cluster = OFile->FileCluster;
+  for (Index = 0; Index < ClusterCount; Index++) {
+    if (Cluster < FAT_MIN_CLUSTER || Cluster > mVolume.MaxCluster + 1 ||
+        TestGetFatEntry (mFatSnapshot, Cluster) != FAT_CLUSTER_FREE) {
+      return FALSE;
+    }
+
+    Next = TestGetFatEntry (mFat, Cluster);
+    if (Index + 1 == ClusterCount) {
+      return (BOOLEAN) (Next == TestEndOfChain () && OFile->FileLastCluster == Cluster);
+    }
+
+    if (Index + 1 < RunLength && Next != Cluster + 1) {
+      return FALSE;
+    }
+
+    Cluster = Next;
+  }
+
+  return FALSE;
+}
+
+/**
+  Grow an empty file and check the clusters it got against a linear scan of
+  the FAT.
+
+  @param  OFile                 - The empty file.
+  @param  ClusterCount          - The number of clusters to grow the file to.
+
+  @retval TRUE                  - The file got the clusters the linear scan
+                                  expects, and the free cluster info matches
+                                  the FAT.
+  @retval FALSE                 - The allocation is wrong.
+
+**/
+STATIC
+BOOLEAN
+TestGrowFile (
+  IN FAT_OFILE          *OFile,
+  IN UINTN              ClusterCount
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       FreeCount;
+  UINTN       Expected;
+  UINTN       RunLength;
+
+  FreeCount = TestCountFreeClusters ();
+  Expected  = TestFindFreeRun (mVolume.FatInfoSector.FreeInfo.NextCluster, ClusterCount, &RunLength);
+  CopyMem (mFatSnapshot, mFat, mFatSize);
+
+  ZeroMem (OFile, sizeof (FAT_OFILE));
+  OFile->Volume = &mVolume;
+  Status        = FatGrowEof (OFile, LShiftU64 (ClusterCount, TEST_CLUSTER_ALIGNMENT));
+  if (ClusterCount > FreeCount) {
+    //
+    // The volume is full, the clusters allocated before are given back
+    //
+    return (BOOLEAN) (Status == EFI_VOLUME_FULL && OFile->FileCluster == FAT_CLUSTER_FREE &&
+                      CompareMem (mFatSnapshot, mFat, mFatSize) == 0 &&
+                      TestFreeInfoMatchesFat ());
+  }
+
+  return (BOOLEAN) (!EFI_ERROR (Status) && OFile->FileCluster == Expected &&
+                    TestCheckChain (OFile, ClusterCount, RunLength) &&
+                    TestCountFreeClusters () == FreeCount - ClusterCount &&
+                    TestFreeInfoMatchesFat ());
+}
+
+/**
+  Free all the clusters of a file.
+
+  @param  OFile                 - The file.
+
+  @return The status of shrinking the file.
+
+**/
+STATIC
+EFI_STATUS
+TestFreeFile (
+  IN FAT_OFILE          *OFile
+  )
+{
+  OFile->FileSize = 0;
+  return FatShrinkEof (OFile);
+}
+
+/**
+  Generate a FAT with used cluster chains and free gaps of random length, and
+  a volume to access it.
+
+  @param  Context               - The FAT_TEST_IMAGE to generate.
+
+  @retval UNIT_TEST_PASSED                      - The volume is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET  - Out of memory.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+GenerateFatImage (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAT_TEST_IMAGE  *Image;
+  UINTN           Cluster;
+  UINTN           Run;
+  UINTN           Index;
+
+  Image = (FAT_TEST_IMAGE *) Context;
+
+  ZeroMem (&mVolume, sizeof (mVolume));
+  mVolume.FatType           = Image->FatType;
+  mVolume.MaxCluster        = Image->MaxCluster;
+  mVolume.FatPos            = TEST_FAT_POS;
+  mVolume.ClusterAlignment  = TEST_CLUSTER_ALIGNMENT;
+  mVolume.ClusterSize       = (UINTN) 1 << TEST_CLUSTER_ALIGNMENT;
+  mVolume.FatEntrySize      = (Image->FatType == Fat32) ? sizeof (UINT32) : sizeof (UINT16);
+  mVolume.FatDirty          = TRUE;
+
+  //
+  // Big enough for the two bytes read of the last FAT12 or FAT16 entry
+  //
+  mFatSize        = FAT_POS_FAT32 (Image->MaxCluster + 2);
+  mVolume.FatSize = mFatSize;
+  mFat            = AllocateZeroPool (mFatSize);
+  mFatSnapshot    = AllocatePool (mFatSize);
+  if (mFat == NULL || mFatSnapshot == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  TestSetFatEntry (0, TestEndOfChain () & ~0x7);
+  TestSetFatEntry (1, TestEndOfChain ());
+
+  mRandomState = Image->Seed;
+  Cluster      = FAT_MIN_CLUSTER;
+  while (Cluster <= Image->MaxCluster + 1) {
+    Run = 1 + TestRandom () % 48;
+    for (Index = 0; Index < Run && Cluster <= Image->MaxCluster + 1; Index++, Cluster++) {
+      if (Index + 1 < Run && Cluster < Image->MaxCluster + 1) {
+        TestSetFatEntry (Cluster, Cluster + 1);
+      } else {
+        TestSetFatEntry (Cluster, TestEndOfChain ());
+      }
+    }
+
+    //
+    // Leave a free gap, now and then a long one
+    //
+    if (TestRandom () % 16 == 0) {
+      Cluster += 64 + TestRandom () % 256;
+    } else {
+      Cluster += 1 + TestRandom () % 24;
+    }
+  }
+
+  FatFsLock.Lock = EfiLockAcquired;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the generated FAT and the files and free cluster bitmap of the volume.
+
+  @param  Context               - The FAT_TEST_IMAGE that was generated.
+
+**/
+STATIC
+VOID
+EFIAPI
+FreeFatImage (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN Index;
+
+  for (Index = 0; Index < TEST_MAX_FILES; Index++) {
+    FatFreeExtentMap (&mFiles[Index]);
+  }
+
+  if (mVolume.FreeBitmap != NULL) {
+    FreePool (mVolume.FreeBitmap);
+    mVolume.FreeBitmap = NULL;
+  }
+
+  if (mFat != NULL) {
+    FreePool (mFat);
+    mFat = NULL;
+  }
+
+  if (mFatSnapshot != NULL) {
+    FreePool (mFatSnapshot);
+    mFatSnapshot = NULL;
+  }
+
+  FatFsLock.Lock = EfiLockReleased;
+}
+
+/**
+  The free cluster count and the free cluster bitmap match a linear scan of
+  the FAT.
+
+  @param  Context               - The FAT_TEST_IMAGE that was generated.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FreeCountShouldMatchLinearScan (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FatComputeFreeInfo (&mVolume);
+
+  UT_ASSERT_TRUE (mVolume.FreeInfoValid);
+  UT_ASSERT_NOT_NULL (mVolume.FreeBitmap);
+  UT_ASSERT_EQUAL (mVolume.FatInfoSector.FreeInfo.ClusterCount, TestCountFreeClusters ());
+  UT_ASSERT_TRUE (TestFreeInfoMatchesFat ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Files get the first free run long enough from the free cluster hint, or the
+  longest one, as a linear scan of the FAT finds it, until the volume is full.
+
+  @param  Context               - The FAT_TEST_IMAGE that was generated.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+AllocationShouldMatchLinearScan (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN FileCount;
+  UINTN ClusterCount;
+  UINTN FreeCount;
+  UINTN Index;
+
+  FatComputeFreeInfo (&mVolume);
+
+  FileCount = 0;
+  FreeCount = TestCountFreeClusters ();
+  while (FileCount < TEST_MAX_FILES - 1) {
+    ClusterCount = 1 + TestRandom () % TEST_MAX_FILE_CLUSTERS;
+    if (ClusterCount > FreeCount) {
+      break;
+    }
+
+    UT_ASSERT_TRUE (TestGrowFile (&mFiles[FileCount], ClusterCount));
+    FileCount++;
+    FreeCount -= ClusterCount;
+  }
+
+  //
+  // A file larger than the free space fails and leaves the FAT unchanged
+  //
+  UT_ASSERT_TRUE (TestGrowFile (&mFiles[FileCount], FreeCount + 1));
+
+  //
+  // Free every other file and fill the volume up with a single file
+  //
+  for (Index = 0; Index < FileCount; Index += 2) {
+    UT_ASSERT_NOT_EFI_ERROR (TestFreeFile (&mFiles[Index]));
+    UT_ASSERT_TRUE (TestFreeInfoMatchesFat ());
+  }
+
+  FreeCount = TestCountFreeClusters ();
+  UT_ASSERT_TRUE (TestGrowFile (&mFiles[TEST_MAX_FILES - 1], FreeCount));
+  UT_ASSERT_EQUAL (mVolume.FatInfoSector.FreeInfo.ClusterCount, 0);
+  UT_ASSERT_EQUAL (TestCountFreeClusters (), 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A growing file gets the cluster that follows its last cluster while it is
+  free, and a free run found by a linear scan of the FAT after that.
+
+  @param  Context               - The FAT_TEST_IMAGE that was generated.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+GrowingFileShouldStayContiguous (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAT_OFILE   *OFile;
+  EFI_STATUS  Status;
+  UINTN       ClusterCount;
+  UINTN       LastCluster;
+  UINTN       Expected;
+  UINTN       RunLength;
+
+  FatComputeFreeInfo (&mVolume);
+
+  OFile = &mFiles[0];
+  UT_ASSERT_TRUE (TestGrowFile (OFile, 1));
+  for (ClusterCount = 2; ClusterCount <= TEST_MAX_FILE_CLUSTERS * 4; ClusterCount++) {
+    LastCluster = OFile->FileLastCluster;
+    if (LastCluster + 1 <= mVolume.MaxCluster + 1 &&
+        TestGetFatEntry (mFat, LastCluster + 1) == FAT_CLUSTER_FREE) {
+      Expected = LastCluster + 1;
+    } else {
+      Expected = TestFindFreeRun (mVolume.FatInfoSector.FreeInfo.NextCluster, 1, &RunLength);
+    }
+
+    Status = FatGrowEof (OFile, LShiftU64 (ClusterCount, TEST_CLUSTER_ALIGNMENT));
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (TestGetFatEntry (mFat, LastCluster), Expected);
+    UT_ASSERT_EQUAL (OFile->FileLastCluster, Expected);
+    UT_ASSERT_EQUAL (TestGetFatEntry (mFat, Expected), TestEndOfChain ());
+    UT_ASSERT_TRUE (TestFreeInfoMatchesFat ());
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (TestFreeFile (OFile));
+  UT_ASSERT_TRUE (TestFreeInfoMatchesFat ());
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Read or write the generated FAT, only FAT accesses are expected.
+
+  @param  Volume                - FAT file system volume.
+  @param  IoMode                - The access mode.
+  @param  Offset                - The starting byte offset to read from.
+  @param  BufferSize            - Size of Buffer.
+  @param  Buffer                - Buffer containing read data.
+  @param  Task                  - point to task instance.
+
+  @retval EFI_SUCCESS           - The operation is performed successfully.
+  @retval EFI_VOLUME_CORRUPTED  - The access is outside of the FAT.
+  @retval EFI_UNSUPPORTED       - The access is not a FAT access.
+
+**/
+EFI_STATUS
+FatDiskIo (
+  IN FAT_VOLUME         *Volume,
+  IN IO_MODE            IoMode,
+  IN UINT64             Offset,
+  IN UINTN              BufferSize,
+  IN OUT VOID           *Buffer,
+  IN FAT_TASK           *Task
+  )
+{
+  if (Offset < Volume->FatPos || Offset - Volume->FatPos + BufferSize > mFatSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  switch (IoMode) {
+  case ReadFat:
+    CopyMem (Buffer, mFat + (UINTN) (Offset - Volume->FatPos), BufferSize);
+    return EFI_SUCCESS;
+
+  case WriteFat:
+    CopyMem (mFat + (UINTN) (Offset - Volume->FatPos), Buffer, BufferSize);
+    return EFI_SUCCESS;
+
+  default:
+    return EFI_UNSUPPORTED;
+  }
+}
+
+/**
+  The generated volumes are always dirty.
+
+  @param  Volume                - FAT file system volume.
+  @param  IoMode                - The access mode.
+  @param  DirtyValue            - Set the volume as dirty or not.
+
+  @retval EFI_SUCCESS           - Always.
+
+**/
+EFI_STATUS
+FatAccessVolumeDirty (
+  IN FAT_VOLUME         *Volume,
+  IN IO_MODE            IoMode,
+  IN VOID               *DirtyValue
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Add the tests of one generated FAT to a suite.
+
+  @param  Suite                 - The test suite.
+  @param  Name                  - The name of the FAT type.
+  @param  Image                 - The FAT to generate.
+
+**/
+STATIC
+VOID
+AddFatImageTests (
+  IN UNIT_TEST_SUITE_HANDLE  Suite,
+  IN CHAR8                   *Name,
+  IN FAT_TEST_IMAGE          *Image
+  )
+{
+  AddTestCase (Suite, "Free count should match a linear scan", Name, FreeCountShouldMatchLinearScan, GenerateFatImage, FreeFatImage, Image);
+  AddTestCase (Suite, "Allocation should match a linear scan", Name, AllocationShouldMatchLinearScan, GenerateFatImage, FreeFatImage, Image);
+  AddTestCase (Suite, "Growing file should stay contiguous", Name, GrowingFileShouldStayContiguous, GenerateFatImage, FreeFatImage, Image);
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the free
+  cluster bitmap allocator and run them.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      FileSpaceTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&FileSpaceTests, Framework, "FAT Free Cluster Bitmap Tests", "Fat.FileSpace", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for FileSpaceTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddFatImageTests (FileSpaceTests, "Fat12", &mFat12Image);
+  AddFatImageTests (FileSpaceTests, "Fat16", &mFat16Image);
+  AddFatImageTests (FileSpaceTests, "Fat32", &mFat32Image);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,247 @@
+/** @file
+  If the HII database has PcdHiiGlyphCacheCollectStatistics set to TRUE then
+  this utility redraws a text screen with EFI_HII_FONT_PROTOCOL.StringToImage()
+  for several sizes of the rendered glyph cache, and prints the hit rate of the
+  cache and the time of one redraw for each size. You can use console
+  redirection to capture the data.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiApplicationEntryPoint.h>
+#include <Library/BaseLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include <Guid/HiiGlyphCacheStatistics.h>
+#include <Protocol/HiiFont.h>
+
+//
+// Size of the screen that is redrawn, in characters
+//
+#define SCREEN_COLUMNS      80
+#define SCREEN_ROWS         25
+
+//
+// Number of timed redraws for each cache size
+//
+#define REDRAW_COUNT        100
+
+//
+// Lines of a typical setup page. The screen repeats them, and one of them is
+// highlighted in other colors, moving down at each redraw, like a cursor.
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST CHAR16  *mScreenLines[] = {
+  L"                              Device Manager",
+  L"/------------------------------------------------------------------------\\",
+  L"| Devices List                                    | Press <Enter> to     |",
+  L"| > Secure Boot Configuration                     | select the device    |",
+  L"| > Driver Health Manager                         | and modify its       |",
+  L"| > Network Device List                           | settings.            |",
+  L"| > iSCSI Configuration                           |                      |",
+  L"| > OVMF Platform Configuration                   | Boot Order:          |",
+  L"| > Tcg2 Configuration                            |   UEFI Shell         |",
+  L"|   MAC:52:54:00:12:34:56 IPv4 0.0.0.0            |   PXEv4 (MAC:0A0B0C) |",
+  L"|   Memory: 0x0000000080000000 - 0x00000000FFFFFFFF                     |",
+  L"| Press ESC to return to Main Page                |                      |",
+  L"\\------------------------------------------------------------------------/",
+  L"  ^v=Move Highlight       <Enter>=Select Entry      Esc=Exit"
+};
+
+//
+// Cache sizes that are measured
+//
+GLOBAL_REMOVE_IF_UNREFERENCED CONST UINT32  mCacheSizes[] = {
+  0, 32, 64, 128, 256, 512, 1024
+};
+
+/**
+  Draw the test screen into an off-screen image.
+
+  @param[in]  HiiFont         The HII font protocol.
+  @param[in]  Normal          The font and colors of the screen.
+  @param[in]  Highlight       The font and colors of the highlighted line.
+  @param[in]  HighlightRow    The row that is highlighted.
+  @param[in]  Image           The image to draw into.
+
+  @retval EFI_SUCCESS         The screen was drawn.
+  @return Others              The error StringToImage() returned.
+
+**/
+EFI_STATUS
+DrawScreen (
+  IN EFI_HII_FONT_PROTOCOL  *HiiFont,
+  IN EFI_FONT_DISPLAY_INFO  *Normal,
+  IN EFI_FONT_DISPLAY_INFO  *Highlight,
+  IN UINTN                  HighlightRow,
+  IN EFI_IMAGE_OUTPUT       *Image
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     Row;
+
+  for (Row = 0; Row < SCREEN_ROWS; Row++) {
+    Status = HiiFont->StringToImage (
+                        HiiFont,
+                        EFI_HII_IGNORE_IF_NO_GLYPH | EFI_HII_IGNORE_LINE_BREAK,
+                        (EFI_STRING) mScreenLines[Row % ARRAY_SIZE (mScreenLines)],
+                        (Row == HighlightRow) ? Highlight : Normal,
+                        &Image,
+                        0,
+                        Row * EFI_GLYPH_HEIGHT,
+                        NULL,
+                        NULL,
+                        NULL
+                        );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  The user Entry Point for Application. The user code starts with this function
+  as the real entry point for the application.
+
+  @param[in] ImageHandle    The firmware allocated handle for the EFI image.
+  @param[in] SystemTable    A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+  @retval other             Some error occurs when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+UefiMain (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  EFI_STATUS                        Status;
+  EDKII_HII_GLYPH_CACHE_STATISTICS  *Statistics;
+  EFI_HII_FONT_PROTOCOL             *HiiFont;
+  EFI_FONT_DISPLAY_INFO             *Normal;
+  EFI_FONT_DISPLAY_INFO             *Highlight;
+  EFI_IMAGE_OUTPUT                  *Image;
+  UINT32                            OriginalMaxCount;
+  UINTN                             SizeIndex;
+  UINTN                             Redraw;
+  UINT64                            Start;
+  UINT64                            End;
+  UINT64                            Lookups;
+  UINT64                            HitRate;
+  UINT64                            Time;
+
+  Status = EfiGetSystemConfigurationTable (&gEdkiiHiiGlyphCacheStatisticsGuid, (VOID **) &Statistics);
+  if (EFI_ERROR (Status) || (Statistics == NULL)) {
+    Print (L"Warning: HII database doesn't enable the feature of glyph cache statistics!\n");
+    Print (L"If you want to see this info, please:\n");
+    Print (L"  1. Set PcdHiiGlyphCacheCollectStatistics as TRUE\n");
+    Print (L"  2. Rebuild HiiDatabase Dxe driver\n");
+    Print (L"  3. Run \"HiiGlyphCacheInfo\" cmd again\n");
+    return EFI_NOT_FOUND;
+  }
+
+  Status = gBS->LocateProtocol (&gEfiHiiFontProtocolGuid, NULL, (VOID **) &HiiFont);
+  if (EFI_ERROR (Status)) {
+    Print (L"HII font protocol not found: %r\n", Status);
+    return Status;
+  }
+
+  Normal    = AllocateZeroPool (sizeof (EFI_FONT_DISPLAY_INFO));
+  Highlight = AllocateZeroPool (sizeof (EFI_FONT_DISPLAY_INFO));
+  Image     = AllocateZeroPool (sizeof (EFI_IMAGE_OUTPUT));
+  if ((Normal == NULL) || (Highlight == NULL) || (Image == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Normal->ForegroundColor.Blue     = 0xAA;
+  Normal->ForegroundColor.Green    = 0xAA;
+  Normal->ForegroundColor.Red      = 0xAA;
+  Highlight->ForegroundColor.Blue  = 0xFF;
+  Highlight->ForegroundColor.Green = 0xFF;
+  Highlight->ForegroundColor.Red   = 0xFF;
+  Highlight->BackgroundColor.Blue  = 0xAA;
+
+  Image->Width        = SCREEN_COLUMNS * EFI_GLYPH_WIDTH;
+  Image->Height       = SCREEN_ROWS * EFI_GLYPH_HEIGHT;
+  Image->Image.Bitmap = AllocateZeroPool (Image->Width * Image->Height * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  if (Image->Image.Bitmap == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Print (L"Redraws of a %dx%d text screen, %d redraws per cache size\n", SCREEN_COLUMNS, SCREEN_ROWS, REDRAW_COUNT);
+  Print (L"CacheSize       Hits     Misses  Evictions  HitRate  us/Redraw\n");
+
+  OriginalMaxCount = Statistics->MaxCount;
+  for (SizeIndex = 0; SizeIndex < ARRAY_SIZE (mCacheSizes); SizeIndex++) {
+    //
+    // The first redraw trims the cache to the new size and fills it.
+    //
+    Statistics->MaxCount = mCacheSizes[SizeIndex];
+    Status = DrawScreen (HiiFont, Normal, Highlight, 0, Image);
+    if (EFI_ERROR (Status)) {
+      Print (L"StringToImage failed: %r\n", Status);
+      break;
+    }
+
+    Statistics->Hits      = 0;
+    Statistics->Misses    = 0;
+    Statistics->Evictions = 0;
+
+    Start = GetPerformanceCounter ();
+    for (Redraw = 1; Redraw <= REDRAW_COUNT; Redraw++) {
+      Status = DrawScreen (HiiFont, Normal, Highlight, Redraw % SCREEN_ROWS, Image);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+    End = GetPerformanceCounter ();
+    if (EFI_ERROR (Status)) {
+      Print (L"StringToImage failed: %r\n", Status);
+      break;
+    }
+
+    Lookups = Statistics->Hits + Statistics->Misses;
+    HitRate = (Lookups == 0) ? 0 : DivU64x64Remainder (MultU64x32 (Statistics->Hits, 1000), Lookups, NULL);
+    Time    = DivU64x32 (GetTimeInNanoSecond (End - Start), REDRAW_COUNT * 1000);
+
+    Print (
+      L"%9d %10ld %10ld %10ld   %3ld.%ld%% %10ld\n",
+      mCacheSizes[SizeIndex],
+      Statistics->Hits,
+      Statistics->Misses,
+      Statistics->Evictions,
+      DivU64x32 (HitRate, 10),
+      ModU64x32 (HitRate, 10),
+      Time
+      );
+  }
+
+  Statistics->MaxCount = OriginalMaxCount;
+
+Done:
+  if (Image != NULL) {
+    if (Image->Image.Bitmap != NULL) {
+      FreePool (Image->Image.Bitmap);
+    }
+    FreePool (Image);
+  }
+  if (Highlight != NULL) {
+    FreePool (Highlight);
+  }
+  if (Normal != NULL) {
+    FreePool (Normal);
+  }
+
+  return Status;
+}
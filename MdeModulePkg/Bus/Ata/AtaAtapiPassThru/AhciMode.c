@@ -2445,6 +2445,702 @@ AhciPuisEnable (
   return Status;
 }
 
+/**
+  Allocate the Native Command Queuing context of a port.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+  @param  QueueDepth         The number of tags the port may keep in flight.
+
+  @retval EFI_OUT_OF_RESOURCES  The command list and tables can't be allocated.
+  @retval EFI_SUCCESS           The context is created.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqCreatePort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port,
+  IN  UINT32                    QueueDepth
+  )
+{
+  EFI_STATUS                    Status;
+  AHCI_NCQ_PORT                 *NcqPort;
+  VOID                          *Buffer;
+  UINTN                         PageCount;
+  UINTN                         Bytes;
+  EFI_PHYSICAL_ADDRESS          PciAddr;
+  UINT32                        Capability;
+
+  if (AhciRegisters->NcqPort[Port] != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  NcqPort = AllocateZeroPool (sizeof (AHCI_NCQ_PORT));
+  if (NcqPort == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The buffer starts with the 1K aligned command list, followed by one
+  // 128 byte aligned command table per tag.
+  //
+  PageCount = EFI_SIZE_TO_PAGES (AHCI_NCQ_MAX_TAGS * (sizeof (EFI_AHCI_COMMAND_LIST) + sizeof (AHCI_NCQ_COMMAND_TABLE)));
+  Status = PciIo->AllocateBuffer (
+                    PciIo,
+                    AllocateAnyPages,
+                    EfiBootServicesData,
+                    PageCount,
+                    &Buffer,
+                    0
+                    );
+  if (EFI_ERROR (Status)) {
+    FreePool (NcqPort);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (Buffer, EFI_PAGES_TO_SIZE (PageCount));
+
+  Bytes  = EFI_PAGES_TO_SIZE (PageCount);
+  Status = PciIo->Map (
+                    PciIo,
+                    EfiPciIoOperationBusMasterCommonBuffer,
+                    Buffer,
+                    &Bytes,
+                    &PciAddr,
+                    &NcqPort->Map
+                    );
+  if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (PageCount))) {
+    if (!EFI_ERROR (Status)) {
+      PciIo->Unmap (PciIo, NcqPort->Map);
+    }
+    PciIo->FreeBuffer (PciIo, PageCount, Buffer);
+    FreePool (NcqPort);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Capability = AhciReadReg (PciIo, EFI_AHCI_CAPABILITY_OFFSET);
+  if (((Capability & EFI_AHCI_CAP_S64A) == 0) && (PciAddr + Bytes > 0x100000000ULL)) {
+    PciIo->Unmap (PciIo, NcqPort->Map);
+    PciIo->FreeBuffer (PciIo, PageCount, Buffer);
+    FreePool (NcqPort);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NcqPort->CmdList             = Buffer;
+  NcqPort->CommandTable        = (AHCI_NCQ_COMMAND_TABLE *) ((UINTN) Buffer + AHCI_NCQ_MAX_TAGS * sizeof (EFI_AHCI_COMMAND_LIST));
+  NcqPort->CmdListPciAddr      = PciAddr;
+  NcqPort->CommandTablePciAddr = PciAddr + AHCI_NCQ_MAX_TAGS * sizeof (EFI_AHCI_COMMAND_LIST);
+  NcqPort->PageCount           = PageCount;
+  NcqPort->QueueDepth          = MIN (QueueDepth, AHCI_NCQ_MAX_TAGS);
+
+  AhciRegisters->NcqPort[Port] = NcqPort;
+  return EFI_SUCCESS;
+}
+
+/**
+  Point the port at its queued command list and start the command engine.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+  @param  Timeout            The timeout value of start, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR   The command engine can't be started.
+  @retval EFI_TIMEOUT        The operation is time out.
+  @retval EFI_SUCCESS        The port accepts queued commands.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqStartPort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port,
+  IN  UINT64                    Timeout
+  )
+{
+  EFI_STATUS                    Status;
+  AHCI_NCQ_PORT                 *NcqPort;
+  DATA_64                       Data64;
+  UINT32                        Offset;
+
+  NcqPort = AhciRegisters->NcqPort[Port];
+
+  //
+  // PxCLB may only be changed while the command engine is stopped.
+  //
+  Status = AhciStopCommand (PciIo, Port, Timeout);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Data64.Uint64 = NcqPort->CmdListPciAddr;
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLB;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Lower32);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLBU;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Upper32);
+
+  AhciClearPortStatus (PciIo, Port);
+
+  NcqPort->Running = TRUE;
+
+  Status = AhciEnableFisReceive (PciIo, Port, Timeout);
+  if (EFI_ERROR (Status)) {
+    AhciNcqStopPort (PciIo, AhciRegisters, Port);
+    return Status;
+  }
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+  AhciAndReg (PciIo, Offset, (UINT32)~(EFI_AHCI_PORT_CMD_DLAE | EFI_AHCI_PORT_CMD_ATAPI));
+  AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_CMD_ST);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Stop the queued commands of a port and hand the port back to the shared
+  command list. Any command still in flight is dropped by the HBA, and its
+  task is left in the tag map for the caller to complete.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqStopPort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port
+  )
+{
+  AHCI_NCQ_PORT                 *NcqPort;
+  DATA_64                       Data64;
+  UINT32                        Offset;
+
+  NcqPort = AhciRegisters->NcqPort[Port];
+  if ((NcqPort == NULL) || !NcqPort->Running) {
+    return;
+  }
+
+  AhciStopCommand (PciIo, Port, ATA_ATAPI_TIMEOUT);
+  AhciDisableFisReceive (PciIo, Port, ATA_ATAPI_TIMEOUT);
+
+  Data64.Uint64 = (UINTN) (AhciRegisters->AhciCmdListPciAddr);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLB;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Lower32);
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CLBU;
+  AhciWriteReg (PciIo, Offset, Data64.Uint32.Upper32);
+
+  NcqPort->Running = FALSE;
+}
+
+/**
+  Stop the queued commands of all ports, as done when the pending non-blocking
+  tasks are destroyed. The device is given the usual timeout to finish the
+  commands it already accepted, so it is not left with stale tags.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+
+**/
+VOID
+EFIAPI
+AhciNcqStopAllPorts (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters
+  )
+{
+  AHCI_NCQ_PORT                 *NcqPort;
+  UINT8                         Port;
+  UINT32                        Offset;
+
+  for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port++) {
+    NcqPort = AhciRegisters->NcqPort[Port];
+    if ((NcqPort == NULL) || !NcqPort->Running) {
+      continue;
+    }
+
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    AhciWaitMmioSet (PciIo, Offset, NcqPort->ActiveTags, 0, ATA_ATAPI_TIMEOUT);
+    AhciNcqStopPort (PciIo, AhciRegisters, Port);
+
+    //
+    // The tasks themselves are unmapped and completed by the caller.
+    //
+    ZeroMem (NcqPort->Task, sizeof (NcqPort->Task));
+    NcqPort->ActiveTags = 0;
+  }
+}
+
+/**
+  Free the Native Command Queuing contexts of all ports.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+
+**/
+VOID
+EFIAPI
+AhciNcqFreePorts (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters
+  )
+{
+  AHCI_NCQ_PORT                 *NcqPort;
+  UINT8                         Port;
+
+  for (Port = 0; Port < EFI_AHCI_MAX_PORTS; Port++) {
+    NcqPort = AhciRegisters->NcqPort[Port];
+    if (NcqPort == NULL) {
+      continue;
+    }
+
+    AhciNcqStopPort (PciIo, AhciRegisters, Port);
+    PciIo->Unmap (PciIo, NcqPort->Map);
+    PciIo->FreeBuffer (PciIo, NcqPort->PageCount, NcqPort->CmdList);
+    FreePool (NcqPort);
+    AhciRegisters->NcqPort[Port] = NULL;
+  }
+}
+
+/**
+  Fail the queued commands left in the tag map of a stopped port.
+
+  The buffer of each command is unmapped and its non-blocking task is removed
+  from the task list and signaled with an error status.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  NcqPort            The Native Command Queuing context of the port.
+
+**/
+VOID
+EFIAPI
+AhciNcqFailPortTasks (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  AHCI_NCQ_PORT             *NcqPort
+  )
+{
+  ATA_NONBLOCK_TASK             *Task;
+  UINT8                         Tag;
+
+  for (Tag = 0; Tag < AHCI_NCQ_MAX_TAGS; Tag++) {
+    Task = NcqPort->Task[Tag];
+    if (Task == NULL) {
+      continue;
+    }
+
+    NcqPort->Task[Tag] = NULL;
+    PciIo->Unmap (PciIo, Task->Map);
+    Task->Map = NULL;
+
+    //
+    // A blocking command never shares the port with other queued commands,
+    // and reports its own error.
+    //
+    if (Task->Event != NULL) {
+      Task->Packet->Asb->AtaStatus |= BIT0;
+      RemoveEntryList (&Task->Link);
+      gBS->SignalEvent (Task->Event);
+      FreePool (Task);
+    }
+  }
+
+  NcqPort->ActiveTags = 0;
+}
+
+/**
+  Reset a stopped port with a COMRESET.
+
+  The device drops all of its outstanding commands and sends a new D2H
+  register FIS once the link is re-established, which leaves it ready to
+  accept non-queued commands.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  Port               The number of port.
+
+  @retval EFI_TIMEOUT        The link or the device did not come back in time.
+  @retval EFI_SUCCESS        The port is reset and the device is ready.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqResetPort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  UINT8                     Port
+  )
+{
+  EFI_STATUS                    Status;
+  UINT32                        Offset;
+
+  //
+  // PxSCTL.DET must be held at 1 for at least 1ms to send the COMRESET.
+  //
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SCTL;
+  AhciAndReg (PciIo, Offset, EFI_AHCI_PORT_SCTL_MASK);
+  AhciOrReg (PciIo, Offset, EFI_AHCI_PORT_SCTL_DET_INIT);
+  MicroSecondDelay (1000);
+  AhciAndReg (PciIo, Offset, EFI_AHCI_PORT_SCTL_MASK);
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SSTS;
+  Status = AhciWaitMmioSet (
+             PciIo,
+             Offset,
+             EFI_AHCI_PORT_SSTS_DET_MASK,
+             EFI_AHCI_PORT_SSTS_DET_PCE,
+             EFI_TIMER_PERIOD_MILLISECONDS (EFI_AHCI_BUS_PHY_DETECT_TIMEOUT)
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The FIS receive engine has to run for the D2H register FIS to update
+  // PxTFD. As on initialization, the device is given up to 16s to clear BSY.
+  //
+  AhciEnableFisReceive (PciIo, Port, ATA_ATAPI_TIMEOUT);
+  AhciClearPortStatus (PciIo, Port);
+
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_TFD;
+  return AhciWaitMmioSet (
+           PciIo,
+           Offset,
+           EFI_AHCI_PORT_TFD_BSY | EFI_AHCI_PORT_TFD_DRQ,
+           0,
+           EFI_TIMER_PERIOD_SECONDS (16)
+           );
+}
+
+/**
+  Recover a port after a queued command failed.
+
+  The HBA stops processing on the error and the device aborts all of its
+  outstanding queued commands. They are failed before the device is taken
+  out of its error state by reading the NCQ Command Error log.
+
+  A device that timed out may not respond to the log read, or may still be
+  processing the queued commands. Its port is reset with a COMRESET instead,
+  which also clears the NCQ error state of the device.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+  @param  PortMultiplier     The number of port multiplier.
+  @param  TimedOut           Whether the failed command timed out.
+
+**/
+VOID
+EFIAPI
+AhciNcqRecoverPort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port,
+  IN  UINT8                     PortMultiplier,
+  IN  BOOLEAN                   TimedOut
+  )
+{
+  EFI_STATUS                    Status;
+  UINT8                         LogData[512];
+
+  AhciNcqStopPort (PciIo, AhciRegisters, Port);
+  AhciNcqFailPortTasks (PciIo, AhciRegisters->NcqPort[Port]);
+  AhciClearPortStatus (PciIo, Port);
+
+  if (TimedOut) {
+    Status = AhciNcqResetPort (PciIo, Port);
+    DEBUG ((DEBUG_ERROR, "AhciNcqRecoverPort: port %d reset after timeout - %r\n", Port, Status));
+    return;
+  }
+
+  Status = AhciReadLogExt (PciIo, AhciRegisters, Port, PortMultiplier, LogData, AHCI_NCQ_COMMAND_ERROR_LOG, 0);
+  DEBUG ((
+    DEBUG_ERROR,
+    "AhciNcqRecoverPort: port %d tag %d status 0x%x error 0x%x - %r\n",
+    Port,
+    LogData[0] & 0x1F,
+    LogData[2],
+    LogData[3],
+    Status
+    ));
+}
+
+/**
+  Start a queued (FPDMA) data transfer on specific port.
+
+  The command is issued on a free tag of the port, so several non-blocking
+  requests may be outstanding at the device at the same time.
+
+  @param[in]       Instance            The ATA_ATAPI_PASS_THRU_INSTANCE protocol instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The number of port multiplier.
+  @param[in]       Read                The transfer direction.
+  @param[in]       AtaCommandBlock     The EFI_ATA_COMMAND_BLOCK data.
+  @param[in, out]  AtaStatusBlock      The EFI_ATA_STATUS_BLOCK data.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       DataCount           The data count to be transferred.
+  @param[in]       Timeout             The timeout value of data transfer, uses 100ns as a unit.
+  @param[in]       Task                Optional. Pointer to the ATA_NONBLOCK_TASK
+                                       used by non-blocking mode.
+
+  @retval EFI_DEVICE_ERROR    The queued data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_NOT_READY       The command is queued or waits for a free tag.
+  @retval EFI_UNSUPPORTED     The port does not support Native Command Queuing.
+  @retval EFI_SUCCESS         The queued data transfer executes successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciFpdmaTransfer (
+  IN     ATA_ATAPI_PASS_THRU_INSTANCE *Instance,
+  IN     EFI_AHCI_REGISTERS           *AhciRegisters,
+  IN     UINT8                        Port,
+  IN     UINT8                        PortMultiplier,
+  IN     BOOLEAN                      Read,
+  IN     EFI_ATA_COMMAND_BLOCK        *AtaCommandBlock,
+  IN OUT EFI_ATA_STATUS_BLOCK         *AtaStatusBlock,
+  IN OUT VOID                         *MemoryAddr,
+  IN     UINT32                       DataCount,
+  IN     UINT64                       Timeout,
+  IN     ATA_NONBLOCK_TASK            *Task
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_PCI_IO_PROTOCOL           *PciIo;
+  AHCI_NCQ_PORT                 *NcqPort;
+  AHCI_NCQ_COMMAND_TABLE        *CommandTable;
+  EFI_AHCI_COMMAND_LIST         *CmdList;
+  EFI_AHCI_COMMAND_FIS          CFis;
+  ATA_NONBLOCK_TASK             BlockingTask;
+  EFI_PCI_IO_PROTOCOL_OPERATION Flag;
+  EFI_PHYSICAL_ADDRESS          PhyAddr;
+  UINTN                         MapLength;
+  VOID                          *Map;
+  UINT32                        PrdtNumber;
+  UINT32                        PrdtIndex;
+  UINT32                        RemainedData;
+  UINT64                        MemAddr;
+  DATA_64                       Data64;
+  UINT32                        FreeTags;
+  UINT32                        TagBit;
+  UINT8                         Tag;
+  UINT32                        PortBase;
+  UINT32                        PortIs;
+  UINT32                        PortTfd;
+  UINT32                        Pending;
+  EFI_TPL                       OldTpl;
+
+  PciIo   = Instance->PciIo;
+  NcqPort = AhciRegisters->NcqPort[Port];
+  if ((NcqPort == NULL) || (DataCount == 0) || (DataCount > AHCI_NCQ_MAX_DATA)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Task == NULL) {
+    //
+    // A blocking queued command is issued once all non-blocking tasks are
+    // finished, and then polled to completion like any other blocking command.
+    //
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    while (!IsListEmpty (&Instance->NonBlockingTaskList)) {
+      AsyncNonBlockingTransferRoutine (NULL, Instance);
+      //
+      // Stall for 100us.
+      //
+      MicroSecondDelay (100);
+    }
+
+    ZeroMem (&BlockingTask, sizeof (ATA_NONBLOCK_TASK));
+    BlockingTask.RetryTimes   = DivU64x32 (Timeout, 1000) + 1;
+    BlockingTask.InfiniteWait = (BOOLEAN) (Timeout == 0);
+    do {
+      Status = AhciFpdmaTransfer (
+                 Instance,
+                 AhciRegisters,
+                 Port,
+                 PortMultiplier,
+                 Read,
+                 AtaCommandBlock,
+                 AtaStatusBlock,
+                 MemoryAddr,
+                 DataCount,
+                 Timeout,
+                 &BlockingTask
+                 );
+      if (Status == EFI_NOT_READY) {
+        MicroSecondDelay (100);
+      }
+    } while (Status == EFI_NOT_READY);
+    gBS->RestoreTPL (OldTpl);
+
+    return Status;
+  }
+
+  PortBase = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH;
+
+  if (!Task->IsStart) {
+    //
+    // Leave the task unstarted while every tag is in use; it is retried on the
+    // next pass of the non-blocking task list.
+    //
+    FreeTags = ~NcqPort->ActiveTags & (UINT32) (LShiftU64 (1, NcqPort->QueueDepth) - 1);
+    if (FreeTags == 0) {
+      return EFI_NOT_READY;
+    }
+    Tag    = (UINT8) LowBitSet32 (FreeTags);
+    TagBit = (UINT32) BIT0 << Tag;
+
+    if (Read) {
+      Flag = EfiPciIoOperationBusMasterWrite;
+    } else {
+      Flag = EfiPciIoOperationBusMasterRead;
+    }
+
+    MapLength = DataCount;
+    Status = PciIo->Map (
+                      PciIo,
+                      Flag,
+                      MemoryAddr,
+                      &MapLength,
+                      &PhyAddr,
+                      &Map
+                      );
+    if (EFI_ERROR (Status) || (DataCount != MapLength)) {
+      if (!EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, Map);
+      }
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
+    if (!NcqPort->Running) {
+      Status = AhciNcqStartPort (PciIo, AhciRegisters, Port, Timeout);
+      if (EFI_ERROR (Status)) {
+        PciIo->Unmap (PciIo, Map);
+        return Status;
+      }
+    }
+
+    //
+    // The sector count is carried in the Features register by the caller; the
+    // tag goes to bits 7:3 of the Count register. Bit 7 of the Device register
+    // is FUA and bit 6 must be set.
+    //
+    AhciBuildCommandFis (&CFis, AtaCommandBlock);
+    CFis.AhciCFisPmNum       = PortMultiplier;
+    CFis.AhciCFisSecCount    = (UINT8) (Tag << 3);
+    CFis.AhciCFisSecCountExp = 0;
+    CFis.AhciCFisDevHead     = (UINT8) ((AtaCommandBlock->AtaDeviceHead & BIT7) | BIT6);
+
+    CommandTable = &NcqPort->CommandTable[Tag];
+    ZeroMem (CommandTable, sizeof (AHCI_NCQ_COMMAND_TABLE));
+    CopyMem (&CommandTable->CommandFis, &CFis, sizeof (EFI_AHCI_COMMAND_FIS));
+
+    PrdtNumber   = (DataCount + EFI_AHCI_MAX_DATA_PER_PRDT - 1) / EFI_AHCI_MAX_DATA_PER_PRDT;
+    RemainedData = DataCount;
+    MemAddr      = PhyAddr;
+    for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+      Data64.Uint64 = MemAddr;
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc  = MIN (RemainedData, EFI_AHCI_MAX_DATA_PER_PRDT) - 1;
+      RemainedData -= MIN (RemainedData, EFI_AHCI_MAX_DATA_PER_PRDT);
+      MemAddr      += EFI_AHCI_MAX_DATA_PER_PRDT;
+    }
+    CommandTable->PrdtTable[PrdtNumber - 1].AhciPrdtIoc = 1;
+
+    CmdList = &NcqPort->CmdList[Tag];
+    ZeroMem (CmdList, sizeof (EFI_AHCI_COMMAND_LIST));
+    CmdList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+    CmdList->AhciCmdW     = Read ? 0 : 1;
+    CmdList->AhciCmdPmp   = PortMultiplier;
+    CmdList->AhciCmdPrdtl = PrdtNumber;
+    Data64.Uint64 = NcqPort->CommandTablePciAddr + Tag * sizeof (AHCI_NCQ_COMMAND_TABLE);
+    CmdList->AhciCmdCtba  = Data64.Uint32.Lower32;
+    CmdList->AhciCmdCtbau = Data64.Uint32.Upper32;
+
+    //
+    // PxSACT must be set before PxCI. Both registers only take the bits written
+    // as one, so the other tags in flight are left untouched.
+    //
+    AhciWriteReg (PciIo, PortBase + EFI_AHCI_PORT_SACT, TagBit);
+    AhciWriteReg (PciIo, PortBase + EFI_AHCI_PORT_CI, TagBit);
+
+    NcqPort->ActiveTags |= TagBit;
+    NcqPort->Task[Tag]   = Task;
+    Task->Tag            = Tag;
+    Task->Map            = Map;
+    Task->IsStart        = TRUE;
+  }
+
+  //
+  // The device reports completion by clearing the tag in PxSACT through a Set
+  // Device Bits FIS; any error stops the whole queue.
+  //
+  TagBit  = (UINT32) BIT0 << Task->Tag;
+  PortIs  = AhciReadReg (PciIo, PortBase + EFI_AHCI_PORT_IS);
+  PortTfd = AhciReadReg (PciIo, PortBase + EFI_AHCI_PORT_TFD);
+  if (((PortIs & (EFI_AHCI_PORT_IS_TFES | EFI_AHCI_PORT_IS_HBFS | EFI_AHCI_PORT_IS_HBDS | EFI_AHCI_PORT_IS_IFS)) != 0) ||
+      ((PortTfd & EFI_AHCI_PORT_TFD_ERR) != 0)) {
+    Status = EFI_DEVICE_ERROR;
+  } else {
+    Pending  = AhciReadReg (PciIo, PortBase + EFI_AHCI_PORT_SACT);
+    Pending |= AhciReadReg (PciIo, PortBase + EFI_AHCI_PORT_CI);
+    if ((Pending & TagBit) == 0) {
+      Status = EFI_SUCCESS;
+    } else {
+      Task->RetryTimes--;
+      if (Task->InfiniteWait || (Task->RetryTimes != 0)) {
+        return EFI_NOT_READY;
+      }
+      Status = EFI_TIMEOUT;
+    }
+  }
+
+  if (AtaStatusBlock != NULL) {
+    ZeroMem (AtaStatusBlock, sizeof (EFI_ATA_STATUS_BLOCK));
+    AtaStatusBlock->AtaStatus = (UINT8) PortTfd;
+    if ((PortTfd & EFI_AHCI_PORT_TFD_ERR) != 0) {
+      AtaStatusBlock->AtaError = (UINT8) (PortTfd >> 8);
+    }
+  }
+
+  //
+  // The port stays in queued mode when its last tag completes. It is handed
+  // back to the shared command list only when a non-queued command needs it.
+  //
+  NcqPort->ActiveTags &= ~TagBit;
+  NcqPort->Task[Task->Tag] = NULL;
+  if (EFI_ERROR (Status)) {
+    if (AtaStatusBlock != NULL) {
+      AtaStatusBlock->AtaStatus |= BIT0;
+    }
+
+    //
+    // The port is stopped before the buffer is unmapped, as a timed out
+    // command may still be transferring data.
+    //
+    AhciNcqStopPort (PciIo, AhciRegisters, Port);
+  }
+
+  PciIo->Unmap (PciIo, Task->Map);
+  Task->Map = NULL;
+
+  //
+  // The other queued commands of the port are failed by the recovery, before
+  // it issues the command that reads the error log.
+  //
+  if (EFI_ERROR (Status)) {
+    AhciNcqRecoverPort (PciIo, AhciRegisters, Port, PortMultiplier, (BOOLEAN) (Status == EFI_TIMEOUT));
+  }
+
+  return Status;
+}
+
 /**
   Initialize ATA host controller at AHCI mode.
 
@@ -2793,6 +3489,23 @@ AhciModeInitialization (
           0,
           &Buffer
           );
+
+        //
+        // Prepare Native Command Queuing if both the HBA and the device support
+        // it (Word[76].BIT8). Word[75] holds the device queue depth minus one.
+        //
+        if (PcdGetBool (PcdAtaNcqEnable) &&
+      ((Capability & EFI_AHCI_CAP_SNCQ) != 0) &&
+            (Buffer.AtaData.serial_ata_capabilities != 0xFFFF) &&
+            ((Buffer.AtaData.serial_ata_capabilities & BIT8) != 0)) {
+          Status = AhciNcqCreatePort (
+                     PciIo,
+                     AhciRegisters,
+                     Port,
+                     MIN ((UINT32) (Buffer.AtaData.queue_depth & 0x1F) + 1, ((Capability & 0x1F00) >> 8) + 1)
+                     );
+          DEBUG ((DEBUG_INFO, "NCQ at port [%d] - %r\n", Port, Status));
+        }
       }
 
       //
@@ -13,6 +13,7 @@
 #define EFI_AHCI_CAPABILITY_OFFSET             0x0000
 #define   EFI_AHCI_CAP_SAM                     BIT18
 #define   EFI_AHCI_CAP_SSS                     BIT27
+#define   EFI_AHCI_CAP_SNCQ                    BIT30
 #define   EFI_AHCI_CAP_S64A                    BIT31
 #define EFI_AHCI_GHC_OFFSET                    0x0004
 #define   EFI_AHCI_GHC_RESET                   BIT0
@@ -61,6 +62,15 @@ typedef union {
 //
 #define EFI_AHCI_MAX_DATA_PER_PRDT             0x400000
 
+//
+// Native Command Queuing limits. A queued command uses a small per-tag command
+// table whose PRDT count covers the largest 48-bit transfer of 4K sectors.
+//
+#define AHCI_NCQ_MAX_TAGS                      32
+#define AHCI_NCQ_MAX_PRDT                      64
+#define AHCI_NCQ_MAX_DATA                      (AHCI_NCQ_MAX_PRDT * EFI_AHCI_MAX_DATA_PER_PRDT)
+#define AHCI_NCQ_COMMAND_ERROR_LOG             0x10
+
 #define EFI_AHCI_FIS_REGISTER_H2D              0x27      //Register FIS - Host to Device
 #define   EFI_AHCI_FIS_REGISTER_H2D_LENGTH     20
 #define EFI_AHCI_FIS_REGISTER_D2H              0x34      //Register FIS - Device to Host
@@ -287,6 +297,18 @@ typedef struct {
   UINT8    AhciUnknownFisRsvd[0x60];
 } EFI_AHCI_RECEIVED_FIS;
 
+//
+// Command table used by a queued command. It has the same layout as
+// EFI_AHCI_COMMAND_TABLE but a bounded scatter/gather list, and its size is a
+// multiple of the 128 byte alignment required for command tables.
+//
+typedef struct {
+  EFI_AHCI_COMMAND_FIS      CommandFis;
+  EFI_AHCI_ATAPI_COMMAND    AtapiCmd;
+  UINT8                     Reserved[0x30];
+  EFI_AHCI_COMMAND_PRDT     PrdtTable[AHCI_NCQ_MAX_PRDT];
+} AHCI_NCQ_COMMAND_TABLE;
+
 typedef struct {
   UINT8  Madt : 5;
   UINT8  Reserved_5 : 3;
@@ -298,6 +320,26 @@ typedef struct {
 
 #pragma pack()
 
+//
+// Per port Native Command Queuing context. Once a queued command is issued the
+// port's command list base points to CmdList instead of the command list
+// shared by all ports, and stays so until a non-queued command needs the port.
+// Each tag owns its slot and command table, and Task maps the tags in flight
+// to the tasks that issued them.
+//
+typedef struct {
+  EFI_AHCI_COMMAND_LIST     *CmdList;
+  AHCI_NCQ_COMMAND_TABLE    *CommandTable;
+  EFI_PHYSICAL_ADDRESS      CmdListPciAddr;
+  EFI_PHYSICAL_ADDRESS      CommandTablePciAddr;
+  UINTN                     PageCount;
+  VOID                      *Map;
+  UINT32                    QueueDepth;
+  UINT32                    ActiveTags;
+  struct _ATA_NONBLOCK_TASK *Task[AHCI_NCQ_MAX_TAGS];
+  BOOLEAN                   Running;
+} AHCI_NCQ_PORT;
+
 typedef struct {
   EFI_AHCI_RECEIVED_FIS     *AhciRFis;
   EFI_AHCI_COMMAND_LIST     *AhciCmdList;
@@ -311,6 +353,7 @@ typedef struct {
   VOID                      *MapRFis;
   VOID                      *MapCmdList;
   VOID                      *MapCommandTable;
+  AHCI_NCQ_PORT             *NcqPort[EFI_AHCI_MAX_PORTS];
 } EFI_AHCI_REGISTERS;
 
 /**
@@ -360,6 +403,75 @@ AhciStartCommand (
   IN  UINT64                    Timeout
   );
 
+/**
+  Allocate the Native Command Queuing context of a port.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+  @param  QueueDepth         The number of tags the port may keep in flight.
+
+  @retval EFI_OUT_OF_RESOURCES  The command list and tables can't be allocated.
+  @retval EFI_SUCCESS           The context is created.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciNcqCreatePort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port,
+  IN  UINT32                    QueueDepth
+  );
+
+/**
+  Stop the queued commands of a port and hand the port back to the shared
+  command list. Any command still in flight is dropped by the HBA, and its
+  task is left in the tag map for the caller to complete.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+  @param  Port               The number of port.
+
+**/
+VOID
+EFIAPI
+AhciNcqStopPort (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters,
+  IN  UINT8                     Port
+  );
+
+/**
+  Stop the queued commands of all ports, as done when the pending non-blocking
+  tasks are destroyed. The device is given the usual timeout to finish the
+  commands it already accepted, so it is not left with stale tags.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+
+**/
+VOID
+EFIAPI
+AhciNcqStopAllPorts (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters
+  );
+
+/**
+  Free the Native Command Queuing contexts of all ports.
+
+  @param  PciIo              The PCI IO protocol instance.
+  @param  AhciRegisters      The pointer to the EFI_AHCI_REGISTERS.
+
+**/
+VOID
+EFIAPI
+AhciNcqFreePorts (
+  IN  EFI_PCI_IO_PROTOCOL       *PciIo,
+  IN  EFI_AHCI_REGISTERS        *AhciRegisters
+  );
+
 /**
   Stop command running for giving port
 
@@ -98,7 +98,8 @@ ATA_ATAPI_PASS_THRU_INSTANCE gAtaAtapiPassThruInstanceTemplate = {
   {                   // NonBlocking TaskList
     NULL,
     NULL
-  }
+  },
+  NULL                // Exit boot service event
 };
 
 ATAPI_DEVICE_PATH    mAtapiDevicePathTemplate = {
@@ -284,6 +285,13 @@ AtaPassThruPassThruExecute (
         //
         PortMultiplierPort = 0;
       }
+      //
+      // A port left in queued mode is handed back to the shared command list
+      // before a non-queued command is issued to it.
+      //
+      if (Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) {
+        AhciNcqStopPort (Instance->PciIo, &Instance->AhciRegisters, (UINT8)Port);
+      }
       switch (Protocol) {
         case EFI_ATA_PASS_THRU_PROTOCOL_ATA_NON_DATA:
           Status = AhciNonDataTransfer (
@@ -367,6 +375,37 @@ AtaPassThruPassThruExecute (
                      Task
                      );
           break;
+        case EFI_ATA_PASS_THRU_PROTOCOL_FPDMA:
+          if (Packet->InTransferLength != 0) {
+            Status = AhciFpdmaTransfer (
+                       Instance,
+                       &Instance->AhciRegisters,
+                       (UINT8)Port,
+                       (UINT8)PortMultiplierPort,
+                       TRUE,
+                       Packet->Acb,
+                       Packet->Asb,
+                       Packet->InDataBuffer,
+                       Packet->InTransferLength,
+                       Packet->Timeout,
+                       Task
+                       );
+          } else {
+            Status = AhciFpdmaTransfer (
+                       Instance,
+                       &Instance->AhciRegisters,
+                       (UINT8)Port,
+                       (UINT8)PortMultiplierPort,
+                       FALSE,
+                       Packet->Acb,
+                       Packet->Asb,
+                       Packet->OutDataBuffer,
+                       Packet->OutTransferLength,
+                       Packet->Timeout,
+                       Task
+                       );
+          }
+          break;
         default :
           return EFI_UNSUPPORTED;
       }
@@ -400,19 +439,29 @@ AsyncNonBlockingTransferRoutine (
   ATA_NONBLOCK_TASK            *Task;
   EFI_STATUS                   Status;
   ATA_ATAPI_PASS_THRU_INSTANCE *Instance;
+  AHCI_NCQ_PORT                *NcqPort;
 
   Instance   = (ATA_ATAPI_PASS_THRU_INSTANCE *) Context;
   EntryHeader = &Instance->NonBlockingTaskList;
   //
   // Get the Tasks from the Tasks List and execute it, until there is
   // no task in the list or the device is busy with task (EFI_NOT_READY).
+  // A queued (FPDMA) command that has been issued doesn't hold up the tasks
+  // behind it, so that several of them are outstanding at the device.
   //
-  while (TRUE) {
-    if (!IsListEmpty (EntryHeader)) {
-      Entry = GetFirstNode (EntryHeader);
-      Task  = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
-    } else {
-      return;
+  Entry = GetFirstNode (EntryHeader);
+  while (!IsNull (EntryHeader, Entry)) {
+    Task = ATA_NON_BLOCK_TASK_FROM_ENTRY (Entry);
+
+    //
+    // Other commands can't be issued to a port with queued commands in flight.
+    //
+    if ((Instance->Mode == EfiAtaAhciMode) && !Task->IsStart &&
+        (Task->Packet->Protocol != EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+      NcqPort = Instance->AhciRegisters.NcqPort[Task->Port];
+      if ((NcqPort != NULL) && (NcqPort->ActiveTags != 0)) {
+        break;
+      }
     }
 
     Status = AtaPassThruPassThruExecute (
@@ -423,6 +472,19 @@ AsyncNonBlockingTransferRoutine (
                Task
                );
 
+    //
+    // A failed queued command has already failed the other queued commands of
+    // its port, so only its own task is completed with error status.
+    //
+    if ((Status != EFI_NOT_READY) && (Status != EFI_SUCCESS) &&
+        (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+      Task->Packet->Asb->AtaStatus |= BIT0;
+      Entry = RemoveEntryList (&Task->Link);
+      gBS->SignalEvent (Task->Event);
+      FreePool (Task);
+      continue;
+    }
+
     //
     // If the data transfer meet a error, remove all tasks in the list since these tasks are
     // associated with one task from Ata Bus and signal the event with error status.
@@ -437,15 +499,42 @@ AsyncNonBlockingTransferRoutine (
     // is not finished yet. Otherwise the operation is successful.
     //
     if (Status == EFI_NOT_READY) {
+      if (Task->IsStart && (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA)) {
+        Entry = GetNextNode (EntryHeader, Entry);
+        continue;
+      }
       break;
     } else {
-      RemoveEntryList (&Task->Link);
+      Entry = RemoveEntryList (&Task->Link);
       gBS->SignalEvent (Task->Event);
       FreePool (Task);
     }
   }
 }
 
+/**
+  Hand the ports left in queued mode back to the shared command list at
+  ExitBootServices(), so that the HBA stops using boot services memory.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the ATA_ATAPI_PASS_THRU_INSTANCE.
+
+**/
+VOID
+EFIAPI
+AtaAtapiPassThruExitBootServices (
+  EFI_EVENT  Event,
+  VOID*      Context
+  )
+{
+  ATA_ATAPI_PASS_THRU_INSTANCE *Instance;
+
+  Instance = (ATA_ATAPI_PASS_THRU_INSTANCE *) Context;
+  if (Instance->Mode == EfiAtaAhciMode) {
+    AhciNcqStopAllPorts (Instance->PciIo, &Instance->AhciRegisters);
+  }
+}
+
 /**
   The Entry Point of module.
 
@@ -789,6 +878,17 @@ AtaAtapiPassThruStart (
     goto ErrorExit;
   }
 
+  Status = gBS->CreateEvent (
+                  EVT_SIGNAL_EXIT_BOOT_SERVICES,
+                  TPL_NOTIFY,
+                  AtaAtapiPassThruExitBootServices,
+                  Instance,
+                  &Instance->ExitBootServiceEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ErrorExit;
+  }
+
   //
   // Enumerate all inserted ATA devices.
   //
@@ -821,6 +921,10 @@ ErrorExit:
     gBS->CloseEvent (Instance->TimerEvent);
   }
 
+  if ((Instance != NULL) && (Instance->ExitBootServiceEvent != NULL)) {
+    gBS->CloseEvent (Instance->ExitBootServiceEvent);
+  }
+
   if (Instance != NULL) {
     //
     // Remove all inserted ATA devices.
@@ -917,6 +1021,10 @@ AtaAtapiPassThruStop (
     gBS->CloseEvent (Instance->TimerEvent);
     Instance->TimerEvent = NULL;
   }
+  if (Instance->ExitBootServiceEvent != NULL) {
+    gBS->CloseEvent (Instance->ExitBootServiceEvent);
+    Instance->ExitBootServiceEvent = NULL;
+  }
   DestroyAsynTaskList (Instance, FALSE);
   //
   // Free allocated resource
@@ -941,6 +1049,7 @@ AtaAtapiPassThruStop (
   //
   if (Instance->Mode == EfiAtaAhciMode) {
     AhciRegisters = &Instance->AhciRegisters;
+    AhciNcqFreePorts (PciIo, AhciRegisters);
     PciIo->Unmap (
              PciIo,
              AhciRegisters->MapCommandTable
@@ -1139,6 +1248,13 @@ DestroyAsynTaskList (
   EFI_TPL              OldTpl;
 
   OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  //
+  // Stop the queued commands before the buffers of their tasks are unmapped.
+  //
+  if (Instance->Mode == EfiAtaAhciMode) {
+    AhciNcqStopAllPorts (Instance->PciIo, &Instance->AhciRegisters);
+  }
+
   if (!IsListEmpty (&Instance->NonBlockingTaskList)) {
     //
     // Free the Subtask list.
@@ -1151,6 +1267,10 @@ DestroyAsynTaskList (
       Task     = ATA_NON_BLOCK_TASK_FROM_ENTRY (DelEntry);
 
       RemoveEntryList (DelEntry);
+      if (Task->IsStart && (Task->Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) &&
+          (Task->Map != NULL)) {
+        Instance->PciIo->Unmap (Instance->PciIo, Task->Map);
+      }
       if (IsSigEvent) {
         Task->Packet->Asb->AtaStatus = 0x01;
         gBS->SignalEvent (Task->Event);
@@ -1357,6 +1477,22 @@ AtaPassThruPassThru (
     return EFI_BAD_BUFFER_SIZE;
   }
 
+  //
+  // Queued commands are only available on AHCI ports that were set up for
+  // Native Command Queuing. Report it before anything is queued so that the
+  // caller can fall back to ordinary DMA commands.
+  //
+  if (Packet->Protocol == EFI_ATA_PASS_THRU_PROTOCOL_FPDMA) {
+    if ((Instance->Mode != EfiAtaAhciMode) ||
+        ((PortMultiplierPort != 0xFFFF) && (PortMultiplierPort != 0)) ||
+        (Instance->AhciRegisters.NcqPort[Port] == NULL) ||
+        ((Packet->InTransferLength == 0) && (Packet->OutTransferLength == 0)) ||
+        (Packet->InTransferLength > AHCI_NCQ_MAX_DATA) ||
+        (Packet->OutTransferLength > AHCI_NCQ_MAX_DATA)) {
+      return EFI_UNSUPPORTED;
+    }
+  }
+
   //
   // For non-blocking mode, queue the Task into the list.
   //
@@ -1385,6 +1521,22 @@ AtaPassThruPassThru (
 
     return EFI_SUCCESS;
   } else {
+    //
+    // A blocking command can't be issued while queued commands are in flight
+    // on the port, so finish the non-blocking tasks first.
+    //
+    if ((Instance->Mode == EfiAtaAhciMode) && (Instance->AhciRegisters.NcqPort[Port] != NULL)) {
+      OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+      while (Instance->AhciRegisters.NcqPort[Port]->ActiveTags != 0) {
+        AsyncNonBlockingTransferRoutine (NULL, Instance);
+        //
+        // Stall for 100us.
+        //
+        MicroSecondDelay (100);
+      }
+      gBS->RestoreTPL (OldTpl);
+    }
+
     return AtaPassThruPassThruExecute (
              Port,
              PortMultiplierPort,
@@ -324,6 +324,17 @@ IdentifyAtaDevice (
     }
   }
 
+  //
+  // Check whether Native Command Queuing is supported (Word[76].BIT8). It is
+  // used for non-blocking transfers as long as the ATA pass through instance
+  // accepts queued commands for the device.
+  //
+  if (AtaDevice->UdmaValid &&
+      (IdentifyData->serial_ata_capabilities != 0xFFFF) &&
+      ((IdentifyData->serial_ata_capabilities & BIT8) != 0)) {
+    AtaDevice->NcqValid = TRUE;
+  }
+
   Capacity = GetAtapi6Capacity (AtaDevice);
   if (Capacity > MAX_28BIT_ADDRESSING_CAPACITY) {
     //
@@ -435,6 +446,77 @@ DiscoverAtaDevice (
   return Status;
 }
 
+/**
+  Transfer data from/to ATA device with a queued (FPDMA) command.
+
+  The transfer is issued as READ/WRITE FPDMA QUEUED, so that the sub tasks of
+  non-blocking requests may be outstanding at the device together. The tag is
+  assigned by the ATA pass through instance.
+
+  @param[in, out]  AtaDevice       The ATA child device involved for the operation.
+  @param[in, out]  TaskPacket      Pointer to a Pass Thru Command Packet of the
+                                   non-blocking sub task.
+  @param[in, out]  Buffer          The pointer to the current transaction buffer.
+  @param[in]       StartLba        The starting logical block address to be accessed.
+  @param[in]       TransferLength  The block number or sector count of the transfer.
+  @param[in]       IsWrite         Indicates whether it is a write operation.
+  @param[in]       Event           Event to be signaled when the request is completed.
+
+  @retval EFI_SUCCESS       The data transfer is queued successfully.
+  @retval EFI_UNSUPPORTED   The ATA pass through instance doesn't accept queued
+                            commands for the device.
+  @return others            Some error occurs when transferring data.
+
+**/
+EFI_STATUS
+TransferAtaDeviceQueued (
+  IN OUT ATA_DEVICE                       *AtaDevice,
+  IN OUT EFI_ATA_PASS_THRU_COMMAND_PACKET *TaskPacket,
+  IN OUT VOID                             *Buffer,
+  IN EFI_LBA                              StartLba,
+  IN UINT32                               TransferLength,
+  IN BOOLEAN                              IsWrite,
+  IN EFI_EVENT                            Event
+  )
+{
+  EFI_ATA_COMMAND_BLOCK             *Acb;
+  EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+
+  //
+  // Queued commands always use 48-bit addressing and carry the sector count
+  // in the Features register.
+  //
+  Acb = ZeroMem (&AtaDevice->Acb, sizeof (EFI_ATA_COMMAND_BLOCK));
+  Acb->AtaCommand         = IsWrite ? ATA_CMD_WRITE_FPDMA_QUEUED : ATA_CMD_READ_FPDMA_QUEUED;
+  Acb->AtaFeatures        = (UINT8) TransferLength;
+  Acb->AtaFeaturesExp     = (UINT8) (TransferLength >> 8);
+  Acb->AtaSectorNumber    = (UINT8) StartLba;
+  Acb->AtaCylinderLow     = (UINT8) RShiftU64 (StartLba, 8);
+  Acb->AtaCylinderHigh    = (UINT8) RShiftU64 (StartLba, 16);
+  Acb->AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
+  Acb->AtaCylinderLowExp  = (UINT8) RShiftU64 (StartLba, 32);
+  Acb->AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
+  Acb->AtaDeviceHead      = BIT6;
+
+  Packet = ZeroMem (TaskPacket, sizeof (EFI_ATA_PASS_THRU_COMMAND_PACKET));
+  if (IsWrite) {
+    Packet->OutDataBuffer     = Buffer;
+    Packet->OutTransferLength = TransferLength;
+  } else {
+    Packet->InDataBuffer     = Buffer;
+    Packet->InTransferLength = TransferLength;
+  }
+
+  Packet->Protocol = EFI_ATA_PASS_THRU_PROTOCOL_FPDMA;
+  Packet->Length   = EFI_ATA_PASS_THRU_LENGTH_SECTOR_COUNT;
+  //
+  // Use the same timeout as a DMA transfer.
+  //
+  Packet->Timeout  = EFI_TIMER_PERIOD_SECONDS (DivU64x32 (MultU64x32 (TransferLength, AtaDevice->BlockMedia.BlockSize), 2100000) + 31);
+
+  return AtaDevicePassThru (AtaDevice, TaskPacket, Event);
+}
+
 /**
   Transfer data from ATA device.
 
@@ -455,7 +537,9 @@ DiscoverAtaDevice (
                                    If Event is not NULL and non-blocking I/O is
                                    supported,then non-blocking I/O is performed,
                                    and Event will be signaled when the write
-                                   request is completed.
+                                   request is completed. Non-blocking transfers
+                                   use queued (FPDMA) commands when the device
+                                   supports Native Command Queuing.
 
   @retval EFI_SUCCESS       The data transfer is complete successfully.
   @return others            Some error occurs when transferring data.
@@ -474,6 +558,23 @@ TransferAtaDevice (
 {
   EFI_ATA_COMMAND_BLOCK             *Acb;
   EFI_ATA_PASS_THRU_COMMAND_PACKET  *Packet;
+  EFI_STATUS                        Status;
+
+  if ((TaskPacket != NULL) && AtaDevice->NcqValid) {
+    Status = TransferAtaDeviceQueued (AtaDevice, TaskPacket, Buffer, StartLba, TransferLength, IsWrite, Event);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+    //
+    // The ATA pass through instance doesn't accept queued commands for this
+    // device, use ordinary DMA commands from now on.
+    //
+    AtaDevice->NcqValid = FALSE;
+    FreeAlignedBuffer (TaskPacket->Asb, sizeof (EFI_ATA_STATUS_BLOCK));
+    if (TaskPacket->Acb != NULL) {
+      FreePool (TaskPacket->Acb);
+    }
+  }
 
   //
   // Ensure AtaDevice->UdmaValid, AtaDevice->Lba48Bit and IsWrite are valid boolean values
@@ -807,7 +908,12 @@ AccessAtaDevice(
   if ((Token != NULL) && (Token->Event != NULL)) {
     OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
-    if (!IsListEmpty (&AtaDevice->AtaSubTaskList)) {
+    //
+    // Without Native Command Queuing a request waits until the sub tasks of the
+    // previous one are done. Queued requests are submitted right away so that
+    // the device sees several of them at once.
+    //
+    if (!AtaDevice->NcqValid && !IsListEmpty (&AtaDevice->AtaSubTaskList)) {
       AtaTask = AllocateZeroPool (sizeof (ATA_BUS_ASYN_TASK));
       if (AtaTask == NULL) {
         gBS->RestoreTPL (OldTpl);
@@ -672,7 +672,7 @@ ProcessAsyncTaskList (
     }
 
     Private->CqHdbl[QueueId].Cqh++;
-    if (Private->CqHdbl[QueueId].Cqh > MIN (NVME_ASYNC_CCQ_SIZE, Private->Cap.Mqes)) {
+    if (Private->CqHdbl[QueueId].Cqh > Private->AsyncCqSize) {
       Private->CqHdbl[QueueId].Cqh = 0;
       Private->Pt[QueueId] ^= 1;
     }
@@ -904,6 +904,7 @@ NvmExpressDriverBindingStart (
   UINT32                              NamespaceId;
   EFI_PHYSICAL_ADDRESS                MappedAddr;
   UINTN                               Bytes;
+  UINT16                              QueueDepth;
   EFI_NVM_EXPRESS_PASS_THRU_PROTOCOL  *Passthru;
 
   DEBUG ((EFI_D_INFO, "NvmExpressDriverBindingStart: start\n"));
@@ -950,21 +951,29 @@ NvmExpressDriverBindingStart (
     }
 
     //
-    // 6 x 4kB aligned buffers will be carved out of this buffer.
+    // 4kB aligned buffers will be carved out of this buffer.
     // 1st 4kB boundary is the start of the admin submission queue.
     // 2nd 4kB boundary is the start of the admin completion queue.
     // 3rd 4kB boundary is the start of I/O submission queue #1.
     // 4th 4kB boundary is the start of I/O completion queue #1.
     // 5th 4kB boundary is the start of I/O submission queue #2.
-    // 6th 4kB boundary is the start of I/O completion queue #2.
+    // I/O completion queue #2 follows I/O submission queue #2.
     //
-    // Allocate 6 pages of memory, then map it for bus master read and write.
+    QueueDepth = PcdGet16 (PcdNvmExpressIoQueueDepth);
+    QueueDepth = MAX (QueueDepth, NVME_ASYNC_MIN_QUEUE_DEPTH);
+    QueueDepth = MIN (QueueDepth, NVME_ASYNC_MAX_QUEUE_DEPTH);
+    Private->AsyncSqPages = NVME_ASYNC_SQ_PAGES (QueueDepth);
+    Private->AsyncCqPages = NVME_ASYNC_CQ_PAGES (QueueDepth);
+    Private->BufferPages  = 4 + Private->AsyncSqPages + Private->AsyncCqPages;
+
+    //
+    // Allocate the pages of memory, then map it for bus master read and write.
     //
     Status = PciIo->AllocateBuffer (
                       PciIo,
                       AllocateAnyPages,
                       EfiBootServicesData,
-                      6,
+                      Private->BufferPages,
                       (VOID**)&Private->Buffer,
                       0
                       );
@@ -972,7 +981,7 @@ NvmExpressDriverBindingStart (
       goto Exit;
     }
 
-    Bytes = EFI_PAGES_TO_SIZE (6);
+    Bytes = EFI_PAGES_TO_SIZE (Private->BufferPages);
     Status = PciIo->Map (
                       PciIo,
                       EfiPciIoOperationBusMasterCommonBuffer,
@@ -982,7 +991,7 @@ NvmExpressDriverBindingStart (
                       &Private->Mapping
                       );
 
-    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (6))) {
+    if (EFI_ERROR (Status) || (Bytes != EFI_PAGES_TO_SIZE (Private->BufferPages))) {
       goto Exit;
     }
 
@@ -1093,7 +1102,7 @@ Exit:
   }
 
   if ((Private != NULL) && (Private->Buffer != NULL)) {
-    PciIo->FreeBuffer (PciIo, 6, Private->Buffer);
+    PciIo->FreeBuffer (PciIo, Private->BufferPages, Private->Buffer);
   }
 
   if ((Private != NULL) && (Private->ControllerData != NULL)) {
@@ -1216,7 +1225,7 @@ NvmExpressDriverBindingStop (
       }
 
       if (Private->Buffer != NULL) {
-        Private->PciIo->FreeBuffer (Private->PciIo, 6, Private->Buffer);
+        Private->PciIo->FreeBuffer (Private->PciIo, Private->BufferPages, Private->Buffer);
       }
 
       FreePool (Private->ControllerData);
@@ -40,6 +40,7 @@
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PcdLib.h>
 
 typedef struct _NVME_CONTROLLER_PRIVATE_DATA NVME_CONTROLLER_PRIVATE_DATA;
 typedef struct _NVME_DEVICE_PRIVATE_DATA     NVME_DEVICE_PRIVATE_DATA;
@@ -63,15 +64,14 @@ extern EFI_DRIVER_SUPPORTED_EFI_VERSION_PROTOCOL  gNvmExpressDriverSupportedEfiV
 #define NVME_CCQ_SIZE                             1     // Number of I/O completion queue entries, which is 0-based
 
 //
-// Number of asynchronous I/O submission queue entries, which is 0-based.
-// The asynchronous I/O submission queue size is 4kB in total.
+// Limits of the number of asynchronous I/O queue entries configured by
+// PcdNvmExpressIoQueueDepth. The asynchronous I/O completion queue is at
+// least 4kB, so it keeps its 256 entries for smaller submission queues.
 //
-#define NVME_ASYNC_CSQ_SIZE                       63
-//
-// Number of asynchronous I/O completion queue entries, which is 0-based.
-// The asynchronous I/O completion queue size is 4kB in total.
-//
-#define NVME_ASYNC_CCQ_SIZE                       255
+#define NVME_ASYNC_MIN_QUEUE_DEPTH                2
+#define NVME_ASYNC_MAX_QUEUE_DEPTH                4096
+#define NVME_ASYNC_SQ_PAGES(Depth)                EFI_SIZE_TO_PAGES ((Depth) * sizeof (NVME_SQ))
+#define NVME_ASYNC_CQ_PAGES(Depth)                EFI_SIZE_TO_PAGES ((Depth) * sizeof (NVME_CQ))
 
 #define NVME_MAX_QUEUES                           3     // Number of queues supported by the driver
 
@@ -116,16 +116,27 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   NVME_ADMIN_CONTROLLER_DATA          *ControllerData;
 
   //
-  // 6 x 4kB aligned buffers will be carved out of this buffer.
+  // 4kB aligned buffers will be carved out of this buffer.
   // 1st 4kB boundary is the start of the admin submission queue.
   // 2nd 4kB boundary is the start of the admin completion queue.
   // 3rd 4kB boundary is the start of I/O submission queue #1.
   // 4th 4kB boundary is the start of I/O completion queue #1.
-  // 5th 4kB boundary is the start of I/O submission queue #2.
-  // 6th 4kB boundary is the start of I/O completion queue #2.
+  // 5th 4kB boundary is the start of I/O submission queue #2, which takes
+  // AsyncSqPages pages.
+  // The following AsyncCqPages pages are I/O completion queue #2.
   //
   UINT8                               *Buffer;
   UINT8                               *BufferPciAddr;
+  UINTN                               BufferPages;
+  UINTN                               AsyncSqPages;
+  UINTN                               AsyncCqPages;
+
+  //
+  // Number of asynchronous I/O submission & completion queue entries, which
+  // are 0-based.
+  //
+  UINT16                              AsyncSqSize;
+  UINT16                              AsyncCqSize;
 
   //
   // Pointers to 4kB aligned submission & completion queues.
@@ -742,4 +753,43 @@ NvmeUnregisterShutdownNotification (
   VOID
   );
 
+/**
+  Call back function when the timer event is signaled.
+
+  @param[in]  Event     The Event this notify function registered to.
+  @param[in]  Context   Pointer to the context data registered to the
+                        Event.
+
+**/
+VOID
+EFIAPI
+ProcessAsyncTaskList (
+  IN EFI_EVENT                    Event,
+  IN VOID*                        Context
+  );
+
+/**
+  Read or write a range of blocks that needs several commands through the
+  asynchronous I/O queue, so that all the commands are in flight at the same
+  time, and wait for the whole transfer to complete.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer to transfer the data from or to.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  IsRead                 TRUE to read from the device, FALSE to write to it.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeTransferMultipleCommands (
+  IN     NVME_DEVICE_PRIVATE_DATA       *Device,
+  IN OUT VOID                           *Buffer,
+  IN     UINT64                         Lba,
+  IN     UINTN                          Blocks,
+  IN     BOOLEAN                        IsRead
+  );
+
 #endif
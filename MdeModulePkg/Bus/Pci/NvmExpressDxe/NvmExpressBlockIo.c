@@ -195,7 +195,17 @@ NvmeRead (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Keep all the commands of a large transfer in flight at the same time.
+    //
+    Status = NvmeTransferMultipleCommands (Device, Buffer, Lba, Blocks, TRUE);
+    if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while (Blocks > 0 && !EFI_ERROR (Status)) {
     if (Blocks > MaxTransferBlocks) {
       Status = ReadSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -273,7 +283,17 @@ NvmeWrite (
     MaxTransferBlocks = 1024;
   }
 
-  while (Blocks > 0) {
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Keep all the commands of a large transfer in flight at the same time.
+    //
+    Status = NvmeTransferMultipleCommands (Device, Buffer, Lba, Blocks, FALSE);
+    if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while (Blocks > 0 && !EFI_ERROR (Status)) {
     if (Blocks > MaxTransferBlocks) {
       Status = WriteSectors (Device, (UINT64)(UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -923,6 +943,64 @@ NvmeAsyncWrite (
   return Status;
 }
 
+/**
+  Read or write a range of blocks that needs several commands through the
+  asynchronous I/O queue, so that all the commands are in flight at the same
+  time, and wait for the whole transfer to complete.
+
+  The commands complete through the same path as BlockIo2 requests. Instead of
+  waiting for the timer, the completion queue is polled until the transfer is
+  done.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer to transfer the data from or to.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be transferred.
+  @param  IsRead                 TRUE to read from the device, FALSE to write to it.
+
+  @retval EFI_SUCCESS            Datum are transferred.
+  @retval Others                 Fail to transfer all the datum.
+
+**/
+EFI_STATUS
+NvmeTransferMultipleCommands (
+  IN     NVME_DEVICE_PRIVATE_DATA       *Device,
+  IN OUT VOID                           *Buffer,
+  IN     UINT64                         Lba,
+  IN     UINTN                          Blocks,
+  IN     BOOLEAN                        IsRead
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_BLOCK_IO2_TOKEN              Token;
+  EFI_TPL                          OldTpl;
+
+  Status = gBS->CreateEvent (0, TPL_NOTIFY, NULL, NULL, &Token.Event);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Token.TransactionStatus = EFI_SUCCESS;
+
+  if (IsRead) {
+    Status = NvmeAsyncRead (Device, Buffer, Lba, Blocks, &Token);
+  } else {
+    Status = NvmeAsyncWrite (Device, Buffer, Lba, Blocks, &Token);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    while (gBS->CheckEvent (Token.Event) == EFI_NOT_READY) {
+      OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+      ProcessAsyncTaskList (NULL, Device->Controller);
+      gBS->RestoreTPL (OldTpl);
+    }
+    Status = Token.TransactionStatus;
+  }
+
+  gBS->CloseEvent (Token.Event);
+
+  return Status;
+}
+
 /**
   Reset the Block Device.
 
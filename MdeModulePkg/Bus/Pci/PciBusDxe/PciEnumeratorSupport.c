@@ -471,6 +471,7 @@ GatherDeviceInfo (
   UINTN                           Offset;
   UINTN                           BarIndex;
   PCI_IO_DEVICE                   *PciIoDevice;
+  PCI_BAR_PROBE                   Probe;
 
   PciIoDevice = CreatePciIoDevice (
                   Bridge,
@@ -496,8 +497,9 @@ GatherDeviceInfo (
   //
   // Start to parse the bars
   //
+  PciProbeBars (PciIoDevice, 0x10, PCI_MAX_BAR, &Probe);
   for (Offset = 0x10, BarIndex = 0; Offset <= 0x24 && BarIndex < PCI_MAX_BAR; BarIndex++) {
-    Offset = PciParseBar (PciIoDevice, Offset, BarIndex);
+    Offset = PciParseBar (PciIoDevice, Offset, BarIndex, &Probe);
   }
 
   //
@@ -546,6 +548,7 @@ GatherPpbInfo (
   UINT32                          PMemBaseLimit;
   UINT16                          PrefetchableMemoryBase;
   UINT16                          PrefetchableMemoryLimit;
+  PCI_BAR_PROBE                   Probe;
 
   PciIoDevice = CreatePciIoDevice (
                   Bridge,
@@ -572,11 +575,12 @@ GatherPpbInfo (
   //
   // PPB can have two BARs
   //
-  if (PciParseBar (PciIoDevice, 0x10, PPB_BAR_0) == 0x14) {
+  PciProbeBars (PciIoDevice, 0x10, 2, &Probe);
+  if (PciParseBar (PciIoDevice, 0x10, PPB_BAR_0, &Probe) == 0x14) {
     //
     // Not 64-bit bar
     //
-    PciParseBar (PciIoDevice, 0x14, PPB_BAR_1);
+    PciParseBar (PciIoDevice, 0x14, PPB_BAR_1, &Probe);
   }
 
   PciIo = &PciIoDevice->PciIo;
@@ -725,7 +729,7 @@ GatherP2CInfo (
   //
   // P2C only has one bar that is in 0x10
   //
-  PciParseBar (PciIoDevice, 0x10, P2C_BAR_0);
+  PciParseBar (PciIoDevice, 0x10, P2C_BAR_0, NULL);
 
   //
   // Read PciBar information from the bar register
@@ -1747,12 +1751,132 @@ PciIovParseVfBar (
   return Offset + 4;
 }
 
+/**
+  Size a run of adjacent BARs with one config read, one write of all ones,
+  one read back and one restore, instead of four accesses per BAR. Only the
+  BARs that do not read back their original value are restored, so BARs that
+  the function does not implement cost three accesses instead of four.
+
+  @param PciIoDevice  Pci device instance.
+  @param Offset       Offset of the first BAR.
+  @param Count        Number of BARs to size, at most PCI_MAX_BAR.
+  @param Probe        Returned original and sized values of the BARs.
+
+**/
+VOID
+PciProbeBars (
+  IN  PCI_IO_DEVICE  *PciIoDevice,
+  IN  UINTN          Offset,
+  IN  UINTN          Count,
+  OUT PCI_BAR_PROBE  *Probe
+  )
+{
+  EFI_PCI_IO_PROTOCOL *PciIo;
+  UINT32              AllOne[PCI_MAX_BAR];
+  EFI_TPL             OldTpl;
+  UINTN               First;
+  UINTN               Last;
+
+  ASSERT (Count <= PCI_MAX_BAR);
+
+  PciIo = &PciIoDevice->PciIo;
+  SetMem32 (AllOne, sizeof (AllOne), 0xFFFFFFFF);
+  Probe->Offset = Offset;
+  Probe->Count  = Count;
+
+  //
+  // Preserve the original values
+  //
+  PciIo->Pci.Read (PciIo, EfiPciIoWidthUint32, (UINT32) Offset, Count, Probe->OriginalValue);
+
+  //
+  // Raise TPL to high level to disable timer interrupt while the BARs are probed
+  //
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+
+  PciIo->Pci.Write (PciIo, EfiPciIoWidthUint32, (UINT32) Offset, Count, AllOne);
+  PciIo->Pci.Read (PciIo, EfiPciIoWidthUint32, (UINT32) Offset, Count, Probe->Value);
+
+  //
+  // Write back the original values of the BARs that changed
+  //
+  for (First = 0; First < Count; First++) {
+    if (Probe->Value[First] != Probe->OriginalValue[First]) {
+      break;
+    }
+  }
+
+  for (Last = Count; Last > First; Last--) {
+    if (Probe->Value[Last - 1] != Probe->OriginalValue[Last - 1]) {
+      break;
+    }
+  }
+
+  if (Last > First) {
+    PciIo->Pci.Write (
+                 PciIo,
+                 EfiPciIoWidthUint32,
+                 (UINT32) (Offset + First * sizeof (UINT32)),
+                 Last - First,
+                 &Probe->OriginalValue[First]
+                 );
+  }
+
+  //
+  // Restore TPL to its original level
+  //
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  Check whether the bar is existed or not, taking its values from a
+  PciProbeBars() result when the bar was sized there.
+
+  @param PciIoDevice       A pointer to the PCI_IO_DEVICE.
+  @param Probe             Optional BAR values sized by PciProbeBars().
+  @param Offset            The offset.
+  @param BarLengthValue    The bar length value returned.
+  @param OriginalBarValue  The original bar value returned.
+
+  @retval EFI_NOT_FOUND    The bar doesn't exist.
+  @retval EFI_SUCCESS      The bar exist.
+
+**/
+EFI_STATUS
+ProbedBarExisted (
+  IN  PCI_IO_DEVICE *PciIoDevice,
+  IN  PCI_BAR_PROBE *Probe            OPTIONAL,
+  IN  UINTN         Offset,
+  OUT UINT32        *BarLengthValue,
+  OUT UINT32        *OriginalBarValue
+  )
+{
+  UINTN               Index;
+
+  if ((Probe == NULL) || (Offset < Probe->Offset) ||
+      (Offset >= Probe->Offset + Probe->Count * sizeof (UINT32))) {
+    return BarExisted (PciIoDevice, Offset, BarLengthValue, OriginalBarValue);
+  }
+
+  Index             = (Offset - Probe->Offset) / sizeof (UINT32);
+  *BarLengthValue   = Probe->Value[Index];
+  *OriginalBarValue = Probe->OriginalValue[Index];
+
+  if (*BarLengthValue == 0) {
+    return EFI_NOT_FOUND;
+  } else {
+    return EFI_SUCCESS;
+  }
+}
+
 /**
   Parse PCI bar information and fill them into PCI device instance.
 
   @param PciIoDevice  Pci device instance.
   @param Offset       Bar offset.
   @param BarIndex     Bar index.
+  @param Probe        Optional BAR values sized by PciProbeBars(). BARs
+                      outside of it are sized one at a time.
 
   @return Next bar offset.
 
@@ -1761,7 +1885,8 @@ UINTN
 PciParseBar (
   IN PCI_IO_DEVICE  *PciIoDevice,
   IN UINTN          Offset,
-  IN UINTN          BarIndex
+  IN UINTN          BarIndex,
+  IN PCI_BAR_PROBE  *Probe      OPTIONAL
   )
 {
   UINT32      Value;
@@ -1772,8 +1897,9 @@ PciParseBar (
   OriginalValue = 0;
   Value         = 0;
 
-  Status = BarExisted (
+  Status = ProbedBarExisted (
              PciIoDevice,
+             Probe,
              Offset,
              &Value,
              &OriginalValue
@@ -1880,8 +2006,9 @@ PciParseBar (
       //
       Offset += 4;
 
-      Status = BarExisted (
+      Status = ProbedBarExisted (
                  PciIoDevice,
+                 Probe,
                  Offset,
                  &Value,
                  &OriginalValue
@@ -9,6 +9,16 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _EFI_PCI_ENUMERATOR_SUPPORT_H_
 #define _EFI_PCI_ENUMERATOR_SUPPORT_H_
 
+//
+// The result of sizing a run of adjacent BARs in one pass.
+//
+typedef struct {
+  UINTN                 Offset;
+  UINTN                 Count;
+  UINT32                Value[PCI_MAX_BAR];
+  UINT32                OriginalValue[PCI_MAX_BAR];
+} PCI_BAR_PROBE;
+
 /**
   This routine is used to check whether the pci device is present.
 
@@ -285,12 +295,57 @@ SetNewAlign (
   IN     UINT64     NewAlignment
   );
 
+/**
+  Size a run of adjacent BARs with one config read, one write of all ones,
+  one read back and one restore, instead of four accesses per BAR. Only the
+  BARs that do not read back their original value are restored, so BARs that
+  the function does not implement cost three accesses instead of four.
+
+  @param PciIoDevice  Pci device instance.
+  @param Offset       Offset of the first BAR.
+  @param Count        Number of BARs to size, at most PCI_MAX_BAR.
+  @param Probe        Returned original and sized values of the BARs.
+
+**/
+VOID
+PciProbeBars (
+  IN  PCI_IO_DEVICE  *PciIoDevice,
+  IN  UINTN          Offset,
+  IN  UINTN          Count,
+  OUT PCI_BAR_PROBE  *Probe
+  );
+
+/**
+  Check whether the bar is existed or not, taking its values from a
+  PciProbeBars() result when the bar was sized there.
+
+  @param PciIoDevice       A pointer to the PCI_IO_DEVICE.
+  @param Probe             Optional BAR values sized by PciProbeBars().
+  @param Offset            The offset.
+  @param BarLengthValue    The bar length value returned.
+  @param OriginalBarValue  The original bar value returned.
+
+  @retval EFI_NOT_FOUND    The bar doesn't exist.
+  @retval EFI_SUCCESS      The bar exist.
+
+**/
+EFI_STATUS
+ProbedBarExisted (
+  IN  PCI_IO_DEVICE *PciIoDevice,
+  IN  PCI_BAR_PROBE *Probe            OPTIONAL,
+  IN  UINTN         Offset,
+  OUT UINT32        *BarLengthValue,
+  OUT UINT32        *OriginalBarValue
+  );
+
 /**
   Parse PCI bar information and fill them into PCI device instance.
 
   @param PciIoDevice  Pci device instance.
   @param Offset       Bar offset.
   @param BarIndex     Bar index.
+  @param Probe        Optional BAR values sized by PciProbeBars(). BARs
+                      outside of it are sized one at a time.
 
   @return Next bar offset.
 
@@ -299,7 +354,8 @@ UINTN
 PciParseBar (
   IN PCI_IO_DEVICE  *PciIoDevice,
   IN UINTN          Offset,
-  IN UINTN          BarIndex
+  IN UINTN          BarIndex,
+  IN PCI_BAR_PROBE  *Probe      OPTIONAL
   );
 
 /**
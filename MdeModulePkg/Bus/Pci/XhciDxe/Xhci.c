@@ -1222,6 +1222,8 @@ XhcBulkTransfer (
   UINT8                   SlotId;
   EFI_STATUS              Status;
   EFI_TPL                 OldTpl;
+  UINTN                   TotalLength;
+  UINTN                   Length;
 
   //
   // Validate the parameters
@@ -1265,20 +1267,29 @@ XhcBulkTransfer (
   //
   // Create a new URB, insert it into the asynchronous
   // schedule list, then poll the execution status.
-  //
-  Status = XhcTransfer (
-             Xhc,
-             DeviceAddress,
-             EndPointAddress,
-             DeviceSpeed,
-             MaximumPacketLength,
-             XHC_BULK_TRANSFER,
-             NULL,
-             Data[0],
-             DataLength,
-             Timeout,
-             TransferResult
-             );
+  // Each URB is a single TD, which the bulk transfer ring can
+  // hold up to XHC_MAX_BULK_TD_SIZE bytes of, so issue larger
+  // requests as a sequence of TDs.
+  //
+  TotalLength = *DataLength;
+  *DataLength = 0;
+  do {
+    Length = MIN (TotalLength - *DataLength, XHC_MAX_BULK_TD_SIZE);
+    Status = XhcTransfer (
+               Xhc,
+               DeviceAddress,
+               EndPointAddress,
+               DeviceSpeed,
+               MaximumPacketLength,
+               XHC_BULK_TRANSFER,
+               NULL,
+               (UINT8 *) Data[0] + *DataLength,
+               &Length,
+               Timeout,
+               TransferResult
+               );
+    *DataLength += Length;
+  } while (!EFI_ERROR (Status) && (Length == XHC_MAX_BULK_TD_SIZE) && (*DataLength < TotalLength));
 
 ON_EXIT:
   if (EFI_ERROR (Status)) {
@@ -1786,6 +1797,7 @@ XhcCreateUsbHc (
   // Be caution that the Offset passed to XhcReadCapReg() should be Dword align
   //
   Xhc->CapLength        = XhcReadCapReg8 (Xhc, XHC_CAPLENGTH_OFFSET);
+  Xhc->HciVersion       = (UINT16) (XhcReadCapReg (Xhc, XHC_CAPLENGTH_OFFSET) >> 16);
   Xhc->HcSParams1.Dword = XhcReadCapReg (Xhc, XHC_HCSPARAMS1_OFFSET);
   Xhc->HcSParams2.Dword = XhcReadCapReg (Xhc, XHC_HCSPARAMS2_OFFSET);
   Xhc->HcCParams.Dword  = XhcReadCapReg (Xhc, XHC_HCCPARAMS_OFFSET);
@@ -1806,6 +1818,7 @@ XhcCreateUsbHc (
   Xhc->DebugCapSupOffset = XhcGetCapabilityAddr (Xhc, XHC_CAP_USB_DEBUG);
 
   DEBUG ((EFI_D_INFO, "XhcCreateUsb3Hc: Capability length 0x%x\n", Xhc->CapLength));
+  DEBUG ((EFI_D_INFO, "XhcCreateUsb3Hc: Interface version 0x%x\n", Xhc->HciVersion));
   DEBUG ((EFI_D_INFO, "XhcCreateUsb3Hc: HcSParams1 0x%x\n", Xhc->HcSParams1));
   DEBUG ((EFI_D_INFO, "XhcCreateUsb3Hc: HcSParams2 0x%x\n", Xhc->HcSParams2));
   DEBUG ((EFI_D_INFO, "XhcCreateUsb3Hc: HcCParams 0x%x\n", Xhc->HcCParams));
@@ -219,6 +219,7 @@ struct _USB_XHCI_INSTANCE {
   LIST_ENTRY                AsyncIntTransfers;
 
   UINT8                     CapLength;    ///< Capability Register Length
+  UINT16                    HciVersion;   ///< Interface Version Number
   XHC_HCSPARAMS1            HcSParams1;   ///< Structural Parameters 1
   XHC_HCSPARAMS2            HcSParams2;   ///< Structural Parameters 2
   XHC_HCCPARAMS             HcCParams;    ///< Capability Parameters
@@ -203,6 +203,45 @@ XhcFreeUrb (
   FreePool (Urb);
 }
 
+/**
+  Calculate the TD Size field of a normal TRB (4.11.2.4).
+
+  The TD Size is the TD Packet Count minus the number of packets that
+  the TRBs up to and including this one fill up, or 0 for the last TRB
+  of the TD. Hosts older than xHCI 1.0 expect the number of bytes of
+  the TD that follow this TRB, in units of 1KB, instead.
+
+  @param  Xhc           The XHCI Instance.
+  @param  Transferred   The bytes of the TD up to and including this TRB.
+  @param  TdLength      The bytes of the whole TD.
+  @param  MaxPacket     The max packet size of the endpoint.
+
+  @return The TD Size value, saturated to 31.
+
+**/
+UINT32
+XhcTrbTdSize (
+  IN USB_XHCI_INSTANCE          *Xhc,
+  IN UINTN                      Transferred,
+  IN UINTN                      TdLength,
+  IN UINTN                      MaxPacket
+  )
+{
+  UINTN                         Packets;
+
+  if ((Transferred >= TdLength) || (MaxPacket == 0)) {
+    return 0;
+  }
+
+  if (Xhc->HciVersion < 0x100) {
+    Packets = (TdLength - Transferred) >> 10;
+  } else {
+    Packets = (TdLength + MaxPacket - 1) / MaxPacket - Transferred / MaxPacket;
+  }
+
+  return (UINT32) MIN (Packets, 31);
+}
+
 /**
   Create a transfer TRB.
 
@@ -371,37 +410,56 @@ XhcCreateTransferTrb (
 
     case ED_BULK_OUT:
     case ED_BULK_IN:
+      //
+      // Build the whole transfer as one TD of chained normal TRBs,
+      // so that the host controller streams it without waiting for
+      // software between TRBs. Only the last TRB interrupts; a short
+      // packet on any TRB is reported through ISP and ends the TD.
+      //
+      ASSERT (Urb->DataLen <= XHC_MAX_BULK_TD_SIZE);
       TotalLen = 0;
       Len      = 0;
       TrbNum   = 0;
       TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
       while (TotalLen < Urb->DataLen) {
-        if ((TotalLen + 0x10000) >= Urb->DataLen) {
+        //
+        // A TRB buffer must not cross a 64KB boundary.
+        //
+        PhyAddr = (EFI_PHYSICAL_ADDRESS)(UINTN) ((UINT8 *) Urb->DataPhy + TotalLen);
+        Len     = XHC_TRB_MAX_BUFFER - (UINTN) (PhyAddr & (XHC_TRB_MAX_BUFFER - 1));
+        if (Len >= Urb->DataLen - TotalLen) {
           Len = Urb->DataLen - TotalLen;
-        } else {
-          Len = 0x10000;
         }
+        TotalLen += Len;
+
         TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
-        TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
-        TrbStart->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
+        TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT (PhyAddr);
+        TrbStart->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT (PhyAddr);
         TrbStart->TrbNormal.Length    = (UINT32) Len;
-        TrbStart->TrbNormal.TDSize    = 0;
+        TrbStart->TrbNormal.TDSize    = XhcTrbTdSize (Xhc, TotalLen, Urb->DataLen, Urb->Ep.MaxPacket);
         TrbStart->TrbNormal.IntTarget = 0;
         TrbStart->TrbNormal.ISP       = 1;
-        TrbStart->TrbNormal.IOC       = 1;
+        TrbStart->TrbNormal.CH        = (TotalLen < Urb->DataLen) ? 1 : 0;
+        TrbStart->TrbNormal.IOC       = (TotalLen < Urb->DataLen) ? 0 : 1;
         TrbStart->TrbNormal.Type      = TRB_TYPE_NORMAL;
         //
+        // A Link TRB in the middle of the TD must carry the chain on.
+        //
+        if ((UINT8) ((TRB_TEMPLATE *) TrbStart + 1)->Type == TRB_TYPE_LINK) {
+          ((LINK_TRB *) ((TRB_TEMPLATE *) TrbStart + 1))->CH = TrbStart->TrbNormal.CH;
+        }
+        //
         // Update the cycle bit
         //
         TrbStart->TrbNormal.CycleBit = EPRing->RingPCS & BIT0;
 
         XhcSyncTrsRing (Xhc, EPRing);
         TrbNum++;
-        TotalLen += Len;
       }
 
-      Urb->TrbNum = TrbNum;
-      Urb->TrbEnd = (TRB_TEMPLATE *)(UINTN)TrbStart;
+      Urb->TrbNum    = TrbNum;
+      Urb->TrbEnd    = (TRB_TEMPLATE *)(UINTN)TrbStart;
+      Urb->StartDone = TRUE;
       break;
 
     case ED_INTERRUPT_OUT:
@@ -786,6 +844,7 @@ CreateEventRing (
   EventRing->TrbNumber        = EVENT_RING_TRB_NUMBER;
   EventRing->EventRingDequeue = (TRB_TEMPLATE *) EventRing->EventRingSeg0;
   EventRing->EventRingEnqueue = (TRB_TEMPLATE *) EventRing->EventRingSeg0;
+  EventRing->EventRingDequeueHc = (TRB_TEMPLATE *) EventRing->EventRingSeg0;
 
   DequeuePhy = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Buf, Size);
 
@@ -1086,10 +1145,8 @@ XhcCheckUrbResult (
   EFI_STATUS              Status;
   URB                     *AsyncUrb;
   URB                     *CheckedUrb;
-  UINT64                  XhcDequeue;
-  UINT32                  High;
-  UINT32                  Low;
   EFI_PHYSICAL_ADDRESS    PhyAddr;
+  EFI_PHYSICAL_ADDRESS    TrbData;
 
   ASSERT ((Xhc != NULL) && (Urb != NULL));
 
@@ -1186,14 +1243,35 @@ XhcCheckUrbResult (
 
       case TRB_COMPLETION_SHORT_PACKET:
       case TRB_COMPLETION_SUCCESS:
+        if (CheckedUrb->Finished) {
+          //
+          // Some host controllers still report the last TRB of a
+          // TD which has already ended with a short packet.
+          //
+          continue;
+        }
+
         if (EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) {
           DEBUG ((EFI_D_VERBOSE, "XhcCheckUrbResult: short packet happens!\n"));
         }
 
         TRBType = (UINT8) (TRBPtr->Type);
-        if ((TRBType == TRB_TYPE_DATA_STAGE) ||
-            (TRBType == TRB_TYPE_NORMAL) ||
-            (TRBType == TRB_TYPE_ISOCH)) {
+        if ((CheckedUrb->Ep.Type == XHC_BULK_TRANSFER) && (TRBType == TRB_TYPE_NORMAL)) {
+          //
+          // The TRBs of a bulk TD are chained and only report on the
+          // last TRB or on a short packet, so all the TRBs before the
+          // reported one have completed in full.
+          //
+          TrbData = (EFI_PHYSICAL_ADDRESS)(((TRANSFER_TRB_NORMAL*)TRBPtr)->TRBPtrLo |
+                      LShiftU64 ((UINT64) ((TRANSFER_TRB_NORMAL*)TRBPtr)->TRBPtrHi, 32));
+          CheckedUrb->Completed = (UINTN) (TrbData - (UINTN) CheckedUrb->DataPhy) +
+                                  (((TRANSFER_TRB_NORMAL*)TRBPtr)->Length - EvtTrb->Length);
+          if (EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) {
+            CheckedUrb->EndDone = TRUE;
+          }
+        } else if ((TRBType == TRB_TYPE_DATA_STAGE) ||
+                   (TRBType == TRB_TYPE_NORMAL) ||
+                   (TRBType == TRB_TYPE_ISOCH)) {
           CheckedUrb->Completed += (((TRANSFER_TRB_NORMAL*)TRBPtr)->Length - EvtTrb->Length);
         }
 
@@ -1226,24 +1304,19 @@ XhcCheckUrbResult (
 EXIT:
 
   //
-  // Advance event ring to last available entry
-  //
-  // Some 3rd party XHCI external cards don't support single 64-bytes width register access,
-  // So divide it to two 32-bytes width register access.
+  // Advance event ring to last available entry. The dequeue pointer
+  // last written to ERDP is kept in software, so the register only
+  // needs to be touched when new events have been consumed.
   //
-  Low  = XhcReadRuntimeReg (Xhc, XHC_ERDP_OFFSET);
-  High = XhcReadRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4);
-  XhcDequeue = (UINT64)(LShiftU64((UINT64)High, 32) | Low);
-
-  PhyAddr = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Xhc->EventRing.EventRingDequeue, sizeof (TRB_TEMPLATE));
-
-  if ((XhcDequeue & (~0x0F)) != (PhyAddr & (~0x0F))) {
+  if (Xhc->EventRing.EventRingDequeue != Xhc->EventRing.EventRingDequeueHc) {
+    PhyAddr = UsbHcGetPciAddrForHostAddr (Xhc->MemPool, Xhc->EventRing.EventRingDequeue, sizeof (TRB_TEMPLATE));
     //
     // Some 3rd party XHCI external cards don't support single 64-bytes width register access,
     // So divide it to two 32-bytes width register access.
     //
     XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET, XHC_LOW_32BIT (PhyAddr) | BIT3);
     XhcWriteRuntimeReg (Xhc, XHC_ERDP_OFFSET + 4, XHC_HIGH_32BIT (PhyAddr));
+    Xhc->EventRing.EventRingDequeueHc = Xhc->EventRing.EventRingDequeue;
   }
 
   return Urb->Finished;
@@ -2532,7 +2605,7 @@ XhcDisableSlotCmd (
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
       RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
       if (RingSeg != NULL) {
-        UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
+        UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->TrbNumber);
       }
       FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] = NULL;
@@ -2639,7 +2712,7 @@ XhcDisableSlotCmd64 (
     if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] != NULL) {
       RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->RingSeg0;
       if (RingSeg != NULL) {
-        UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
+        UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index])->TrbNumber);
       }
       FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index]);
       Xhc->UsbDevContext[SlotId].EndpointTransferRing[Index] = NULL;
@@ -2853,7 +2926,7 @@ XhcInitializeEndpointContext (
     PhyAddr = UsbHcGetPciAddrForHostAddr (
                 Xhc->MemPool,
                 ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1])->RingSeg0,
-                sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER
+                sizeof (TRB_TEMPLATE) * ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1])->TrbNumber
                 );
     PhyAddr &= ~((EFI_PHYSICAL_ADDRESS)0x0F);
     PhyAddr |= (EFI_PHYSICAL_ADDRESS)((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1])->RingPCS;
@@ -3045,7 +3118,7 @@ XhcInitializeEndpointContext64 (
     PhyAddr = UsbHcGetPciAddrForHostAddr (
                 Xhc->MemPool,
                 ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1])->RingSeg0,
-                sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER
+                sizeof (TRB_TEMPLATE) * ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1])->TrbNumber
                 );
     PhyAddr &= ~((EFI_PHYSICAL_ADDRESS)0x0F);
     PhyAddr |= (EFI_PHYSICAL_ADDRESS)((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci-1])->RingPCS;
@@ -3545,7 +3618,7 @@ XhcSetInterface (
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
         RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
         if (RingSeg != NULL) {
-          UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
+          UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->TrbNumber);
         }
         FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] = NULL;
@@ -3747,7 +3820,7 @@ XhcSetInterface64 (
       if (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] != NULL) {
         RingSeg = ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->RingSeg0;
         if (RingSeg != NULL) {
-          UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * TR_RING_TRB_NUMBER);
+          UsbHcFreeMem (Xhc->MemPool, RingSeg, sizeof (TRB_TEMPLATE) * ((TRANSFER_RING *)(UINTN)Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1])->TrbNumber);
         }
         FreePool (Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1]);
         Xhc->UsbDevContext[SlotId].EndpointTransferRing[Dci - 1] = NULL;
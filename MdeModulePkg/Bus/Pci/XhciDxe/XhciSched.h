@@ -145,6 +145,15 @@ typedef struct _TRANSFER_RING {
   UINT32                    RingPCS;
 } TRANSFER_RING;
 
+//
+// A TRB data buffer shall not span a 64KB boundary (6.4.1.1).
+// The largest bulk TD is sized so that its TRBs, one more for
+// an unaligned buffer, still leave the Link TRB and one free
+// entry in the ring.
+//
+#define XHC_TRB_MAX_BUFFER          SIZE_64KB
+#define XHC_MAX_BULK_TD_SIZE        ((TR_RING_TRB_NUMBER - 3) * XHC_TRB_MAX_BUFFER)
+
 typedef struct _EVENT_RING {
   VOID                      *ERSTBase;
   VOID                      *EventRingSeg0;
@@ -152,6 +161,11 @@ typedef struct _EVENT_RING {
   TRB_TEMPLATE              *EventRingEnqueue;
   TRB_TEMPLATE              *EventRingDequeue;
   UINT32                    EventRingCCS;
+  //
+  // The dequeue pointer last written to the ERDP register. It
+  // saves reading the register back each time the ring is polled.
+  //
+  TRB_TEMPLATE              *EventRingDequeueHc;
 } EVENT_RING;
 
 //
@@ -1469,6 +1483,30 @@ XhcFreeUrb (
   IN URB                  *Urb
   );
 
+/**
+  Calculate the TD Size field of a normal TRB (4.11.2.4).
+
+  The TD Size is the TD Packet Count minus the number of packets that
+  the TRBs up to and including this one fill up, or 0 for the last TRB
+  of the TD. Hosts older than xHCI 1.0 expect the number of bytes of
+  the TD that follow this TRB, in units of 1KB, instead.
+
+  @param  Xhc           The XHCI Instance.
+  @param  Transferred   The bytes of the TD up to and including this TRB.
+  @param  TdLength      The bytes of the whole TD.
+  @param  MaxPacket     The max packet size of the endpoint.
+
+  @return The TD Size value, saturated to 31.
+
+**/
+UINT32
+XhcTrbTdSize (
+  IN USB_XHCI_INSTANCE            *Xhc,
+  IN UINTN                        Transferred,
+  IN UINTN                        TdLength,
+  IN UINTN                        MaxPacket
+  );
+
 /**
   Create a transfer TRB.
 
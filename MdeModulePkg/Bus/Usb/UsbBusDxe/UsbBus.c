@@ -34,6 +34,12 @@ EFI_DRIVER_BINDING_PROTOCOL mUsbBusDriverBinding = {
   NULL
 };
 
+//
+// Number of USB buses started, used to tell the buses apart
+// in the performance log.
+//
+UINT32 mUsbBusCount = 0;
+
 /**
   USB_IO function to execute a control transfer. This
   function will execute the USB transfer. If transfer
@@ -888,6 +894,43 @@ ON_EXIT:
 }
 
 
+/**
+  Wait for the root hub ports of a USB bus to finish their enumeration, so
+  that the devices attached to them exist when the bus start returns.
+
+  The wait is bounded by USB_WAIT_ROOT_PORT_ENUM_STALL. The root hub ports
+  of the buses started before keep being enumerated in the background while
+  this bus is waited for, and a port that is still busy when the wait times
+  out connects its device when it is ready.
+
+  The ports are advanced by timer events, so nothing is waited for if the
+  caller runs at a TPL that blocks them.
+
+  @param UsbBus                  The USB bus that is started.
+
+**/
+VOID
+UsbBusWaitRootPortEnum (
+  IN USB_BUS                      *UsbBus
+  )
+{
+  UINTN                   Elapsed;
+
+  if (UsbGetCurrentTpl () >= TPL_CALLBACK) {
+    return;
+  }
+
+  for (Elapsed = 0; Elapsed < USB_WAIT_ROOT_PORT_ENUM_STALL; Elapsed += USB_BUS_1_MILLISECOND) {
+    if (!UsbPortEnumBusy (UsbBus->Devices[0]->Interfaces[0])) {
+      return;
+    }
+
+    gBS->Stall (USB_BUS_1_MILLISECOND);
+  }
+
+  DEBUG (( EFI_D_ERROR, "UsbBusWaitRootPortEnum: root hub ports still busy\n"));
+}
+
 /**
   Install Usb Bus Protocol on host controller, and start the Usb bus.
 
@@ -923,6 +966,8 @@ UsbBusBuildProtocol (
   UsbBus->Signature  = USB_BUS_SIGNATURE;
   UsbBus->HostHandle = Controller;
   UsbBus->MaxDevices = USB_MAX_DEVICES;
+  UsbBus->Index      = mUsbBusCount++;
+  InitializeListHead (&UsbBus->PortResetQueue);
 
   Status = gBS->OpenProtocol (
                   Controller,
@@ -1341,6 +1386,8 @@ UsbBusControllerDriverStart (
                     EFI_OPEN_PROTOCOL_GET_PROTOCOL
                     );
     ASSERT (!EFI_ERROR (Status));
+
+    UsbBusWaitRootPortEnum (USB_BUS_FROM_THIS (UsbBusId));
   } else {
     //
     // USB Bus driver need to control the recursive connect policy of the bus, only those wanted
@@ -1364,8 +1411,10 @@ UsbBusControllerDriverStart (
     Status = UsbBusAddWantedUsbIoDP (UsbBusId, RemainingDevicePath);
     ASSERT (!EFI_ERROR (Status));
     //
-    // Ensure all wanted child usb devices are fully recursively connected
+    // Ensure all wanted child usb devices are fully recursively connected,
+    // including those on root hub ports that are still being enumerated
     //
+    UsbBusWaitRootPortEnum (USB_BUS_FROM_THIS (UsbBusId));
     Status = UsbBusRecursivelyConnectWantedUsbIo (UsbBusId);
     ASSERT (!EFI_ERROR (Status));
   }
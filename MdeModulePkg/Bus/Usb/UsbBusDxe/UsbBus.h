@@ -27,6 +27,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DevicePathLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PerformanceLib.h>
+#include <Library/PrintLib.h>
 
 
 #include <IndustryStandard/Usb.h>
@@ -115,6 +117,33 @@ typedef struct _USB_HUB_API    USB_HUB_API;
 //
 #define USB_SET_ROOT_PORT_ENABLE_STALL (20 * USB_BUS_1_MILLISECOND)
 
+//
+// Interval between two port status polls while a port reset is
+// driven by timer events, one tick of the default system timer.
+//
+#define USB_PORT_RESET_POLL_STALL      (10 * USB_BUS_1_MILLISECOND)
+
+//
+// A relative timer event may fire up to one system tick before the
+// requested delay has elapsed. The port state machine pads each wait
+// by one default tick so the minimum delays above still hold.
+//
+#define USB_PORT_TIMER_GUARD_STALL     (10 * USB_BUS_1_MILLISECOND)
+
+//
+// Convert a stall in microseconds to a timer event trigger time
+// in 100ns units.
+//
+#define USB_STALL_TO_TIMER(Stall)      \
+          MultU64x32 ((UINT64) (Stall) + USB_PORT_TIMER_GUARD_STALL, 10)
+
+//
+// Longest time the bus start waits for the root hub ports of all
+// the USB buses to finish their enumeration, set by experience.
+// Ports of other hubs have always been enumerated in the background.
+//
+#define USB_WAIT_ROOT_PORT_ENUM_STALL  (5000 * USB_BUS_1_MILLISECOND)
+
 //
 // Send general device request timeout.
 //
@@ -219,6 +248,7 @@ struct _USB_INTERFACE {
   USB_HUB_API               *HubApi;
   UINT8                     NumOfPort;
   EFI_EVENT                 HubNotify;
+  USB_PORT_ENUM             *Ports;
 
   //
   // Data used only by normal hub devices
@@ -271,6 +301,14 @@ struct _USB_BUS {
   //
   LIST_ENTRY                WantedUsbIoDPList;
 
+  //
+  // Only one device on the bus may answer at the default address,
+  // so port resets are granted to one port at a time. Ports that
+  // finished debouncing wait on PortResetQueue for their turn.
+  //
+  LIST_ENTRY                PortResetQueue;
+  USB_PORT_ENUM             *PortResetOwner;
+  UINT32                    Index;
 };
 
 //
@@ -283,6 +321,7 @@ struct _USB_HUB_API{
   USB_HUB_SET_PORT_FEATURE    SetPortFeature;
   USB_HUB_CLEAR_PORT_FEATURE  ClearPortFeature;
   USB_HUB_RESET_PORT          ResetPort;
+  USB_HUB_RESET_PORT_STEP     ResetPortStep;
   USB_HUB_RELEASE             Release;
 };
 
@@ -677,6 +716,18 @@ UsbBusBuildProtocol (
   IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
   );
 
+/**
+  Wait for the root hub ports of a USB bus to finish their enumeration, so
+  that the devices attached to them exist when the bus start returns.
+
+  @param UsbBus                  The USB bus that is started.
+
+**/
+VOID
+UsbBusWaitRootPortEnum (
+  IN USB_BUS                      *UsbBus
+  );
+
 /**
   The USB bus driver entry pointer.
 
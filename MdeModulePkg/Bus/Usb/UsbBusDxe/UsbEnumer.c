@@ -649,10 +649,10 @@ UsbFindChild (
 
 /**
   Enumerate and configure the new device on the port of this HUB interface.
+  The port has been debounced and reset by the port state machine.
 
   @param  HubIf                 The HUB that has the device connected.
   @param  Port                  The port index of the hub (started with zero).
-  @param  ResetIsNeeded         The boolean to control whether skip the reset of the port.
 
   @retval EFI_SUCCESS           The device is enumerated (added or removed).
   @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource for the device.
@@ -662,8 +662,7 @@ UsbFindChild (
 EFI_STATUS
 UsbEnumerateNewDev (
   IN USB_INTERFACE        *HubIf,
-  IN UINT8                Port,
-  IN BOOLEAN              ResetIsNeeded
+  IN UINT8                Port
   )
 {
   USB_BUS                 *Bus;
@@ -680,26 +679,6 @@ UsbEnumerateNewDev (
   HubApi  = HubIf->HubApi;
   Address = Bus->MaxDevices;
 
-  gBS->Stall (USB_WAIT_PORT_STABLE_STALL);
-
-  //
-  // Hub resets the device for at least 10 milliseconds.
-  // Host learns device speed. If device is of low/full speed
-  // and the hub is a EHCI root hub, ResetPort will release
-  // the device to its companion UHCI and return an error.
-  //
-  if (ResetIsNeeded) {
-    Status = HubApi->ResetPort (HubIf, Port);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((EFI_D_ERROR, "UsbEnumerateNewDev: failed to reset port %d - %r\n", Port, Status));
-
-      return Status;
-    }
-    DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: hub port %d is reset\n", Port));
-  } else {
-    DEBUG (( EFI_D_INFO, "UsbEnumerateNewDev: hub port %d reset is skipped\n", Port));
-  }
-
   Child = UsbCreateDevice (HubIf, Port);
 
   if (Child == NULL) {
@@ -871,6 +850,365 @@ ON_ERROR:
 }
 
 
+/**
+  Start the next port waiting on the bus for its turn to reset.
+  The reset itself runs from the port's timer event.
+
+  @param  Bus                   The USB bus.
+
+**/
+VOID
+UsbPortKickReset (
+  IN USB_BUS              *Bus
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+
+  if ((Bus->PortResetOwner != NULL) || IsListEmpty (&Bus->PortResetQueue)) {
+    return;
+  }
+
+  PortEnum = BASE_CR (GetFirstNode (&Bus->PortResetQueue), USB_PORT_ENUM, Link);
+  RemoveEntryList (&PortEnum->Link);
+
+  Bus->PortResetOwner = PortEnum;
+  PortEnum->State     = USB_PORT_STATE_RESET;
+
+  ZeroMem (&PortEnum->Reset, sizeof (USB_PORT_RESET_CONTEXT));
+  PortEnum->Reset.PollStall = USB_PORT_RESET_POLL_STALL;
+
+  gBS->SignalEvent (PortEnum->Timer);
+}
+
+
+/**
+  Stop the enumeration in progress on the port. If the port
+  owns the bus reset, hand it over to the next waiting port.
+
+  @param  PortEnum              The port to stop.
+
+**/
+VOID
+UsbPortSetIdle (
+  IN USB_PORT_ENUM        *PortEnum
+  )
+{
+  USB_BUS                 *Bus;
+
+  Bus = PortEnum->HubIf->Device->Bus;
+
+  gBS->SetTimer (PortEnum->Timer, TimerCancel, 0);
+
+  if (PortEnum->State == USB_PORT_STATE_WAIT_RESET) {
+    RemoveEntryList (&PortEnum->Link);
+  }
+
+  if (PortEnum->Measuring) {
+    PERF_INMODULE_END (PortEnum->PerfName);
+    PortEnum->Measuring = FALSE;
+  }
+
+  PortEnum->State = USB_PORT_STATE_IDLE;
+
+  if (Bus->PortResetOwner == PortEnum) {
+    Bus->PortResetOwner = NULL;
+    UsbPortKickReset (Bus);
+  }
+}
+
+
+/**
+  Start, or restart, debouncing a new connection on the port.
+
+  @param  PortEnum              The port that has the device connected.
+  @param  ResetIsNeeded         The boolean to control whether skip the reset of the port.
+
+**/
+VOID
+UsbPortStartDebounce (
+  IN USB_PORT_ENUM        *PortEnum,
+  IN BOOLEAN              ResetIsNeeded
+  )
+{
+  if (PortEnum->State == USB_PORT_STATE_WAIT_RESET) {
+    RemoveEntryList (&PortEnum->Link);
+  }
+
+  if (!PortEnum->Measuring) {
+    PERF_INMODULE_BEGIN (PortEnum->PerfName);
+    PortEnum->Measuring = TRUE;
+  }
+
+  PortEnum->State         = USB_PORT_STATE_DEBOUNCE;
+  PortEnum->ResetIsNeeded = ResetIsNeeded;
+
+  gBS->SetTimer (
+         PortEnum->Timer,
+         TimerRelative,
+         USB_STALL_TO_TIMER (USB_WAIT_PORT_STABLE_STALL)
+         );
+}
+
+
+/**
+  The timer callback of the port state machine. It runs each
+  port from a new connection to a configured device without
+  stalling, so the waits of all the ports overlap.
+
+  @param  Event                 The port's timer event.
+  @param  Context               The port enumeration state.
+
+**/
+VOID
+EFIAPI
+UsbPortOnTimer (
+  IN EFI_EVENT            Event,
+  IN VOID                 *Context
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  USB_INTERFACE           *HubIf;
+  USB_HUB_API             *HubApi;
+  USB_BUS                 *Bus;
+  EFI_USB_PORT_STATUS     PortState;
+  EFI_STATUS              Status;
+
+  PortEnum = (USB_PORT_ENUM *) Context;
+  HubIf    = PortEnum->HubIf;
+  HubApi   = HubIf->HubApi;
+  Bus      = HubIf->Device->Bus;
+
+  switch (PortEnum->State) {
+  case USB_PORT_STATE_POWER_ON:
+    PortEnum->State = USB_PORT_STATE_IDLE;
+    break;
+
+  case USB_PORT_STATE_DEBOUNCE:
+    //
+    // The connection must stay stable for the whole debounce
+    // interval, start over if it changed meanwhile.
+    //
+    Status = HubApi->GetPortStatus (HubIf, PortEnum->Port, &PortState);
+
+    if (EFI_ERROR (Status) ||
+        !USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_CONNECTION)) {
+      DEBUG (( EFI_D_INFO, "UsbPortOnTimer: device left port %d while debouncing\n", PortEnum->Port));
+      UsbPortSetIdle (PortEnum);
+      break;
+    }
+
+    if (USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_CONNECTION)) {
+      HubApi->ClearPortChange (HubIf, PortEnum->Port);
+      UsbPortStartDebounce (PortEnum, PortEnum->ResetIsNeeded);
+      break;
+    }
+
+    PortEnum->State = USB_PORT_STATE_WAIT_RESET;
+    InsertTailList (&Bus->PortResetQueue, &PortEnum->Link);
+    UsbPortKickReset (Bus);
+    break;
+
+  case USB_PORT_STATE_RESET:
+    //
+    // Hub resets the device for at least 10 milliseconds.
+    // Host learns device speed. If device is of low/full speed
+    // and the hub is a EHCI root hub, the reset will release
+    // the device to its companion UHCI and return an error.
+    //
+    Status = EFI_SUCCESS;
+
+    if (PortEnum->ResetIsNeeded) {
+      Status = HubApi->ResetPortStep (HubIf, PortEnum->Port, &PortEnum->Reset);
+
+      if (Status == EFI_NOT_READY) {
+        gBS->SetTimer (
+               PortEnum->Timer,
+               TimerRelative,
+               USB_STALL_TO_TIMER (PortEnum->Reset.Delay)
+               );
+        break;
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((EFI_D_ERROR, "UsbPortOnTimer: failed to reset port %d - %r\n", PortEnum->Port, Status));
+    } else {
+      DEBUG (( EFI_D_INFO, "UsbPortOnTimer: hub port %d is %a\n", PortEnum->Port,
+                  PortEnum->ResetIsNeeded ? "reset" : "not reset"));
+
+      UsbEnumerateNewDev (HubIf, PortEnum->Port);
+    }
+
+    HubApi->ClearPortChange (HubIf, PortEnum->Port);
+    UsbPortSetIdle (PortEnum);
+    break;
+
+  default:
+    break;
+  }
+}
+
+
+/**
+  Create the enumeration state of each port of the hub.
+
+  @param  HubIf                 The hub interface, NumOfPort is set.
+
+  @retval EFI_SUCCESS           The port states are created.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource.
+
+**/
+EFI_STATUS
+UsbPortEnumInit (
+  IN USB_INTERFACE        *HubIf
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  EFI_STATUS              Status;
+  UINT8                   Index;
+
+  HubIf->Ports = NULL;
+
+  if (HubIf->NumOfPort == 0) {
+    return EFI_SUCCESS;
+  }
+
+  HubIf->Ports = AllocateZeroPool (HubIf->NumOfPort * sizeof (USB_PORT_ENUM));
+
+  if (HubIf->Ports == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    PortEnum        = &HubIf->Ports[Index];
+    PortEnum->HubIf = HubIf;
+    PortEnum->Port  = Index;
+    PortEnum->State = USB_PORT_STATE_IDLE;
+
+    //
+    // The measurement is named by bus, hub address and 1-based port.
+    //
+    AsciiSPrint (
+      PortEnum->PerfName,
+      sizeof (PortEnum->PerfName),
+      "UsbPort %d-%d.%d",
+      HubIf->Device->Bus->Index,
+      HubIf->Device->Address,
+      Index + 1
+      );
+
+    Status = gBS->CreateEvent (
+                    EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    UsbPortOnTimer,
+                    PortEnum,
+                    &PortEnum->Timer
+                    );
+
+    if (EFI_ERROR (Status)) {
+      UsbPortEnumRelease (HubIf);
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Stop the enumeration in progress on the hub ports and
+  free their state.
+
+  @param  HubIf                 The hub interface.
+
+**/
+VOID
+UsbPortEnumRelease (
+  IN USB_INTERFACE        *HubIf
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  UINT8                   Index;
+
+  if (HubIf->Ports == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    PortEnum = &HubIf->Ports[Index];
+
+    if (PortEnum->Timer == NULL) {
+      break;
+    }
+
+    UsbPortSetIdle (PortEnum);
+    gBS->CloseEvent (PortEnum->Timer);
+  }
+
+  FreePool (HubIf->Ports);
+  HubIf->Ports = NULL;
+}
+
+
+/**
+  Hold off the enumeration of the hub ports until the power
+  supplied to them is good.
+
+  @param  HubIf                 The hub interface.
+  @param  Stall                 The power on to power good time in microseconds.
+
+**/
+VOID
+UsbPortEnumPowerOn (
+  IN USB_INTERFACE        *HubIf,
+  IN UINTN                Stall
+  )
+{
+  USB_PORT_ENUM           *PortEnum;
+  UINT8                   Index;
+
+  //
+  // Update for the usb hub has no power on delay requirement
+  //
+  if (Stall == 0) {
+    return;
+  }
+
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    PortEnum        = &HubIf->Ports[Index];
+    PortEnum->State = USB_PORT_STATE_POWER_ON;
+
+    gBS->SetTimer (PortEnum->Timer, TimerRelative, USB_STALL_TO_TIMER (Stall));
+  }
+}
+
+
+/**
+  Check whether an enumeration is in progress on the hub ports.
+
+  @param  HubIf                 The hub interface.
+
+  @retval TRUE                  A port of the hub is being enumerated.
+  @retval FALSE                 All the ports of the hub are idle.
+
+**/
+BOOLEAN
+UsbPortEnumBusy (
+  IN USB_INTERFACE        *HubIf
+  )
+{
+  UINT8                   Index;
+
+  for (Index = 0; Index < HubIf->NumOfPort; Index++) {
+    if (HubIf->Ports[Index].State != USB_PORT_STATE_IDLE) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+
 /**
   Process the events on the port.
 
@@ -890,11 +1228,22 @@ UsbEnumeratePort (
 {
   USB_HUB_API             *HubApi;
   USB_DEVICE              *Child;
+  USB_PORT_ENUM           *PortEnum;
   EFI_USB_PORT_STATUS     PortState;
   EFI_STATUS              Status;
 
-  Child   = NULL;
-  HubApi  = HubIf->HubApi;
+  Child    = NULL;
+  HubApi   = HubIf->HubApi;
+  PortEnum = &HubIf->Ports[Port];
+
+  //
+  // The port changes while it is powered up or reset. Leave the
+  // change bits alone, the state machine acknowledges them.
+  //
+  if ((PortEnum->State == USB_PORT_STATE_POWER_ON) ||
+      (PortEnum->State == USB_PORT_STATE_RESET)) {
+    return EFI_SUCCESS;
+  }
 
   //
   // Host learns of the new device by polling the hub for port changes.
@@ -975,17 +1324,18 @@ UsbEnumeratePort (
 
   if (USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_CONNECTION)) {
     //
-    // Now, new device connected, enumerate and configure the device
+    // Now, new device connected. Debounce the connection, then the
+    // port state machine resets the port and configures the device.
     //
     DEBUG (( EFI_D_INFO, "UsbEnumeratePort: new device connected at port %d\n", Port));
-    if (USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET)) {
-      Status = UsbEnumerateNewDev (HubIf, Port, FALSE);
-    } else {
-      Status = UsbEnumerateNewDev (HubIf, Port, TRUE);
-    }
+    UsbPortStartDebounce (
+      PortEnum,
+      (BOOLEAN) !USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET)
+      );
 
   } else {
     DEBUG (( EFI_D_INFO, "UsbEnumeratePort: device disconnected event on port %d\n", Port));
+    UsbPortSetIdle (PortEnum);
   }
 
   HubApi->ClearPortChange (HubIf, Port);
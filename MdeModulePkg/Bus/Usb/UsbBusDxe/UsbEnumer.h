@@ -79,12 +79,48 @@ EFI_STATUS
   IN UINT8                Port
   );
 
+//
+// Run the next step of a port reset. EFI_NOT_READY means the
+// caller has to wait Reset->Delay microseconds and call again.
+//
+typedef
+EFI_STATUS
+(*USB_HUB_RESET_PORT_STEP) (
+  IN     USB_INTERFACE          *UsbIf,
+  IN     UINT8                  Port,
+  IN OUT USB_PORT_RESET_CONTEXT *Reset
+  );
+
 typedef
 EFI_STATUS
 (*USB_HUB_RELEASE) (
   IN USB_INTERFACE        *UsbIf
   );
 
+//
+// State of the enumeration of a hub port. A new connection is
+// debounced, waits for its turn to reset, then is reset and
+// addressed. Each wait is a timer event, so the waits of all
+// the ports on all the hubs overlap.
+//
+#define USB_PORT_STATE_IDLE         0
+#define USB_PORT_STATE_POWER_ON     1
+#define USB_PORT_STATE_DEBOUNCE     2
+#define USB_PORT_STATE_WAIT_RESET   3
+#define USB_PORT_STATE_RESET        4
+
+typedef struct {
+  USB_INTERFACE           *HubIf;
+  UINT8                   Port;
+  UINT8                   State;
+  BOOLEAN                 ResetIsNeeded;
+  BOOLEAN                 Measuring;
+  EFI_EVENT               Timer;
+  LIST_ENTRY              Link;
+  USB_PORT_RESET_CONTEXT  Reset;
+  CHAR8                   PerfName[24];
+} USB_PORT_ENUM;
+
 /**
   Return the endpoint descriptor in this interface.
 
@@ -163,6 +199,60 @@ UsbRemoveDevice (
   IN USB_DEVICE           *Device
   );
 
+/**
+  Create the enumeration state of each port of the hub.
+
+  @param  HubIf                 The hub interface, NumOfPort is set.
+
+  @retval EFI_SUCCESS           The port states are created.
+  @retval EFI_OUT_OF_RESOURCES  Failed to allocate resource.
+
+**/
+EFI_STATUS
+UsbPortEnumInit (
+  IN USB_INTERFACE        *HubIf
+  );
+
+/**
+  Stop the enumeration in progress on the hub ports and
+  free their state.
+
+  @param  HubIf                 The hub interface.
+
+**/
+VOID
+UsbPortEnumRelease (
+  IN USB_INTERFACE        *HubIf
+  );
+
+/**
+  Hold off the enumeration of the hub ports until the power
+  supplied to them is good.
+
+  @param  HubIf                 The hub interface.
+  @param  Stall                 The power on to power good time in microseconds.
+
+**/
+VOID
+UsbPortEnumPowerOn (
+  IN USB_INTERFACE        *HubIf,
+  IN UINTN                Stall
+  );
+
+/**
+  Check whether an enumeration is in progress on the hub ports.
+
+  @param  HubIf                 The hub interface.
+
+  @retval TRUE                  A port of the hub is being enumerated.
+  @retval FALSE                 All the ports of the hub are idle.
+
+**/
+BOOLEAN
+UsbPortEnumBusy (
+  IN USB_INTERFACE        *HubIf
+  );
+
 /**
   Enumerate all the changed hub ports.
 
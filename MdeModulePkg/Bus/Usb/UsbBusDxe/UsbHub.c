@@ -628,6 +628,12 @@ UsbHubInit (
 
   DEBUG (( EFI_D_INFO, "UsbHubInit: hub %d has %d ports\n", HubDev->Address,HubIf->NumOfPort));
 
+  Status = UsbPortEnumInit (HubIf);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   //
   // OK, set IsHub to TRUE. Now usb bus can handle this device
   // as a working HUB. If failed earlier, bus driver will not
@@ -656,11 +662,11 @@ UsbHubInit (
     }
 
     //
-    // Update for the usb hub has no power on delay requirement
+    // Don't stall for the power to become good. The ports keep their
+    // connect change until then, which the hub reports again once
+    // the ports can be enumerated.
     //
-    if (HubDesc->PwrOn2PwrGood > 0) {
-      gBS->Stall (HubDesc->PwrOn2PwrGood * USB_SET_PORT_POWER_STALL);
-    }
+    UsbPortEnumPowerOn (HubIf, HubDesc->PwrOn2PwrGood * USB_SET_PORT_POWER_STALL);
     UsbHubAckHubStatus (HubIf->Device);
   }
 
@@ -679,6 +685,7 @@ UsbHubInit (
     DEBUG (( EFI_D_ERROR, "UsbHubInit: failed to create signal for hub %d - %r\n",
                 HubDev->Address, Status));
 
+    UsbPortEnumRelease (HubIf);
     return Status;
   }
 
@@ -706,6 +713,7 @@ UsbHubInit (
 
     gBS->CloseEvent (HubIf->HubNotify);
     HubIf->HubNotify = NULL;
+    UsbPortEnumRelease (HubIf);
 
     return Status;
   }
@@ -840,60 +848,130 @@ UsbHubClearPortFeature (
 
 
 /**
-  Interface function to reset the port.
+  Run a port reset to completion, stalling between the steps.
 
   @param  HubIf                 The hub interface.
   @param  Port                  The port to reset.
+  @param  ResetPortStep         The function running one reset step.
+
+  @retval EFI_SUCCESS           The port is reset.
+  @retval Others                Failed to reset the port.
+
+**/
+EFI_STATUS
+UsbHubRunResetSteps (
+  IN USB_INTERFACE            *HubIf,
+  IN UINT8                    Port,
+  IN USB_HUB_RESET_PORT_STEP  ResetPortStep
+  )
+{
+  USB_PORT_RESET_CONTEXT  Reset;
+  EFI_STATUS              Status;
+
+  ZeroMem (&Reset, sizeof (USB_PORT_RESET_CONTEXT));
+  Reset.PollStall = USB_WAIT_PORT_STS_CHANGE_STALL;
+
+  do {
+    Status = ResetPortStep (HubIf, Port, &Reset);
+
+    if (Status == EFI_NOT_READY) {
+      gBS->Stall (Reset.Delay);
+    }
+  } while (Status == EFI_NOT_READY);
+
+  return Status;
+}
+
+
+/**
+  Run the next step of the port reset.
+
+  @param  HubIf                 The hub interface.
+  @param  Port                  The port to reset.
+  @param  Reset                 The progress of the reset.
 
   @retval EFI_SUCCESS           The hub port is reset.
+  @retval EFI_NOT_READY         Call again after Reset->Delay microseconds.
   @retval EFI_TIMEOUT           Failed to reset the port in time.
   @retval Others                Failed to reset the port.
 
 **/
 EFI_STATUS
-UsbHubResetPort (
-  IN USB_INTERFACE        *HubIf,
-  IN UINT8                Port
+UsbHubResetPortStep (
+  IN     USB_INTERFACE          *HubIf,
+  IN     UINT8                  Port,
+  IN OUT USB_PORT_RESET_CONTEXT *Reset
   )
 {
   EFI_USB_PORT_STATUS     PortState;
-  UINTN                   Index;
   EFI_STATUS              Status;
 
-  Status  = UsbHubSetPortFeature (HubIf, Port, (EFI_USB_PORT_FEATURE) USB_HUB_PORT_RESET);
+  switch (Reset->Step) {
+  case USB_PORT_RESET_START:
+    Status  = UsbHubSetPortFeature (HubIf, Port, (EFI_USB_PORT_FEATURE) USB_HUB_PORT_RESET);
 
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  //
-  // Drive the reset signal for worst 20ms. Check USB 2.0 Spec
-  // section 7.1.7.5 for timing requirements.
-  //
-  gBS->Stall (USB_SET_PORT_RESET_STALL);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
 
-  //
-  // Check USB_PORT_STAT_C_RESET bit to see if the resetting state is done.
-  //
-  ZeroMem (&PortState, sizeof (EFI_USB_PORT_STATUS));
+    //
+    // Drive the reset signal for worst 20ms. Check USB 2.0 Spec
+    // section 7.1.7.5 for timing requirements.
+    //
+    Reset->Step  = USB_PORT_RESET_WAIT;
+    Reset->Delay = USB_SET_PORT_RESET_STALL;
+    return EFI_NOT_READY;
 
-  for (Index = 0; Index < USB_WAIT_PORT_STS_CHANGE_LOOP; Index++) {
+  case USB_PORT_RESET_WAIT:
+    //
+    // Check USB_PORT_STAT_C_RESET bit to see if the resetting state is done.
+    //
+    ZeroMem (&PortState, sizeof (EFI_USB_PORT_STATUS));
     Status = UsbHubGetPortStatus (HubIf, Port, &PortState);
 
     if (EFI_ERROR (Status)) {
       return Status;
     }
 
-    if (!EFI_ERROR (Status) &&
-        USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET)) {
-      gBS->Stall (USB_SET_PORT_RECOVERY_STALL);
-      return EFI_SUCCESS;
+    if (USB_BIT_IS_SET (PortState.PortChangeStatus, USB_PORT_STAT_C_RESET)) {
+      Reset->Step  = USB_PORT_RESET_RECOVERY;
+      Reset->Delay = USB_SET_PORT_RECOVERY_STALL;
+      return EFI_NOT_READY;
+    }
+
+    Reset->PollTime += Reset->PollStall;
+
+    if (Reset->PollTime >= USB_WAIT_PORT_STS_CHANGE_TIMEOUT) {
+      return EFI_TIMEOUT;
     }
 
-    gBS->Stall (USB_WAIT_PORT_STS_CHANGE_STALL);
+    Reset->Delay = Reset->PollStall;
+    return EFI_NOT_READY;
+
+  default:
+    return EFI_SUCCESS;
   }
+}
+
+
+/**
+  Interface function to reset the port.
 
-  return EFI_TIMEOUT;
+  @param  HubIf                 The hub interface.
+  @param  Port                  The port to reset.
+
+  @retval EFI_SUCCESS           The hub port is reset.
+  @retval EFI_TIMEOUT           Failed to reset the port in time.
+  @retval Others                Failed to reset the port.
+
+**/
+EFI_STATUS
+UsbHubResetPort (
+  IN USB_INTERFACE        *HubIf,
+  IN UINT8                Port
+  )
+{
+  return UsbHubRunResetSteps (HubIf, Port, UsbHubResetPortStep);
 }
 
 
@@ -929,6 +1007,7 @@ UsbHubRelease (
   }
 
   gBS->CloseEvent (HubIf->HubNotify);
+  UsbPortEnumRelease (HubIf);
 
   HubIf->IsHub      = FALSE;
   HubIf->HubApi     = NULL;
@@ -976,6 +1055,12 @@ UsbRootHubInit (
   HubIf->NumOfPort  = NumOfPort;
   HubIf->HubNotify  = NULL;
 
+  Status = UsbPortEnumInit (HubIf);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   //
   // Create a timer to poll root hub ports periodically
   //
@@ -988,6 +1073,7 @@ UsbRootHubInit (
                   );
 
   if (EFI_ERROR (Status)) {
+    UsbPortEnumRelease (HubIf);
     return Status;
   }
 
@@ -1005,6 +1091,7 @@ UsbRootHubInit (
 
   if (EFI_ERROR (Status)) {
     gBS->CloseEvent (HubIf->HubNotify);
+    UsbPortEnumRelease (HubIf);
   }
 
   return Status;
@@ -1135,12 +1222,14 @@ UsbRootHubClearPortFeature (
 
 
 /**
-  Interface function to reset the root hub port.
+  Run the next step of the root hub port reset.
 
   @param  RootIf                The root hub interface.
   @param  Port                  The port to reset.
+  @param  Reset                 The progress of the reset.
 
   @retval EFI_SUCCESS           The hub port is reset.
+  @retval EFI_NOT_READY         Call again after Reset->Delay microseconds.
   @retval EFI_TIMEOUT           Failed to reset the port in time.
   @retval EFI_NOT_FOUND         The low/full speed device connected to high  speed.
                                 root hub is released to the companion UHCI.
@@ -1148,15 +1237,15 @@ UsbRootHubClearPortFeature (
 
 **/
 EFI_STATUS
-UsbRootHubResetPort (
-  IN USB_INTERFACE        *RootIf,
-  IN UINT8                Port
+UsbRootHubResetPortStep (
+  IN     USB_INTERFACE          *RootIf,
+  IN     UINT8                  Port,
+  IN OUT USB_PORT_RESET_CONTEXT *Reset
   )
 {
   USB_BUS                 *Bus;
   EFI_STATUS              Status;
   EFI_USB_PORT_STATUS     PortState;
-  UINTN                   Index;
 
   //
   // Notice: although EHCI requires that ENABLED bit be cleared
@@ -1165,80 +1254,115 @@ UsbRootHubResetPort (
   //
   Bus     = RootIf->Device->Bus;
 
-  Status  = UsbHcSetRootHubPortFeature (Bus, Port, EfiUsbPortReset);
+  switch (Reset->Step) {
+  case USB_PORT_RESET_START:
+    Status  = UsbHcSetRootHubPortFeature (Bus, Port, EfiUsbPortReset);
 
-  if (EFI_ERROR (Status)) {
-    DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: failed to start reset on port %d\n", Port));
-    return Status;
-  }
-
-  //
-  // Drive the reset signal for at least 50ms. Check USB 2.0 Spec
-  // section 7.1.7.5 for timing requirements.
-  //
-  gBS->Stall (USB_SET_ROOT_PORT_RESET_STALL);
+    if (EFI_ERROR (Status)) {
+      DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: failed to start reset on port %d\n", Port));
+      return Status;
+    }
 
-  Status = UsbHcClearRootHubPortFeature (Bus, Port, EfiUsbPortReset);
+    //
+    // Drive the reset signal for at least 50ms. Check USB 2.0 Spec
+    // section 7.1.7.5 for timing requirements.
+    //
+    Reset->Step  = USB_PORT_RESET_CLEAR;
+    Reset->Delay = USB_SET_ROOT_PORT_RESET_STALL;
+    return EFI_NOT_READY;
 
-  if (EFI_ERROR (Status)) {
-    DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: failed to clear reset on port %d\n", Port));
-    return Status;
-  }
+  case USB_PORT_RESET_CLEAR:
+    Status = UsbHcClearRootHubPortFeature (Bus, Port, EfiUsbPortReset);
 
-  gBS->Stall (USB_CLR_ROOT_PORT_RESET_STALL);
+    if (EFI_ERROR (Status)) {
+      DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: failed to clear reset on port %d\n", Port));
+      return Status;
+    }
 
-  //
-  // USB host controller won't clear the RESET bit until
-  // reset is actually finished.
-  //
-  ZeroMem (&PortState, sizeof (EFI_USB_PORT_STATUS));
+    Reset->Step  = USB_PORT_RESET_WAIT;
+    Reset->Delay = USB_CLR_ROOT_PORT_RESET_STALL;
+    return EFI_NOT_READY;
 
-  for (Index = 0; Index < USB_WAIT_PORT_STS_CHANGE_LOOP; Index++) {
+  case USB_PORT_RESET_WAIT:
+    //
+    // USB host controller won't clear the RESET bit until
+    // reset is actually finished.
+    //
+    ZeroMem (&PortState, sizeof (EFI_USB_PORT_STATUS));
     Status = UsbHcGetRootHubPortStatus (Bus, Port, &PortState);
 
     if (EFI_ERROR (Status)) {
       return Status;
     }
 
-    if (!USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_RESET)) {
-      break;
-    }
+    if (USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_RESET)) {
+      Reset->PollTime += Reset->PollStall;
 
-    gBS->Stall (USB_WAIT_PORT_STS_CHANGE_STALL);
-  }
+      if (Reset->PollTime >= USB_WAIT_PORT_STS_CHANGE_TIMEOUT) {
+        DEBUG ((EFI_D_ERROR, "UsbRootHubResetPort: reset not finished in time on port %d\n", Port));
+        return EFI_TIMEOUT;
+      }
 
-  if (Index == USB_WAIT_PORT_STS_CHANGE_LOOP) {
-    DEBUG ((EFI_D_ERROR, "UsbRootHubResetPort: reset not finished in time on port %d\n", Port));
-    return EFI_TIMEOUT;
-  }
+      Reset->Delay = Reset->PollStall;
+      return EFI_NOT_READY;
+    }
 
-  if (!USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_ENABLE)) {
-    //
-    // OK, the port is reset. If root hub is of high speed and
-    // the device is of low/full speed, release the ownership to
-    // companion UHCI. If root hub is of full speed, it won't
-    // automatically enable the port, we need to enable it manually.
-    //
-    if (RootIf->MaxSpeed == EFI_USB_SPEED_HIGH) {
-      DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: release low/full speed device (%d) to UHCI\n", Port));
+    if (!USB_BIT_IS_SET (PortState.PortStatus, USB_PORT_STAT_ENABLE)) {
+      //
+      // OK, the port is reset. If root hub is of high speed and
+      // the device is of low/full speed, release the ownership to
+      // companion UHCI. If root hub is of full speed, it won't
+      // automatically enable the port, we need to enable it manually.
+      //
+      if (RootIf->MaxSpeed == EFI_USB_SPEED_HIGH) {
+        DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: release low/full speed device (%d) to UHCI\n", Port));
 
-      UsbRootHubSetPortFeature (RootIf, Port, EfiUsbPortOwner);
-      return EFI_NOT_FOUND;
+        UsbRootHubSetPortFeature (RootIf, Port, EfiUsbPortOwner);
+        return EFI_NOT_FOUND;
 
-    } else {
+      } else {
 
-      Status = UsbRootHubSetPortFeature (RootIf, Port, EfiUsbPortEnable);
+        Status = UsbRootHubSetPortFeature (RootIf, Port, EfiUsbPortEnable);
 
-      if (EFI_ERROR (Status)) {
-        DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: failed to enable port %d for UHCI\n", Port));
-        return Status;
-      }
+        if (EFI_ERROR (Status)) {
+          DEBUG (( EFI_D_ERROR, "UsbRootHubResetPort: failed to enable port %d for UHCI\n", Port));
+          return Status;
+        }
 
-      gBS->Stall (USB_SET_ROOT_PORT_ENABLE_STALL);
+        Reset->Step  = USB_PORT_RESET_RECOVERY;
+        Reset->Delay = USB_SET_ROOT_PORT_ENABLE_STALL;
+        return EFI_NOT_READY;
+      }
     }
+
+    return EFI_SUCCESS;
+
+  default:
+    return EFI_SUCCESS;
   }
+}
 
-  return EFI_SUCCESS;
+
+/**
+  Interface function to reset the root hub port.
+
+  @param  RootIf                The root hub interface.
+  @param  Port                  The port to reset.
+
+  @retval EFI_SUCCESS           The hub port is reset.
+  @retval EFI_TIMEOUT           Failed to reset the port in time.
+  @retval EFI_NOT_FOUND         The low/full speed device connected to high  speed.
+                                root hub is released to the companion UHCI.
+  @retval Others                Failed to reset the port.
+
+**/
+EFI_STATUS
+UsbRootHubResetPort (
+  IN USB_INTERFACE        *RootIf,
+  IN UINT8                Port
+  )
+{
+  return UsbHubRunResetSteps (RootIf, Port, UsbRootHubResetPortStep);
 }
 
 
@@ -1260,6 +1384,7 @@ UsbRootHubRelease (
 
   gBS->SetTimer (HubIf->HubNotify, TimerCancel, USB_ROOTHUB_POLL_INTERVAL);
   gBS->CloseEvent (HubIf->HubNotify);
+  UsbPortEnumRelease (HubIf);
 
   return EFI_SUCCESS;
 }
@@ -1271,6 +1396,7 @@ USB_HUB_API mUsbHubApi = {
   UsbHubSetPortFeature,
   UsbHubClearPortFeature,
   UsbHubResetPort,
+  UsbHubResetPortStep,
   UsbHubRelease
 };
 
@@ -1281,5 +1407,6 @@ USB_HUB_API mUsbRootHubApi = {
   UsbRootHubSetPortFeature,
   UsbRootHubClearPortFeature,
   UsbRootHubResetPort,
+  UsbRootHubResetPortStep,
   UsbRootHubRelease
 };
@@ -94,6 +94,31 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // after 500ms(LOOP * STALL = 5000 * 0.1ms), set by experience
 //
 #define USB_WAIT_PORT_STS_CHANGE_LOOP  5000
+#define USB_WAIT_PORT_STS_CHANGE_TIMEOUT \
+          (USB_WAIT_PORT_STS_CHANGE_LOOP * USB_WAIT_PORT_STS_CHANGE_STALL)
+
+//
+// Steps of a port reset. The reset is driven one step at a time so
+// that the waits in between can be either stalls or timer events.
+//
+#define USB_PORT_RESET_START        0
+#define USB_PORT_RESET_CLEAR        1
+#define USB_PORT_RESET_WAIT         2
+#define USB_PORT_RESET_RECOVERY     3
+
+typedef struct {
+  UINT8                 Step;
+  //
+  // Microseconds to wait before the next step, set by the step.
+  //
+  UINT32                Delay;
+  //
+  // Microseconds between two port status polls, set by the caller,
+  // and the time spent polling for the reset to complete so far.
+  //
+  UINT32                PollStall;
+  UINT32                PollTime;
+} USB_PORT_RESET_CONTEXT;
 
 #pragma pack(1)
 //
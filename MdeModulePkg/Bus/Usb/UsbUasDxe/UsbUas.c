@@ -0,0 +1,841 @@
+/** @file
+  USB Attached SCSI (UAS) driver. It selects the UAS alternate setting of a
+  USB mass storage interface and produces the Extended SCSI Pass Thru
+  Protocol on it, so that ScsiBusDxe and ScsiDiskDxe drive the device.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbUas.h"
+
+//
+// The version is above the one of UsbMassStorageDxe, so that an interface
+// with a UAS setting is offered to this driver first. The BOT driver takes
+// the interface over if this driver fails to start on it.
+//
+EFI_DRIVER_BINDING_PROTOCOL gUsbUasDriverBinding = {
+  UsbUasDriverBindingSupported,
+  UsbUasDriverBindingStart,
+  UsbUasDriverBindingStop,
+  0x12,
+  NULL,
+  NULL
+};
+
+/**
+  Check whether a Target ID addresses the single target of the device.
+
+  @param  Target                The Target ID to check.
+
+  @retval TRUE                  Target is all zero.
+  @retval FALSE                 Target is something else.
+
+**/
+BOOLEAN
+UsbUasIsTargetZero (
+  IN UINT8                      *Target
+  )
+{
+  return IsZeroBuffer (Target, TARGET_MAX_BYTES);
+}
+
+/**
+  Look up a LUN in the list of LUNs reported by the device.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to look up.
+
+  @return The index of Lun in the list, or LunCount if it isn't there.
+
+**/
+UINTN
+UsbUasLunIndex (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT64                     Lun
+  )
+{
+  UINTN                         Index;
+
+  for (Index = 0; Index < UasDev->LunCount; Index++) {
+    if (UasDev->Luns[Index] == Lun) {
+      break;
+    }
+  }
+
+  return Index;
+}
+
+/**
+  Build the list of LUNs of the device with REPORT LUNS. The device is
+  assumed to have LUN 0 only if the command fails.
+
+  @param  UasDev                The UAS device.
+
+**/
+VOID
+UsbUasDiscoverLuns (
+  IN USB_UAS_DEVICE             *UasDev
+  )
+{
+  EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET  Packet;
+  UINT8                         Cdb[12];
+  EFI_SCSI_SENSE_DATA           SenseData;
+  UINT8                         *Data;
+  UINT8                         *Entry;
+  UINT32                        DataLength;
+  UINT32                        ListLength;
+  UINT32                        Count;
+  UINT32                        Index;
+  UINTN                         Retry;
+  EFI_STATUS                    Status;
+
+  UasDev->LunCount = 1;
+  UasDev->Luns[0]  = 0;
+
+  DataLength = 8 + 8 * USB_UAS_MAX_LUNS;
+  Data       = AllocateZeroPool (DataLength);
+  if (Data == NULL) {
+    return;
+  }
+
+  ZeroMem (Cdb, sizeof (Cdb));
+  Cdb[0] = USB_UAS_OP_REPORT_LUNS;
+  WriteUnaligned32 ((UINT32 *) &Cdb[6], SwapBytes32 (DataLength));
+
+  //
+  // The first command after the setting is selected may just report the
+  // UNIT ATTENTION of the power on, so try twice.
+  //
+  Status = EFI_DEVICE_ERROR;
+  for (Retry = 0; Retry < 2; Retry++) {
+    ZeroMem (&Packet, sizeof (Packet));
+    Packet.Timeout          = USB_UAS_REPORT_LUNS_TIMEOUT;
+    Packet.Cdb              = Cdb;
+    Packet.CdbLength        = sizeof (Cdb);
+    Packet.InDataBuffer     = Data;
+    Packet.InTransferLength = DataLength;
+    Packet.SenseData        = &SenseData;
+    Packet.SenseDataLength  = sizeof (SenseData);
+    Packet.DataDirection    = EFI_EXT_SCSI_DATA_DIRECTION_READ;
+
+    Status = UsbUasExecCommand (UasDev, 0, &Packet);
+    if (!EFI_ERROR (Status) && (Packet.TargetStatus == EFI_EXT_SCSI_STATUS_TARGET_GOOD) &&
+        (Packet.InTransferLength >= 8)) {
+      break;
+    }
+
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "UsbUasDiscoverLuns: REPORT LUNS failed, use LUN 0 only\n"));
+    FreePool (Data);
+    return;
+  }
+
+  ListLength = SwapBytes32 (ReadUnaligned32 ((UINT32 *) Data));
+  Count      = MIN (ListLength, Packet.InTransferLength - 8) / 8;
+  Count      = MIN (Count, USB_UAS_MAX_LUNS);
+
+  UasDev->LunCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    Entry = Data + 8 + 8 * Index;
+
+    switch (Entry[0] >> 6) {
+    case 0:
+      //
+      // Peripheral device addressing, only bus 0 is reachable.
+      //
+      if (Entry[0] == 0) {
+        UasDev->Luns[UasDev->LunCount++] = Entry[1];
+      }
+      break;
+
+    case 1:
+      //
+      // Flat space addressing
+      //
+      UasDev->Luns[UasDev->LunCount++] = ((Entry[0] & 0x3F) << 8) | Entry[1];
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  if (UasDev->LunCount == 0) {
+    UasDev->LunCount = 1;
+    UasDev->Luns[0]  = 0;
+  }
+
+  DEBUG ((DEBUG_INFO, "UsbUasDiscoverLuns: %d LUN(s) found\n", UasDev->LunCount));
+  FreePool (Data);
+}
+
+/**
+  Sends a SCSI Request Packet to a SCSI device that is attached to the SCSI channel.
+
+  The USB I/O Protocol only offers synchronous bulk transfers, so the IUs of
+  a command can't be received without waiting on the status pipe. Nonblocking
+  I/O is not advertised and every request is executed before returning.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                The Target ID of the SCSI device.
+  @param  Lun                   The LUN of the SCSI device.
+  @param  Packet                A pointer to the SCSI Request Packet to send.
+  @param  Event                 Ignored, nonblocking I/O is not supported.
+
+  @retval EFI_SUCCESS           The SCSI Request Packet was sent by the host.
+  @retval EFI_NOT_READY         Too many SCSI Request Packets are already queued.
+  @retval EFI_DEVICE_ERROR      A device error occurred.
+  @retval EFI_INVALID_PARAMETER Target, Lun, or the contents of Packet are invalid.
+  @retval EFI_TIMEOUT           A timeout occurred while waiting for the SCSI Request Packet.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasPassThru (
+  IN EFI_EXT_SCSI_PASS_THRU_PROTOCOL                    *This,
+  IN UINT8                                              *Target,
+  IN UINT64                                             Lun,
+  IN OUT EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET     *Packet,
+  IN EFI_EVENT                                          Event OPTIONAL
+  )
+{
+  USB_UAS_DEVICE                *UasDev;
+  EFI_TPL                       OldTpl;
+  EFI_STATUS                    Status;
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (This);
+
+  if ((Packet == NULL) || (Packet->Cdb == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Don't support variable length CDB
+  //
+  if ((Packet->CdbLength != 6) && (Packet->CdbLength != 10) &&
+      (Packet->CdbLength != 12) && (Packet->CdbLength != 16)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Packet->SenseDataLength != 0) && (Packet->SenseData == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (((Packet->InTransferLength != 0) && (Packet->InDataBuffer == NULL)) ||
+      ((Packet->OutTransferLength != 0) && (Packet->OutDataBuffer == NULL))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Target == NULL) || !UsbUasIsTargetZero (Target) ||
+      (UsbUasLunIndex (UasDev, Lun) == UasDev->LunCount)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (USB_UAS_TPL);
+  Status = UsbUasExecCommand (UasDev, Lun, Packet);
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Used to retrieve the list of legal Target IDs and LUNs for SCSI devices on a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                On input, the Target ID of a SCSI device, all 0xFF to get
+                                the first one. On output, the Target ID of the next device.
+  @param  Lun                   On input, the LUN of a SCSI device. On output, the LUN of
+                                the next device.
+
+  @retval EFI_SUCCESS           The Target ID and LUN of the next SCSI device was returned.
+  @retval EFI_INVALID_PARAMETER Target or Lun is invalid.
+  @retval EFI_NOT_FOUND         There are no more SCSI devices on this SCSI channel.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetNextTargetLun (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN OUT UINT8                           **Target,
+  IN OUT UINT64                          *Lun
+  )
+{
+  USB_UAS_DEVICE                *UasDev;
+  UINT8                         TargetId[TARGET_MAX_BYTES];
+  UINTN                         Index;
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (This);
+
+  if ((Target == NULL) || (*Target == NULL) || (Lun == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // If the array is all 0xFF's, return the first LUN to caller.
+  //
+  SetMem (TargetId, TARGET_MAX_BYTES, 0xFF);
+  if (CompareMem (*Target, TargetId, TARGET_MAX_BYTES) == 0) {
+    SetMem (*Target, TARGET_MAX_BYTES, 0x00);
+    *Lun = UasDev->Luns[0];
+    return EFI_SUCCESS;
+  }
+
+  if (!UsbUasIsTargetZero (*Target)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Index = UsbUasLunIndex (UasDev, *Lun);
+  if (Index == UasDev->LunCount) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Index + 1 == UasDev->LunCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Lun = UasDev->Luns[Index + 1];
+  return EFI_SUCCESS;
+}
+
+/**
+  Used to allocate and build a device path node for a SCSI device on a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                The Target ID of the SCSI device.
+  @param  Lun                   The LUN of the SCSI device.
+  @param  DevicePath            Return the allocated device path node.
+
+  @retval EFI_SUCCESS           The device path node was allocated and returned.
+  @retval EFI_INVALID_PARAMETER DevicePath is NULL.
+  @retval EFI_NOT_FOUND         The SCSI device specified by Target and Lun does not exist.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to allocate DevicePath.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasBuildDevicePath (
+  IN     EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN     UINT8                              *Target,
+  IN     UINT64                             Lun,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL           **DevicePath
+  )
+{
+  USB_UAS_DEVICE                *UasDev;
+  SCSI_DEVICE_PATH              *ScsiNode;
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (This);
+
+  if ((Target == NULL) || (DevicePath == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!UsbUasIsTargetZero (Target) || (UsbUasLunIndex (UasDev, Lun) == UasDev->LunCount)) {
+    return EFI_NOT_FOUND;
+  }
+
+  ScsiNode = (SCSI_DEVICE_PATH *) CreateDeviceNode (
+                                    MESSAGING_DEVICE_PATH,
+                                    MSG_SCSI_DP,
+                                    (UINT16) sizeof (SCSI_DEVICE_PATH)
+                                    );
+  if (ScsiNode == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ScsiNode->Pun = 0;
+  ScsiNode->Lun = (UINT16) Lun;
+
+  *DevicePath = (EFI_DEVICE_PATH_PROTOCOL *) ScsiNode;
+  return EFI_SUCCESS;
+}
+
+/**
+  Used to translate a device path node to a Target ID and LUN.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  DevicePath            A single device path node describing the SCSI device.
+  @param  Target                Return the Target ID of the SCSI device.
+  @param  Lun                   Return the LUN of the SCSI device.
+
+  @retval EFI_SUCCESS           DevicePath was translated to a Target ID and LUN.
+  @retval EFI_INVALID_PARAMETER DevicePath, Target or Lun is NULL.
+  @retval EFI_NOT_FOUND         No SCSI device matches DevicePath.
+  @retval EFI_UNSUPPORTED       The device path node type is not supported.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetTargetLun (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN  EFI_DEVICE_PATH_PROTOCOL           *DevicePath,
+  OUT UINT8                              **Target,
+  OUT UINT64                             *Lun
+  )
+{
+  USB_UAS_DEVICE                *UasDev;
+  SCSI_DEVICE_PATH              *ScsiNode;
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (This);
+
+  if ((DevicePath == NULL) || (Target == NULL) || (*Target == NULL) || (Lun == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((DevicePathType (DevicePath) != MESSAGING_DEVICE_PATH) ||
+      (DevicePathSubType (DevicePath) != MSG_SCSI_DP) ||
+      (DevicePathNodeLength (DevicePath) != sizeof (SCSI_DEVICE_PATH))) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ScsiNode = (SCSI_DEVICE_PATH *) DevicePath;
+  if ((ScsiNode->Pun != 0) || (UsbUasLunIndex (UasDev, ScsiNode->Lun) == UasDev->LunCount)) {
+    return EFI_NOT_FOUND;
+  }
+
+  SetMem (*Target, TARGET_MAX_BYTES, 0x00);
+  *Lun = ScsiNode->Lun;
+  return EFI_SUCCESS;
+}
+
+/**
+  Resets a SCSI channel. This operation resets all the SCSI devices connected to the SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+
+  @retval EFI_SUCCESS           The SCSI channel was reset.
+  @retval EFI_DEVICE_ERROR      A device error occurred while resetting the SCSI channel.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasResetChannel (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL   *This
+  )
+{
+  USB_UAS_DEVICE                *UasDev;
+  EFI_TPL                       OldTpl;
+  EFI_STATUS                    Status;
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (This);
+
+  OldTpl = gBS->RaiseTPL (USB_UAS_TPL);
+  Status = UsbUasResetDevice (UasDev);
+  gBS->RestoreTPL (OldTpl);
+
+  return EFI_ERROR (Status) ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+}
+
+/**
+  Resets a SCSI logical unit that is connected to a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                The Target ID of the SCSI device.
+  @param  Lun                   The LUN of the SCSI device to reset.
+
+  @retval EFI_SUCCESS           The SCSI device specified by Target and Lun was reset.
+  @retval EFI_INVALID_PARAMETER Target or Lun is invalid.
+  @retval EFI_TIMEOUT           A timeout occurred while resetting the SCSI device.
+  @retval EFI_DEVICE_ERROR      A device error occurred while resetting the SCSI device.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasResetTargetLun (
+  IN EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN UINT8                              *Target,
+  IN UINT64                             Lun
+  )
+{
+  USB_UAS_DEVICE                *UasDev;
+  EFI_TPL                       OldTpl;
+  EFI_STATUS                    Status;
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (This);
+
+  if ((Target == NULL) || !UsbUasIsTargetZero (Target) ||
+      (UsbUasLunIndex (UasDev, Lun) == UasDev->LunCount)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  OldTpl = gBS->RaiseTPL (USB_UAS_TPL);
+  Status = UsbUasResetLun (UasDev, Lun);
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status) && (Status != EFI_TIMEOUT)) {
+    Status = EFI_DEVICE_ERROR;
+  }
+
+  return Status;
+}
+
+/**
+  Used to retrieve the list of legal Target IDs for SCSI devices on a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                On input, the Target ID of a SCSI device, all 0xFF to get
+                                the first one. On output, the Target ID of the next device.
+
+  @retval EFI_SUCCESS           The Target ID of the next SCSI device was returned.
+  @retval EFI_INVALID_PARAMETER Target is NULL.
+  @retval EFI_NOT_FOUND         There are no more SCSI devices on this SCSI channel.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetNextTarget (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN OUT UINT8                           **Target
+  )
+{
+  UINT8                         TargetId[TARGET_MAX_BYTES];
+
+  if ((Target == NULL) || (*Target == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SetMem (TargetId, TARGET_MAX_BYTES, 0xFF);
+  if (CompareMem (*Target, TargetId, TARGET_MAX_BYTES) == 0) {
+    SetMem (*Target, TARGET_MAX_BYTES, 0x00);
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Check whether the controller is a USB mass storage interface of a device
+  that may run UAS without bulk streams.
+
+  Only the descriptors cached by the USB bus driver are looked at. Whether
+  the interface has a UAS alternate setting is found out by Start().
+
+  @param  This                   The USB UAS driver binding protocol.
+  @param  Controller             The controller handle to check.
+  @param  RemainingDevicePath    The remaining device path.
+
+  @retval EFI_SUCCESS            The driver supports this controller.
+  @retval other                  This device isn't supported.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasDriverBindingSupported (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   Controller,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
+  )
+{
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_USB_DEVICE_DESCRIPTOR     DevDesc;
+  EFI_STATUS                    Status;
+
+  Status = gBS->OpenProtocol (
+                  Controller,
+                  &gEfiUsbIoProtocolGuid,
+                  (VOID **) &UsbIo,
+                  This->DriverBindingHandle,
+                  Controller,
+                  EFI_OPEN_PROTOCOL_BY_DRIVER
+                  );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  if ((Interface.InterfaceClass != USB_MASS_STORE_CLASS) ||
+      (Interface.InterfaceSubClass != USB_MASS_STORE_SCSI)) {
+    Status = EFI_UNSUPPORTED;
+    goto ON_EXIT;
+  }
+
+  Status = UsbIo->UsbGetDeviceDescriptor (UsbIo, &DevDesc);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  //
+  // bcdUSB reflects the speed the device runs at. UAS needs a high-speed
+  // link, and over SuperSpeed the device only runs it on bulk streams,
+  // which the USB I/O Protocol doesn't expose.
+  //
+  if ((DevDesc.BcdUSB < USB_UAS_MIN_BCD_USB) || (DevDesc.BcdUSB >= USB_UAS_SS_BCD_USB)) {
+    Status = EFI_UNSUPPORTED;
+  }
+
+ON_EXIT:
+  gBS->CloseProtocol (
+         Controller,
+         &gEfiUsbIoProtocolGuid,
+         This->DriverBindingHandle,
+         Controller
+         );
+
+  return Status;
+}
+
+/**
+  Select the UAS setting of the interface and install the Extended SCSI
+  Pass Thru Protocol on it.
+
+  @param  This                   The USB UAS driver binding protocol.
+  @param  Controller             The USB interface to start on.
+  @param  RemainingDevicePath    The remaining device path.
+
+  @retval EFI_SUCCESS            The driver is started.
+  @retval EFI_UNSUPPORTED        This driver does not support this device.
+  @retval EFI_OUT_OF_RESOURCES   Can't allocate memory resources.
+  @retval Others                 Failed to start the device.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasDriverBindingStart (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   Controller,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
+  )
+{
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+  USB_UAS_DEVICE                *UasDev;
+  BOOLEAN                       SettingSelected;
+  UINT32                        UsbStatus;
+  EFI_TPL                       OldTpl;
+  EFI_STATUS                    Status;
+
+  OldTpl          = gBS->RaiseTPL (USB_UAS_TPL);
+  UasDev          = NULL;
+  SettingSelected = FALSE;
+
+  Status = gBS->OpenProtocol (
+                  Controller,
+                  &gEfiUsbIoProtocolGuid,
+                  (VOID **) &UsbIo,
+                  This->DriverBindingHandle,
+                  Controller,
+                  EFI_OPEN_PROTOCOL_BY_DRIVER
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasDriverBindingStart: OpenProtocol (UsbIo) %r\n", Status));
+    goto ON_EXIT;
+  }
+
+  UasDev = AllocateZeroPool (sizeof (USB_UAS_DEVICE));
+  if (UasDev == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_ERROR;
+  }
+
+  UasDev->Signature  = USB_UAS_SIGNATURE;
+  UasDev->Controller = Controller;
+  UasDev->UsbIo      = UsbIo;
+
+  //
+  // Finding the UAS setting takes reading the configuration from the device,
+  // so it is left out of Supported(). The BOT driver gets the interface if
+  // there is none.
+  //
+  Status = UsbUasFindPipes (UsbIo, &UasDev->Pipes);
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  UasDev->StatusBuffer = AllocateZeroPool (UasDev->Pipes.StatusPacketSize);
+  if (UasDev->StatusBuffer == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_ERROR;
+  }
+
+  Status = UsbSetInterface (
+             UsbIo,
+             UasDev->Pipes.InterfaceNumber,
+             UasDev->Pipes.AlternateSetting,
+             &UsbStatus
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasDriverBindingStart: failed to select UAS setting - %r\n", Status));
+    goto ON_ERROR;
+  }
+
+  SettingSelected = TRUE;
+
+  UasDev->ExtScsiPassThruMode.AdapterId  = 0xFFFFFFFF;
+  UasDev->ExtScsiPassThruMode.Attributes = EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_PHYSICAL |
+                                           EFI_EXT_SCSI_PASS_THRU_ATTRIBUTES_LOGICAL;
+  UasDev->ExtScsiPassThruMode.IoAlign    = 0;
+
+  UasDev->ExtScsiPassThru.Mode             = &UasDev->ExtScsiPassThruMode;
+  UasDev->ExtScsiPassThru.PassThru         = UsbUasPassThru;
+  UasDev->ExtScsiPassThru.GetNextTargetLun = UsbUasGetNextTargetLun;
+  UasDev->ExtScsiPassThru.BuildDevicePath  = UsbUasBuildDevicePath;
+  UasDev->ExtScsiPassThru.GetTargetLun     = UsbUasGetTargetLun;
+  UasDev->ExtScsiPassThru.ResetChannel     = UsbUasResetChannel;
+  UasDev->ExtScsiPassThru.ResetTargetLun   = UsbUasResetTargetLun;
+  UasDev->ExtScsiPassThru.GetNextTarget    = UsbUasGetNextTarget;
+
+  UsbUasDiscoverLuns (UasDev);
+
+  Status = gBS->InstallProtocolInterface (
+                  &Controller,
+                  &gEfiExtScsiPassThruProtocolGuid,
+                  EFI_NATIVE_INTERFACE,
+                  &UasDev->ExtScsiPassThru
+                  );
+  if (EFI_ERROR (Status)) {
+    goto ON_ERROR;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "UsbUasDriverBindingStart: UAS started on interface %d setting %d\n",
+    UasDev->Pipes.InterfaceNumber,
+    UasDev->Pipes.AlternateSetting
+    ));
+  goto ON_EXIT;
+
+ON_ERROR:
+  if (UasDev != NULL) {
+    //
+    // Give the interface back to the BOT driver in its default setting.
+    //
+    if (SettingSelected) {
+      UsbSetInterface (UsbIo, UasDev->Pipes.InterfaceNumber, 0, &UsbStatus);
+    }
+
+    if (UasDev->StatusBuffer != NULL) {
+      FreePool (UasDev->StatusBuffer);
+    }
+
+    FreePool (UasDev);
+  }
+
+  gBS->CloseProtocol (
+         Controller,
+         &gEfiUsbIoProtocolGuid,
+         This->DriverBindingHandle,
+         Controller
+         );
+
+ON_EXIT:
+  gBS->RestoreTPL (OldTpl);
+  return Status;
+}
+
+/**
+  Stop controlling the device.
+
+  @param  This                   The USB UAS driver binding.
+  @param  Controller             The device controller controlled by the driver.
+  @param  NumberOfChildren       The number of children of this device.
+  @param  ChildHandleBuffer      The buffer of children handle.
+
+  @retval EFI_SUCCESS            The driver stopped from controlling the device.
+  @retval Others                 Failed to stop the driver.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasDriverBindingStop (
+  IN  EFI_DRIVER_BINDING_PROTOCOL *This,
+  IN  EFI_HANDLE                  Controller,
+  IN  UINTN                       NumberOfChildren,
+  IN  EFI_HANDLE                  *ChildHandleBuffer
+  )
+{
+  EFI_EXT_SCSI_PASS_THRU_PROTOCOL  *ExtScsiPassThru;
+  USB_UAS_DEVICE                   *UasDev;
+  UINT32                           UsbStatus;
+  EFI_TPL                          OldTpl;
+  EFI_STATUS                       Status;
+
+  Status = gBS->OpenProtocol (
+                  Controller,
+                  &gEfiExtScsiPassThruProtocolGuid,
+                  (VOID **) &ExtScsiPassThru,
+                  This->DriverBindingHandle,
+                  Controller,
+                  EFI_OPEN_PROTOCOL_GET_PROTOCOL
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  UasDev = USB_UAS_DEVICE_FROM_PASS_THRU (ExtScsiPassThru);
+
+  Status = gBS->UninstallProtocolInterface (
+                  Controller,
+                  &gEfiExtScsiPassThruProtocolGuid,
+                  &UasDev->ExtScsiPassThru
+                  );
+  if (EFI_ERROR (Status)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  OldTpl = gBS->RaiseTPL (USB_UAS_TPL);
+
+  //
+  // Cleanup the requests left in flight and switch the interface back to
+  // its default setting.
+  //
+  UsbUasFailAllRequests (UasDev, EFI_EXT_SCSI_STATUS_HOST_ADAPTER_PHASE_ERROR);
+  UsbSetInterface (UasDev->UsbIo, UasDev->Pipes.InterfaceNumber, 0, &UsbStatus);
+
+  gBS->RestoreTPL (OldTpl);
+
+  gBS->CloseProtocol (
+         Controller,
+         &gEfiUsbIoProtocolGuid,
+         This->DriverBindingHandle,
+         Controller
+         );
+
+  FreePool (UasDev->StatusBuffer);
+  FreePool (UasDev);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Entrypoint of USB Attached SCSI Driver.
+
+  This function is the entrypoint of USB Attached SCSI Driver. It installs
+  Driver Binding Protocol together with Component Name Protocols.
+
+  @param  ImageHandle       The firmware allocated handle for the EFI image.
+  @param  SystemTable       A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS       The entry point is executed successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasEntryPoint (
+  IN EFI_HANDLE               ImageHandle,
+  IN EFI_SYSTEM_TABLE         *SystemTable
+  )
+{
+  EFI_STATUS  Status;
+
+  //
+  // Install driver binding protocol
+  //
+  Status = EfiLibInstallDriverBindingComponentName2 (
+             ImageHandle,
+             SystemTable,
+             &gUsbUasDriverBinding,
+             ImageHandle,
+             &gUsbUasComponentName,
+             &gUsbUasComponentName2
+             );
+  ASSERT_EFI_ERROR (Status);
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,651 @@
+/** @file
+  Definitions of the USB Attached SCSI (UAS) driver, which produces the
+  Extended SCSI Pass Thru Protocol for UAS interfaces.
+
+  This driver refers to USB Attached SCSI (UAS) Revision 1.0 and
+  SCSI Architecture Model - 4 (SAM-4) / T10 UAS-2.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _EFI_USB_UAS_H_
+#define _EFI_USB_UAS_H_
+
+#include <Uefi.h>
+#include <IndustryStandard/Scsi.h>
+#include <Protocol/UsbIo.h>
+#include <Protocol/DevicePath.h>
+#include <Protocol/ScsiPassThruExt.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/UefiDriverEntryPoint.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UefiUsbLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/DevicePathLib.h>
+
+//
+// Interface protocol code of the UAS transport (the USB mass storage class
+// and SCSI transparent subclass are shared with BOT).
+//
+#define USB_MASS_STORE_UAS              0x62
+
+//
+// Lowest bcdUSB of a device running at high speed, and lowest bcdUSB of a
+// device running at SuperSpeed, where UAS is only carried by bulk streams.
+//
+#define USB_UAS_MIN_BCD_USB             0x0200
+#define USB_UAS_SS_BCD_USB              0x0300
+
+//
+// Class specific descriptors attached to the UAS endpoints.
+//
+#define USB_UAS_DESC_TYPE_PIPE_USAGE    0x24
+#define USB_UAS_DESC_TYPE_SS_COMPANION  0x30
+#define USB_UAS_SS_MAX_STREAMS_MASK     0x1F
+
+#define USB_UAS_PIPE_ID_COMMAND         0x01
+#define USB_UAS_PIPE_ID_STATUS          0x02
+#define USB_UAS_PIPE_ID_DATA_IN         0x03
+#define USB_UAS_PIPE_ID_DATA_OUT        0x04
+
+//
+// Information Unit identifiers
+//
+#define USB_UAS_IU_COMMAND              0x01
+#define USB_UAS_IU_SENSE                0x03
+#define USB_UAS_IU_RESPONSE             0x04
+#define USB_UAS_IU_TASK_MANAGEMENT      0x05
+#define USB_UAS_IU_READ_READY           0x06
+#define USB_UAS_IU_WRITE_READY          0x07
+
+#define USB_UAS_TASK_ATTR_SIMPLE        0x00
+
+//
+// Task management functions and response codes.
+//
+#define USB_UAS_TMF_ABORT_TASK          0x01
+#define USB_UAS_TMF_LOGICAL_UNIT_RESET  0x08
+
+#define USB_UAS_RC_TMF_COMPLETE         0x00
+#define USB_UAS_RC_TMF_SUCCEEDED        0x08
+
+#define USB_UAS_OP_REPORT_LUNS          0xA0
+
+#pragma pack(1)
+///
+/// Pipe Usage descriptor, follows each endpoint descriptor of a UAS
+/// alternate setting.
+///
+typedef struct {
+  UINT8           Length;
+  UINT8           DescriptorType;
+  UINT8           PipeId;
+  UINT8           Reserved;
+} USB_UAS_PIPE_USAGE_DESCRIPTOR;
+
+///
+/// SuperSpeed Endpoint Companion descriptor. Only the stream count of bulk
+/// endpoints is of interest.
+///
+typedef struct {
+  UINT8           Length;
+  UINT8           DescriptorType;
+  UINT8           MaxBurst;
+  UINT8           Attributes;
+  UINT16          BytesPerInterval;
+} USB_UAS_SS_COMPANION_DESCRIPTOR;
+
+///
+/// Common header of all the Information Units. Tag is big endian.
+///
+typedef struct {
+  UINT8           IuId;
+  UINT8           Reserved;
+  UINT16          Tag;
+} USB_UAS_IU_HEADER;
+
+typedef struct {
+  USB_UAS_IU_HEADER  Header;
+  UINT8           TaskAttribute;        ///< Bits 6:3 priority, bits 2:0 attribute
+  UINT8           Reserved0;
+  UINT8           AddCdbLength;         ///< Bits 7:2, in dwords
+  UINT8           Reserved1;
+  UINT8           Lun[8];
+  UINT8           Cdb[16];
+} USB_UAS_COMMAND_IU;
+
+typedef struct {
+  USB_UAS_IU_HEADER  Header;
+  UINT16          StatusQualifier;
+  UINT8           Status;
+  UINT8           Reserved[7];
+  UINT16          SenseLength;          ///< Big endian
+  UINT8           SenseData[1];
+} USB_UAS_SENSE_IU;
+
+typedef struct {
+  USB_UAS_IU_HEADER  Header;
+  UINT8           ResponseInfo[3];
+  UINT8           ResponseCode;
+} USB_UAS_RESPONSE_IU;
+
+typedef struct {
+  USB_UAS_IU_HEADER  Header;
+  UINT8           Function;
+  UINT8           Reserved;
+  UINT16          TaskTag;              ///< Big endian
+  UINT8           Lun[8];
+} USB_UAS_TASK_MANAGEMENT_IU;
+#pragma pack()
+
+#define USB_UAS_SENSE_IU_HEADER_LENGTH  OFFSET_OF (USB_UAS_SENSE_IU, SenseData)
+
+//
+// Commands in flight are identified by tags 1 .. USB_UAS_MAX_TAGS. Task
+// management functions use a tag of their own so that they never collide
+// with the command being managed.
+//
+#define USB_UAS_MAX_TAGS                16
+#define USB_UAS_TMF_TAG                 (USB_UAS_MAX_TAGS + 1)
+#define USB_UAS_MAX_LUNS                16
+
+//
+// Timeouts of the USB transfers, in milliseconds. The status pipe is polled
+// with short timeouts so that the pipe is free again between IUs.
+//
+#define USB_UAS_IU_TIMEOUT              3000
+#define USB_UAS_TMF_TIMEOUT             3000
+#define USB_UAS_STATUS_POLL_TIMEOUT     10
+
+//
+// Largest chunk handed to a single bulk transfer in the data phase.
+//
+#define USB_UAS_MAX_CARRY_SIZE          SIZE_1MB
+
+#define USB_UAS_REPORT_LUNS_TIMEOUT     EFI_TIMER_PERIOD_SECONDS (3)
+
+#define USB_UAS_TPL                     TPL_CALLBACK
+
+///
+/// Endpoints of the UAS alternate setting of the interface.
+///
+typedef struct {
+  UINT8                             InterfaceNumber;
+  UINT8                             AlternateSetting;
+  UINT8                             CommandPipe;
+  UINT8                             StatusPipe;
+  UINT8                             DataInPipe;
+  UINT8                             DataOutPipe;
+  UINT16                            StatusPacketSize;
+} USB_UAS_PIPES;
+
+#define USB_UAS_REQUEST_SIGNATURE       SIGNATURE_32 ('U', 'a', 's', 'R')
+
+///
+/// A SCSI request packet in flight. It lives on the stack of the caller.
+///
+typedef struct {
+  UINT32                                        Signature;
+  UINT16                                        Tag;
+  UINT64                                        Lun;
+  EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET    *Packet;
+  UINT32                                        InLength;
+  UINT32                                        OutLength;
+  UINT32                                        InTransferred;
+  UINT32                                        OutTransferred;
+  BOOLEAN                                       Completed;
+  EFI_STATUS                                    Status;
+} USB_UAS_REQUEST;
+
+#define USB_UAS_SIGNATURE               SIGNATURE_32 ('U', 's', 'b', 'U')
+
+typedef struct {
+  UINT32                            Signature;
+  EFI_HANDLE                        Controller;
+  EFI_USB_IO_PROTOCOL               *UsbIo;
+  EFI_EXT_SCSI_PASS_THRU_MODE       ExtScsiPassThruMode;
+  EFI_EXT_SCSI_PASS_THRU_PROTOCOL   ExtScsiPassThru;
+  USB_UAS_PIPES                     Pipes;
+
+  //
+  // Receive buffer of the status pipe, one max packet in size.
+  //
+  UINT8                             *StatusBuffer;
+
+  //
+  // Commands in flight, indexed by tag - 1.
+  //
+  USB_UAS_REQUEST                   *Requests[USB_UAS_MAX_TAGS];
+
+  //
+  // State of the outstanding task management function.
+  //
+  BOOLEAN                           TmfPending;
+  UINT8                             TmfResponse;
+
+  UINTN                             LunCount;
+  UINT64                            Luns[USB_UAS_MAX_LUNS];
+} USB_UAS_DEVICE;
+
+#define USB_UAS_DEVICE_FROM_PASS_THRU(a) \
+        CR (a, USB_UAS_DEVICE, ExtScsiPassThru, USB_UAS_SIGNATURE)
+
+extern EFI_DRIVER_BINDING_PROTOCOL   gUsbUasDriverBinding;
+extern EFI_COMPONENT_NAME_PROTOCOL   gUsbUasComponentName;
+extern EFI_COMPONENT_NAME2_PROTOCOL  gUsbUasComponentName2;
+
+//
+// Functions of the UAS transport
+//
+
+/**
+  Locate the UAS alternate setting of the interface managed by UsbIo.
+
+  The whole configuration descriptor is read from the device, because the
+  USB I/O Protocol only reports the active setting, which is the BOT one
+  until the UAS setting gets selected.
+
+  @param  UsbIo                 The USB I/O Protocol instance.
+  @param  Pipes                 Return the endpoints of the UAS setting.
+
+  @retval EFI_SUCCESS           The UAS setting is found.
+  @retval EFI_UNSUPPORTED       The interface has no usable UAS setting.
+  @retval Others                Failed to read the descriptors.
+
+**/
+EFI_STATUS
+UsbUasFindPipes (
+  IN  EFI_USB_IO_PROTOCOL       *UsbIo,
+  OUT USB_UAS_PIPES             *Pipes
+  );
+
+/**
+  Queue a SCSI request packet to the device by sending its Command IU.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to send the command to.
+  @param  Packet                The SCSI request packet.
+  @param  Request               The request tracking the packet.
+
+  @retval EFI_SUCCESS           The Command IU is sent.
+  @retval EFI_NOT_READY         All the tags are in use.
+  @retval Others                Failed to send the Command IU.
+
+**/
+EFI_STATUS
+UsbUasSubmitRequest (
+  IN USB_UAS_DEVICE                              *UasDev,
+  IN UINT64                                      Lun,
+  IN EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET  *Packet,
+  IN USB_UAS_REQUEST                             *Request
+  );
+
+/**
+  Execute a SCSI request packet and wait for its completion.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to send the command to.
+  @param  Packet                The SCSI request packet.
+
+  @retval EFI_SUCCESS           The command is executed, the status is in Packet.
+  @retval EFI_TIMEOUT           The command did not complete in time.
+  @retval Others                Failed to execute the command.
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN USB_UAS_DEVICE                              *UasDev,
+  IN UINT64                                      Lun,
+  IN EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET  *Packet
+  );
+
+/**
+  Run a task management function and wait for its Response IU.
+
+  @param  UasDev                The UAS device.
+  @param  Function              The task management function.
+  @param  Lun                   The LUN the function applies to.
+  @param  TaskTag               The tag of the managed command, if any.
+
+  @retval EFI_SUCCESS           The function completed or succeeded.
+  @retval EFI_TIMEOUT           No Response IU was received in time.
+  @retval EFI_DEVICE_ERROR      The device rejected the function.
+
+**/
+EFI_STATUS
+UsbUasTaskManagement (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT8                      Function,
+  IN UINT64                     Lun,
+  IN UINT16                     TaskTag
+  );
+
+/**
+  Reset a logical unit with the LOGICAL UNIT RESET task management function.
+  The device drops the commands of the logical unit without status, so they
+  are completed here with a bus reset status.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to reset.
+
+  @retval EFI_SUCCESS           The logical unit is reset.
+  @retval Others                Failed to reset the logical unit.
+
+**/
+EFI_STATUS
+UsbUasResetLun (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT64                     Lun
+  );
+
+/**
+  Reset the device by a port reset and select the UAS setting again.
+  All the commands in flight are completed with a bus reset status.
+
+  @param  UasDev                The UAS device.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN USB_UAS_DEVICE             *UasDev
+  );
+
+/**
+  Complete all the commands in flight with the given host adapter status.
+
+  @param  UasDev                The UAS device.
+  @param  HostAdapterStatus     The host adapter status to report.
+
+**/
+VOID
+UsbUasFailAllRequests (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT8                      HostAdapterStatus
+  );
+
+//
+// Functions of the Extended SCSI Pass Thru Protocol
+//
+
+/**
+  Sends a SCSI Request Packet to a SCSI device that is attached to the SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                The Target ID of the SCSI device.
+  @param  Lun                   The LUN of the SCSI device.
+  @param  Packet                A pointer to the SCSI Request Packet to send.
+  @param  Event                 Ignored, nonblocking I/O is not supported.
+
+  @retval EFI_SUCCESS           The SCSI Request Packet was sent by the host.
+  @retval EFI_NOT_READY         Too many SCSI Request Packets are already queued.
+  @retval EFI_DEVICE_ERROR      A device error occurred.
+  @retval EFI_INVALID_PARAMETER Target, Lun, or the contents of Packet are invalid.
+  @retval EFI_TIMEOUT           A timeout occurred while waiting for the SCSI Request Packet.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasPassThru (
+  IN EFI_EXT_SCSI_PASS_THRU_PROTOCOL                    *This,
+  IN UINT8                                              *Target,
+  IN UINT64                                             Lun,
+  IN OUT EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET     *Packet,
+  IN EFI_EVENT                                          Event OPTIONAL
+  );
+
+/**
+  Used to retrieve the list of legal Target IDs and LUNs for SCSI devices on a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                On input, the Target ID of a SCSI device, all 0xFF to get
+                                the first one. On output, the Target ID of the next device.
+  @param  Lun                   On input, the LUN of a SCSI device. On output, the LUN of
+                                the next device.
+
+  @retval EFI_SUCCESS           The Target ID and LUN of the next SCSI device was returned.
+  @retval EFI_INVALID_PARAMETER Target or Lun is invalid.
+  @retval EFI_NOT_FOUND         There are no more SCSI devices on this SCSI channel.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetNextTargetLun (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN OUT UINT8                           **Target,
+  IN OUT UINT64                          *Lun
+  );
+
+/**
+  Used to allocate and build a device path node for a SCSI device on a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                The Target ID of the SCSI device.
+  @param  Lun                   The LUN of the SCSI device.
+  @param  DevicePath            Return the allocated device path node.
+
+  @retval EFI_SUCCESS           The device path node was allocated and returned.
+  @retval EFI_INVALID_PARAMETER DevicePath is NULL.
+  @retval EFI_NOT_FOUND         The SCSI device specified by Target and Lun does not exist.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources to allocate DevicePath.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasBuildDevicePath (
+  IN     EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN     UINT8                              *Target,
+  IN     UINT64                             Lun,
+  IN OUT EFI_DEVICE_PATH_PROTOCOL           **DevicePath
+  );
+
+/**
+  Used to translate a device path node to a Target ID and LUN.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  DevicePath            A single device path node describing the SCSI device.
+  @param  Target                Return the Target ID of the SCSI device.
+  @param  Lun                   Return the LUN of the SCSI device.
+
+  @retval EFI_SUCCESS           DevicePath was translated to a Target ID and LUN.
+  @retval EFI_INVALID_PARAMETER DevicePath, Target or Lun is NULL.
+  @retval EFI_NOT_FOUND         No SCSI device matches DevicePath.
+  @retval EFI_UNSUPPORTED       The device path node type is not supported.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetTargetLun (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN  EFI_DEVICE_PATH_PROTOCOL           *DevicePath,
+  OUT UINT8                              **Target,
+  OUT UINT64                             *Lun
+  );
+
+/**
+  Resets a SCSI channel. This operation resets all the SCSI devices connected to the SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+
+  @retval EFI_SUCCESS           The SCSI channel was reset.
+  @retval EFI_DEVICE_ERROR      A device error occurred while resetting the SCSI channel.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasResetChannel (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL   *This
+  );
+
+/**
+  Resets a SCSI logical unit that is connected to a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                The Target ID of the SCSI device.
+  @param  Lun                   The LUN of the SCSI device to reset.
+
+  @retval EFI_SUCCESS           The SCSI device specified by Target and Lun was reset.
+  @retval EFI_INVALID_PARAMETER Target or Lun is invalid.
+  @retval EFI_TIMEOUT           A timeout occurred while resetting the SCSI device.
+  @retval EFI_DEVICE_ERROR      A device error occurred while resetting the SCSI device.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasResetTargetLun (
+  IN EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN UINT8                              *Target,
+  IN UINT64                             Lun
+  );
+
+/**
+  Used to retrieve the list of legal Target IDs for SCSI devices on a SCSI channel.
+
+  @param  This                  A pointer to the EFI_EXT_SCSI_PASS_THRU_PROTOCOL instance.
+  @param  Target                On input, the Target ID of a SCSI device, all 0xFF to get
+                                the first one. On output, the Target ID of the next device.
+
+  @retval EFI_SUCCESS           The Target ID of the next SCSI device was returned.
+  @retval EFI_INVALID_PARAMETER Target is NULL.
+  @retval EFI_NOT_FOUND         There are no more SCSI devices on this SCSI channel.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetNextTarget (
+  IN  EFI_EXT_SCSI_PASS_THRU_PROTOCOL    *This,
+  IN OUT UINT8                           **Target
+  );
+
+//
+// Functions for Driver Binding Protocol
+//
+
+/**
+  Check whether the controller is a USB mass storage interface with a UAS
+  alternate setting.
+
+  @param  This                   The USB UAS driver binding protocol.
+  @param  Controller             The controller handle to check.
+  @param  RemainingDevicePath    The remaining device path.
+
+  @retval EFI_SUCCESS            The driver supports this controller.
+  @retval other                  This device isn't supported.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasDriverBindingSupported (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   Controller,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
+  );
+
+/**
+  Select the UAS setting of the interface and install the Extended SCSI
+  Pass Thru Protocol on it.
+
+  @param  This                   The USB UAS driver binding protocol.
+  @param  Controller             The USB interface to start on.
+  @param  RemainingDevicePath    The remaining device path.
+
+  @retval EFI_SUCCESS            The driver is started.
+  @retval EFI_UNSUPPORTED        This driver does not support this device.
+  @retval EFI_OUT_OF_RESOURCES   Can't allocate memory resources.
+  @retval Others                 Failed to start the device.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasDriverBindingStart (
+  IN EFI_DRIVER_BINDING_PROTOCOL  *This,
+  IN EFI_HANDLE                   Controller,
+  IN EFI_DEVICE_PATH_PROTOCOL     *RemainingDevicePath
+  );
+
+/**
+  Stop controlling the device.
+
+  @param  This                   The USB UAS driver binding.
+  @param  Controller             The device controller controlled by the driver.
+  @param  NumberOfChildren       The number of children of this device.
+  @param  ChildHandleBuffer      The buffer of children handle.
+
+  @retval EFI_SUCCESS            The driver stopped from controlling the device.
+  @retval Others                 Failed to stop the driver.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasDriverBindingStop (
+  IN  EFI_DRIVER_BINDING_PROTOCOL *This,
+  IN  EFI_HANDLE                  Controller,
+  IN  UINTN                       NumberOfChildren,
+  IN  EFI_HANDLE                  *ChildHandleBuffer
+  );
+
+//
+// EFI Component Name Functions
+//
+
+/**
+  Retrieves a Unicode string that is the user readable name of the driver.
+
+  @param  This                  A pointer to the EFI_COMPONENT_NAME2_PROTOCOL or
+                                EFI_COMPONENT_NAME_PROTOCOL instance.
+  @param  Language              A pointer to a Null-terminated ASCII string
+                                array indicating the language.
+  @param  DriverName            A pointer to the Unicode string to return.
+
+  @retval EFI_SUCCESS           The Unicode string for the Driver specified by
+                                This and the language specified by Language was
+                                returned in DriverName.
+  @retval EFI_INVALID_PARAMETER Language or DriverName is NULL.
+  @retval EFI_UNSUPPORTED       The driver specified by This does not support
+                                the language specified by Language.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetDriverName (
+  IN  EFI_COMPONENT_NAME_PROTOCOL  *This,
+  IN  CHAR8                        *Language,
+  OUT CHAR16                       **DriverName
+  );
+
+/**
+  Retrieves a Unicode string that is the user readable name of the controller
+  that is being managed by a driver.
+
+  @param  This                  A pointer to the EFI_COMPONENT_NAME2_PROTOCOL or
+                                EFI_COMPONENT_NAME_PROTOCOL instance.
+  @param  ControllerHandle      The handle of a controller that the driver
+                                specified by This is managing.
+  @param  ChildHandle           The handle of the child controller to retrieve
+                                the name of.
+  @param  Language              A pointer to a Null-terminated ASCII string
+                                array indicating the language.
+  @param  ControllerName        A pointer to the Unicode string to return.
+
+  @retval EFI_UNSUPPORTED       The driver specified by This does not provide
+                                controller names.
+
+**/
+EFI_STATUS
+EFIAPI
+UsbUasGetControllerName (
+  IN  EFI_COMPONENT_NAME_PROTOCOL                     *This,
+  IN  EFI_HANDLE                                      ControllerHandle,
+  IN  EFI_HANDLE                                      ChildHandle        OPTIONAL,
+  IN  CHAR8                                           *Language,
+  OUT CHAR16                                          **ControllerName
+  );
+
+#endif
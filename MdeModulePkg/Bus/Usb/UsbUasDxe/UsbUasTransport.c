@@ -0,0 +1,953 @@
+/** @file
+  Implementation of the USB Attached SCSI transport: descriptor parsing and
+  the Information Unit engine that runs the tagged commands.
+
+  Without bulk streams every IU of the device arrives on the status pipe, so
+  the commands are matched to their READ READY, WRITE READY, SENSE and
+  RESPONSE IUs by tag. The data phase of a command is run as soon as the
+  device signals it is ready for it.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "UsbUas.h"
+
+/**
+  Encode a LUN into the eight byte SAM LUN structure used by the IUs.
+
+  @param  Lun                   The LUN to encode.
+  @param  SamLun                The buffer to hold the encoded LUN.
+
+**/
+VOID
+UsbUasEncodeLun (
+  IN  UINT64                    Lun,
+  OUT UINT8                     *SamLun
+  )
+{
+  ZeroMem (SamLun, 8);
+
+  if (Lun < 0x100) {
+    //
+    // Peripheral device addressing
+    //
+    SamLun[1] = (UINT8) Lun;
+  } else {
+    //
+    // Flat space addressing
+    //
+    SamLun[0] = (UINT8) (BIT6 | (RShiftU64 (Lun, 8) & 0x3F));
+    SamLun[1] = (UINT8) Lun;
+  }
+}
+
+/**
+  Convert the timeout of a SCSI request packet into the timeout of a USB
+  transfer.
+
+  @param  Timeout               The timeout in 100ns units, 0 for infinite.
+
+  @return The timeout in milliseconds, 0 for infinite.
+
+**/
+UINTN
+UsbUasTransferTimeout (
+  IN UINT64                     Timeout
+  )
+{
+  UINT64                        Milliseconds;
+
+  if (Timeout == 0) {
+    return 0;
+  }
+
+  Milliseconds = DivU64x32 (Timeout + 10000 - 1, 10000);
+  return (UINTN) MIN (Milliseconds, MAX_UINT32);
+}
+
+/**
+  Check whether the endpoints collected for an alternate setting form a
+  complete UAS pipe set.
+
+  @param  Pipes                 The endpoints of the setting.
+
+  @retval TRUE                  All four pipes are present.
+  @retval FALSE                 The setting is not usable.
+
+**/
+BOOLEAN
+UsbUasPipesComplete (
+  IN USB_UAS_PIPES              *Pipes
+  )
+{
+  return (BOOLEAN) ((Pipes->CommandPipe != 0) && (Pipes->StatusPipe != 0) &&
+                    (Pipes->DataInPipe != 0) && (Pipes->DataOutPipe != 0) &&
+                    (Pipes->StatusPacketSize != 0));
+}
+
+/**
+  Walk a configuration descriptor and collect the pipes of the UAS
+  alternate setting of an interface.
+
+  @param  Buffer                The whole configuration descriptor.
+  @param  Length                The length of Buffer.
+  @param  InterfaceNumber       The interface to look for.
+  @param  Pipes                 Return the endpoints of the UAS setting.
+
+  @retval EFI_SUCCESS           A UAS setting usable without streams is found.
+  @retval EFI_UNSUPPORTED       No such setting exists.
+
+**/
+EFI_STATUS
+UsbUasParseConfig (
+  IN  UINT8                     *Buffer,
+  IN  UINTN                     Length,
+  IN  UINT8                     InterfaceNumber,
+  OUT USB_UAS_PIPES             *Pipes
+  )
+{
+  EFI_USB_INTERFACE_DESCRIPTOR     *Interface;
+  EFI_USB_ENDPOINT_DESCRIPTOR      *Endpoint;
+  USB_UAS_PIPE_USAGE_DESCRIPTOR    *PipeUsage;
+  USB_UAS_SS_COMPANION_DESCRIPTOR  *Companion;
+  USB_UAS_PIPES                    Setting;
+  BOOLEAN                          InSetting;
+  BOOLEAN                          StreamsRequired;
+  UINTN                            Offset;
+  UINT8                            DescLength;
+  UINT8                            DescType;
+
+  ZeroMem (&Setting, sizeof (Setting));
+  InSetting       = FALSE;
+  StreamsRequired = FALSE;
+  Endpoint        = NULL;
+  Offset          = 0;
+
+  while (TRUE) {
+    if (Offset + 2 <= Length) {
+      DescLength = Buffer[Offset];
+      DescType   = Buffer[Offset + 1];
+      if ((DescLength < 2) || (Offset + DescLength > Length)) {
+        DEBUG ((DEBUG_ERROR, "UsbUasParseConfig: met mal-format descriptor at offset %d\n", Offset));
+        DescLength = 0;
+        DescType   = 0;
+      }
+    } else {
+      DescLength = 0;
+      DescType   = 0;
+    }
+
+    //
+    // A new interface descriptor or the end of the buffer closes the
+    // alternate setting being collected.
+    //
+    if ((DescLength == 0) || (DescType == USB_DESC_TYPE_INTERFACE)) {
+      if (InSetting && UsbUasPipesComplete (&Setting)) {
+        if (!StreamsRequired) {
+          CopyMem (Pipes, &Setting, sizeof (Setting));
+          return EFI_SUCCESS;
+        }
+
+        DEBUG ((
+          DEBUG_INFO,
+          "UsbUasParseConfig: UAS setting %d needs bulk streams, leave interface %d to BOT\n",
+          Setting.AlternateSetting,
+          InterfaceNumber
+          ));
+      }
+
+      if (DescLength == 0) {
+        break;
+      }
+
+      Interface       = (EFI_USB_INTERFACE_DESCRIPTOR *) (Buffer + Offset);
+      InSetting       = (BOOLEAN) ((DescLength >= sizeof (EFI_USB_INTERFACE_DESCRIPTOR)) &&
+                                   (Interface->InterfaceNumber    == InterfaceNumber) &&
+                                   (Interface->InterfaceClass     == USB_MASS_STORE_CLASS) &&
+                                   (Interface->InterfaceSubClass  == USB_MASS_STORE_SCSI) &&
+                                   (Interface->InterfaceProtocol  == USB_MASS_STORE_UAS));
+      StreamsRequired = FALSE;
+      Endpoint        = NULL;
+      ZeroMem (&Setting, sizeof (Setting));
+      Setting.InterfaceNumber  = InterfaceNumber;
+      if (InSetting) {
+        Setting.AlternateSetting = Interface->AlternateSetting;
+      }
+
+    } else if (!InSetting) {
+      //
+      // Skip the descriptors of other interfaces and settings.
+      //
+
+    } else if (DescType == USB_DESC_TYPE_ENDPOINT) {
+      Endpoint = NULL;
+      if (DescLength >= sizeof (EFI_USB_ENDPOINT_DESCRIPTOR)) {
+        Endpoint = (EFI_USB_ENDPOINT_DESCRIPTOR *) (Buffer + Offset);
+        if ((Endpoint->Attributes & USB_ENDPOINT_TYPE_MASK) != USB_ENDPOINT_BULK) {
+          Endpoint = NULL;
+        }
+      }
+
+    } else if ((DescType == USB_UAS_DESC_TYPE_SS_COMPANION) && (Endpoint != NULL)) {
+      //
+      // The UAS setting of a SuperSpeed device advertises streams on its
+      // bulk endpoints, and the device will only run the protocol over them.
+      //
+      Companion = (USB_UAS_SS_COMPANION_DESCRIPTOR *) (Buffer + Offset);
+      if ((DescLength >= sizeof (USB_UAS_SS_COMPANION_DESCRIPTOR)) &&
+          ((Companion->Attributes & USB_UAS_SS_MAX_STREAMS_MASK) != 0)) {
+        StreamsRequired = TRUE;
+      }
+
+    } else if ((DescType == USB_UAS_DESC_TYPE_PIPE_USAGE) && (Endpoint != NULL) &&
+               (DescLength >= sizeof (USB_UAS_PIPE_USAGE_DESCRIPTOR))) {
+      PipeUsage = (USB_UAS_PIPE_USAGE_DESCRIPTOR *) (Buffer + Offset);
+
+      switch (PipeUsage->PipeId) {
+      case USB_UAS_PIPE_ID_COMMAND:
+        if ((Endpoint->EndpointAddress & USB_ENDPOINT_DIR_IN) == 0) {
+          Setting.CommandPipe = Endpoint->EndpointAddress;
+        }
+        break;
+
+      case USB_UAS_PIPE_ID_STATUS:
+        if ((Endpoint->EndpointAddress & USB_ENDPOINT_DIR_IN) != 0) {
+          Setting.StatusPipe       = Endpoint->EndpointAddress;
+          Setting.StatusPacketSize = Endpoint->MaxPacketSize;
+        }
+        break;
+
+      case USB_UAS_PIPE_ID_DATA_IN:
+        if ((Endpoint->EndpointAddress & USB_ENDPOINT_DIR_IN) != 0) {
+          Setting.DataInPipe = Endpoint->EndpointAddress;
+        }
+        break;
+
+      case USB_UAS_PIPE_ID_DATA_OUT:
+        if ((Endpoint->EndpointAddress & USB_ENDPOINT_DIR_IN) == 0) {
+          Setting.DataOutPipe = Endpoint->EndpointAddress;
+        }
+        break;
+
+      default:
+        break;
+      }
+    }
+
+    Offset += DescLength;
+  }
+
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Locate the UAS alternate setting of the interface managed by UsbIo.
+
+  The whole configuration descriptor is read from the device, because the
+  USB I/O Protocol only reports the active setting, which is the BOT one
+  until the UAS setting gets selected.
+
+  @param  UsbIo                 The USB I/O Protocol instance.
+  @param  Pipes                 Return the endpoints of the UAS setting.
+
+  @retval EFI_SUCCESS           The UAS setting is found.
+  @retval EFI_UNSUPPORTED       The interface has no usable UAS setting.
+  @retval Others                Failed to read the descriptors.
+
+**/
+EFI_STATUS
+UsbUasFindPipes (
+  IN  EFI_USB_IO_PROTOCOL       *UsbIo,
+  OUT USB_UAS_PIPES             *Pipes
+  )
+{
+  EFI_USB_INTERFACE_DESCRIPTOR  Interface;
+  EFI_USB_DEVICE_DESCRIPTOR     DevDesc;
+  EFI_USB_CONFIG_DESCRIPTOR     ActiveConfig;
+  EFI_USB_CONFIG_DESCRIPTOR     ConfigDesc;
+  UINT8                         *Buffer;
+  UINT32                        UsbStatus;
+  UINT8                         Index;
+  EFI_STATUS                    Status;
+
+  Status = UsbIo->UsbGetInterfaceDescriptor (UsbIo, &Interface);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((Interface.InterfaceClass != USB_MASS_STORE_CLASS) ||
+      (Interface.InterfaceSubClass != USB_MASS_STORE_SCSI)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = UsbIo->UsbGetDeviceDescriptor (UsbIo, &DevDesc);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = UsbIo->UsbGetConfigDescriptor (UsbIo, &ActiveConfig);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // GET_DESCRIPTOR addresses the configurations by index rather than by
+  // value, so look up the index of the active one first.
+  //
+  for (Index = 0; Index < DevDesc.NumConfigurations; Index++) {
+    Status = UsbGetDescriptor (
+               UsbIo,
+               (UINT16) ((USB_DESC_TYPE_CONFIG << 8) | Index),
+               0,
+               sizeof (ConfigDesc),
+               &ConfigDesc,
+               &UsbStatus
+               );
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    if (ConfigDesc.ConfigurationValue == ActiveConfig.ConfigurationValue) {
+      break;
+    }
+  }
+
+  if ((Index == DevDesc.NumConfigurations) ||
+      (ConfigDesc.TotalLength <= sizeof (EFI_USB_CONFIG_DESCRIPTOR))) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Buffer = AllocatePool (ConfigDesc.TotalLength);
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = UsbGetDescriptor (
+             UsbIo,
+             (UINT16) ((USB_DESC_TYPE_CONFIG << 8) | Index),
+             0,
+             ConfigDesc.TotalLength,
+             Buffer,
+             &UsbStatus
+             );
+  if (!EFI_ERROR (Status)) {
+    Status = UsbUasParseConfig (
+               Buffer,
+               ConfigDesc.TotalLength,
+               Interface.InterfaceNumber,
+               Pipes
+               );
+  }
+
+  FreePool (Buffer);
+  return Status;
+}
+
+/**
+  Send an IU to the device on the command pipe.
+
+  @param  UasDev                The UAS device.
+  @param  Iu                    The IU to send.
+  @param  Length                The length of the IU.
+
+  @retval EFI_SUCCESS           The IU is sent.
+  @retval Others                Failed to send the IU.
+
+**/
+EFI_STATUS
+UsbUasSendIu (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN VOID                       *Iu,
+  IN UINTN                      Length
+  )
+{
+  EFI_STATUS                    Status;
+  UINT32                        UsbStatus;
+
+  Status = UasDev->UsbIo->UsbBulkTransfer (
+                            UasDev->UsbIo,
+                            UasDev->Pipes.CommandPipe,
+                            Iu,
+                            &Length,
+                            USB_UAS_IU_TIMEOUT,
+                            &UsbStatus
+                            );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasSendIu: (%r) failed to send IU, UsbStatus %x\n", Status, UsbStatus));
+    if ((UsbStatus & EFI_USB_ERR_STALL) != 0) {
+      UsbClearEndpointHalt (UasDev->UsbIo, UasDev->Pipes.CommandPipe, &UsbStatus);
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Complete a command in flight and release its tag.
+
+  @param  UasDev                The UAS device.
+  @param  Request               The request to complete.
+  @param  Status                The status of the request.
+
+**/
+VOID
+UsbUasCompleteRequest (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN USB_UAS_REQUEST            *Request,
+  IN EFI_STATUS                 Status
+  )
+{
+  ASSERT (UasDev->Requests[Request->Tag - 1] == Request);
+
+  UasDev->Requests[Request->Tag - 1] = NULL;
+
+  Request->Packet->InTransferLength  = Request->InTransferred;
+  Request->Packet->OutTransferLength = Request->OutTransferred;
+  Request->Status                    = Status;
+  Request->Completed                 = TRUE;
+}
+
+/**
+  Complete all the commands in flight with the given host adapter status.
+
+  @param  UasDev                The UAS device.
+  @param  HostAdapterStatus     The host adapter status to report.
+
+**/
+VOID
+UsbUasFailAllRequests (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT8                      HostAdapterStatus
+  )
+{
+  USB_UAS_REQUEST               *Request;
+  UINTN                         Index;
+
+  for (Index = 0; Index < USB_UAS_MAX_TAGS; Index++) {
+    Request = UasDev->Requests[Index];
+    if (Request != NULL) {
+      Request->Packet->HostAdapterStatus = HostAdapterStatus;
+      UsbUasCompleteRequest (UasDev, Request, EFI_DEVICE_ERROR);
+    }
+  }
+}
+
+/**
+  Run the data phase of a command after the device sent READ READY or
+  WRITE READY for it.
+
+  A failure of the data transfer doesn't complete the command: the device
+  still reports its status with a SENSE IU.
+
+  @param  UasDev                The UAS device.
+  @param  Request               The command to transfer the data of.
+  @param  Input                 TRUE for the Data-In pipe, FALSE for Data-Out.
+
+**/
+VOID
+UsbUasTransferData (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN USB_UAS_REQUEST            *Request,
+  IN BOOLEAN                    Input
+  )
+{
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+  UINT8                         Pipe;
+  UINT8                         *Data;
+  UINT32                        Length;
+  UINT32                        *Transferred;
+  UINTN                         Chunk;
+  UINTN                         Size;
+  UINTN                         Timeout;
+  UINT32                        UsbStatus;
+  EFI_STATUS                    Status;
+
+  UsbIo = UasDev->UsbIo;
+
+  if (Input) {
+    Pipe        = UasDev->Pipes.DataInPipe;
+    Data        = Request->Packet->InDataBuffer;
+    Length      = Request->InLength;
+    Transferred = &Request->InTransferred;
+  } else {
+    Pipe        = UasDev->Pipes.DataOutPipe;
+    Data        = Request->Packet->OutDataBuffer;
+    Length      = Request->OutLength;
+    Transferred = &Request->OutTransferred;
+  }
+
+  Timeout = UsbUasTransferTimeout (Request->Packet->Timeout);
+
+  while (*Transferred < Length) {
+    Chunk  = MIN (Length - *Transferred, USB_UAS_MAX_CARRY_SIZE);
+    Size   = Chunk;
+    Status = UsbIo->UsbBulkTransfer (
+                      UsbIo,
+                      Pipe,
+                      Data + *Transferred,
+                      &Size,
+                      Timeout,
+                      &UsbStatus
+                      );
+
+    *Transferred += (UINT32) MIN (Size, Chunk);
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((
+        DEBUG_ERROR,
+        "UsbUasTransferData: (%r) tag %d failed after %d of %d bytes\n",
+        Status,
+        Request->Tag,
+        *Transferred,
+        Length
+        ));
+      if ((UsbStatus & EFI_USB_ERR_STALL) != 0) {
+        UsbClearEndpointHalt (UsbIo, Pipe, &UsbStatus);
+      }
+      break;
+    }
+
+    //
+    // A short packet ends the data phase.
+    //
+    if (Size < Chunk) {
+      break;
+    }
+  }
+}
+
+/**
+  Receive one IU from the status pipe and act on it.
+
+  @param  UasDev                The UAS device.
+  @param  Timeout               The time to wait for an IU, in milliseconds.
+
+  @retval EFI_SUCCESS           An IU was received and processed.
+  @retval EFI_NOT_READY         No IU arrived within Timeout.
+  @retval Others                The status pipe failed.
+
+**/
+EFI_STATUS
+UsbUasPollStatus (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINTN                      Timeout
+  )
+{
+  EFI_USB_IO_PROTOCOL           *UsbIo;
+  USB_UAS_IU_HEADER             *Header;
+  USB_UAS_SENSE_IU              *Sense;
+  USB_UAS_RESPONSE_IU           *Response;
+  USB_UAS_REQUEST               *Request;
+  EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET  *Packet;
+  UINTN                         Length;
+  UINTN                         SenseLength;
+  UINT16                        Tag;
+  UINT32                        UsbStatus;
+  EFI_STATUS                    Status;
+
+  UsbIo  = UasDev->UsbIo;
+  Length = UasDev->Pipes.StatusPacketSize;
+  Status = UsbIo->UsbBulkTransfer (
+                    UsbIo,
+                    UasDev->Pipes.StatusPipe,
+                    UasDev->StatusBuffer,
+                    &Length,
+                    Timeout,
+                    &UsbStatus
+                    );
+  if (EFI_ERROR (Status)) {
+    if ((UsbStatus & EFI_USB_ERR_STALL) != 0) {
+      UsbClearEndpointHalt (UsbIo, UasDev->Pipes.StatusPipe, &UsbStatus);
+    }
+
+    if (Status == EFI_TIMEOUT) {
+      return EFI_NOT_READY;
+    }
+
+    DEBUG ((DEBUG_ERROR, "UsbUasPollStatus: (%r) status pipe failed, UsbStatus %x\n", Status, UsbStatus));
+    return Status;
+  }
+
+  if (Length < sizeof (USB_UAS_IU_HEADER)) {
+    return EFI_SUCCESS;
+  }
+
+  Header = (USB_UAS_IU_HEADER *) UasDev->StatusBuffer;
+  Tag    = SwapBytes16 (Header->Tag);
+
+  if (Tag == USB_UAS_TMF_TAG) {
+    if ((Header->IuId == USB_UAS_IU_RESPONSE) && (Length >= sizeof (USB_UAS_RESPONSE_IU))) {
+      Response              = (USB_UAS_RESPONSE_IU *) Header;
+      UasDev->TmfPending    = FALSE;
+      UasDev->TmfResponse   = Response->ResponseCode;
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  if ((Tag == 0) || (Tag > USB_UAS_MAX_TAGS) || (UasDev->Requests[Tag - 1] == NULL)) {
+    DEBUG ((DEBUG_WARN, "UsbUasPollStatus: IU %x for unknown tag %d\n", Header->IuId, Tag));
+    return EFI_SUCCESS;
+  }
+
+  Request = UasDev->Requests[Tag - 1];
+  Packet  = Request->Packet;
+
+  switch (Header->IuId) {
+  case USB_UAS_IU_READ_READY:
+    UsbUasTransferData (UasDev, Request, TRUE);
+    break;
+
+  case USB_UAS_IU_WRITE_READY:
+    UsbUasTransferData (UasDev, Request, FALSE);
+    break;
+
+  case USB_UAS_IU_SENSE:
+    if (Length < USB_UAS_SENSE_IU_HEADER_LENGTH) {
+      Packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_PHASE_ERROR;
+      UsbUasCompleteRequest (UasDev, Request, EFI_DEVICE_ERROR);
+      break;
+    }
+
+    Sense       = (USB_UAS_SENSE_IU *) Header;
+    SenseLength = MIN (SwapBytes16 (Sense->SenseLength), Length - USB_UAS_SENSE_IU_HEADER_LENGTH);
+    SenseLength = MIN (SenseLength, Packet->SenseDataLength);
+    if (SenseLength != 0) {
+      CopyMem (Packet->SenseData, Sense->SenseData, SenseLength);
+    }
+
+    Packet->SenseDataLength   = (UINT8) SenseLength;
+    Packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_OK;
+    Packet->TargetStatus      = Sense->Status;
+    UsbUasCompleteRequest (UasDev, Request, EFI_SUCCESS);
+    break;
+
+  case USB_UAS_IU_RESPONSE:
+    //
+    // A RESPONSE IU for a command means the device rejected its Command IU.
+    //
+    Response = (USB_UAS_RESPONSE_IU *) Header;
+    DEBUG ((
+      DEBUG_ERROR,
+      "UsbUasPollStatus: tag %d rejected, response code %x\n",
+      Tag,
+      (Length >= sizeof (USB_UAS_RESPONSE_IU)) ? Response->ResponseCode : 0xFF
+      ));
+    Packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_MESSAGE_REJECT;
+    UsbUasCompleteRequest (UasDev, Request, EFI_DEVICE_ERROR);
+    break;
+
+  default:
+    DEBUG ((DEBUG_WARN, "UsbUasPollStatus: unexpected IU %x for tag %d\n", Header->IuId, Tag));
+    break;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Queue a SCSI request packet to the device by sending its Command IU.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to send the command to.
+  @param  Packet                The SCSI request packet.
+  @param  Request               The request tracking the packet.
+
+  @retval EFI_SUCCESS           The Command IU is sent.
+  @retval EFI_NOT_READY         All the tags are in use.
+  @retval Others                Failed to send the Command IU.
+
+**/
+EFI_STATUS
+UsbUasSubmitRequest (
+  IN USB_UAS_DEVICE                              *UasDev,
+  IN UINT64                                      Lun,
+  IN EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET  *Packet,
+  IN USB_UAS_REQUEST                             *Request
+  )
+{
+  USB_UAS_COMMAND_IU            CommandIu;
+  UINTN                         Index;
+  EFI_STATUS                    Status;
+
+  for (Index = 0; Index < USB_UAS_MAX_TAGS; Index++) {
+    if (UasDev->Requests[Index] == NULL) {
+      break;
+    }
+  }
+
+  if (Index == USB_UAS_MAX_TAGS) {
+    return EFI_NOT_READY;
+  }
+
+  Request->Signature      = USB_UAS_REQUEST_SIGNATURE;
+  Request->Tag            = (UINT16) (Index + 1);
+  Request->Lun            = Lun;
+  Request->Packet         = Packet;
+  Request->InLength       = Packet->InTransferLength;
+  Request->OutLength      = Packet->OutTransferLength;
+  Request->InTransferred  = 0;
+  Request->OutTransferred = 0;
+  Request->Completed      = FALSE;
+  Request->Status         = EFI_SUCCESS;
+
+  Packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_OK;
+  Packet->TargetStatus      = EFI_EXT_SCSI_STATUS_TARGET_GOOD;
+
+  ZeroMem (&CommandIu, sizeof (CommandIu));
+  CommandIu.Header.IuId     = USB_UAS_IU_COMMAND;
+  CommandIu.Header.Tag      = SwapBytes16 (Request->Tag);
+  CommandIu.TaskAttribute   = USB_UAS_TASK_ATTR_SIMPLE;
+  UsbUasEncodeLun (Lun, CommandIu.Lun);
+  CopyMem (CommandIu.Cdb, Packet->Cdb, Packet->CdbLength);
+
+  //
+  // Register the request before sending, the device may answer right away.
+  //
+  UasDev->Requests[Index] = Request;
+
+  Status = UsbUasSendIu (UasDev, &CommandIu, sizeof (CommandIu));
+  if (EFI_ERROR (Status)) {
+    UasDev->Requests[Index] = NULL;
+  }
+
+  return Status;
+}
+
+/**
+  Run a task management function and wait for its Response IU.
+
+  @param  UasDev                The UAS device.
+  @param  Function              The task management function.
+  @param  Lun                   The LUN the function applies to.
+  @param  TaskTag               The tag of the managed command, if any.
+
+  @retval EFI_SUCCESS           The function completed or succeeded.
+  @retval EFI_TIMEOUT           No Response IU was received in time.
+  @retval EFI_DEVICE_ERROR      The device rejected the function.
+
+**/
+EFI_STATUS
+UsbUasTaskManagement (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT8                      Function,
+  IN UINT64                     Lun,
+  IN UINT16                     TaskTag
+  )
+{
+  USB_UAS_TASK_MANAGEMENT_IU    TaskIu;
+  UINTN                         Elapsed;
+  EFI_STATUS                    Status;
+
+  ZeroMem (&TaskIu, sizeof (TaskIu));
+  TaskIu.Header.IuId = USB_UAS_IU_TASK_MANAGEMENT;
+  TaskIu.Header.Tag  = SwapBytes16 (USB_UAS_TMF_TAG);
+  TaskIu.Function    = Function;
+  TaskIu.TaskTag     = SwapBytes16 (TaskTag);
+  UsbUasEncodeLun (Lun, TaskIu.Lun);
+
+  UasDev->TmfPending = TRUE;
+  Status = UsbUasSendIu (UasDev, &TaskIu, sizeof (TaskIu));
+  if (EFI_ERROR (Status)) {
+    UasDev->TmfPending = FALSE;
+    return Status;
+  }
+
+  Elapsed = 0;
+  while (UasDev->TmfPending && (Elapsed < USB_UAS_TMF_TIMEOUT)) {
+    Status = UsbUasPollStatus (UasDev, USB_UAS_STATUS_POLL_TIMEOUT);
+    if (Status == EFI_NOT_READY) {
+      Elapsed += USB_UAS_STATUS_POLL_TIMEOUT;
+    } else if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (UasDev->TmfPending) {
+    UasDev->TmfPending = FALSE;
+    return EFI_TIMEOUT;
+  }
+
+  if ((UasDev->TmfResponse != USB_UAS_RC_TMF_COMPLETE) &&
+      (UasDev->TmfResponse != USB_UAS_RC_TMF_SUCCEEDED)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasTaskManagement: function %x failed, response code %x\n", Function, UasDev->TmfResponse));
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset a logical unit with the LOGICAL UNIT RESET task management function.
+  The device drops the commands of the logical unit without status, so they
+  are completed here with a bus reset status.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to reset.
+
+  @retval EFI_SUCCESS           The logical unit is reset.
+  @retval Others                Failed to reset the logical unit.
+
+**/
+EFI_STATUS
+UsbUasResetLun (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN UINT64                     Lun
+  )
+{
+  USB_UAS_REQUEST               *Request;
+  UINTN                         Index;
+  EFI_STATUS                    Status;
+
+  Status = UsbUasTaskManagement (UasDev, USB_UAS_TMF_LOGICAL_UNIT_RESET, Lun, 0);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  for (Index = 0; Index < USB_UAS_MAX_TAGS; Index++) {
+    Request = UasDev->Requests[Index];
+    if ((Request != NULL) && (Request->Lun == Lun)) {
+      Request->Packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_BUS_RESET;
+      UsbUasCompleteRequest (UasDev, Request, EFI_DEVICE_ERROR);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reset the device by a port reset and select the UAS setting again.
+  All the commands in flight are completed with a bus reset status.
+
+  @param  UasDev                The UAS device.
+
+  @retval EFI_SUCCESS           The device is reset.
+  @retval Others                Failed to reset the device.
+
+**/
+EFI_STATUS
+UsbUasResetDevice (
+  IN USB_UAS_DEVICE             *UasDev
+  )
+{
+  EFI_STATUS                    Status;
+  UINT32                        UsbStatus;
+
+  UsbUasFailAllRequests (UasDev, EFI_EXT_SCSI_STATUS_HOST_ADAPTER_BUS_RESET);
+  UasDev->TmfPending = FALSE;
+
+  Status = UasDev->UsbIo->UsbPortReset (UasDev->UsbIo);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasResetDevice: (%r) port reset failed\n", Status));
+    return Status;
+  }
+
+  //
+  // The port reset brings the interface back to its default, BOT, setting.
+  //
+  Status = UsbSetInterface (
+             UasDev->UsbIo,
+             UasDev->Pipes.InterfaceNumber,
+             UasDev->Pipes.AlternateSetting,
+             &UsbStatus
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasResetDevice: (%r) failed to select the UAS setting\n", Status));
+  }
+
+  return Status;
+}
+
+/**
+  Abort a command that has timed out. The device is reset if it doesn't
+  acknowledge the abort.
+
+  @param  UasDev                The UAS device.
+  @param  Request               The command to abort.
+
+**/
+VOID
+UsbUasAbortRequest (
+  IN USB_UAS_DEVICE             *UasDev,
+  IN USB_UAS_REQUEST            *Request
+  )
+{
+  UINT16                        Tag;
+  EFI_STATUS                    Status;
+
+  Tag    = Request->Tag;
+  Status = UsbUasTaskManagement (UasDev, USB_UAS_TMF_ABORT_TASK, Request->Lun, Tag);
+
+  //
+  // The command may have completed while the abort was in progress.
+  //
+  if (UasDev->Requests[Tag - 1] == Request) {
+    Request->Packet->HostAdapterStatus = EFI_EXT_SCSI_STATUS_HOST_ADAPTER_TIMEOUT_COMMAND;
+    UsbUasCompleteRequest (UasDev, Request, EFI_TIMEOUT);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "UsbUasAbortRequest: (%r) failed to abort tag %d, reset the device\n", Status, Tag));
+    UsbUasResetDevice (UasDev);
+  }
+}
+
+/**
+  Execute a SCSI request packet and wait for its completion.
+
+  @param  UasDev                The UAS device.
+  @param  Lun                   The LUN to send the command to.
+  @param  Packet                The SCSI request packet.
+
+  @retval EFI_SUCCESS           The command is executed, the status is in Packet.
+  @retval EFI_TIMEOUT           The command did not complete in time.
+  @retval Others                Failed to execute the command.
+
+**/
+EFI_STATUS
+UsbUasExecCommand (
+  IN USB_UAS_DEVICE                              *UasDev,
+  IN UINT64                                      Lun,
+  IN EFI_EXT_SCSI_PASS_THRU_SCSI_REQUEST_PACKET  *Packet
+  )
+{
+  USB_UAS_REQUEST               Request;
+  UINT64                        Remain;
+  UINT64                        PollPeriod;
+  EFI_STATUS                    Status;
+
+  ZeroMem (&Request, sizeof (Request));
+  Remain     = Packet->Timeout;
+  PollPeriod = EFI_TIMER_PERIOD_MILLISECONDS (USB_UAS_STATUS_POLL_TIMEOUT);
+
+  Status = UsbUasSubmitRequest (UasDev, Lun, Packet, &Request);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  while (!Request.Completed) {
+    Status = UsbUasPollStatus (UasDev, USB_UAS_STATUS_POLL_TIMEOUT);
+    if (Status == EFI_NOT_READY) {
+      if (Packet->Timeout != 0) {
+        if (Remain <= PollPeriod) {
+          break;
+        }
+
+        Remain -= PollPeriod;
+      }
+    } else if (EFI_ERROR (Status)) {
+      //
+      // The reset completes the request with a bus reset status.
+      //
+      UsbUasResetDevice (UasDev);
+    }
+  }
+
+  if (!Request.Completed) {
+    UsbUasAbortRequest (UasDev, &Request);
+  }
+
+  return Request.Status;
+}
@@ -385,6 +385,35 @@ CoreTrust (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Queue the GUIDed sections of the drivers on the mScheduledQueue for decoding
+  on the APs, so they are ready by the time the drivers are loaded. Stops at the
+  first driver that does not fit into the prefetch cache.
+
+**/
+VOID
+CorePrefetchScheduledDrivers (
+  VOID
+  )
+{
+  EFI_STATUS                      Status;
+  LIST_ENTRY                      *Link;
+  EFI_CORE_DRIVER_ENTRY           *DriverEntry;
+
+  for (Link = mScheduledQueue.ForwardLink; Link != &mScheduledQueue; Link = Link->ForwardLink) {
+    DriverEntry = CR (Link, EFI_CORE_DRIVER_ENTRY, ScheduledLink, EFI_CORE_DRIVER_ENTRY_SIGNATURE);
+    if (DriverEntry->Prefetched || DriverEntry->IsFvImage || DriverEntry->ImageHandle != NULL) {
+      continue;
+    }
+
+    Status = CorePrefetchFileSections (DriverEntry->Fv, &DriverEntry->FileName);
+    if (EFI_ERROR (Status)) {
+      return;
+    }
+    DriverEntry->Prefetched = TRUE;
+  }
+}
+
 /**
   This is the main Dispatcher for DXE and it exits when there are no more
   drivers to run. Drain the mScheduledQueue and load and start a PE
@@ -448,6 +477,10 @@ CoreDispatcher (
                       EFI_CORE_DRIVER_ENTRY_SIGNATURE
                       );
 
+      if (FeaturePcdGet (PcdDxeCoreParallelDecompressEnable)) {
+        CorePrefetchScheduledDrivers ();
+      }
+
       //
       // Load the DXE Driver image into memory. If the Driver was transitioned from
       // Untrused to Scheduled it would have already been loaded so we may need to
@@ -571,6 +604,11 @@ CoreDispatcher (
     }
   } while (ReadyToRun);
 
+  if (FeaturePcdGet (PcdDxeCoreParallelDecompressEnable)) {
+    CoreFlushSectionPrefetch ();
+  }
+  CoreDumpSectionCacheStatistics ();
+
   //
   // Close DXE dispatch Event
   //
@@ -47,6 +47,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/HiiPackageList.h>
 #include <Protocol/SmmBase2.h>
 #include <Protocol/PeCoffImageEmulator.h>
+#include <Protocol/MpService.h>
 #include <Guid/MemoryTypeInformation.h>
 #include <Guid/FirmwareFileSystem2.h>
 #include <Guid/FirmwareFileSystem3.h>
@@ -57,6 +58,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/DxeServices.h>
 #include <Guid/MemoryAllocationHob.h>
 #include <Guid/EventLegacyBios.h>
+#include <Guid/DecompressedSectionCache.h>
 #include <Guid/EventGroup.h>
 #include <Guid/EventExitBootServiceFailed.h>
 #include <Guid/LoadModuleAtFixedAddress.h>
@@ -166,6 +168,8 @@ typedef struct {
   EFI_HANDLE                      ImageHandle;
   BOOLEAN                         IsFvImage;
 
+  BOOLEAN                         Prefetched;
+
 } EFI_CORE_DRIVER_ENTRY;
 
 //
@@ -2120,6 +2124,163 @@ InitializeSectionExtraction (
   );
 
 
+/**
+  Get a pointer to the contents of a file in a firmware volume produced by
+  the DXE Core, without reading the file into a new buffer.
+
+  @param  Fv                 The firmware volume that contains the file.
+  @param  NameGuid           The name of the file.
+  @param  FileData           Returns the file contents, following the FFS
+                             file header. The caller must not modify or free it.
+  @param  FileSize           Returns the size of the file contents.
+
+  @retval EFI_SUCCESS        The file was found.
+  @retval EFI_NOT_FOUND      The file is not in the firmware volume.
+  @retval EFI_UNSUPPORTED    The firmware volume is not produced by the DXE Core.
+
+**/
+EFI_STATUS
+CoreFvGetFileInPlace (
+  IN  EFI_FIRMWARE_VOLUME2_PROTOCOL  *Fv,
+  IN  CONST EFI_GUID                 *NameGuid,
+  OUT CONST VOID                     **FileData,
+  OUT UINTN                          *FileSize
+  );
+
+
+/**
+  Queue the GUIDed sections of an FFS file for decoding on the APs.
+
+  Nothing is queued if the MP Services protocol is not available yet.
+
+  @param  Fv              The firmware volume that contains the file.
+  @param  FileName        The name of the file.
+
+  @retval EFI_SUCCESS           The sections of the file were queued, or the
+                                file has nothing to prefetch.
+  @retval EFI_NOT_READY         There is no AP to decode sections on.
+  @retval EFI_OUT_OF_RESOURCES  The cache is full; retry on a later call.
+
+**/
+EFI_STATUS
+CorePrefetchFileSections (
+  IN EFI_FIRMWARE_VOLUME2_PROTOCOL  *Fv,
+  IN EFI_GUID                       *FileName
+  );
+
+
+/**
+  Take the decoded data of a GUIDed section out of the prefetch cache.
+
+  @param  InputSection          The GUIDed section to extract.
+  @param  OutputBuffer          Returns the pool buffer with the section contents.
+                                The caller owns the buffer.
+  @param  OutputSize            Returns the size of OutputBuffer.
+  @param  AuthenticationStatus  Returns the authentication status of the decode.
+
+  @retval EFI_SUCCESS           The section was found in the cache.
+  @retval EFI_NOT_FOUND         The section was not prefetched, or decoding it failed.
+
+**/
+EFI_STATUS
+CoreGetPrefetchedSection (
+  IN  CONST VOID  *InputSection,
+  OUT VOID        **OutputBuffer,
+  OUT UINTN       *OutputSize,
+  OUT UINT32      *AuthenticationStatus
+  );
+
+
+/**
+  Wait for all outstanding decodes and drop the sections nobody asked for.
+
+**/
+VOID
+CoreFlushSectionPrefetch (
+  VOID
+  );
+
+
+/**
+  Index the sections the PEI Core published, so that a lookup does not walk
+  the HOB list.
+
+**/
+VOID
+CoreInitializeSectionCache (
+  VOID
+  );
+
+
+/**
+  Set the name of the file whose sections are read next.
+
+  @param  FileName        The name of the file, or NULL if the sections are
+                          not to be cached.
+
+  @return The name that was set before, to be restored by the caller.
+
+**/
+CONST EFI_GUID *
+CoreSetSectionCacheFileName (
+  IN CONST EFI_GUID  *FileName  OPTIONAL
+  );
+
+
+/**
+  Look up the decoded data of a GUIDed section, first in the sections the DXE
+  Core decoded, then in the sections the PEI Core published.
+
+  @param  InputSection          The GUIDed section to extract.
+  @param  OutputBuffer          Returns a pool buffer with a copy of the section
+                                contents. The caller owns the buffer.
+  @param  OutputSize            Returns the size of OutputBuffer.
+  @param  AuthenticationStatus  Returns the authentication status of the decode.
+
+  @retval EFI_SUCCESS           The section was found in the cache.
+  @retval EFI_NOT_FOUND         The section was not found in the cache.
+  @retval EFI_OUT_OF_RESOURCES  The copy of the section could not be allocated.
+
+**/
+EFI_STATUS
+CoreLookupSectionCache (
+  IN  CONST VOID  *InputSection,
+  OUT VOID        **OutputBuffer,
+  OUT UINTN       *OutputSize,
+  OUT UINT32      *AuthenticationStatus
+  );
+
+
+/**
+  Keep a copy of the decoded data of a GUIDed section, evicting the least
+  recently used sections if the cache is full.
+
+  @param  InputSection          The GUIDed section that was decoded.
+  @param  Data                  The decoded section contents.
+  @param  DataSize              The size of Data.
+  @param  AuthenticationStatus  The authentication status of the decode.
+
+**/
+VOID
+CoreInsertSectionCache (
+  IN CONST VOID  *InputSection,
+  IN VOID        *Data,
+  IN UINTN       DataSize,
+  IN UINT32      AuthenticationStatus
+  );
+
+
+/**
+  Display how many bytes of GUIDed sections were decoded and how many were
+  served from the cache.
+
+**/
+VOID
+CoreDumpSectionCacheStatistics (
+  VOID
+  );
+
+
 /**
   This DXE service routine is used to process a firmware volume. In
   particular, it can be called by BDS to process a single firmware
@@ -2171,6 +2332,16 @@ CoreDisplayDiscoveredNotDispatched (
   );
 
 
+/**
+  Display the protocol database lookup statistics collected so far.
+
+**/
+VOID
+CoreDumpProtocolDatabaseStatistics (
+  VOID
+  );
+
+
 
 /**
   Place holder function until all the Boot Services and Runtime Services are
@@ -529,6 +529,11 @@ DxeMain (
   }
   ASSERT_EFI_ERROR (Status);
 
+  //
+  // Display the protocol database statistics if they were collected
+  //
+  CoreDumpProtocolDatabaseStatistics ();
+
   //
   // Report Status code before transfer control to BDS
   //
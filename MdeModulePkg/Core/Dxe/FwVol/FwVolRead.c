@@ -402,6 +402,62 @@ FvReadFile (
 }
 
 
+/**
+  Get a pointer to the contents of a file in a firmware volume produced by
+  the DXE Core, without reading the file into a new buffer.
+
+  @param  Fv                 The firmware volume that contains the file.
+  @param  NameGuid           The name of the file.
+  @param  FileData           Returns the file contents, following the FFS
+                             file header. The caller must not modify or free it.
+  @param  FileSize           Returns the size of the file contents.
+
+  @retval EFI_SUCCESS        The file was found.
+  @retval EFI_NOT_FOUND      The file is not in the firmware volume.
+  @retval EFI_UNSUPPORTED    The firmware volume is not produced by the DXE Core.
+
+**/
+EFI_STATUS
+CoreFvGetFileInPlace (
+  IN  EFI_FIRMWARE_VOLUME2_PROTOCOL  *Fv,
+  IN  CONST EFI_GUID                 *NameGuid,
+  OUT CONST VOID                     **FileData,
+  OUT UINTN                          *FileSize
+  )
+{
+  FV_DEVICE                         *FvDevice;
+  LIST_ENTRY                        *Link;
+  FFS_FILE_LIST_ENTRY               *FfsFileEntry;
+  EFI_FFS_FILE_HEADER               *FfsHeader;
+
+  if (Fv->ReadFile != FvReadFile) {
+    return EFI_UNSUPPORTED;
+  }
+
+  FvDevice = FV_DEVICE_FROM_THIS (Fv);
+  for (Link = FvDevice->FfsFileListHeader.ForwardLink;
+       Link != &FvDevice->FfsFileListHeader;
+       Link = Link->ForwardLink) {
+    FfsFileEntry = (FFS_FILE_LIST_ENTRY *) Link;
+    FfsHeader    = FfsFileEntry->FfsHeader;
+    if (!CompareGuid (&FfsHeader->Name, NameGuid)) {
+      continue;
+    }
+
+    if (IS_FFS_FILE2 (FfsHeader)) {
+      *FileData = (UINT8 *) FfsHeader + sizeof (EFI_FFS_FILE_HEADER2);
+      *FileSize = FFS_FILE2_SIZE (FfsHeader) - sizeof (EFI_FFS_FILE_HEADER2);
+    } else {
+      *FileData = (UINT8 *) FfsHeader + sizeof (EFI_FFS_FILE_HEADER);
+      *FileSize = FFS_FILE_SIZE (FfsHeader) - sizeof (EFI_FFS_FILE_HEADER);
+    }
+    return EFI_SUCCESS;
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+
 
 /**
   Locates a section in a given FFS File and
@@ -450,6 +506,7 @@ FvReadFileSection (
   UINTN                             FileSize;
   UINT8                             *FileBuffer;
   FFS_FILE_LIST_ENTRY               *FfsEntry;
+  CONST EFI_GUID                    *PreviousFileName;
 
   if (NameGuid == NULL || Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -505,8 +562,14 @@ FvReadFileSection (
   }
 
   //
-  // If SectionType == 0 We need the whole section stream
+  // If SectionType == 0 We need the whole section stream.
+  // The GUIDed sections decoded on the way are cached under the file name,
+  // except those of firmware volume image files, as the decoded firmware
+  // volume is installed once and its sections are not read again.
   //
+  PreviousFileName = CoreSetSectionCacheFileName (
+                       (FileType == EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE) ? NULL : NameGuid
+                       );
   Status = GetSection (
              FfsEntry->StreamHandle,
              (SectionType == 0) ? NULL : &SectionType,
@@ -517,6 +580,7 @@ FvReadFileSection (
              AuthenticationStatus,
              FvDevice->IsFfs3Fv
              );
+  CoreSetSectionCacheFileName (PreviousFileName);
 
   if (!EFI_ERROR (Status)) {
     //
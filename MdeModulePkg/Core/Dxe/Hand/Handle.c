@@ -21,6 +21,31 @@ LIST_ENTRY      gHandleList           = INITIALIZE_LIST_HEAD_VARIABLE (gHandleLi
 EFI_LOCK        gProtocolDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
 UINT64          gHandleDatabaseKey    = 0;
 
+//
+// mProtocolHashTable - The entries of mProtocolDatabase, hashed by protocol GUID
+// mHandleHashTable   - The entries of gHandleList, hashed by handle address
+//
+#define PROTOCOL_HASH_BUCKETS   64
+#define HANDLE_HASH_BUCKETS     256
+
+LIST_ENTRY      mProtocolHashTable[PROTOCOL_HASH_BUCKETS];
+LIST_ENTRY      mHandleHashTable[HANDLE_HASH_BUCKETS];
+BOOLEAN         mHashTablesInitialized = FALSE;
+
+//
+// Protocol database lookup statistics, collected if PcdProtocolDatabaseCollectStatistics is TRUE
+//
+typedef struct {
+  UINT64        ProtocolLookups;
+  UINT64        ProtocolProbes;
+  UINT64        ProtocolMaxProbes;
+  UINT64        HandleLookups;
+  UINT64        HandleProbes;
+  UINT64        HandleMaxProbes;
+} PROTOCOL_DATABASE_STATISTICS;
+
+PROTOCOL_DATABASE_STATISTICS  mProtocolDatabaseStatistics;
+
 
 
 /**
@@ -51,6 +76,185 @@ CoreReleaseProtocolLock (
 
 
 
+/**
+  Initialize the buckets of the protocol and handle hash tables on first use.
+
+**/
+STATIC
+VOID
+CoreInitializeHashTables (
+  VOID
+  )
+{
+  UINTN   Index;
+
+  if (mHashTablesInitialized) {
+    return;
+  }
+
+  for (Index = 0; Index < PROTOCOL_HASH_BUCKETS; Index++) {
+    InitializeListHead (&mProtocolHashTable[Index]);
+  }
+  for (Index = 0; Index < HANDLE_HASH_BUCKETS; Index++) {
+    InitializeListHead (&mHandleHashTable[Index]);
+  }
+  mHashTablesInitialized = TRUE;
+}
+
+
+
+/**
+  Get the protocol hash bucket of a protocol GUID.
+
+  @param  Protocol               The ID of the protocol
+
+  @return The head of the bucket list.
+
+**/
+STATIC
+LIST_ENTRY *
+CoreGetProtocolHashBucket (
+  IN EFI_GUID   *Protocol
+  )
+{
+  UINT32  Hash;
+
+  Hash  = ReadUnaligned32 ((UINT32 *)Protocol);
+  Hash ^= ReadUnaligned32 ((UINT32 *)Protocol + 1);
+  Hash ^= ReadUnaligned32 ((UINT32 *)Protocol + 2);
+  Hash ^= ReadUnaligned32 ((UINT32 *)Protocol + 3);
+  Hash ^= Hash >> 16;
+  Hash ^= Hash >> 8;
+
+  return &mProtocolHashTable[Hash % PROTOCOL_HASH_BUCKETS];
+}
+
+
+
+/**
+  Get the handle hash bucket of a handle.
+
+  @param  UserHandle             The handle
+
+  @return The head of the bucket list.
+
+**/
+STATIC
+LIST_ENTRY *
+CoreGetHandleHashBucket (
+  IN EFI_HANDLE   UserHandle
+  )
+{
+  UINTN   Hash;
+
+  //
+  // Handles are pool allocations, so the low bits carry no information
+  //
+  Hash = (UINTN)UserHandle >> 4;
+  Hash ^= Hash >> 8;
+
+  return &mHandleHashTable[Hash % HANDLE_HASH_BUCKETS];
+}
+
+
+
+/**
+  Update the probe counters of a hash table lookup.
+
+  @param  Lookups                The lookup counter
+  @param  Probes                 The probe counter
+  @param  MaxProbes              The longest lookup seen so far
+  @param  Count                  The number of entries probed by this lookup
+
+**/
+STATIC
+VOID
+CoreUpdateLookupStatistics (
+  IN OUT UINT64   *Lookups,
+  IN OUT UINT64   *Probes,
+  IN OUT UINT64   *MaxProbes,
+  IN     UINTN    Count
+  )
+{
+  *Lookups += 1;
+  *Probes  += Count;
+  if (Count > *MaxProbes) {
+    *MaxProbes = Count;
+  }
+}
+
+
+
+/**
+  Adds a newly created handle to the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandleHash (
+  IN IHANDLE    *Handle
+  )
+{
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  CoreInitializeHashTables ();
+  InsertHeadList (CoreGetHandleHashBucket (Handle), &Handle->HashLink);
+}
+
+
+
+/**
+  Removes a handle that is about to be freed from the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandleHash (
+  IN IHANDLE    *Handle
+  )
+{
+  ASSERT_LOCKED(&gProtocolDatabaseLock);
+
+  RemoveEntryList (&Handle->HashLink);
+}
+
+
+
+/**
+  Display the protocol database lookup statistics collected so far.
+
+**/
+VOID
+CoreDumpProtocolDatabaseStatistics (
+  VOID
+  )
+{
+  if (!FeaturePcdGet (PcdProtocolDatabaseCollectStatistics)) {
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Protocol database: %ld protocol lookups, %ld probes (max %ld)\n",
+    mProtocolDatabaseStatistics.ProtocolLookups,
+    mProtocolDatabaseStatistics.ProtocolProbes,
+    mProtocolDatabaseStatistics.ProtocolMaxProbes
+    ));
+  DEBUG ((
+    DEBUG_INFO,
+    "Protocol database: %ld handle validations, %ld probes (max %ld)\n",
+    mProtocolDatabaseStatistics.HandleLookups,
+    mProtocolDatabaseStatistics.HandleProbes,
+    mProtocolDatabaseStatistics.HandleMaxProbes
+    ));
+}
+
+
+
 /**
   Check whether a handle is a valid EFI_HANDLE
 
@@ -66,20 +270,38 @@ CoreValidateHandle (
   )
 {
   IHANDLE             *Handle;
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
+  UINTN               Probes;
 
-  if (UserHandle == NULL) {
+  if (UserHandle == NULL || !mHashTablesInitialized) {
     return EFI_INVALID_PARAMETER;
   }
 
-  for (Link = gHandleList.BackLink; Link != &gHandleList; Link = Link->BackLink) {
-    Handle = CR (Link, IHANDLE, AllHandles, EFI_HANDLE_SIGNATURE);
+  //
+  // Only compare addresses, UserHandle must not be dereferenced before it
+  // is known to be valid
+  //
+  Probes = 0;
+  Bucket = CoreGetHandleHashBucket (UserHandle);
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Probes++;
+    Handle = CR (Link, IHANDLE, HashLink, EFI_HANDLE_SIGNATURE);
     if (Handle == (IHANDLE *) UserHandle) {
-      return EFI_SUCCESS;
+      break;
     }
   }
 
-  return EFI_INVALID_PARAMETER;
+  if (FeaturePcdGet (PcdProtocolDatabaseCollectStatistics)) {
+    CoreUpdateLookupStatistics (
+      &mProtocolDatabaseStatistics.HandleLookups,
+      &mProtocolDatabaseStatistics.HandleProbes,
+      &mProtocolDatabaseStatistics.HandleMaxProbes,
+      Probes
+      );
+  }
+
+  return (Link != Bucket) ? EFI_SUCCESS : EFI_INVALID_PARAMETER;
 }
 
 
@@ -100,22 +322,29 @@ CoreFindProtocolEntry (
   IN BOOLEAN    Create
   )
 {
+  LIST_ENTRY          *Bucket;
   LIST_ENTRY          *Link;
   PROTOCOL_ENTRY      *Item;
   PROTOCOL_ENTRY      *ProtEntry;
+  UINTN               Probes;
 
   ASSERT_LOCKED(&gProtocolDatabaseLock);
 
+  CoreInitializeHashTables ();
+
   //
-  // Search the database for the matching GUID
+  // Search the hash bucket of the GUID for the matching GUID
   //
 
   ProtEntry = NULL;
-  for (Link = mProtocolDatabase.ForwardLink;
-       Link != &mProtocolDatabase;
+  Probes    = 0;
+  Bucket    = CoreGetProtocolHashBucket (Protocol);
+  for (Link = Bucket->ForwardLink;
+       Link != Bucket;
        Link = Link->ForwardLink) {
 
-    Item = CR(Link, PROTOCOL_ENTRY, AllEntries, PROTOCOL_ENTRY_SIGNATURE);
+    Probes++;
+    Item = CR(Link, PROTOCOL_ENTRY, HashLink, PROTOCOL_ENTRY_SIGNATURE);
     if (CompareGuid (&Item->ProtocolID, Protocol)) {
 
       //
@@ -127,6 +356,15 @@ CoreFindProtocolEntry (
     }
   }
 
+  if (FeaturePcdGet (PcdProtocolDatabaseCollectStatistics)) {
+    CoreUpdateLookupStatistics (
+      &mProtocolDatabaseStatistics.ProtocolLookups,
+      &mProtocolDatabaseStatistics.ProtocolProbes,
+      &mProtocolDatabaseStatistics.ProtocolMaxProbes,
+      Probes
+      );
+  }
+
   //
   // If the protocol entry was not found and Create is TRUE, then
   // allocate a new entry
@@ -147,6 +385,7 @@ CoreFindProtocolEntry (
       // Add it to protocol database
       //
       InsertTailList (&mProtocolDatabase, &ProtEntry->AllEntries);
+      InsertHeadList (Bucket, &ProtEntry->HashLink);
     }
   }
 
@@ -427,6 +666,7 @@ CoreInstallProtocolInterfaceNotify (
     // in the system
     //
     InsertTailList (&gHandleList, &Handle->AllHandles);
+    CoreInsertHandleHash (Handle);
   } else {
     Status = CoreValidateHandle (Handle);
     if (EFI_ERROR (Status)) {
@@ -789,6 +1029,7 @@ CoreUninstallProtocolInterface (
   if (IsListEmpty (&Handle->Protocols)) {
     Handle->Signature = 0;
     RemoveEntryList (&Handle->AllHandles);
+    CoreRemoveHandleHash (Handle);
     CoreFreePool (Handle);
   }
 
@@ -19,6 +19,8 @@ typedef struct {
   UINTN               Signature;
   /// All handles list of IHANDLE
   LIST_ENTRY          AllHandles;
+  /// Link on the handle hash bucket used to validate handles
+  LIST_ENTRY          HashLink;
   /// List of PROTOCOL_INTERFACE's for this handle
   LIST_ENTRY          Protocols;
   UINTN               LocateRequest;
@@ -39,6 +41,8 @@ typedef struct {
   UINTN               Signature;
   /// Link Entry inserted to mProtocolDatabase
   LIST_ENTRY          AllEntries;
+  /// Link Entry inserted to the protocol hash bucket of ProtocolID
+  LIST_ENTRY          HashLink;
   /// ID of the protocol
   EFI_GUID            ProtocolID;
   /// All protocol interfaces
@@ -104,6 +108,32 @@ typedef struct {
 
 
 
+/**
+  Adds a newly created handle to the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to add
+
+**/
+VOID
+CoreInsertHandleHash (
+  IN IHANDLE    *Handle
+  );
+
+
+/**
+  Removes a handle that is about to be freed from the handle hash table.
+  The gProtocolDatabaseLock must be owned
+
+  @param  Handle                 The handle to remove
+
+**/
+VOID
+CoreRemoveHandleHash (
+  IN IHANDLE    *Handle
+  );
+
+
 /**
   Finds the protocol entry for the requested protocol.
   The gProtocolDatabaseLock must be owned
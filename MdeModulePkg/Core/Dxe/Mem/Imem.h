@@ -30,7 +30,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 
 #define MEMORY_MAP_SIGNATURE   SIGNATURE_32('m','m','a','p')
-typedef struct {
+typedef struct _MEMORY_MAP {
   UINTN           Signature;
   LIST_ENTRY      Link;
   BOOLEAN         FromPages;
@@ -41,6 +41,17 @@ typedef struct {
 
   UINT64          VirtualStart;
   UINT64          Attribute;
+
+  //
+  // Linkage in the address ordered red-black tree indexing gMemoryMap.
+  // MaxFreeBytes is the size of the largest EfiConventionalMemory
+  // descriptor in the subtree rooted at this descriptor.
+  //
+  struct _MEMORY_MAP  *Parent;
+  struct _MEMORY_MAP  *Left;
+  struct _MEMORY_MAP  *Right;
+  BOOLEAN             Red;
+  UINT64              MaxFreeBytes;
 } MEMORY_MAP;
 
 //
@@ -172,6 +183,85 @@ CoreInternalAllocatePages (
   IN BOOLEAN                NeedGuard
   );
 
+/**
+  Internal function.  Adds a descriptor to the memory map index.
+  The range of the descriptor must not overlap any indexed descriptor.
+
+  @param  Entry                  The descriptor to add
+
+**/
+VOID
+CoreMemoryMapIndexInsert (
+  IN OUT MEMORY_MAP      *Entry
+  );
+
+/**
+  Internal function.  Removes a descriptor from the memory map index.
+
+  @param  Entry                  The descriptor to remove
+
+**/
+VOID
+CoreMemoryMapIndexRemove (
+  IN OUT MEMORY_MAP      *Entry
+  );
+
+/**
+  Internal function.  Makes the index refer to a copy of an indexed
+  descriptor instead of the descriptor itself.
+
+  @param  OldEntry               The indexed descriptor
+  @param  NewEntry               The copy of OldEntry taking its place
+
+**/
+VOID
+CoreMemoryMapIndexReplace (
+  IN     MEMORY_MAP      *OldEntry,
+  IN OUT MEMORY_MAP      *NewEntry
+  );
+
+/**
+  Internal function.  Refreshes the index after the range of an indexed
+  descriptor was clipped.
+
+  @param  Entry                  The descriptor that was clipped
+
+**/
+VOID
+CoreMemoryMapIndexUpdate (
+  IN OUT MEMORY_MAP      *Entry
+  );
+
+/**
+  Internal function.  Finds the indexed descriptor with the highest start
+  address that is not above Address.
+
+  @param  Address                The address to look up
+
+  @return The descriptor found, or NULL if all descriptors start above Address.
+
+**/
+MEMORY_MAP *
+CoreMemoryMapIndexLookup (
+  IN UINT64              Address
+  );
+
+/**
+  Internal function.  Finds the EfiConventionalMemory descriptor with the
+  highest start address below Limit that is at least Length bytes long.
+
+  @param  Limit                  The start address must be below this address
+  @param  Length                 The minimum size of the descriptor in bytes
+
+  @return The descriptor found, or NULL if there is no such descriptor.
+
+**/
+MEMORY_MAP *
+CoreMemoryMapIndexFindFree (
+  IN UINT64              Limit,
+  IN UINT64              Length
+  );
+
 //
 // Internal Global data
 //
@@ -0,0 +1,541 @@
+/** @file
+  Address ordered index of the UEFI memory map.
+
+  Every descriptor in gMemoryMap is also linked into a red-black tree keyed
+  by its start address. Each node caches the size of the largest free
+  (EfiConventionalMemory) descriptor in its subtree, so that the descriptor
+  covering an address and the highest free range of a given size can both be
+  found in O(log n) instead of walking the whole memory map.
+
+  The tree linkage lives in MEMORY_MAP itself, so updating the index never
+  allocates memory. This matters because the memory map is updated with
+  gMemoryLock held, from inside the page allocator.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "Imem.h"
+
+//
+// Root of the memory map index
+//
+STATIC MEMORY_MAP  *mMemoryMapRoot = NULL;
+
+/**
+  Get the number of free bytes described by a memory map descriptor.
+
+  @param  Entry                  The memory map descriptor
+
+  @return The size of Entry if it is EfiConventionalMemory, or 0.
+
+**/
+STATIC
+UINT64
+GetFreeBytes (
+  IN MEMORY_MAP      *Entry
+  )
+{
+  if (Entry->Type != EfiConventionalMemory) {
+    return 0;
+  }
+  return Entry->End - Entry->Start + 1;
+}
+
+/**
+  Recompute the cached largest free range of a node from its children.
+
+  @param  Node                   The node to update
+
+**/
+STATIC
+VOID
+RecomputeMaxFreeBytes (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  UINT64  MaxFreeBytes;
+
+  MaxFreeBytes = GetFreeBytes (Node);
+  if (Node->Left != NULL && Node->Left->MaxFreeBytes > MaxFreeBytes) {
+    MaxFreeBytes = Node->Left->MaxFreeBytes;
+  }
+  if (Node->Right != NULL && Node->Right->MaxFreeBytes > MaxFreeBytes) {
+    MaxFreeBytes = Node->Right->MaxFreeBytes;
+  }
+  Node->MaxFreeBytes = MaxFreeBytes;
+}
+
+/**
+  Recompute the cached largest free range of a node and all its ancestors.
+
+  @param  Node                   The lowest node to update, may be NULL
+
+**/
+STATIC
+VOID
+RecomputeMaxFreeBytesToRoot (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  while (Node != NULL) {
+    RecomputeMaxFreeBytes (Node);
+    Node = Node->Parent;
+  }
+}
+
+/**
+  Make a parent refer to a new child in place of an old one.
+
+  @param  Parent                 The parent node, or NULL if OldChild is the root
+  @param  OldChild               The current child
+  @param  NewChild               The child replacing OldChild, may be NULL
+
+**/
+STATIC
+VOID
+ReplaceChild (
+  IN OUT MEMORY_MAP  *Parent,
+  IN     MEMORY_MAP  *OldChild,
+  IN     MEMORY_MAP  *NewChild
+  )
+{
+  if (Parent == NULL) {
+    mMemoryMapRoot = NewChild;
+  } else if (Parent->Left == OldChild) {
+    Parent->Left = NewChild;
+  } else {
+    ASSERT (Parent->Right == OldChild);
+    Parent->Right = NewChild;
+  }
+}
+
+/**
+  Rotate a subtree to the left.
+
+  @param  Node                   The root of the subtree, must have a right child
+
+**/
+STATIC
+VOID
+RotateLeft (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot = Node->Right;
+  Node->Right = Pivot->Left;
+  if (Pivot->Left != NULL) {
+    Pivot->Left->Parent = Node;
+  }
+  Pivot->Parent = Node->Parent;
+  ReplaceChild (Node->Parent, Node, Pivot);
+  Pivot->Left  = Node;
+  Node->Parent = Pivot;
+
+  RecomputeMaxFreeBytes (Node);
+  RecomputeMaxFreeBytes (Pivot);
+}
+
+/**
+  Rotate a subtree to the right.
+
+  @param  Node                   The root of the subtree, must have a left child
+
+**/
+STATIC
+VOID
+RotateRight (
+  IN OUT MEMORY_MAP  *Node
+  )
+{
+  MEMORY_MAP  *Pivot;
+
+  Pivot = Node->Left;
+  Node->Left = Pivot->Right;
+  if (Pivot->Right != NULL) {
+    Pivot->Right->Parent = Node;
+  }
+  Pivot->Parent = Node->Parent;
+  ReplaceChild (Node->Parent, Node, Pivot);
+  Pivot->Right = Node;
+  Node->Parent = Pivot;
+
+  RecomputeMaxFreeBytes (Node);
+  RecomputeMaxFreeBytes (Pivot);
+}
+
+/**
+  Check whether a node is red. NULL leaves are black.
+
+  @param  Node                   The node to check, may be NULL
+
+  @retval TRUE                   The node is red.
+  @retval FALSE                  The node is black.
+
+**/
+STATIC
+BOOLEAN
+IsRed (
+  IN MEMORY_MAP      *Node
+  )
+{
+  return (BOOLEAN)(Node != NULL && Node->Red);
+}
+
+/**
+  Internal function.  Adds a descriptor to the memory map index.
+  The range of the descriptor must not overlap any indexed descriptor.
+
+  @param  Entry                  The descriptor to add
+
+**/
+VOID
+CoreMemoryMapIndexInsert (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  **Link;
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *Grand;
+  MEMORY_MAP  *Uncle;
+  MEMORY_MAP  *Node;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  Parent = NULL;
+  Link   = &mMemoryMapRoot;
+  while (*Link != NULL) {
+    Parent = *Link;
+    Link   = (Entry->Start < Parent->Start) ? &Parent->Left : &Parent->Right;
+  }
+
+  Entry->Parent = Parent;
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+  Entry->Red    = TRUE;
+  *Link         = Entry;
+  RecomputeMaxFreeBytesToRoot (Entry);
+
+  //
+  // Restore the red-black properties
+  //
+  Node = Entry;
+  while ((Parent = Node->Parent) != NULL && Parent->Red) {
+    Grand = Parent->Parent;
+    if (Parent == Grand->Left) {
+      Uncle = Grand->Right;
+      if (IsRed (Uncle)) {
+        Parent->Red = FALSE;
+        Uncle->Red  = FALSE;
+        Grand->Red  = TRUE;
+        Node        = Grand;
+        continue;
+      }
+      if (Node == Parent->Right) {
+        RotateLeft (Parent);
+        Node   = Parent;
+        Parent = Node->Parent;
+      }
+      Parent->Red = FALSE;
+      Grand->Red  = TRUE;
+      RotateRight (Grand);
+    } else {
+      Uncle = Grand->Left;
+      if (IsRed (Uncle)) {
+        Parent->Red = FALSE;
+        Uncle->Red  = FALSE;
+        Grand->Red  = TRUE;
+        Node        = Grand;
+        continue;
+      }
+      if (Node == Parent->Left) {
+        RotateRight (Parent);
+        Node   = Parent;
+        Parent = Node->Parent;
+      }
+      Parent->Red = FALSE;
+      Grand->Red  = TRUE;
+      RotateLeft (Grand);
+    }
+  }
+  mMemoryMapRoot->Red = FALSE;
+}
+
+/**
+  Internal function.  Removes a descriptor from the memory map index.
+
+  @param  Entry                  The descriptor to remove
+
+**/
+VOID
+CoreMemoryMapIndexRemove (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  MEMORY_MAP  *Spliced;
+  MEMORY_MAP  *Child;
+  MEMORY_MAP  *Parent;
+  MEMORY_MAP  *Sibling;
+  BOOLEAN     SplicedRed;
+
+  ASSERT_LOCKED (&gMemoryLock);
+
+  //
+  // Find the node to splice out of the tree: Entry itself if it has at most
+  // one child, otherwise its in-order successor, which then takes its place.
+  //
+  if (Entry->Left == NULL || Entry->Right == NULL) {
+    Spliced = Entry;
+  } else {
+    Spliced = Entry->Right;
+    while (Spliced->Left != NULL) {
+      Spliced = Spliced->Left;
+    }
+  }
+
+  Child  = (Spliced->Left != NULL) ? Spliced->Left : Spliced->Right;
+  Parent = Spliced->Parent;
+  if (Child != NULL) {
+    Child->Parent = Parent;
+  }
+  ReplaceChild (Parent, Spliced, Child);
+  SplicedRed = Spliced->Red;
+
+  if (Spliced != Entry) {
+    if (Parent == Entry) {
+      Parent = Spliced;
+    }
+    Spliced->Parent = Entry->Parent;
+    Spliced->Left   = Entry->Left;
+    Spliced->Right  = Entry->Right;
+    Spliced->Red    = Entry->Red;
+    ReplaceChild (Entry->Parent, Entry, Spliced);
+    if (Spliced->Left != NULL) {
+      Spliced->Left->Parent = Spliced;
+    }
+    if (Spliced->Right != NULL) {
+      Spliced->Right->Parent = Spliced;
+    }
+  }
+
+  Entry->Parent = NULL;
+  Entry->Left   = NULL;
+  Entry->Right  = NULL;
+
+  RecomputeMaxFreeBytesToRoot (Parent);
+
+  if (SplicedRed) {
+    return;
+  }
+
+  //
+  // A black node was removed, restore the red-black properties
+  //
+  while (Child != mMemoryMapRoot && !IsRed (Child)) {
+    if (Child == Parent->Left) {
+      Sibling = Parent->Right;
+      if (Sibling->Red) {
+        Sibling->Red = FALSE;
+        Parent->Red  = TRUE;
+        RotateLeft (Parent);
+        Sibling = Parent->Right;
+      }
+      if (!IsRed (Sibling->Left) && !IsRed (Sibling->Right)) {
+        Sibling->Red = TRUE;
+        Child        = Parent;
+        Parent       = Child->Parent;
+      } else {
+        if (!IsRed (Sibling->Right)) {
+          Sibling->Left->Red = FALSE;
+          Sibling->Red       = TRUE;
+          RotateRight (Sibling);
+          Sibling = Parent->Right;
+        }
+        Sibling->Red        = Parent->Red;
+        Parent->Red         = FALSE;
+        Sibling->Right->Red = FALSE;
+        RotateLeft (Parent);
+        Child = mMemoryMapRoot;
+      }
+    } else {
+      Sibling = Parent->Left;
+      if (Sibling->Red) {
+        Sibling->Red = FALSE;
+        Parent->Red  = TRUE;
+        RotateRight (Parent);
+        Sibling = Parent->Left;
+      }
+      if (!IsRed (Sibling->Left) && !IsRed (Sibling->Right)) {
+        Sibling->Red = TRUE;
+        Child        = Parent;
+        Parent       = Child->Parent;
+      } else {
+        if (!IsRed (Sibling->Left)) {
+          Sibling->Right->Red = FALSE;
+          Sibling->Red        = TRUE;
+          RotateLeft (Sibling);
+          Sibling = Parent->Left;
+        }
+        Sibling->Red       = Parent->Red;
+        Parent->Red        = FALSE;
+        Sibling->Left->Red = FALSE;
+        RotateRight (Parent);
+        Child = mMemoryMapRoot;
+      }
+    }
+  }
+
+  if (Child != NULL) {
+    Child->Red = FALSE;
+  }
+}
+
+/**
+  Internal function.  Makes the index refer to a copy of an indexed
+  descriptor instead of the descriptor itself.
+
+  @param  OldEntry               The indexed descriptor
+  @param  NewEntry               The copy of OldEntry taking its place
+
+**/
+VOID
+CoreMemoryMapIndexReplace (
+  IN     MEMORY_MAP      *OldEntry,
+  IN OUT MEMORY_MAP      *NewEntry
+  )
+{
+  ASSERT_LOCKED (&gMemoryLock);
+
+  NewEntry->Parent       = OldEntry->Parent;
+  NewEntry->Left         = OldEntry->Left;
+  NewEntry->Right        = OldEntry->Right;
+  NewEntry->Red          = OldEntry->Red;
+  NewEntry->MaxFreeBytes = OldEntry->MaxFreeBytes;
+
+  ReplaceChild (NewEntry->Parent, OldEntry, NewEntry);
+  if (NewEntry->Left != NULL) {
+    NewEntry->Left->Parent = NewEntry;
+  }
+  if (NewEntry->Right != NULL) {
+    NewEntry->Right->Parent = NewEntry;
+  }
+
+  OldEntry->Parent = NULL;
+  OldEntry->Left   = NULL;
+  OldEntry->Right  = NULL;
+}
+
+/**
+  Internal function.  Refreshes the index after the range of an indexed
+  descriptor was clipped.
+
+  @param  Entry                  The descriptor that was clipped
+
+**/
+VOID
+CoreMemoryMapIndexUpdate (
+  IN OUT MEMORY_MAP      *Entry
+  )
+{
+  ASSERT_LOCKED (&gMemoryLock);
+
+  RecomputeMaxFreeBytesToRoot (Entry);
+}
+
+/**
+  Internal function.  Finds the indexed descriptor with the highest start
+  address that is not above Address.
+
+  @param  Address                The address to look up
+
+  @return The descriptor found, or NULL if all descriptors start above Address.
+
+**/
+MEMORY_MAP *
+CoreMemoryMapIndexLookup (
+  IN UINT64              Address
+  )
+{
+  MEMORY_MAP  *Node;
+  MEMORY_MAP  *Found;
+
+  Found = NULL;
+  Node  = mMemoryMapRoot;
+  while (Node != NULL) {
+    if (Node->Start <= Address) {
+      Found = Node;
+      Node  = Node->Right;
+    } else {
+      Node  = Node->Left;
+    }
+  }
+  return Found;
+}
+
+/**
+  Find the free descriptor with the highest start address below Limit that
+  is at least Length bytes long in a subtree.
+
+  @param  Node                   The root of the subtree, may be NULL
+  @param  Limit                  The start address must be below this address
+  @param  Length                 The minimum size of the descriptor in bytes
+
+  @return The descriptor found, or NULL if there is no such descriptor.
+
+**/
+STATIC
+MEMORY_MAP *
+FindFreeInSubtree (
+  IN MEMORY_MAP      *Node,
+  IN UINT64          Limit,
+  IN UINT64          Length
+  )
+{
+  MEMORY_MAP  *Found;
+
+  while (Node != NULL && Node->MaxFreeBytes >= Length) {
+    if (Node->Start >= Limit) {
+      Node = Node->Left;
+      continue;
+    }
+
+    Found = FindFreeInSubtree (Node->Right, Limit, Length);
+    if (Found != NULL) {
+      return Found;
+    }
+
+    if (GetFreeBytes (Node) >= Length) {
+      return Node;
+    }
+
+    Node = Node->Left;
+  }
+
+  return NULL;
+}
+
+/**
+  Internal function.  Finds the EfiConventionalMemory descriptor with the
+  highest start address below Limit that is at least Length bytes long.
+
+  @param  Limit                  The start address must be below this address
+  @param  Length                 The minimum size of the descriptor in bytes
+
+  @return The descriptor found, or NULL if there is no such descriptor.
+
+**/
+MEMORY_MAP *
+CoreMemoryMapIndexFindFree (
+  IN UINT64              Limit,
+  IN UINT64              Length
+  )
+{
+  if (Length == 0) {
+    Length = 1;
+  }
+  return FindFreeInSubtree (mMemoryMapRoot, Limit, Length);
+}
@@ -60,6 +60,45 @@ STATIC CONST UINT16 mPoolSizeTable[] = {
 
 #define MAX_POOL_SIZE     (MAX_ADDRESS - POOL_OVERHEAD)
 
+//
+// Slab allocator for small pool requests. Each slab is a single page holding
+// objects of one size class, with a bitmap tracking the free objects. An
+// object only carries a small POOL_SLAB_HEAD instead of POOL_HEAD/POOL_TAIL.
+//
+#define POOL_SLAB_SIGNATURE       SIGNATURE_32('p','s','l','b')
+#define POOL_SLAB_HEAD_SIGNATURE  SIGNATURE_32('p','s','h','d')
+
+#define POOL_SLAB_BITMAP_WORDS    4
+
+typedef struct {
+  UINT32          Signature;
+  UINT16          Class;
+  UINT16          FreeCount;
+  EFI_MEMORY_TYPE Type;
+  LIST_ENTRY      Link;
+  UINT32          FreeMap[POOL_SLAB_BITMAP_WORDS];
+} POOL_SLAB;
+
+typedef struct {
+  UINT32          Signature;
+  UINT32          Index;
+} POOL_SLAB_HEAD;
+
+#define POOL_SLAB_DATA_OFFSET   ALIGN_VALUE (sizeof (POOL_SLAB), 16)
+
+//
+// Object stride (including POOL_SLAB_HEAD) of each slab size class
+//
+STATIC CONST UINT16 mPoolSlabSizeTable[] = {
+  32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+#define MAX_SLAB_CLASS        (ARRAY_SIZE (mPoolSlabSizeTable))
+#define MAX_SLAB_OBJECT_SIZE  (mPoolSlabSizeTable[MAX_SLAB_CLASS - 1] - sizeof (POOL_SLAB_HEAD))
+
+#define SLAB_CLASS_TO_SIZE(a)     (mPoolSlabSizeTable[a])
+#define SLAB_CLASS_TO_COUNT(a)    ((EFI_PAGE_SIZE - POOL_SLAB_DATA_OFFSET) / mPoolSlabSizeTable[a])
+
 //
 // Globals
 //
@@ -70,6 +109,7 @@ typedef struct {
     UINTN            Used;
     EFI_MEMORY_TYPE  MemoryType;
     LIST_ENTRY       FreeList[MAX_POOL_LIST];
+    LIST_ENTRY       SlabList[MAX_SLAB_CLASS];
     LIST_ENTRY       Link;
 } POOL;
 
@@ -107,6 +147,31 @@ GetPoolIndexFromSize (
   return MAX_POOL_LIST;
 }
 
+/**
+  Get slab size class index from the specified size.
+
+  @param  Size          The requested pool size, excluding POOL_SLAB_HEAD.
+
+  @return               The index of slab size table.
+
+**/
+STATIC
+UINTN
+GetSlabClassFromSize (
+  UINTN   Size
+  )
+{
+  UINTN   Class;
+
+  Size += sizeof (POOL_SLAB_HEAD);
+  for (Class = 0; Class < MAX_SLAB_CLASS; Class++) {
+    if (mPoolSlabSizeTable[Class] >= Size) {
+      return Class;
+    }
+  }
+  return MAX_SLAB_CLASS;
+}
+
 /**
   Called to initialize the pool.
 
@@ -126,6 +191,9 @@ CoreInitializePool (
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&mPoolHead[Type].FreeList[Index]);
     }
+    for (Index=0; Index < MAX_SLAB_CLASS; Index++) {
+      InitializeListHead (&mPoolHead[Type].SlabList[Index]);
+    }
   }
 }
 
@@ -176,6 +244,9 @@ LookupPoolHead (
     for (Index=0; Index < MAX_POOL_LIST; Index++) {
       InitializeListHead (&Pool->FreeList[Index]);
     }
+    for (Index=0; Index < MAX_SLAB_CLASS; Index++) {
+      InitializeListHead (&Pool->SlabList[Index]);
+    }
 
     InsertHeadList (&mPoolHeadList, &Pool->Link);
 
@@ -332,6 +403,98 @@ CoreAllocatePoolPagesI (
   return Buffer;
 }
 
+/**
+  Internal function to allocate a small pool entry from a slab.
+  Caller must have the memory lock held
+
+  @param  Pool                   The pool head of the memory type to allocate
+  @param  Size                   The amount of pool to allocate
+
+  @return The allocated pool, or NULL
+
+**/
+STATIC
+VOID *
+CoreAllocatePoolSlab (
+  IN POOL             *Pool,
+  IN UINTN            Size
+  )
+{
+  POOL_SLAB       *Slab;
+  POOL_SLAB_HEAD  *Head;
+  UINTN           Class;
+  UINTN           Count;
+  UINTN           Index;
+  UINTN           Word;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+
+  Class = GetSlabClassFromSize (Size);
+  ASSERT (Class < MAX_SLAB_CLASS);
+
+  //
+  // If no slab of this size class has a free entry, go get another page
+  //
+  if (IsListEmpty (&Pool->SlabList[Class])) {
+    Slab = CoreAllocatePoolPagesI (Pool->MemoryType, 1, EFI_PAGE_SIZE, FALSE);
+    if (Slab == NULL) {
+      DEBUG ((DEBUG_ERROR | DEBUG_POOL, "AllocatePool: failed to allocate slab for %ld bytes\n", (UINT64) Size));
+      return NULL;
+    }
+
+    Count = SLAB_CLASS_TO_COUNT (Class);
+    ASSERT (Count <= POOL_SLAB_BITMAP_WORDS * 32);
+
+    Slab->Signature = POOL_SLAB_SIGNATURE;
+    Slab->Class     = (UINT16)Class;
+    Slab->FreeCount = (UINT16)Count;
+    Slab->Type      = Pool->MemoryType;
+    ZeroMem (Slab->FreeMap, sizeof (Slab->FreeMap));
+    for (Index = 0; Index < Count; Index++) {
+      Slab->FreeMap[Index / 32] |= (UINT32)1 << (Index % 32);
+    }
+    InsertHeadList (&Pool->SlabList[Class], &Slab->Link);
+  }
+
+  //
+  // Take the first free entry of the first slab with free entries
+  //
+  Slab = CR (Pool->SlabList[Class].ForwardLink, POOL_SLAB, Link, POOL_SLAB_SIGNATURE);
+  for (Word = 0; Slab->FreeMap[Word] == 0; Word++) {
+    ASSERT (Word < POOL_SLAB_BITMAP_WORDS - 1);
+  }
+  Index = (UINTN)LowBitSet32 (Slab->FreeMap[Word]);
+  Slab->FreeMap[Word] &= ~((UINT32)1 << Index);
+  Index += Word * 32;
+
+  Slab->FreeCount--;
+  if (Slab->FreeCount == 0) {
+    RemoveEntryList (&Slab->Link);
+  }
+
+  Head = (POOL_SLAB_HEAD *)((UINT8 *)Slab + POOL_SLAB_DATA_OFFSET +
+                            Index * SLAB_CLASS_TO_SIZE (Class));
+  Head->Signature = POOL_SLAB_HEAD_SIGNATURE;
+  Head->Index     = (UINT32)Index;
+
+  //
+  // Account the allocation
+  //
+  Pool->Used += SLAB_CLASS_TO_SIZE (Class);
+
+  DEBUG_CLEAR_MEMORY (Head + 1, Size);
+
+  DEBUG ((
+    DEBUG_POOL,
+    "AllocatePoolI: Type %x, Addr %p (len %lx) %,ld\n", Pool->MemoryType,
+    Head + 1,
+    (UINT64)Size,
+    (UINT64) Pool->Used
+    ));
+
+  return Head + 1;
+}
+
 /**
   Internal function to allocate pool of a particular type.
   Caller must have the memory lock held
@@ -391,6 +554,17 @@ CoreAllocatePoolI (
   //
   Size = ALIGN_VARIABLE (Size);
 
+  //
+  // Small requests of the regular memory types are served from slabs
+  //
+  if (FeaturePcdGet (PcdDxeCorePoolSlabEnable) &&
+      !NeedGuard && !PageAsPool &&
+      (UINT32)PoolType < EfiMaxMemoryType &&
+      Granularity == EFI_PAGE_SIZE &&
+      Size <= MAX_SLAB_OBJECT_SIZE) {
+    return CoreAllocatePoolSlab (&mPoolHead[PoolType], Size);
+  }
+
   Size += POOL_OVERHEAD;
   Index = SIZE_TO_LIST(Size);
   Pool = LookupPoolHead (PoolType);
@@ -653,6 +827,125 @@ CoreFreePoolPagesWithGuard (
   }
 }
 
+/**
+  Internal function.  Look up the slab holding a pool entry.
+
+  @param  Buffer                 The allocated pool entry
+
+  @return The slab holding Buffer, or NULL if Buffer was not allocated from a slab.
+
+**/
+STATIC
+POOL_SLAB *
+CoreLookupPoolSlab (
+  IN VOID               *Buffer
+  )
+{
+  POOL_SLAB       *Slab;
+  POOL_SLAB_HEAD  *Head;
+  UINTN           Offset;
+
+  //
+  // Slab entries never start at the beginning of a page, so both the entry
+  // header and the slab header live in the page holding Buffer.
+  //
+  Offset = (UINTN)Buffer & EFI_PAGE_MASK;
+  if (Offset < POOL_SLAB_DATA_OFFSET + sizeof (POOL_SLAB_HEAD)) {
+    return NULL;
+  }
+
+  Head = (POOL_SLAB_HEAD *)Buffer - 1;
+  if (Head->Signature != POOL_SLAB_HEAD_SIGNATURE) {
+    return NULL;
+  }
+
+  Slab = (POOL_SLAB *)((UINTN)Buffer & ~(UINTN)EFI_PAGE_MASK);
+  if (Slab->Signature != POOL_SLAB_SIGNATURE ||
+      Slab->Class >= MAX_SLAB_CLASS ||
+      Head->Index >= SLAB_CLASS_TO_COUNT (Slab->Class)) {
+    return NULL;
+  }
+
+  if (Offset - sizeof (POOL_SLAB_HEAD) !=
+      POOL_SLAB_DATA_OFFSET + Head->Index * SLAB_CLASS_TO_SIZE (Slab->Class)) {
+    return NULL;
+  }
+
+  return Slab;
+}
+
+/**
+  Internal function to free a pool entry allocated from a slab.
+  Caller must have the memory lock held
+
+  @param  Slab                   The slab holding the pool entry
+  @param  Buffer                 The allocated pool entry to free
+  @param  PoolType               Pointer to pool type
+
+  @retval EFI_INVALID_PARAMETER  Buffer not valid
+  @retval EFI_SUCCESS            Buffer successfully freed.
+
+**/
+STATIC
+EFI_STATUS
+CoreFreePoolSlab (
+  IN POOL_SLAB          *Slab,
+  IN VOID               *Buffer,
+  OUT EFI_MEMORY_TYPE   *PoolType OPTIONAL
+  )
+{
+  POOL            *Pool;
+  POOL_SLAB_HEAD  *Head;
+  UINTN           Class;
+  UINTN           Index;
+  UINT32          Mask;
+
+  ASSERT_LOCKED (&mPoolMemoryLock);
+
+  Head  = (POOL_SLAB_HEAD *)Buffer - 1;
+  Index = Head->Index;
+  Class = Slab->Class;
+  Mask  = (UINT32)1 << (Index % 32);
+
+  //
+  // Catch double free of the same entry
+  //
+  if ((Slab->FreeMap[Index / 32] & Mask) != 0) {
+    ASSERT ((Slab->FreeMap[Index / 32] & Mask) == 0);
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Pool = &mPoolHead[Slab->Type];
+  Pool->Used -= SLAB_CLASS_TO_SIZE (Class);
+  DEBUG ((DEBUG_POOL, "FreePool: %p (len %lx) %,ld\n", Buffer, (UINT64)(SLAB_CLASS_TO_SIZE (Class) - sizeof (POOL_SLAB_HEAD)), (UINT64) Pool->Used));
+
+  if (PoolType != NULL) {
+    *PoolType = Slab->Type;
+  }
+
+  DEBUG_CLEAR_MEMORY (Head, SLAB_CLASS_TO_SIZE (Class));
+
+  Slab->FreeMap[Index / 32] |= Mask;
+  Slab->FreeCount++;
+  if (Slab->FreeCount == 1) {
+    InsertHeadList (&Pool->SlabList[Class], &Slab->Link);
+  }
+
+  //
+  // Give a completely free slab back to free memory, unless it is the only
+  // slab left for this size class
+  //
+  if (Slab->FreeCount == SLAB_CLASS_TO_COUNT (Class) &&
+      (Pool->SlabList[Class].ForwardLink != &Slab->Link ||
+       Slab->Link.ForwardLink != &Pool->SlabList[Class])) {
+    RemoveEntryList (&Slab->Link);
+    Slab->Signature = 0;
+    CoreFreePoolPagesI (Pool->MemoryType, (EFI_PHYSICAL_ADDRESS)(UINTN)Slab, 1);
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   Internal function to free a pool entry.
   Caller must have the memory lock held
@@ -684,8 +977,17 @@ CoreFreePoolI (
   BOOLEAN     IsGuarded;
   BOOLEAN     HasPoolTail;
   BOOLEAN     PageAsPool;
+  POOL_SLAB   *Slab;
 
   ASSERT(Buffer != NULL);
+
+  if (FeaturePcdGet (PcdDxeCorePoolSlabEnable)) {
+    Slab = CoreLookupPoolSlab (Buffer);
+    if (Slab != NULL) {
+      return CoreFreePoolSlab (Slab, Buffer, PoolType);
+    }
+  }
+
   //
   // Get the head & tail of the pool entry
   //
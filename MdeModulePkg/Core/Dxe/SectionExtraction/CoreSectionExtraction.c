@@ -220,6 +220,8 @@ InitializeSectionExtraction (
   EFI_GUID                           *ExtractHandlerGuidTable;
   UINTN                              ExtractHandlerNumber;
 
+  CoreInitializeSectionCache ();
+
   //
   // Get custom extract guided section method guid list
   //
@@ -1514,6 +1516,23 @@ CustomGuidedSectionExtract (
   ScratchBuffer         = NULL;
   AllocatedOutputBuffer = NULL;
 
+  //
+  // The section may already have been decoded in PEI or earlier in DXE
+  //
+  Status = CoreLookupSectionCache (InputSection, OutputBuffer, OutputSize, AuthenticationStatus);
+  if (!EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // The section may already have been decoded on an AP by the dispatcher
+  //
+  Status = CoreGetPrefetchedSection (InputSection, OutputBuffer, OutputSize, AuthenticationStatus);
+  if (!EFI_ERROR (Status)) {
+    CoreInsertSectionCache (InputSection, *OutputBuffer, *OutputSize, *AuthenticationStatus);
+    return Status;
+  }
+
   //
   // Call GetInfo to get the size and attribute of input guided section data.
   //
@@ -1556,12 +1575,14 @@ CustomGuidedSectionExtract (
   //
   // Call decode function to extract raw data from the guided section.
   //
+  PERF_INMODULE_BEGIN ("GuidedSectionDecode");
   Status = ExtractGuidedSectionDecode (
              InputSection,
              OutputBuffer,
              ScratchBuffer,
              AuthenticationStatus
              );
+  PERF_INMODULE_END ("GuidedSectionDecode");
   if (EFI_ERROR (Status)) {
     //
     // Decode failed
@@ -1597,5 +1618,7 @@ CustomGuidedSectionExtract (
     CoreFreePool (ScratchBuffer);
   }
 
+  CoreInsertSectionCache (InputSection, *OutputBuffer, *OutputSize, *AuthenticationStatus);
+
   return EFI_SUCCESS;
 }
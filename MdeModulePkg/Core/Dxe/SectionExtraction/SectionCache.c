@@ -0,0 +1,408 @@
+/** @file
+  Cache of decoded GUIDed encapsulation sections.
+
+  The section streams of the section extraction code only live as long as the
+  stream is open, so a GUIDed section read through a new stream is decoded
+  again. This cache keeps the decoded data of GUIDed sections independent of
+  the streams, and also serves the sections the PEI Core already decoded and
+  published in gEdkiiDecompressedSectionCacheHobGuid HOBs.
+
+  Sections are matched by the name of the file they were read from, their
+  definition GUID and their size, as the same section is found at different
+  addresses in the different stream buffers. A match is only accepted once the
+  cached copy of the section compares equal to the section being extracted.
+  Only the sections of firmware volume files are cached, the sections read from
+  other buffers have no name to be found again by.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+
+#define SECTION_CACHE_ENTRY_SIGNATURE  SIGNATURE_32('S','C','A','E')
+
+//
+// Upper bound of the decoded data kept by the DXE Core itself. The data
+// published by the PEI Core is not counted, it is not owned by the cache.
+//
+#define SECTION_CACHE_MAX_BYTES        SIZE_16MB
+
+typedef struct {
+  EFI_GUID                FileName;
+  EFI_GUID                SectionDefinitionGuid;
+  UINT32                  SectionSize;
+} SECTION_CACHE_KEY;
+
+typedef struct {
+  UINTN                   Signature;
+  LIST_ENTRY              Link;
+  SECTION_CACHE_KEY       Key;
+  //
+  // Private copy of the GUIDed section the data was decoded from
+  //
+  VOID                    *Section;
+  UINT32                  AuthenticationStatus;
+  VOID                    *Data;
+  UINTN                   DataSize;
+} SECTION_CACHE_ENTRY;
+
+//
+// Most recently used entries first
+//
+LIST_ENTRY  mSectionCacheList  = INITIALIZE_LIST_HEAD_VARIABLE (mSectionCacheList);
+UINTN       mSectionCacheBytes = 0;
+
+//
+// The sections published by the PEI Core, sorted by file name
+//
+EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY  **mSectionCacheHobIndex = NULL;
+UINTN                                   mSectionCacheHobCount   = 0;
+
+//
+// The file whose sections are being read, set by FvReadFileSection()
+//
+CONST EFI_GUID  *mSectionCacheFileName = NULL;
+
+//
+// Counters displayed by CoreDumpSectionCacheStatistics()
+//
+UINT64      mSectionBytesDecoded  = 0;
+UINT64      mSectionBytesReused   = 0;
+UINTN       mSectionDecodes       = 0;
+UINTN       mSectionCacheHits     = 0;
+UINTN       mSectionCacheHobHits  = 0;
+
+
+/**
+  Index the sections the PEI Core published, so that a lookup does not walk
+  the HOB list.
+
+**/
+VOID
+CoreInitializeSectionCache (
+  VOID
+  )
+{
+  EFI_HOB_GUID_TYPE                       *GuidHob;
+  EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY  *HobEntry;
+  UINTN                                   Count;
+  UINTN                                   Index;
+
+  if (!FeaturePcdGet (PcdDecompressedSectionCacheEnable)) {
+    return;
+  }
+
+  Count = 0;
+  for (GuidHob = GetFirstGuidHob (&gEdkiiDecompressedSectionCacheHobGuid);
+       GuidHob != NULL;
+       GuidHob = GetNextGuidHob (&gEdkiiDecompressedSectionCacheHobGuid, GET_NEXT_HOB (GuidHob))) {
+    Count++;
+  }
+  if (Count == 0) {
+    return;
+  }
+
+  mSectionCacheHobIndex = AllocatePool (Count * sizeof (*mSectionCacheHobIndex));
+  if (mSectionCacheHobIndex == NULL) {
+    return;
+  }
+
+  //
+  // Insertion sort on the file name, the HOBs are few
+  //
+  for (GuidHob = GetFirstGuidHob (&gEdkiiDecompressedSectionCacheHobGuid);
+       GuidHob != NULL;
+       GuidHob = GetNextGuidHob (&gEdkiiDecompressedSectionCacheHobGuid, GET_NEXT_HOB (GuidHob))) {
+    HobEntry = (EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY *) GET_GUID_HOB_DATA (GuidHob);
+    for (Index = mSectionCacheHobCount;
+         Index > 0 && CompareMem (&mSectionCacheHobIndex[Index - 1]->FileName, &HobEntry->FileName, sizeof (EFI_GUID)) > 0;
+         Index--) {
+      mSectionCacheHobIndex[Index] = mSectionCacheHobIndex[Index - 1];
+    }
+    mSectionCacheHobIndex[Index] = HobEntry;
+    mSectionCacheHobCount++;
+  }
+}
+
+
+/**
+  Set the name of the file whose sections are read next.
+
+  @param  FileName        The name of the file, or NULL if the sections are
+                          not to be cached.
+
+  @return The name that was set before, to be restored by the caller.
+
+**/
+CONST EFI_GUID *
+CoreSetSectionCacheFileName (
+  IN CONST EFI_GUID  *FileName  OPTIONAL
+  )
+{
+  CONST EFI_GUID  *PreviousFileName;
+
+  PreviousFileName      = mSectionCacheFileName;
+  mSectionCacheFileName = FileName;
+  return PreviousFileName;
+}
+
+
+/**
+  Compute the cache key of a GUIDed section.
+
+  @param  InputSection    The GUIDed section.
+  @param  Key             Returns the key of the section.
+
+**/
+STATIC
+VOID
+CoreGetSectionCacheKey (
+  IN  CONST VOID          *InputSection,
+  OUT SECTION_CACHE_KEY   *Key
+  )
+{
+  EFI_COMMON_SECTION_HEADER  *Section;
+
+  ZeroMem (Key, sizeof (*Key));
+  CopyGuid (&Key->FileName, mSectionCacheFileName);
+
+  Section = (EFI_COMMON_SECTION_HEADER *) InputSection;
+  if (IS_SECTION2 (Section)) {
+    CopyGuid (&Key->SectionDefinitionGuid, &((EFI_GUID_DEFINED_SECTION2 *) Section)->SectionDefinitionGuid);
+    Key->SectionSize = SECTION2_SIZE (Section);
+  } else {
+    CopyGuid (&Key->SectionDefinitionGuid, &((EFI_GUID_DEFINED_SECTION *) Section)->SectionDefinitionGuid);
+    Key->SectionSize = SECTION_SIZE (Section);
+  }
+}
+
+
+/**
+  Find a section in the sections the PEI Core published.
+
+  @param  InputSection    The GUIDed section to extract.
+  @param  Key             The key of the section.
+
+  @return The matching HOB entry, or NULL if there is none.
+
+**/
+STATIC
+EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY *
+CoreLookupSectionCacheHob (
+  IN CONST VOID               *InputSection,
+  IN CONST SECTION_CACHE_KEY  *Key
+  )
+{
+  UINTN                                   Low;
+  UINTN                                   High;
+  UINTN                                   Middle;
+  EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY  *HobEntry;
+
+  //
+  // Find the first entry of the file
+  //
+  Low  = 0;
+  High = mSectionCacheHobCount;
+  while (Low < High) {
+    Middle = (Low + High) / 2;
+    if (CompareMem (&mSectionCacheHobIndex[Middle]->FileName, &Key->FileName, sizeof (EFI_GUID)) < 0) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  for (; Low < mSectionCacheHobCount; Low++) {
+    HobEntry = mSectionCacheHobIndex[Low];
+    if (!CompareGuid (&HobEntry->FileName, &Key->FileName)) {
+      break;
+    }
+    if (HobEntry->SectionSize == Key->SectionSize &&
+        CompareGuid (&HobEntry->SectionDefinitionGuid, &Key->SectionDefinitionGuid) &&
+        CompareMem ((VOID *) (UINTN) HobEntry->SectionBase, InputSection, Key->SectionSize) == 0) {
+      return HobEntry;
+    }
+  }
+
+  return NULL;
+}
+
+
+/**
+  Look up the decoded data of a GUIDed section, first in the sections the DXE
+  Core decoded, then in the sections the PEI Core published.
+
+  @param  InputSection          The GUIDed section to extract.
+  @param  OutputBuffer          Returns a pool buffer with a copy of the section
+                                contents. The caller owns the buffer.
+  @param  OutputSize            Returns the size of OutputBuffer.
+  @param  AuthenticationStatus  Returns the authentication status of the decode.
+
+  @retval EFI_SUCCESS           The section was found in the cache.
+  @retval EFI_NOT_FOUND         The section was not found in the cache.
+  @retval EFI_OUT_OF_RESOURCES  The copy of the section could not be allocated.
+
+**/
+EFI_STATUS
+CoreLookupSectionCache (
+  IN  CONST VOID  *InputSection,
+  OUT VOID        **OutputBuffer,
+  OUT UINTN       *OutputSize,
+  OUT UINT32      *AuthenticationStatus
+  )
+{
+  SECTION_CACHE_KEY                       Key;
+  LIST_ENTRY                              *Link;
+  SECTION_CACHE_ENTRY                     *Entry;
+  EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY  *HobEntry;
+  VOID                                    *Data;
+  UINTN                                   DataSize;
+  UINT32                                  DataAuthenticationStatus;
+
+  if (!FeaturePcdGet (PcdDecompressedSectionCacheEnable) || mSectionCacheFileName == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  CoreGetSectionCacheKey (InputSection, &Key);
+
+  Data                     = NULL;
+  DataSize                 = 0;
+  DataAuthenticationStatus = 0;
+  for (Link = mSectionCacheList.ForwardLink; Link != &mSectionCacheList; Link = Link->ForwardLink) {
+    Entry = CR (Link, SECTION_CACHE_ENTRY, Link, SECTION_CACHE_ENTRY_SIGNATURE);
+    if (CompareMem (&Entry->Key, &Key, sizeof (Key)) == 0 &&
+        CompareMem (Entry->Section, InputSection, Key.SectionSize) == 0) {
+      //
+      // Keep the entry at the head of the list, it is evicted last
+      //
+      RemoveEntryList (&Entry->Link);
+      InsertHeadList (&mSectionCacheList, &Entry->Link);
+
+      Data                     = Entry->Data;
+      DataSize                 = Entry->DataSize;
+      DataAuthenticationStatus = Entry->AuthenticationStatus;
+      mSectionCacheHits++;
+      break;
+    }
+  }
+
+  if (Data == NULL) {
+    HobEntry = CoreLookupSectionCacheHob (InputSection, &Key);
+    if (HobEntry != NULL) {
+      Data                     = (VOID *) (UINTN) HobEntry->DataBase;
+      DataSize                 = (UINTN) HobEntry->DataSize;
+      DataAuthenticationStatus = HobEntry->AuthenticationStatus;
+      mSectionCacheHobHits++;
+    }
+  }
+
+  if (Data == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  *OutputBuffer = AllocateCopyPool (DataSize, Data);
+  if (*OutputBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  *OutputSize           = DataSize;
+  *AuthenticationStatus = DataAuthenticationStatus;
+  mSectionBytesReused  += DataSize;
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Keep a copy of the decoded data of a GUIDed section, evicting the least
+  recently used sections if the cache is full.
+
+  @param  InputSection          The GUIDed section that was decoded.
+  @param  Data                  The decoded section contents.
+  @param  DataSize              The size of Data.
+  @param  AuthenticationStatus  The authentication status of the decode.
+
+**/
+VOID
+CoreInsertSectionCache (
+  IN CONST VOID  *InputSection,
+  IN VOID        *Data,
+  IN UINTN       DataSize,
+  IN UINT32      AuthenticationStatus
+  )
+{
+  SECTION_CACHE_ENTRY  *Entry;
+  SECTION_CACHE_KEY    Key;
+
+  mSectionBytesDecoded += DataSize;
+  mSectionDecodes++;
+
+  if (!FeaturePcdGet (PcdDecompressedSectionCacheEnable) || mSectionCacheFileName == NULL) {
+    return;
+  }
+
+  CoreGetSectionCacheKey (InputSection, &Key);
+  if (DataSize == 0 || (UINT64) DataSize + Key.SectionSize > SECTION_CACHE_MAX_BYTES / 2) {
+    return;
+  }
+
+  while (mSectionCacheBytes + DataSize + Key.SectionSize > SECTION_CACHE_MAX_BYTES) {
+    Entry = CR (mSectionCacheList.BackLink, SECTION_CACHE_ENTRY, Link, SECTION_CACHE_ENTRY_SIGNATURE);
+    RemoveEntryList (&Entry->Link);
+    mSectionCacheBytes -= Entry->DataSize + Entry->Key.SectionSize;
+    CoreFreePool (Entry->Section);
+    CoreFreePool (Entry->Data);
+    CoreFreePool (Entry);
+  }
+
+  Entry = AllocatePool (sizeof (SECTION_CACHE_ENTRY));
+  if (Entry == NULL) {
+    return;
+  }
+  Entry->Section = AllocateCopyPool (Key.SectionSize, InputSection);
+  Entry->Data    = AllocateCopyPool (DataSize, Data);
+  if (Entry->Section == NULL || Entry->Data == NULL) {
+    if (Entry->Section != NULL) {
+      CoreFreePool (Entry->Section);
+    }
+    if (Entry->Data != NULL) {
+      CoreFreePool (Entry->Data);
+    }
+    CoreFreePool (Entry);
+    return;
+  }
+  Entry->Signature            = SECTION_CACHE_ENTRY_SIGNATURE;
+  Entry->DataSize             = DataSize;
+  Entry->AuthenticationStatus = AuthenticationStatus;
+  CopyMem (&Entry->Key, &Key, sizeof (Key));
+
+  InsertHeadList (&mSectionCacheList, &Entry->Link);
+  mSectionCacheBytes += DataSize + Key.SectionSize;
+}
+
+
+/**
+  Display how many bytes of GUIDed sections were decoded and how many were
+  served from the cache.
+
+**/
+VOID
+CoreDumpSectionCacheStatistics (
+  VOID
+  )
+{
+  if (!FeaturePcdGet (PcdDecompressedSectionCacheEnable)) {
+    return;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "Section cache: %d sections decoded (%ld bytes), %d DXE hits, %d PEI hits (%ld bytes reused)\n",
+    mSectionDecodes,
+    mSectionBytesDecoded,
+    mSectionCacheHits,
+    mSectionCacheHobHits,
+    mSectionBytesReused
+    ));
+}
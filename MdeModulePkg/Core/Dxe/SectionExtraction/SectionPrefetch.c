@@ -0,0 +1,609 @@
+/** @file
+  Prefetch of GUIDed encapsulation sections on application processors.
+
+  While the DXE dispatcher loads and starts the driver at the head of the
+  scheduled queue, the GUIDed sections (typically LZMA or Brotli compressed)
+  of the drivers behind it are decoded on the APs through the MP Services
+  protocol. The decoded data is parked in a bounded cache, and
+  CustomGuidedSectionExtract() takes it from there instead of decoding the
+  section again on the BSP.
+
+  All buffers are allocated and freed on the BSP. Only the sections of the
+  decompressors listed in mPrefetchApSafeGuids are decoded on the APs: their
+  handlers work on the buffers they are given and do not call any boot service.
+  Other GUIDed sections, such as CRC32 or signed sections whose handlers locate
+  protocols or allocate memory, are left to be extracted on the BSP.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+
+#define SECTION_PREFETCH_JOB_SIGNATURE  SIGNATURE_32('S','P','F','J')
+
+//
+// Upper bound of the memory held by queued and decoded sections
+//
+#define SECTION_PREFETCH_MAX_BYTES      SIZE_32MB
+#define SECTION_PREFETCH_MAX_JOBS       32
+
+#define SECTION_PREFETCH_MAX_APS        64
+
+typedef enum {
+  SectionPrefetchPending,
+  SectionPrefetchRunning,
+  SectionPrefetchDone
+} SECTION_PREFETCH_STATE;
+
+typedef struct {
+  UINTN                   Signature;
+  LIST_ENTRY              Link;
+  //
+  // Private copy of the GUIDed section as found in the FFS file
+  //
+  VOID                    *InputSection;
+  UINT32                  InputSize;
+  VOID                    *OutputBuffer;
+  UINT32                  OutputSize;
+  VOID                    *ScratchBuffer;
+  UINT32                  ScratchSize;
+  //
+  // Filled in by the decode handler
+  //
+  VOID                    *DecodedBuffer;
+  UINT32                  AuthenticationStatus;
+  EFI_STATUS              Status;
+  volatile UINT32         State;
+} SECTION_PREFETCH_JOB;
+
+typedef struct {
+  UINTN                   ProcessorNumber;
+  EFI_EVENT               Event;
+  SECTION_PREFETCH_JOB    *Job;
+} SECTION_PREFETCH_AP;
+
+EFI_MP_SERVICES_PROTOCOL  *mPrefetchMpServices = NULL;
+SECTION_PREFETCH_AP       mPrefetchAp[SECTION_PREFETCH_MAX_APS];
+UINTN                     mPrefetchApCount     = 0;
+LIST_ENTRY                mPrefetchJobList     = INITIALIZE_LIST_HEAD_VARIABLE (mPrefetchJobList);
+UINTN                     mPrefetchJobCount    = 0;
+UINTN                     mPrefetchBytes       = 0;
+
+//
+// GUIDed sections whose decode handler is safe to run on an AP
+//
+EFI_GUID                  *mPrefetchApSafeGuids[] = {
+  &gLzmaCustomDecompressGuid,
+  &gLzmaF86CustomDecompressGuid,
+  &gBrotliCustomDecompressGuid,
+  &gTianoCustomDecompressGuid
+};
+
+//
+// Counters displayed when the cache is flushed
+//
+UINTN                     mPrefetchApDecodes   = 0;
+UINTN                     mPrefetchBspDecodes  = 0;
+UINTN                     mPrefetchHits        = 0;
+UINTN                     mPrefetchDiscards    = 0;
+
+
+/**
+  Locate the MP Services protocol and set up one completion event per enabled AP.
+
+  @retval TRUE   APs are available to decode sections.
+  @retval FALSE  The MP Services protocol is not installed yet, or there is no AP.
+
+**/
+STATIC
+BOOLEAN
+CorePrefetchInitializeAps (
+  VOID
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_MP_SERVICES_PROTOCOL   *MpServices;
+  UINTN                      NumberOfProcessors;
+  UINTN                      NumberOfEnabledProcessors;
+  UINTN                      BspNumber;
+  UINTN                      Index;
+  EFI_PROCESSOR_INFORMATION  ProcessorInfo;
+
+  if (mPrefetchMpServices != NULL) {
+    return (BOOLEAN) (mPrefetchApCount != 0);
+  }
+
+  Status = CoreLocateProtocol (&gEfiMpServiceProtocolGuid, NULL, (VOID **) &MpServices);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  mPrefetchMpServices = MpServices;
+
+  Status = MpServices->GetNumberOfProcessors (MpServices, &NumberOfProcessors, &NumberOfEnabledProcessors);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+  Status = MpServices->WhoAmI (MpServices, &BspNumber);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  for (Index = 0; Index < NumberOfProcessors && mPrefetchApCount < SECTION_PREFETCH_MAX_APS; Index++) {
+    if (Index == BspNumber) {
+      continue;
+    }
+    Status = MpServices->GetProcessorInfo (MpServices, Index, &ProcessorInfo);
+    if (EFI_ERROR (Status) || (ProcessorInfo.StatusFlag & PROCESSOR_ENABLED_BIT) == 0) {
+      continue;
+    }
+    Status = CoreCreateEvent (0, TPL_CALLBACK, NULL, NULL, &mPrefetchAp[mPrefetchApCount].Event);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    mPrefetchAp[mPrefetchApCount].ProcessorNumber = Index;
+    mPrefetchAp[mPrefetchApCount].Job             = NULL;
+    mPrefetchApCount++;
+  }
+
+  DEBUG ((DEBUG_INFO, "Section prefetch: %d APs available\n", mPrefetchApCount));
+  return (BOOLEAN) (mPrefetchApCount != 0);
+}
+
+
+/**
+  Decode one prefetch job. Runs on an AP, or on the BSP for jobs that are
+  needed before an AP could pick them up.
+
+  @param  Buffer   The SECTION_PREFETCH_JOB to decode.
+
+**/
+STATIC
+VOID
+EFIAPI
+CorePrefetchDecode (
+  IN OUT VOID  *Buffer
+  )
+{
+  SECTION_PREFETCH_JOB  *Job;
+
+  Job = (SECTION_PREFETCH_JOB *) Buffer;
+
+  Job->DecodedBuffer = Job->OutputBuffer;
+  Job->Status = ExtractGuidedSectionDecode (
+                  Job->InputSection,
+                  &Job->DecodedBuffer,
+                  Job->ScratchBuffer,
+                  &Job->AuthenticationStatus
+                  );
+  MemoryFence ();
+  Job->State = SectionPrefetchDone;
+}
+
+
+/**
+  Hand pending jobs to the APs that have finished their previous job.
+
+**/
+STATIC
+VOID
+CorePrefetchStartJobs (
+  VOID
+  )
+{
+  EFI_STATUS            Status;
+  UINTN                 Index;
+  LIST_ENTRY            *Link;
+  SECTION_PREFETCH_JOB  *Job;
+
+  Link = mPrefetchJobList.ForwardLink;
+  for (Index = 0; Index < mPrefetchApCount; Index++) {
+    if (mPrefetchAp[Index].Job != NULL) {
+      if (CoreCheckEvent (mPrefetchAp[Index].Event) != EFI_SUCCESS) {
+        continue;
+      }
+      mPrefetchAp[Index].Job = NULL;
+    }
+
+    //
+    // Find the next job nobody has started yet
+    //
+    Job = NULL;
+    for (; Link != &mPrefetchJobList; Link = Link->ForwardLink) {
+      Job = CR (Link, SECTION_PREFETCH_JOB, Link, SECTION_PREFETCH_JOB_SIGNATURE);
+      if (Job->State == SectionPrefetchPending) {
+        break;
+      }
+      Job = NULL;
+    }
+    if (Job == NULL) {
+      return;
+    }
+
+    Job->State = SectionPrefetchRunning;
+    Status = mPrefetchMpServices->StartupThisAP (
+                                    mPrefetchMpServices,
+                                    CorePrefetchDecode,
+                                    mPrefetchAp[Index].ProcessorNumber,
+                                    mPrefetchAp[Index].Event,
+                                    0,
+                                    Job,
+                                    NULL
+                                    );
+    if (EFI_ERROR (Status)) {
+      Job->State = SectionPrefetchPending;
+      continue;
+    }
+    mPrefetchAp[Index].Job = Job;
+    mPrefetchApDecodes++;
+  }
+}
+
+
+/**
+  Release all buffers of a job and remove it from the cache.
+
+  @param  Job             The job to free. It must not be running.
+  @param  KeepOutput      TRUE if the output buffer was handed to the caller.
+
+**/
+STATIC
+VOID
+CorePrefetchFreeJob (
+  IN SECTION_PREFETCH_JOB  *Job,
+  IN BOOLEAN               KeepOutput
+  )
+{
+  ASSERT (Job->State != SectionPrefetchRunning);
+
+  RemoveEntryList (&Job->Link);
+  mPrefetchJobCount--;
+  mPrefetchBytes -= Job->InputSize + Job->OutputSize + Job->ScratchSize;
+
+  if (!KeepOutput && Job->OutputBuffer != NULL) {
+    CoreFreePool (Job->OutputBuffer);
+  }
+  if (Job->ScratchBuffer != NULL) {
+    CoreFreePool (Job->ScratchBuffer);
+  }
+  CoreFreePool (Job->InputSection);
+  CoreFreePool (Job);
+}
+
+
+/**
+  Wait until a job has been decoded, decoding it on the BSP if no AP started it.
+
+  @param  Job             The job to complete.
+
+**/
+STATIC
+VOID
+CorePrefetchCompleteJob (
+  IN SECTION_PREFETCH_JOB  *Job
+  )
+{
+  if (Job->State == SectionPrefetchPending) {
+    Job->State = SectionPrefetchRunning;
+    CorePrefetchDecode (Job);
+    mPrefetchBspDecodes++;
+    return;
+  }
+
+  while (Job->State != SectionPrefetchDone) {
+    CpuPause ();
+  }
+}
+
+
+/**
+  Queue one GUIDed section for decoding.
+
+  @param  Section         The GUIDed section in the file buffer.
+  @param  SectionSize     The size of the section.
+
+  @retval EFI_SUCCESS           The section was queued.
+  @retval EFI_UNSUPPORTED       The section is not decoded by a decompressor
+                                that may run on an AP.
+  @retval EFI_OUT_OF_RESOURCES  The cache is full.
+
+**/
+STATIC
+EFI_STATUS
+CorePrefetchQueueSection (
+  IN CONST VOID  *Section,
+  IN UINT32      SectionSize
+  )
+{
+  EFI_STATUS            Status;
+  SECTION_PREFETCH_JOB  *Job;
+  UINT32                OutputSize;
+  UINT32                ScratchSize;
+  UINT16                SectionAttribute;
+  EFI_GUID              *SectionDefinitionGuid;
+  UINT16                GuidAttributes;
+  UINTN                 Index;
+
+  if (IS_SECTION2 (Section)) {
+    if (SectionSize < sizeof (EFI_GUID_DEFINED_SECTION2)) {
+      return EFI_UNSUPPORTED;
+    }
+    SectionDefinitionGuid = &((EFI_GUID_DEFINED_SECTION2 *) Section)->SectionDefinitionGuid;
+    GuidAttributes        = ((EFI_GUID_DEFINED_SECTION2 *) Section)->Attributes;
+  } else {
+    if (SectionSize < sizeof (EFI_GUID_DEFINED_SECTION)) {
+      return EFI_UNSUPPORTED;
+    }
+    SectionDefinitionGuid = &((EFI_GUID_DEFINED_SECTION *) Section)->SectionDefinitionGuid;
+    GuidAttributes        = ((EFI_GUID_DEFINED_SECTION *) Section)->Attributes;
+  }
+
+  //
+  // Look at the section header first, so that nothing is copied or
+  // asked of the handler for sections that are not prefetched.
+  //
+  if ((GuidAttributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) == 0) {
+    return EFI_UNSUPPORTED;
+  }
+  for (Index = 0; Index < ARRAY_SIZE (mPrefetchApSafeGuids); Index++) {
+    if (CompareGuid (SectionDefinitionGuid, mPrefetchApSafeGuids[Index])) {
+      break;
+    }
+  }
+  if (Index == ARRAY_SIZE (mPrefetchApSafeGuids)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = ExtractGuidedSectionGetInfo (Section, &OutputSize, &ScratchSize, &SectionAttribute);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+  if ((SectionAttribute & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (mPrefetchJobCount >= SECTION_PREFETCH_MAX_JOBS ||
+      (UINT64) mPrefetchBytes + SectionSize + OutputSize + ScratchSize > SECTION_PREFETCH_MAX_BYTES) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Job = AllocateZeroPool (sizeof (SECTION_PREFETCH_JOB));
+  if (Job == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+  Job->Signature    = SECTION_PREFETCH_JOB_SIGNATURE;
+  Job->InputSize    = SectionSize;
+  Job->OutputSize   = OutputSize;
+  Job->ScratchSize  = ScratchSize;
+  Job->InputSection = AllocateCopyPool (SectionSize, Section);
+  if (OutputSize > 0) {
+    Job->OutputBuffer = AllocatePool (OutputSize);
+  }
+  if (ScratchSize > 0) {
+    Job->ScratchBuffer = AllocatePool (ScratchSize);
+  }
+  if (Job->InputSection == NULL ||
+      (OutputSize > 0 && Job->OutputBuffer == NULL) ||
+      (ScratchSize > 0 && Job->ScratchBuffer == NULL)) {
+    if (Job->InputSection != NULL) {
+      CoreFreePool (Job->InputSection);
+    }
+    if (Job->OutputBuffer != NULL) {
+      CoreFreePool (Job->OutputBuffer);
+    }
+    if (Job->ScratchBuffer != NULL) {
+      CoreFreePool (Job->ScratchBuffer);
+    }
+    CoreFreePool (Job);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Job->State = SectionPrefetchPending;
+  InsertTailList (&mPrefetchJobList, &Job->Link);
+  mPrefetchJobCount++;
+  mPrefetchBytes += SectionSize + OutputSize + ScratchSize;
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Queue the GUIDed sections of an FFS file for decoding on the APs.
+
+  Nothing is queued if the MP Services protocol is not available yet. The file
+  is scanned in place, so files without a section to prefetch cost no copy, and
+  files of firmware volumes not produced by the DXE Core are skipped.
+
+  @param  Fv              The firmware volume that contains the file.
+  @param  FileName        The name of the file.
+
+  @retval EFI_SUCCESS           The sections of the file were queued, or the
+                                file has nothing to prefetch.
+  @retval EFI_NOT_READY         There is no AP to decode sections on.
+  @retval EFI_OUT_OF_RESOURCES  The cache is full; retry on a later call.
+
+**/
+EFI_STATUS
+CorePrefetchFileSections (
+  IN EFI_FIRMWARE_VOLUME2_PROTOCOL  *Fv,
+  IN EFI_GUID                       *FileName
+  )
+{
+  EFI_STATUS                  Status;
+  CONST VOID                  *FileBuffer;
+  UINTN                       FileSize;
+  EFI_COMMON_SECTION_HEADER   *Section;
+  UINT32                      SectionSize;
+  UINTN                       Offset;
+
+  if (!FeaturePcdGet (PcdDxeCoreParallelDecompressEnable)) {
+    return EFI_NOT_READY;
+  }
+  if (!CorePrefetchInitializeAps ()) {
+    return EFI_NOT_READY;
+  }
+
+  Status = CoreFvGetFileInPlace (Fv, FileName, &FileBuffer, &FileSize);
+  if (EFI_ERROR (Status)) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Only the top level GUIDed sections are prefetched, nested encapsulations
+  // are processed by the section extraction code when the image is loaded.
+  //
+  Status = EFI_SUCCESS;
+  Offset = 0;
+  while (Offset + sizeof (EFI_COMMON_SECTION_HEADER) <= FileSize) {
+    Section = (EFI_COMMON_SECTION_HEADER *) ((UINT8 *) FileBuffer + Offset);
+    if (IS_SECTION2 (Section)) {
+      SectionSize = SECTION2_SIZE (Section);
+    } else {
+      SectionSize = SECTION_SIZE (Section);
+    }
+    if (SectionSize < sizeof (EFI_COMMON_SECTION_HEADER) || SectionSize > FileSize - Offset) {
+      break;
+    }
+
+    if (Section->Type == EFI_SECTION_GUID_DEFINED) {
+      Status = CorePrefetchQueueSection (Section, SectionSize);
+      if (Status == EFI_OUT_OF_RESOURCES) {
+        break;
+      }
+      Status = EFI_SUCCESS;
+    }
+
+    Offset += ALIGN_VALUE (SectionSize, 4);
+  }
+
+  CorePrefetchStartJobs ();
+
+  return Status;
+}
+
+
+/**
+  Take the decoded data of a GUIDed section out of the prefetch cache.
+
+  @param  InputSection          The GUIDed section to extract.
+  @param  OutputBuffer          Returns the pool buffer with the section contents.
+                                The caller owns the buffer.
+  @param  OutputSize            Returns the size of OutputBuffer.
+  @param  AuthenticationStatus  Returns the authentication status of the decode.
+
+  @retval EFI_SUCCESS           The section was found in the cache.
+  @retval EFI_NOT_FOUND         The section was not prefetched, or decoding it failed.
+
+**/
+EFI_STATUS
+CoreGetPrefetchedSection (
+  IN  CONST VOID  *InputSection,
+  OUT VOID        **OutputBuffer,
+  OUT UINTN       *OutputSize,
+  OUT UINT32      *AuthenticationStatus
+  )
+{
+  LIST_ENTRY                 *Link;
+  SECTION_PREFETCH_JOB       *Job;
+  EFI_COMMON_SECTION_HEADER  *Section;
+  UINT32                     SectionSize;
+
+  if (IsListEmpty (&mPrefetchJobList)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Section = (EFI_COMMON_SECTION_HEADER *) InputSection;
+  if (IS_SECTION2 (Section)) {
+    SectionSize = SECTION2_SIZE (Section);
+  } else {
+    SectionSize = SECTION_SIZE (Section);
+  }
+
+  for (Link = mPrefetchJobList.ForwardLink; Link != &mPrefetchJobList; Link = Link->ForwardLink) {
+    Job = CR (Link, SECTION_PREFETCH_JOB, Link, SECTION_PREFETCH_JOB_SIGNATURE);
+    if (Job->InputSize == SectionSize && CompareMem (Job->InputSection, InputSection, SectionSize) == 0) {
+      break;
+    }
+  }
+  if (Link == &mPrefetchJobList) {
+    return EFI_NOT_FOUND;
+  }
+
+  CorePrefetchCompleteJob (Job);
+
+  if (EFI_ERROR (Job->Status) || Job->OutputBuffer == NULL) {
+    //
+    // Let the caller decode the section again so the error is reported there
+    //
+    CorePrefetchFreeJob (Job, FALSE);
+    mPrefetchDiscards++;
+    CorePrefetchStartJobs ();
+    return EFI_NOT_FOUND;
+  }
+
+  if (Job->DecodedBuffer != Job->OutputBuffer) {
+    CopyMem (Job->OutputBuffer, Job->DecodedBuffer, Job->OutputSize);
+  }
+  *OutputBuffer         = Job->OutputBuffer;
+  *OutputSize           = Job->OutputSize;
+  *AuthenticationStatus = Job->AuthenticationStatus;
+
+  CorePrefetchFreeJob (Job, TRUE);
+  mPrefetchHits++;
+
+  CorePrefetchStartJobs ();
+
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Wait for all outstanding decodes and drop the sections nobody asked for.
+
+**/
+VOID
+CoreFlushSectionPrefetch (
+  VOID
+  )
+{
+  SECTION_PREFETCH_JOB  *Job;
+  UINTN                 Index;
+
+  while (!IsListEmpty (&mPrefetchJobList)) {
+    Job = CR (mPrefetchJobList.ForwardLink, SECTION_PREFETCH_JOB, Link, SECTION_PREFETCH_JOB_SIGNATURE);
+    if (Job->State == SectionPrefetchPending) {
+      //
+      // Not started, there is no need to decode it
+      //
+      Job->State = SectionPrefetchDone;
+    }
+    CorePrefetchCompleteJob (Job);
+    CorePrefetchFreeJob (Job, FALSE);
+    mPrefetchDiscards++;
+  }
+
+  //
+  // Wait for the APs to become idle so the next round can start them again
+  //
+  for (Index = 0; Index < mPrefetchApCount; Index++) {
+    if (mPrefetchAp[Index].Job != NULL) {
+      while (CoreCheckEvent (mPrefetchAp[Index].Event) != EFI_SUCCESS) {
+        CpuPause ();
+      }
+      mPrefetchAp[Index].Job = NULL;
+    }
+  }
+
+  if (mPrefetchApDecodes + mPrefetchBspDecodes != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "Section prefetch: %d decoded on APs, %d on BSP, %d hits, %d discarded\n",
+      mPrefetchApDecodes,
+      mPrefetchBspDecodes,
+      mPrefetchHits,
+      mPrefetchDiscards
+      ));
+  }
+}
@@ -0,0 +1,373 @@
+/** @file
+  Unit tests of the index of the UEFI memory map, Mem/MemoryMapIndex.c
+
+  The index is driven with random inserts, removals, clips and replacements of
+  descriptors. After each step, CoreMemoryMapIndexLookup() and
+  CoreMemoryMapIndexFindFree() are compared with a scan of all descriptors.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "Imem.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DXE Core Memory Map Index Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Each descriptor of the test lives in its own slot of the address space, so
+// descriptors never overlap and clipping never changes their order.
+//
+#define TEST_SLOT_COUNT           512
+#define TEST_SLOT_SIZE            SIZE_64KB
+#define TEST_STEP_COUNT           20000
+#define TEST_QUERY_COUNT          8
+
+//
+// State of the stubs
+//
+EFI_LOCK      gMemoryLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+
+//
+// Two descriptors for each slot, so that a descriptor can be replaced by a
+// copy as CoreFreeMemoryMapStack() does.
+//
+STATIC MEMORY_MAP   mEntries[2][TEST_SLOT_COUNT];
+STATIC MEMORY_MAP   *mSlot[TEST_SLOT_COUNT];
+STATIC UINT32       mRandomState;
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Return a random address within the slots of the test, or just above them.
+
+  @return A random address.
+
+**/
+STATIC
+UINT64
+TestRandomAddress (
+  VOID
+  )
+{
+  return MultU64x32 (TestRandom () % (TEST_SLOT_COUNT + 1), TEST_SLOT_SIZE) +
+         MultU64x32 (TestRandom () % (TEST_SLOT_SIZE / EFI_PAGE_SIZE), EFI_PAGE_SIZE);
+}
+
+/**
+  Find the indexed descriptor with the highest start address that is not above
+  Address by scanning all the slots.
+
+  @param  Address               The address to look up.
+
+  @return The descriptor found, or NULL.
+
+**/
+STATIC
+MEMORY_MAP *
+TestReferenceLookup (
+  IN UINT64             Address
+  )
+{
+  MEMORY_MAP  *Found;
+  UINTN       Index;
+
+  Found = NULL;
+  for (Index = 0; Index < TEST_SLOT_COUNT; Index++) {
+    if ((mSlot[Index] != NULL) && (mSlot[Index]->Start <= Address)) {
+      Found = mSlot[Index];
+    }
+  }
+  return Found;
+}
+
+/**
+  Find the free descriptor with the highest start address below Limit that is
+  at least Length bytes long by scanning all the slots.
+
+  @param  Limit                 The start address must be below this address.
+  @param  Length                The minimum size of the descriptor in bytes.
+
+  @return The descriptor found, or NULL.
+
+**/
+STATIC
+MEMORY_MAP *
+TestReferenceFindFree (
+  IN UINT64             Limit,
+  IN UINT64             Length
+  )
+{
+  MEMORY_MAP  *Found;
+  UINTN       Index;
+
+  Found = NULL;
+  for (Index = 0; Index < TEST_SLOT_COUNT; Index++) {
+    if ((mSlot[Index] != NULL) &&
+        (mSlot[Index]->Type == EfiConventionalMemory) &&
+        (mSlot[Index]->Start < Limit) &&
+        (mSlot[Index]->End - mSlot[Index]->Start + 1 >= Length)) {
+      Found = mSlot[Index];
+    }
+  }
+  return Found;
+}
+
+/**
+  Fill the descriptor of a slot with a random range and type.
+
+  @param  Entry                 The descriptor to fill.
+  @param  Index                 The slot of the descriptor.
+
+**/
+STATIC
+VOID
+TestFillEntry (
+  OUT MEMORY_MAP        *Entry,
+  IN  UINTN             Index
+  )
+{
+  UINTN  Pages;
+
+  ZeroMem (Entry, sizeof (*Entry));
+  Pages        = 1 + TestRandom () % (TEST_SLOT_SIZE / EFI_PAGE_SIZE);
+  Entry->Start = MultU64x32 (Index, TEST_SLOT_SIZE);
+  Entry->End   = Entry->Start + EFI_PAGES_TO_SIZE (Pages) - 1;
+  Entry->Type  = ((TestRandom () % 3) != 0) ? EfiConventionalMemory : EfiBootServicesData;
+}
+
+/**
+  Insert, remove, clip and replace random descriptors, and check after each
+  step that lookups and free range searches agree with a scan of all the
+  descriptors.
+
+  @param[in]  Context           Unused.
+
+  @retval UNIT_TEST_PASSED      The index always agreed with the scan.
+  @retval UNIT_TEST_ERROR_TEST_FAILED The index returned another descriptor.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IndexShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MEMORY_MAP  *Entry;
+  MEMORY_MAP  *Copy;
+  UINTN       Step;
+  UINTN       Index;
+  UINTN       Query;
+  UINT64      Address;
+  UINT64      Length;
+
+  mRandomState = 1;
+  ZeroMem (mSlot, sizeof (mSlot));
+
+  for (Step = 0; Step < TEST_STEP_COUNT; Step++) {
+    Index = TestRandom () % TEST_SLOT_COUNT;
+    Entry = mSlot[Index];
+
+    if (Entry == NULL) {
+      Entry = &mEntries[0][Index];
+      TestFillEntry (Entry, Index);
+      CoreMemoryMapIndexInsert (Entry);
+      mSlot[Index] = Entry;
+    } else {
+      switch (TestRandom () % 4) {
+      case 0:
+        CoreMemoryMapIndexRemove (Entry);
+        mSlot[Index] = NULL;
+        break;
+
+      case 1:
+        //
+        // Clip the start or the end of the range, as CoreAddRange() and
+        // CoreConvertPagesEx() do
+        //
+        if (Entry->End > Entry->Start + EFI_PAGE_SIZE) {
+          if ((TestRandom () & 1) != 0) {
+            Entry->Start += EFI_PAGE_SIZE;
+          } else {
+            Entry->End -= EFI_PAGE_SIZE;
+          }
+          CoreMemoryMapIndexUpdate (Entry);
+        }
+        break;
+
+      case 2:
+        Copy = (Entry == &mEntries[0][Index]) ? &mEntries[1][Index] : &mEntries[0][Index];
+        CopyMem (Copy, Entry, sizeof (*Copy));
+        CoreMemoryMapIndexReplace (Entry, Copy);
+        SetMem (Entry, sizeof (*Entry), 0xAF);
+        mSlot[Index] = Copy;
+        break;
+
+      default:
+        //
+        // Change the type, as when a whole free descriptor is allocated
+        //
+        Entry->Type = (Entry->Type == EfiConventionalMemory) ? EfiBootServicesData : EfiConventionalMemory;
+        CoreMemoryMapIndexUpdate (Entry);
+        break;
+      }
+    }
+
+    for (Query = 0; Query < TEST_QUERY_COUNT; Query++) {
+      Address = TestRandomAddress ();
+      UT_ASSERT_EQUAL ((UINTN) CoreMemoryMapIndexLookup (Address), (UINTN) TestReferenceLookup (Address));
+
+      Length = EFI_PAGES_TO_SIZE (1 + TestRandom () % (TEST_SLOT_SIZE / EFI_PAGE_SIZE));
+      UT_ASSERT_EQUAL (
+        (UINTN) CoreMemoryMapIndexFindFree (Address, Length),
+        (UINTN) TestReferenceFindFree (Address, Length)
+        );
+    }
+  }
+
+  for (Index = 0; Index < TEST_SLOT_COUNT; Index++) {
+    if (mSlot[Index] != NULL) {
+      CoreMemoryMapIndexRemove (mSlot[Index]);
+      mSlot[Index] = NULL;
+    }
+  }
+
+  UT_ASSERT_TRUE (CoreMemoryMapIndexLookup (MAX_UINT64) == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that the free range search returns the highest fitting descriptor
+  below the limit, and skips descriptors that are too small or not free.
+
+  @param[in]  Context           Unused.
+
+  @retval UNIT_TEST_PASSED      The expected descriptors were returned.
+  @retval UNIT_TEST_ERROR_TEST_FAILED Another descriptor was returned.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FindFreeShouldReturnHighestFit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  //
+  // Slot 0: 16 free pages, slot 1: 4 free pages, slot 2: 16 allocated pages,
+  // slot 3: 8 free pages
+  //
+  for (Index = 0; Index < 4; Index++) {
+    ZeroMem (&mEntries[0][Index], sizeof (MEMORY_MAP));
+    mEntries[0][Index].Start = MultU64x32 (Index, TEST_SLOT_SIZE);
+    mEntries[0][Index].Type  = (Index == 2) ? EfiBootServicesData : EfiConventionalMemory;
+  }
+  mEntries[0][0].End = mEntries[0][0].Start + EFI_PAGES_TO_SIZE (16) - 1;
+  mEntries[0][1].End = mEntries[0][1].Start + EFI_PAGES_TO_SIZE (4) - 1;
+  mEntries[0][2].End = mEntries[0][2].Start + EFI_PAGES_TO_SIZE (16) - 1;
+  mEntries[0][3].End = mEntries[0][3].Start + EFI_PAGES_TO_SIZE (8) - 1;
+
+  for (Index = 0; Index < 4; Index++) {
+    CoreMemoryMapIndexInsert (&mEntries[0][Index]);
+  }
+
+  UT_ASSERT_TRUE (CoreMemoryMapIndexFindFree (MAX_UINT64, EFI_PAGES_TO_SIZE (1)) == &mEntries[0][3]);
+  UT_ASSERT_TRUE (CoreMemoryMapIndexFindFree (MAX_UINT64, EFI_PAGES_TO_SIZE (9)) == &mEntries[0][0]);
+  UT_ASSERT_TRUE (CoreMemoryMapIndexFindFree (mEntries[0][3].Start, EFI_PAGES_TO_SIZE (1)) == &mEntries[0][1]);
+  UT_ASSERT_TRUE (CoreMemoryMapIndexFindFree (mEntries[0][1].Start, EFI_PAGES_TO_SIZE (1)) == &mEntries[0][0]);
+  UT_ASSERT_TRUE (CoreMemoryMapIndexFindFree (MAX_UINT64, EFI_PAGES_TO_SIZE (17)) == NULL);
+  UT_ASSERT_TRUE (CoreMemoryMapIndexFindFree (0, EFI_PAGES_TO_SIZE (1)) == NULL);
+
+  UT_ASSERT_TRUE (CoreMemoryMapIndexLookup (mEntries[0][2].End) == &mEntries[0][2]);
+  UT_ASSERT_TRUE (CoreMemoryMapIndexLookup (mEntries[0][3].Start - 1) == &mEntries[0][2]);
+
+  for (Index = 0; Index < 4; Index++) {
+    CoreMemoryMapIndexRemove (&mEntries[0][Index]);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the memory
+  map index and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "DXE Core Memory Map Index Tests", "DxeCore.MemoryMap.Index", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Index should match a scan of the descriptors", "Random", IndexShouldMatchReference, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Free range search should return the highest fit", "FindFree", FindFreeShouldReturnHighestFit, NULL, NULL, NULL);
+
+  //
+  // The index is only used with the memory map lock held
+  //
+  gMemoryLock.Lock = EfiLockAcquired;
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
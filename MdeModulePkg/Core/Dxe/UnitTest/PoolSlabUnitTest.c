@@ -0,0 +1,755 @@
+/** @file
+  Unit tests of the slab allocator of the DXE Core pool, Mem/Pool.c
+
+  Pool.c is linked with stubs of the page allocator, the heap guard, the memory
+  profile and the locks of the DXE Core. The page allocator stub counts the
+  pages in use, so the tests can check when slabs are taken from and given back
+  to free memory.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "DxeMain.h"
+#include "Imem.h"
+#include "HeapGuard.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "DXE Core Pool Slab Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_MEMORY_TYPE          EfiBootServicesData
+#define TEST_ALLOCATION_COUNT     2000
+#define TEST_ROUND_COUNT          8
+
+//
+// Layout of the slabs, as defined in Pool.c
+//
+#define TEST_SLAB_SIGNATURE       SIGNATURE_32('p','s','l','b')
+#define TEST_SLAB_HEAD_SIZE       8
+
+STATIC CONST UINT16  mTestSlabSizeTable[] = {
+  32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+#define TEST_MAX_SLAB_OBJECT_SIZE \
+  (mTestSlabSizeTable[ARRAY_SIZE (mTestSlabSizeTable) - 1] - TEST_SLAB_HEAD_SIZE)
+
+//
+// State of the stubs
+//
+EFI_LOCK      gMemoryLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+BOOLEAN       mOnGuarding = FALSE;
+STATIC UINTN  mPagesInUse;
+
+STATIC VOID   *mBuffer[TEST_ALLOCATION_COUNT];
+STATIC UINTN  mSize[TEST_ALLOCATION_COUNT];
+STATIC UINT32 mRandomState;
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Check whether a pool buffer was allocated from a slab.
+
+  @param  Buffer                The pool buffer.
+
+  @retval TRUE                  The page of Buffer starts with a slab header.
+  @retval FALSE                 Buffer was allocated from the pool free lists.
+
+**/
+STATIC
+BOOLEAN
+TestIsSlabEntry (
+  IN VOID               *Buffer
+  )
+{
+  return (BOOLEAN) (*(UINT32 *) ((UINTN) Buffer & ~(UINTN) EFI_PAGE_MASK) == TEST_SLAB_SIGNATURE);
+}
+
+/**
+  Allocate a test buffer of the test memory type.
+
+  @param  Size                  The size of the buffer.
+
+  @return The buffer, or NULL if it could not be allocated.
+
+**/
+STATIC
+VOID *
+TestAllocate (
+  IN UINTN              Size
+  )
+{
+  VOID        *Buffer;
+
+  if (EFI_ERROR (CoreAllocatePool (TEST_MEMORY_TYPE, Size, &Buffer))) {
+    return NULL;
+  }
+  return Buffer;
+}
+
+/**
+  Count the entries of a slab of the largest size class, by allocating
+  entries until one is served from another page. All the entries are freed.
+
+  @param  Count                 Output the number of entries per slab.
+
+  @retval UNIT_TEST_PASSED      The entries were counted.
+  @retval UNIT_TEST_ERROR_TEST_FAILED The entries could not be counted.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+TestCountSlabEntries (
+  OUT UINTN             *Count
+  )
+{
+  UINTN       Index;
+
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    mBuffer[Index] = TestAllocate (TEST_MAX_SLAB_OBJECT_SIZE);
+    UT_ASSERT_NOT_NULL (mBuffer[Index]);
+    if (((UINTN) mBuffer[Index] & ~(UINTN) EFI_PAGE_MASK) !=
+        ((UINTN) mBuffer[0] & ~(UINTN) EFI_PAGE_MASK)) {
+      break;
+    }
+  }
+  UT_ASSERT_TRUE (Index > 1 && Index < TEST_ALLOCATION_COUNT);
+
+  *Count = Index;
+  for (; Index != MAX_UINTN; Index--) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[Index]));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that requests are served from the smallest size class they fit in,
+  and that requests larger than the largest size class use the free lists.
+
+  @param[in]  Context           Unused.
+
+  @retval UNIT_TEST_PASSED      The size classes are as expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED A request used the wrong size class.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SizeClassBoundariesShouldBeExact (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN       Class;
+  UINTN       Size;
+  UINTN       Stride;
+  VOID        *First;
+  VOID        *Second;
+
+  for (Class = 0; Class < ARRAY_SIZE (mTestSlabSizeTable); Class++) {
+    //
+    // The largest request of the class, then the smallest request of the
+    // next class. Two entries allocated in a row are adjacent in the slab.
+    //
+    for (Size = mTestSlabSizeTable[Class] - TEST_SLAB_HEAD_SIZE;
+         Size <= mTestSlabSizeTable[Class] - TEST_SLAB_HEAD_SIZE + 1;
+         Size++) {
+      First  = TestAllocate (Size);
+      Second = TestAllocate (Size);
+      UT_ASSERT_NOT_NULL (First);
+      UT_ASSERT_NOT_NULL (Second);
+
+      if (Size <= TEST_MAX_SLAB_OBJECT_SIZE) {
+        Stride = (Size == mTestSlabSizeTable[Class] - TEST_SLAB_HEAD_SIZE) ?
+                 mTestSlabSizeTable[Class] :
+                 mTestSlabSizeTable[Class + 1];
+        UT_ASSERT_TRUE (TestIsSlabEntry (First));
+        UT_ASSERT_TRUE (TestIsSlabEntry (Second));
+        UT_ASSERT_EQUAL ((UINTN) Second - (UINTN) First, Stride);
+      } else {
+        UT_ASSERT_FALSE (TestIsSlabEntry (First));
+        UT_ASSERT_FALSE (TestIsSlabEntry (Second));
+      }
+
+      UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (Second));
+      UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (First));
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Allocate and free buffers of random sizes in random order, and check that
+  the buffers do not overlap and that the slabs are given back.
+
+  @param[in]  Context           Unused.
+
+  @retval UNIT_TEST_PASSED      All the buffers kept their contents, and the
+                                slabs were given back.
+  @retval UNIT_TEST_ERROR_TEST_FAILED A buffer was overwritten, or pages were
+                                leaked.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomAllocationsShouldNotOverlap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN       PagesInUse;
+  UINTN       Round;
+  UINTN       Index;
+  UINTN       Offset;
+
+  mRandomState = 1;
+  PagesInUse   = mPagesInUse;
+  ZeroMem (mBuffer, sizeof (mBuffer));
+
+  for (Round = 0; Round < TEST_ROUND_COUNT; Round++) {
+    //
+    // Replace about half of the buffers, so that slabs fill and empty in
+    // every order
+    //
+    for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+      if (mBuffer[Index] != NULL) {
+        if ((TestRandom () & 1) == 0) {
+          continue;
+        }
+        UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[Index]));
+      }
+
+      mSize[Index]   = 1 + TestRandom () % TEST_MAX_SLAB_OBJECT_SIZE;
+      mBuffer[Index] = TestAllocate (mSize[Index]);
+      UT_ASSERT_NOT_NULL (mBuffer[Index]);
+      UT_ASSERT_TRUE (TestIsSlabEntry (mBuffer[Index]));
+      SetMem (mBuffer[Index], mSize[Index], (UINT8) Index);
+    }
+
+    for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+      for (Offset = 0; Offset < mSize[Index]; Offset++) {
+        UT_ASSERT_EQUAL (((UINT8 *) mBuffer[Index])[Offset], (UINT8) Index);
+      }
+    }
+  }
+
+  for (Index = 0; Index < TEST_ALLOCATION_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[Index]));
+  }
+
+  //
+  // At most one empty slab is kept for each size class
+  //
+  UT_ASSERT_TRUE (mPagesInUse <= PagesInUse + ARRAY_SIZE (mTestSlabSizeTable));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that a slab left empty by a free is given back to free memory,
+  unless it is the only slab of its size class with free entries.
+
+  @param[in]  Context           Unused.
+
+  @retval UNIT_TEST_PASSED      The empty slabs were given back or kept as
+                                expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED A slab was leaked, or given back too
+                                early.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EmptySlabShouldBeReleased (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             Count;
+  UINTN             PagesInUse;
+  UINTN             Index;
+
+  Status = TestCountSlabEntries (&Count);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // The slab of the class is kept after TestCountSlabEntries(). Fill it and
+  // a second one.
+  //
+  PagesInUse = mPagesInUse;
+  for (Index = 0; Index < 2 * Count; Index++) {
+    mBuffer[Index] = TestAllocate (TEST_MAX_SLAB_OBJECT_SIZE);
+    UT_ASSERT_NOT_NULL (mBuffer[Index]);
+  }
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse + 1);
+
+  //
+  // With an entry of the second slab free, emptying the first slab gives it
+  // back
+  //
+  UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[2 * Count - 1]));
+  for (Index = 0; Index < Count; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[Index]));
+  }
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse);
+
+  //
+  // The last slab of the class is kept when it becomes empty, and reused
+  //
+  for (Index = Count; Index < 2 * Count - 1; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[Index]));
+  }
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse);
+
+  for (Index = 0; Index < Count; Index++) {
+    mBuffer[Index] = TestAllocate (TEST_MAX_SLAB_OBJECT_SIZE);
+    UT_ASSERT_NOT_NULL (mBuffer[Index]);
+  }
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse);
+
+  mBuffer[Count] = TestAllocate (TEST_MAX_SLAB_OBJECT_SIZE);
+  UT_ASSERT_NOT_NULL (mBuffer[Count]);
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse + 1);
+
+  for (Index = 0; Index <= Count; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (CoreFreePool (mBuffer[Index]));
+  }
+  UT_ASSERT_EQUAL (mPagesInUse, PagesInUse);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Check that the pool type of a slab entry is returned when it is freed.
+
+  @param[in]  Context           Unused.
+
+  @retval UNIT_TEST_PASSED      The pool type was returned.
+  @retval UNIT_TEST_ERROR_TEST_FAILED The pool type was wrong.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FreeShouldReturnPoolType (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID            *Buffer;
+  EFI_MEMORY_TYPE PoolType;
+
+  UT_ASSERT_NOT_EFI_ERROR (CoreInternalAllocatePool (EfiRuntimeServicesData, 100, &Buffer));
+  UT_ASSERT_TRUE (TestIsSlabEntry (Buffer));
+
+  PoolType = EfiMaxMemoryType;
+  UT_ASSERT_NOT_EFI_ERROR (CoreInternalFreePool (Buffer, &PoolType));
+  UT_ASSERT_EQUAL (PoolType, EfiRuntimeServicesData);
+
+  return UNIT_TEST_PASSED;
+}
+
+//
+// Stubs of the DXE Core services used by Pool.c
+//
+
+/**
+  Stub of the DXE Core lock, the tests are single threaded.
+
+  @param  Lock                  The lock to acquire.
+
+**/
+VOID
+CoreAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  Lock->Lock = EfiLockAcquired;
+}
+
+/**
+  Stub of the DXE Core lock, the tests are single threaded.
+
+  @param  Lock                  The lock to acquire.
+
+  @retval EFI_SUCCESS           The lock was acquired.
+
+**/
+EFI_STATUS
+CoreAcquireLockOrFail (
+  IN EFI_LOCK  *Lock
+  )
+{
+  Lock->Lock = EfiLockAcquired;
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the DXE Core lock, the tests are single threaded.
+
+  @param  Lock                  The lock to release.
+
+**/
+VOID
+CoreReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+  Lock->Lock = EfiLockReleased;
+}
+
+/**
+  Stub of the memory map lock.
+
+**/
+VOID
+CoreAcquireMemoryLock (
+  VOID
+  )
+{
+  CoreAcquireLock (&gMemoryLock);
+}
+
+/**
+  Stub of the memory map lock.
+
+**/
+VOID
+CoreReleaseMemoryLock (
+  VOID
+  )
+{
+  CoreReleaseLock (&gMemoryLock);
+}
+
+/**
+  Stub of the page allocator of the pool, counting the pages in use.
+
+  @param  PoolType              The type of memory for the new pool pages.
+  @param  NumberOfPages         No of pages to allocate.
+  @param  Alignment             Bits to align.
+  @param  NeedGuard             Unused, the heap guard is disabled.
+
+  @return The allocated memory, or NULL.
+
+**/
+VOID *
+CoreAllocatePoolPages (
+  IN EFI_MEMORY_TYPE    PoolType,
+  IN UINTN              NumberOfPages,
+  IN UINTN              Alignment,
+  IN BOOLEAN            NeedGuard
+  )
+{
+  VOID        *Buffer;
+
+  Buffer = AllocateAlignedPages (NumberOfPages, Alignment);
+  if (Buffer != NULL) {
+    mPagesInUse += NumberOfPages;
+  }
+  return Buffer;
+}
+
+/**
+  Stub of the page allocator of the pool, counting the pages in use.
+
+  @param  Memory                The base address to free.
+  @param  NumberOfPages         The number of pages to free.
+
+**/
+VOID
+CoreFreePoolPages (
+  IN EFI_PHYSICAL_ADDRESS   Memory,
+  IN UINTN                  NumberOfPages
+  )
+{
+  FreeAlignedPages ((VOID *) (UINTN) Memory, NumberOfPages);
+  mPagesInUse -= NumberOfPages;
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  MemoryType            The memory type to check.
+
+  @retval FALSE                 The memory type is not guarded.
+
+**/
+BOOLEAN
+IsPoolTypeToGuard (
+  IN EFI_MEMORY_TYPE        MemoryType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  GuardType             The guard type to check.
+
+  @retval FALSE                 The heap guard is disabled.
+
+**/
+BOOLEAN
+IsHeapGuardEnabled (
+  UINT8           GuardType
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  Address               The address to check.
+
+  @retval FALSE                 The page is not guarded.
+
+**/
+BOOLEAN
+EFIAPI
+IsMemoryGuarded (
+  IN EFI_PHYSICAL_ADDRESS    Address
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  Memory                Base address of memory to set guard for.
+  @param  NumberOfPages         Memory size in pages.
+
+**/
+VOID
+SetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS   Memory,
+  IN UINTN                  NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  Memory                Base address of memory to unset guard for.
+  @param  NumberOfPages         Memory size in pages.
+
+**/
+VOID
+UnsetGuardForMemory (
+  IN EFI_PHYSICAL_ADDRESS   Memory,
+  IN UINTN                  NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  Memory                Base address of memory to free.
+  @param  NumberOfPages         Size of memory to free.
+
+**/
+VOID
+AdjustMemoryF (
+  IN OUT EFI_PHYSICAL_ADDRESS    *Memory,
+  IN OUT UINTN                   *NumberOfPages
+  )
+{
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  Memory                Base address of memory allocated.
+  @param  NoPages               Number of pages actually allocated.
+  @param  Size                  Size of memory requested.
+
+  @return Memory.
+
+**/
+VOID *
+AdjustPoolHeadA (
+  IN EFI_PHYSICAL_ADDRESS    Memory,
+  IN UINTN                   NoPages,
+  IN UINTN                   Size
+  )
+{
+  return (VOID *) (UINTN) Memory;
+}
+
+/**
+  Stub of the heap guard, which is disabled.
+
+  @param  Memory                Base address of memory to free.
+
+  @return Memory.
+
+**/
+VOID *
+AdjustPoolHeadF (
+  IN EFI_PHYSICAL_ADDRESS    Memory
+  )
+{
+  return (VOID *) (UINTN) Memory;
+}
+
+/**
+  Stub of the freed-memory guard, which is disabled.
+
+  @param  BaseAddress           Base address of the freed pages.
+  @param  Pages                 Number of freed pages.
+
+**/
+VOID
+EFIAPI
+GuardFreedPagesChecked (
+  IN  EFI_PHYSICAL_ADDRESS    BaseAddress,
+  IN  UINTN                   Pages
+  )
+{
+}
+
+/**
+  Stub of the memory protection policy, which is not applied.
+
+  @param  OldType               The old memory type.
+  @param  NewType               The new memory type.
+  @param  Memory                The base address of the memory.
+  @param  Length                The size of the memory.
+
+  @retval EFI_SUCCESS           The policy was applied.
+
+**/
+EFI_STATUS
+EFIAPI
+ApplyMemoryProtectionPolicy (
+  IN  EFI_MEMORY_TYPE       OldType,
+  IN  EFI_MEMORY_TYPE       NewType,
+  IN  EFI_PHYSICAL_ADDRESS  Memory,
+  IN  UINT64                Length
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the memory profile, which is disabled.
+
+  @param  CallerAddress         Address of caller who call Allocate or Free.
+  @param  Action                This Allocate or Free action.
+  @param  MemoryType            Memory type.
+  @param  Size                  Buffer size.
+  @param  Buffer                Buffer address.
+  @param  ActionString          String for memory profile action.
+
+  @retval EFI_UNSUPPORTED       The memory profile is disabled.
+
+**/
+EFI_STATUS
+EFIAPI
+CoreUpdateProfile (
+  IN EFI_PHYSICAL_ADDRESS   CallerAddress,
+  IN MEMORY_PROFILE_ACTION  Action,
+  IN EFI_MEMORY_TYPE        MemoryType,
+  IN UINTN                  Size,
+  IN VOID                   *Buffer,
+  IN CHAR8                  *ActionString OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Stub of the memory attributes table, which is not installed.
+
+  @param  MemoryType            The type of memory allocated or freed.
+
+**/
+VOID
+InstallMemoryAttributesTableOnMemoryAllocation (
+  IN EFI_MEMORY_TYPE    MemoryType
+  )
+{
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the slab
+  allocator of the pool and run them.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SlabTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SlabTests, Framework, "DXE Core Pool Slab Tests", "DxeCore.Pool.Slab", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SlabTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (SlabTests, "Size class boundaries should be exact", "Class", SizeClassBoundariesShouldBeExact, NULL, NULL, NULL);
+  AddTestCase (SlabTests, "Random allocations should not overlap", "Random", RandomAllocationsShouldNotOverlap, NULL, NULL, NULL);
+  AddTestCase (SlabTests, "Empty slab should be released", "Empty", EmptySlabShouldBeReleased, NULL, NULL, NULL);
+  AddTestCase (SlabTests, "Free should return the pool type", "Type", FreeShouldReturnPoolType, NULL, NULL, NULL);
+
+  CoreInitializePool ();
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -749,6 +749,82 @@ VerifyGuidedSectionGuid (
   return FALSE;
 }
 
+/**
+  Publish a decoded GUIDed section in a HOB, so the DXE Core does not decode it again.
+
+  Only sections decoded into permanent memory are published, as the data must
+  still be there when the DXE Core looks for it, and only sections of files the
+  DXE Core reads again. A copy of the section is kept with the data, so the DXE
+  Core can confirm a match byte for byte.
+
+  @param PrivateData           The PEI Core private data.
+  @param FileHeader            The header of the file that holds the section.
+  @param Section               The GUIDed section that was decoded.
+  @param SectionDefinitionGuid The definition GUID of the section.
+  @param OutputBuffer          The decoded section data.
+  @param OutputSize            The size of the decoded section data.
+  @param AuthenticationStatus  The authentication status returned by the decode.
+
+**/
+STATIC
+VOID
+PublishDecompressedSection (
+  IN PEI_CORE_INSTANCE            *PrivateData,
+  IN CONST EFI_FFS_FILE_HEADER    *FileHeader,
+  IN EFI_COMMON_SECTION_HEADER    *Section,
+  IN EFI_GUID                     *SectionDefinitionGuid,
+  IN VOID                         *OutputBuffer,
+  IN UINT32                       OutputSize,
+  IN UINT32                       AuthenticationStatus
+  )
+{
+  EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY  Entry;
+  VOID                                    *SectionCopy;
+
+  if (!PrivateData->PeiMemoryInstalled || OutputBuffer == NULL) {
+    return;
+  }
+
+  //
+  // The DXE Core never reads the sections of these files: the SEC and PEI
+  // modules and the DXE Core are only loaded in PEI, and the firmware volume
+  // decoded from a firmware volume image file, like the DXE FV, is installed
+  // as is. Keeping a copy of such sections only wastes time and memory.
+  //
+  switch (FileHeader->Type) {
+  case EFI_FV_FILETYPE_SECURITY_CORE:
+  case EFI_FV_FILETYPE_PEI_CORE:
+  case EFI_FV_FILETYPE_PEIM:
+  case EFI_FV_FILETYPE_DXE_CORE:
+  case EFI_FV_FILETYPE_FIRMWARE_VOLUME_IMAGE:
+    return;
+  default:
+    break;
+  }
+
+  ZeroMem (&Entry, sizeof (Entry));
+  CopyGuid (&Entry.FileName, &FileHeader->Name);
+  CopyGuid (&Entry.SectionDefinitionGuid, SectionDefinitionGuid);
+  if (IS_SECTION2 (Section)) {
+    Entry.SectionSize = SECTION2_SIZE (Section);
+  } else {
+    Entry.SectionSize = SECTION_SIZE (Section);
+  }
+
+  SectionCopy = AllocatePages (EFI_SIZE_TO_PAGES (Entry.SectionSize));
+  if (SectionCopy == NULL) {
+    return;
+  }
+  CopyMem (SectionCopy, Section, Entry.SectionSize);
+
+  Entry.SectionBase          = (EFI_PHYSICAL_ADDRESS) (UINTN) SectionCopy;
+  Entry.AuthenticationStatus = AuthenticationStatus;
+  Entry.DataBase             = (EFI_PHYSICAL_ADDRESS) (UINTN) OutputBuffer;
+  Entry.DataSize             = OutputSize;
+
+  BuildGuidDataHob (&gEdkiiDecompressedSectionCacheHobGuid, &Entry, sizeof (Entry));
+}
+
 /**
   Go through the file to search SectionType section.
   Search within encapsulation sections (compression and GUIDed) recursively,
@@ -763,6 +839,7 @@ VerifyGuidedSectionGuid (
                            NULL if section not found
   @param AuthenticationStatus Updated upon return to point to the authentication status for this section.
   @param IsFfs3Fv          Indicates the FV format.
+  @param FileHeader        The header of the file the sections belong to.
 
   @return EFI_NOT_FOUND    The match section is not found.
   @return EFI_SUCCESS      The match section is found.
@@ -777,7 +854,8 @@ ProcessSection (
   IN UINTN                      SectionSize,
   OUT VOID                      **OutputBuffer,
   OUT UINT32                    *AuthenticationStatus,
-  IN BOOLEAN                    IsFfs3Fv
+  IN BOOLEAN                    IsFfs3Fv,
+  IN CONST EFI_FFS_FILE_HEADER  *FileHeader
   )
 {
   EFI_STATUS                              Status;
@@ -876,7 +954,8 @@ ProcessSection (
                      PpiOutputSize,
                      &TempOutputBuffer,
                      &TempAuthenticationStatus,
-                     IsFfs3Fv
+                     IsFfs3Fv,
+                     FileHeader
                    );
           if (!EFI_ERROR (Status)) {
             *OutputBuffer = TempOutputBuffer;
@@ -908,6 +987,19 @@ ProcessSection (
                                        &PpiOutputSize,
                                        &Authentication
                                        );
+            if (!EFI_ERROR (Status) &&
+                FeaturePcdGet (PcdDecompressedSectionCacheEnable) &&
+                (GuidedSectionAttributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) != 0) {
+              PublishDecompressedSection (
+                PrivateData,
+                FileHeader,
+                Section,
+                SectionDefinitionGuid,
+                PpiOutput,
+                PpiOutputSize,
+                Authentication
+                );
+            }
           } else if ((GuidedSectionAttributes & EFI_GUIDED_SECTION_PROCESSING_REQUIRED) == 0) {
             //
             // Figure out the proper authentication status for GUIDED section without processing required
@@ -960,7 +1052,8 @@ ProcessSection (
                      PpiOutputSize,
                      &TempOutputBuffer,
                      &TempAuthenticationStatus,
-                     IsFfs3Fv
+                     IsFfs3Fv,
+                     FileHeader
                    );
           if (!EFI_ERROR (Status)) {
             *OutputBuffer = TempOutputBuffer;
@@ -2049,7 +2142,8 @@ PeiFfsFvPpiFindSectionByType2 (
              FileSize,
              SectionData,
              &ExtractedAuthenticationStatus,
-             FwVolInstance->IsFfs3Fv
+             FwVolInstance->IsFfs3Fv,
+             FfsFileHeader
              );
   if (!EFI_ERROR (Status)) {
     //
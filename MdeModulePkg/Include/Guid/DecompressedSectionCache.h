@@ -0,0 +1,38 @@
+/** @file
+  This file defines the GUID and data structure of the HOB that describes a
+  GUIDed encapsulation section decoded by the PEI Core.
+
+  The PEI Core builds one HOB for every GUIDed section it decodes once
+  permanent memory is installed, in a file the DXE Core reads again. The DXE
+  Core looks up sections in these HOBs before decoding them again, so a
+  compressed section is expanded at most once per boot.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __DECOMPRESSED_SECTION_CACHE_GUID_H__
+#define __DECOMPRESSED_SECTION_CACHE_GUID_H__
+
+#define EDKII_DECOMPRESSED_SECTION_CACHE_HOB_GUID \
+  { 0x93cbe73a, 0x86d8, 0x432d, { 0xb0, 0x84, 0x9c, 0x00, 0x5c, 0x30, 0x29, 0x35 } }
+
+extern EFI_GUID gEdkiiDecompressedSectionCacheHobGuid;
+
+///
+/// The GUID HOB data. The section is looked up by the name of the file it was
+/// read from, its definition GUID and its size. A match is confirmed against
+/// the copy of the section at SectionBase.
+///
+typedef struct {
+  EFI_GUID              FileName;               ///< Name of the FFS file that holds the section.
+  EFI_GUID              SectionDefinitionGuid;  ///< Definition GUID of the encapsulation section.
+  UINT32                SectionSize;            ///< Size of the encapsulation section.
+  UINT32                AuthenticationStatus;   ///< Authentication status returned by the decode.
+  EFI_PHYSICAL_ADDRESS  SectionBase;            ///< Copy of the encapsulation section, in permanent memory.
+  EFI_PHYSICAL_ADDRESS  DataBase;               ///< Decoded section data, in permanent memory.
+  UINT64                DataSize;               ///< Size of the decoded section data.
+} EDKII_DECOMPRESSED_SECTION_CACHE_ENTRY;
+
+#endif
@@ -0,0 +1,48 @@
+/** @file
+  GUID of the configuration table that holds the statistics of the rendered
+  glyph cache of the HII database.
+
+  The HII database only installs the table when PcdHiiGlyphCacheCollectStatistics
+  is TRUE. It is meant for tools that measure the glyph cache, which may reset
+  the counters and change MaxCount to compare cache sizes.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __HII_GLYPH_CACHE_STATISTICS_H__
+#define __HII_GLYPH_CACHE_STATISTICS_H__
+
+#define EDKII_HII_GLYPH_CACHE_STATISTICS_GUID \
+  { \
+    0x4f3b8a6d, 0x2c15, 0x4e97, { 0xb8, 0x3a, 0x61, 0xd4, 0x0e, 0x7c, 0x95, 0x2f } \
+  }
+
+typedef struct {
+  ///
+  /// The number of rendered glyphs the cache keeps between two calls of
+  /// StringToImage(). It starts as PcdHiiGlyphCacheSize.
+  ///
+  UINT32  MaxCount;
+  ///
+  /// The number of rendered glyphs in the cache.
+  ///
+  UINT32  Count;
+  ///
+  /// The number of glyphs found in the cache.
+  ///
+  UINT64  Hits;
+  ///
+  /// The number of glyphs that were rendered and added to the cache.
+  ///
+  UINT64  Misses;
+  ///
+  /// The number of glyphs evicted to keep the cache within MaxCount.
+  ///
+  UINT64  Evictions;
+} EDKII_HII_GLYPH_CACHE_STATISTICS;
+
+extern EFI_GUID gEdkiiHiiGlyphCacheStatisticsGuid;
+
+#endif
@@ -138,6 +138,14 @@ typedef struct {
   VARIABLE_STORE_HEADER   *RuntimeHobCache;
   VARIABLE_STORE_HEADER   *RuntimeNvCache;
   VARIABLE_STORE_HEADER   *RuntimeVolatileCache;
+  //
+  // Optional, counts the reclaims of the variable stores. May be NULL, or
+  // left out of the communicate buffer by callers built without it. The
+  // caller sets it to MAX_UINT32, and an SMM driver that counts the reclaims
+  // sets it to 0 when it accepts the context, so the caller can tell it from
+  // an SMM driver built without it.
+  //
+  UINT32                  *ReclaimCount;
 } SMM_VARIABLE_COMMUNICATE_RUNTIME_VARIABLE_CACHE_CONTEXT;
 
 typedef struct {
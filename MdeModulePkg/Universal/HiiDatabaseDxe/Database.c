@@ -1416,6 +1416,7 @@ InsertStringPackage (
 Error:
 
   if (StringPackage != NULL) {
+    InvalidateStringIndex (StringPackage);
     if (StringPackage->StringBlock != NULL) {
       FreePool (StringPackage->StringBlock);
     }
@@ -1495,6 +1496,7 @@ AdjustStringPackage (
       // Append a EFI_HII_SIBT_END block to the end.
       //
       *BlockPtr = EFI_HII_SIBT_END;
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Skip2BlockSize;
@@ -1636,6 +1638,7 @@ RemoveStringPackages (
 
     RemoveEntryList (&Package->StringEntry);
     PackageList->PackageListHdr.PackageLength -= Package->StringPkgHdr->Header.Length;
+    InvalidateStringIndex (Package);
     FreePool (Package->StringBlock);
     FreePool (Package->StringPkgHdr);
     //
@@ -1945,6 +1948,7 @@ RemoveFontPackages (
 
     RemoveEntryList (&Package->FontEntry);
     PackageList->PackageListHdr.PackageLength -= Package->FontPkgHdr->Header.Length;
+    InvalidateGlyphCache (Private);
 
     if (Package->GlyphBlock != NULL) {
       FreePool (Package->GlyphBlock);
@@ -2458,6 +2462,7 @@ RemoveSimpleFontPackages (
 
     RemoveEntryList (&Package->SimpleFontEntry);
     PackageList->PackageListHdr.PackageLength -= Package->SimpleFontPkgHdr->Header.Length;
+    InvalidateGlyphCache (Private);
     FreePool (Package->SimpleFontPkgHdr);
     FreePool (Package);
   }
@@ -3088,6 +3093,7 @@ AddPackages (
       if (EFI_ERROR (Status)) {
         return Status;
       }
+      InvalidateGlyphCache (Private);
       Status = InvokeRegisteredFunction (
                  Private,
                  NotifyType,
@@ -3124,6 +3130,7 @@ AddPackages (
       if (EFI_ERROR (Status)) {
         return Status;
       }
+      InvalidateGlyphCache (Private);
       Status = InvokeRegisteredFunction (
                  Private,
                  NotifyType,
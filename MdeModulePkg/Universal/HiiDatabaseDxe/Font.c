@@ -576,6 +576,344 @@ GlyphToImage (
 }
 
 
+/**
+  Remove a rendered glyph from the glyph cache and free it.
+
+  This is a internal function.
+
+  @param  Private                 HII database driver private data.
+  @param  Glyph                   The glyph cache entry to release.
+
+**/
+VOID
+FreeGlyphCacheEntry (
+  IN HII_DATABASE_PRIVATE_DATA       *Private,
+  IN HII_GLYPH_CACHE_ENTRY           *Glyph
+  )
+{
+  RemoveEntryList (&Glyph->HashEntry);
+  RemoveEntryList (&Glyph->LruEntry);
+  Private->GlyphCacheCount--;
+  if (Private->GlyphCacheStatistics != NULL) {
+    Private->GlyphCacheStatistics->Count = (UINT32) Private->GlyphCacheCount;
+  }
+
+  if (Glyph->GlyphBuffer != NULL) {
+    FreePool (Glyph->GlyphBuffer);
+  }
+  if (Glyph->Bitmap != NULL) {
+    FreePool (Glyph->Bitmap);
+  }
+  FreePool (Glyph);
+}
+
+
+/**
+  Release all rendered glyphs kept by the glyph cache. It must be called
+  whenever a font or simplified font package is added or removed, since the
+  cache refers to font packages and reflects the glyph lookup order.
+
+  @param  Private                 HII database driver private data.
+
+**/
+VOID
+InvalidateGlyphCache (
+  IN HII_DATABASE_PRIVATE_DATA       *Private
+  )
+{
+  while (!IsListEmpty (&Private->GlyphCacheList)) {
+    FreeGlyphCacheEntry (
+      Private,
+      CR (Private->GlyphCacheList.ForwardLink, HII_GLYPH_CACHE_ENTRY, LruEntry, HII_GLYPH_CACHE_SIGNATURE)
+      );
+  }
+}
+
+
+/**
+  Evict the least recently used glyphs until the glyph cache holds no more
+  than PcdHiiGlyphCacheSize entries, or than the MaxCount of the glyph cache
+  statistics when they are collected.
+
+  The cache may grow beyond that limit while a string is rendered, because all
+  glyphs of the string stay referenced until it is drawn.
+
+  This is a internal function.
+
+  @param  Private                 HII database driver private data.
+
+**/
+VOID
+TrimGlyphCache (
+  IN HII_DATABASE_PRIVATE_DATA       *Private
+  )
+{
+  UINTN                              MaxCount;
+
+  if (Private->GlyphCacheStatistics != NULL) {
+    MaxCount = Private->GlyphCacheStatistics->MaxCount;
+  } else {
+    MaxCount = PcdGet32 (PcdHiiGlyphCacheSize);
+  }
+
+  while (Private->GlyphCacheCount > MaxCount) {
+    if (Private->GlyphCacheStatistics != NULL) {
+      Private->GlyphCacheStatistics->Evictions++;
+    }
+    FreeGlyphCacheEntry (
+      Private,
+      CR (Private->GlyphCacheList.BackLink, HII_GLYPH_CACHE_ENTRY, LruEntry, HII_GLYPH_CACHE_SIGNATURE)
+      );
+  }
+}
+
+
+/**
+  Get the rendered glyph of a character in the specified font and colors.
+
+  The glyph is taken from the glyph cache if it was rendered before. Otherwise
+  it is retrieved with GetGlyphBuffer(), converted once to BLT pixels in the
+  given colors and added to the cache. The returned entry is owned by the cache
+  and remains valid until TrimGlyphCache() or InvalidateGlyphCache() is called.
+
+  This is a internal function.
+
+  @param  Private                 HII database driver private data.
+  @param  Char                    Character to retrieve.
+  @param  StringInfo              Points to the string font information or NULL
+                                  if the string should use the default system
+                                  font.
+  @param  FontPackage             The font package StringInfo resolves to, or
+                                  NULL if StringInfo is NULL.
+  @param  Foreground              The color of the "on" pixels in the glyph.
+  @param  Background              The color of the "off" pixels in the glyph.
+  @param  Glyph                   Output the glyph cache entry.
+
+  @retval EFI_SUCCESS             Glyph outputted.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+  @retval EFI_NOT_FOUND           The glyph was unknown can not be found.
+  @retval EFI_INVALID_PARAMETER   Any input parameter is invalid.
+
+**/
+EFI_STATUS
+GetCachedGlyph (
+  IN  HII_DATABASE_PRIVATE_DATA      *Private,
+  IN  CHAR16                         Char,
+  IN  EFI_FONT_INFO                  *StringInfo,
+  IN  HII_FONT_PACKAGE_INSTANCE      *FontPackage,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Foreground,
+  IN  EFI_GRAPHICS_OUTPUT_BLT_PIXEL  Background,
+  OUT HII_GLYPH_CACHE_ENTRY          **Glyph
+  )
+{
+  EFI_STATUS                         Status;
+  LIST_ENTRY                         *Bucket;
+  LIST_ENTRY                         *Link;
+  HII_GLYPH_CACHE_ENTRY              *Entry;
+  EFI_HII_GLYPH_INFO                 LocalCell;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL      *Origin;
+  BOOLEAN                            Renderable;
+
+  Bucket = &Private->GlyphCacheBucket[HII_GLYPH_CACHE_HASH (FontPackage, Char)];
+  for (Link = Bucket->ForwardLink; Link != Bucket; Link = Link->ForwardLink) {
+    Entry = CR (Link, HII_GLYPH_CACHE_ENTRY, HashEntry, HII_GLYPH_CACHE_SIGNATURE);
+    if (Entry->FontPackage == FontPackage && Entry->Char == Char &&
+        CompareMem (&Entry->Foreground, &Foreground, sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) == 0 &&
+        CompareMem (&Entry->Background, &Background, sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) == 0) {
+      RemoveEntryList (&Entry->LruEntry);
+      InsertHeadList (&Private->GlyphCacheList, &Entry->LruEntry);
+      if (Private->GlyphCacheStatistics != NULL) {
+        Private->GlyphCacheStatistics->Hits++;
+      }
+      *Glyph = Entry;
+      return EFI_SUCCESS;
+    }
+  }
+
+  Entry = (HII_GLYPH_CACHE_ENTRY *) AllocateZeroPool (sizeof (HII_GLYPH_CACHE_ENTRY));
+  if (Entry == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = GetGlyphBuffer (Private, Char, StringInfo, &Entry->GlyphBuffer, &Entry->Cell, &Entry->Attributes);
+  if (EFI_ERROR (Status)) {
+    FreePool (Entry);
+    return Status;
+  }
+
+  Entry->Signature   = HII_GLYPH_CACHE_SIGNATURE;
+  Entry->FontPackage = FontPackage;
+  Entry->Char        = Char;
+  Entry->Foreground  = Foreground;
+  Entry->Background  = Background;
+
+  //
+  // Pre-render opaque glyphs. Non-spacing glyphs are always drawn transparent,
+  // and glyphs with a negative OffsetX or a cell size that does not match the
+  // glyph type keep using GlyphToImage() for exactly the same clipping.
+  //
+  if ((Entry->Attributes & EFI_GLYPH_NON_SPACING) == EFI_GLYPH_NON_SPACING) {
+    Renderable = FALSE;
+  } else if ((Entry->Attributes & EFI_GLYPH_WIDE) == EFI_GLYPH_WIDE) {
+    Renderable = (BOOLEAN) (Entry->Cell.Width == EFI_GLYPH_WIDTH * 2);
+  } else if ((Entry->Attributes & NARROW_GLYPH) == NARROW_GLYPH) {
+    Renderable = (BOOLEAN) (Entry->Cell.Width == EFI_GLYPH_WIDTH);
+  } else if ((Entry->Attributes & PROPORTIONAL_GLYPH) == PROPORTIONAL_GLYPH) {
+    Renderable = (BOOLEAN) (Entry->Cell.Width != 0 && Entry->Cell.OffsetX >= 0);
+  } else {
+    Renderable = FALSE;
+  }
+
+  if (Renderable && Entry->GlyphBuffer != NULL && Entry->Cell.Height != 0) {
+    Entry->Bitmap = AllocatePool (Entry->Cell.Width * Entry->Cell.Height * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    if (Entry->Bitmap != NULL) {
+      //
+      // Draw the glyph with its top-left corner at the start of Bitmap.
+      //
+      CopyMem (&LocalCell, &Entry->Cell, sizeof (EFI_HII_GLYPH_INFO));
+      LocalCell.OffsetX = 0;
+      LocalCell.OffsetY = 0;
+      Origin = Entry->Bitmap + Entry->Cell.Height * Entry->Cell.Width;
+      GlyphToImage (
+        Entry->GlyphBuffer,
+        Foreground,
+        Background,
+        Entry->Cell.Width,
+        Entry->Cell.Height,
+        Entry->Cell.Width,
+        Entry->Cell.Height,
+        FALSE,
+        &LocalCell,
+        Entry->Attributes,
+        &Origin
+        );
+    }
+  }
+
+  InsertHeadList (&Private->GlyphCacheList, &Entry->LruEntry);
+  InsertHeadList (Bucket, &Entry->HashEntry);
+  Private->GlyphCacheCount++;
+  if (Private->GlyphCacheStatistics != NULL) {
+    Private->GlyphCacheStatistics->Misses++;
+    Private->GlyphCacheStatistics->Count = (UINT32) Private->GlyphCacheCount;
+  }
+
+  *Glyph = Entry;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Draw a glyph taken from the glyph cache. It behaves like GlyphToImage() with
+  the colors the glyph was rendered in, but copies whole pixel rows of the
+  pre-rendered glyph when the background is drawn.
+
+  This is a internal function.
+
+  @param  Glyph                   The glyph cache entry, or NULL if the character
+                                  has no glyph.
+  @param  ImageWidth              Width of the whole image in pixels.
+  @param  BaseLine                BaseLine in the line.
+  @param  RowWidth                The width of the text on the line, in pixels.
+  @param  RowHeight               The height of the line, in pixels.
+  @param  Transparent             If TRUE, the Background color is ignored and all
+                                  "off" pixels in the character's drawn will use the
+                                  pixel value from BltBuffer.
+  @param  Origin                  On input, points to the origin of the to be
+                                  displayed character, on output, points to the
+                                  next glyph's origin.
+
+**/
+VOID
+CachedGlyphToImage (
+  IN     HII_GLYPH_CACHE_ENTRY         *Glyph,
+  IN     UINT16                        ImageWidth,
+  IN     UINT16                        BaseLine,
+  IN     UINTN                         RowWidth,
+  IN     UINTN                         RowHeight,
+  IN     BOOLEAN                       Transparent,
+  IN OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL **Origin
+  )
+{
+  EFI_HII_GLYPH_INFO                   *Cell;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Buffer;
+  UINT16                               YposOffset;
+  UINTN                                Xpos;
+  UINTN                                Ypos;
+  UINTN                                Rows;
+  UINTN                                Columns;
+
+  ASSERT (Origin != NULL && *Origin != NULL);
+
+  if (Glyph == NULL) {
+    return;
+  }
+
+  Cell = &Glyph->Cell;
+  if (Transparent || Glyph->Bitmap == NULL) {
+    GlyphToImage (
+      Glyph->GlyphBuffer,
+      Glyph->Foreground,
+      Glyph->Background,
+      ImageWidth,
+      BaseLine,
+      RowWidth,
+      RowHeight,
+      Transparent,
+      Cell,
+      Glyph->Attributes,
+      Origin
+      );
+    return;
+  }
+
+  if ((Glyph->Attributes & (EFI_GLYPH_WIDE | NARROW_GLYPH)) != 0) {
+    //
+    // Narrow and wide glyphs are drawn in halves of EFI_GLYPH_WIDTH pixels,
+    // each clipped to RowWidth the same way NarrowGlyphToBlt() does.
+    //
+    Buffer  = *Origin - EFI_GLYPH_HEIGHT * ImageWidth;
+    Rows    = MIN (EFI_GLYPH_HEIGHT, RowHeight);
+    Columns = MIN (EFI_GLYPH_WIDTH, RowWidth);
+    for (Xpos = 0; Xpos < Cell->Width; Xpos += EFI_GLYPH_WIDTH) {
+      for (Ypos = 0; Ypos < Rows; Ypos++) {
+        CopyMem (
+          Buffer + Ypos * ImageWidth + Xpos,
+          Glyph->Bitmap + Ypos * Cell->Width + Xpos,
+          Columns * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+          );
+      }
+    }
+    *Origin = *Origin + Cell->Width;
+    return;
+  }
+
+  //
+  // Apply the same clipping as GlyphToBlt().
+  //
+  Buffer     = *Origin + Cell->OffsetX - (Cell->OffsetY + Cell->Height) * ImageWidth;
+  YposOffset = (UINT16) (BaseLine - (Cell->OffsetY + Cell->Height));
+  Rows       = 0;
+  Columns    = 0;
+  if (YposOffset < RowHeight) {
+    Rows = MIN (Cell->Height, RowHeight - YposOffset);
+  }
+  if ((UINTN) Cell->OffsetX < RowWidth) {
+    Columns = MIN (Cell->Width, RowWidth - Cell->OffsetX);
+  }
+  for (Ypos = 0; Ypos < Rows; Ypos++) {
+    CopyMem (
+      Buffer + Ypos * ImageWidth,
+      Glyph->Bitmap + Ypos * Cell->Width,
+      Columns * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)
+      );
+  }
+
+  *Origin = *Origin + Cell->AdvanceX;
+}
+
+
 /**
   Write the output parameters of FindGlyphBlock().
 
@@ -1584,9 +1922,8 @@ HiiStringToImage (
 {
   EFI_STATUS                          Status;
   HII_DATABASE_PRIVATE_DATA           *Private;
-  UINT8                               **GlyphBuf;
+  HII_GLYPH_CACHE_ENTRY               **Glyph;
   EFI_HII_GLYPH_INFO                  *Cell;
-  UINT8                               *Attributes;
   EFI_IMAGE_OUTPUT                    *Image;
   EFI_STRING                          StringPtr;
   EFI_STRING                          StringTmp;
@@ -1614,12 +1951,15 @@ HiiStringToImage (
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL       Background;
   BOOLEAN                             Transparent;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL       *BltBuffer;
+  UINTN                               BltBufferSize;
+  UINTN                               LineBufferSize;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL       *BufferPtr;
   UINTN                               RowInfoSize;
   BOOLEAN                             LineBreak;
   UINTN                               StrLength;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL       *RowBufferPtr;
   HII_GLOBAL_FONT_INFO                *GlobalFont;
+  HII_FONT_PACKAGE_INSTANCE           *FontPackage;
   UINT32                              PreInitBkgnd;
 
   //
@@ -1680,14 +2020,15 @@ HiiStringToImage (
   }
 
   StrLength = StrLen(String);
-  GlyphBuf = (UINT8 **) AllocateZeroPool (StrLength * sizeof (UINT8 *));
-  ASSERT (GlyphBuf != NULL);
+  Glyph = (HII_GLYPH_CACHE_ENTRY **) AllocateZeroPool (StrLength * sizeof (HII_GLYPH_CACHE_ENTRY *));
+  ASSERT (Glyph != NULL);
   Cell = (EFI_HII_GLYPH_INFO *) AllocateZeroPool (StrLength * sizeof (EFI_HII_GLYPH_INFO));
   ASSERT (Cell != NULL);
-  Attributes = (UINT8 *) AllocateZeroPool (StrLength * sizeof (UINT8));
-  ASSERT (Attributes != NULL);
 
   FontInfo      = NULL;
+  FontPackage   = NULL;
+  BltBuffer     = NULL;
+  BltBufferSize = 0;
   RowInfo       = NULL;
   Status        = EFI_SUCCESS;
   StringIn2     = NULL;
@@ -1733,6 +2074,7 @@ HiiStringToImage (
     } else if (Status == EFI_SUCCESS) {
       FontInfo = &StringInfoOut->FontInfo;
       if (IsFontInfoExisted (Private, FontInfo, NULL, NULL, &GlobalFont)) {
+        FontPackage = GlobalFont->FontPackage;
         Height     = GlobalFont->FontPackage->Height;
         BaseLine   = GlobalFont->FontPackage->BaseLine;
         Foreground = StringInfoOut->ForegroundColor;
@@ -1799,23 +2141,23 @@ HiiStringToImage (
       continue;
     }
 
-    Status = GetGlyphBuffer (Private, *StringPtr, FontInfo, &GlyphBuf[Index], &Cell[Index], &Attributes[Index]);
+    Status = GetCachedGlyph (Private, *StringPtr, FontInfo, FontPackage, Foreground, Background, &Glyph[Index]);
     if (Status == EFI_NOT_FOUND) {
       if ((Flags & EFI_HII_IGNORE_IF_NO_GLYPH) == EFI_HII_IGNORE_IF_NO_GLYPH) {
-        GlyphBuf[Index] = NULL;
-        ZeroMem (&Cell[Index], sizeof (Cell[Index]));
+        Glyph[Index] = NULL;
         Status = EFI_SUCCESS;
       } else {
         //
         // Unicode 0xFFFD must exist in current hii database if this flag is not set.
         //
-        Status = GetGlyphBuffer (
+        Status = GetCachedGlyph (
                    Private,
                    REPLACE_UNKNOWN_GLYPH,
                    FontInfo,
-                   &GlyphBuf[Index],
-                   &Cell[Index],
-                   &Attributes[Index]
+                   FontPackage,
+                   Foreground,
+                   Background,
+                   &Glyph[Index]
                    );
         if (EFI_ERROR (Status)) {
           Status = EFI_INVALID_PARAMETER;
@@ -1827,6 +2169,10 @@ HiiStringToImage (
       goto Exit;
     }
 
+    if (Glyph[Index] != NULL) {
+      CopyMem (&Cell[Index], &Glyph[Index]->Cell, sizeof (EFI_HII_GLYPH_INFO));
+    }
+
     *StringTmp++ = *StringPtr++;
     Index++;
   }
@@ -2053,18 +2399,29 @@ HiiStringToImage (
     //
     LineOffset = 0;
     if ((Flags & EFI_HII_DIRECT_TO_SCREEN) == EFI_HII_DIRECT_TO_SCREEN) {
-      BltBuffer = NULL;
       if (RowInfo[RowIndex].LineWidth != 0) {
-        BltBuffer = AllocatePool (RowInfo[RowIndex].LineWidth * RowInfo[RowIndex].LineHeight * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
-        if (BltBuffer == NULL) {
-          Status = EFI_OUT_OF_RESOURCES;
-          goto Exit;
+        //
+        // Every line is composed in one off-screen buffer, which is shared by
+        // all lines of the string and is only grown when a line needs more.
+        //
+        LineBufferSize = RowInfo[RowIndex].LineWidth * RowInfo[RowIndex].LineHeight * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL);
+        if (LineBufferSize > BltBufferSize) {
+          if (BltBuffer != NULL) {
+            FreePool (BltBuffer);
+          }
+          BltBufferSize = 0;
+          BltBuffer     = AllocatePool (LineBufferSize);
+          if (BltBuffer == NULL) {
+            Status = EFI_OUT_OF_RESOURCES;
+            goto Exit;
+          }
+          BltBufferSize = LineBufferSize;
         }
         //
         // Initialize the background color.
         //
         PreInitBkgnd = Background.Blue | Background.Green << 8 | Background.Red << 16;
-        SetMem32 (BltBuffer,RowInfo[RowIndex].LineWidth * RowInfo[RowIndex].LineHeight * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL),PreInitBkgnd);
+        SetMem32 (BltBuffer, LineBufferSize, PreInitBkgnd);
         //
         // Set BufferPtr to Origin by adding baseline to the starting position.
         //
@@ -2075,22 +2432,18 @@ HiiStringToImage (
           //
           // Only BLT these character which have corresponding glyph in font database.
           //
-          GlyphToImage (
-            GlyphBuf[Index1],
-            Foreground,
-            Background,
+          CachedGlyphToImage (
+            Glyph[Index1],
             (UINT16) RowInfo[RowIndex].LineWidth,
             BaseLine,
             RowInfo[RowIndex].LineWidth - LineOffset,
             RowInfo[RowIndex].LineHeight,
             Transparent,
-            &Cell[Index1],
-            Attributes[Index1],
             &BufferPtr
           );
         }
         if (ColumnInfoArray != NULL) {
-          if ((GlyphBuf[Index1] == NULL && Cell[Index1].AdvanceX == 0)
+          if (((Glyph[Index1] == NULL || Glyph[Index1]->GlyphBuffer == NULL) && Cell[Index1].AdvanceX == 0)
               || RowInfo[RowIndex].LineWidth == 0) {
             *ColumnInfoArray = (UINTN) ~0;
           } else {
@@ -2101,7 +2454,7 @@ HiiStringToImage (
         LineOffset += Cell[Index1].AdvanceX;
       }
 
-      if (BltBuffer != NULL) {
+      if (RowInfo[RowIndex].LineWidth != 0) {
         Status = Image->Image.Screen->Blt (
                                         Image->Image.Screen,
                                         BltBuffer,
@@ -2115,11 +2468,8 @@ HiiStringToImage (
                                         0
                                         );
         if (EFI_ERROR (Status)) {
-          FreePool (BltBuffer);
           goto Exit;
         }
-
-        FreePool (BltBuffer);
       }
     } else {
       //
@@ -2135,22 +2485,18 @@ HiiStringToImage (
           //
           // Only BLT these character which have corresponding glyph in font database.
           //
-          GlyphToImage (
-            GlyphBuf[Index1],
-            Foreground,
-            Background,
+          CachedGlyphToImage (
+            Glyph[Index1],
             Image->Width,
             BaseLine,
             RowInfo[RowIndex].LineWidth - LineOffset,
             RowInfo[RowIndex].LineHeight,
             Transparent,
-            &Cell[Index1],
-            Attributes[Index1],
             &BufferPtr
           );
         }
         if (ColumnInfoArray != NULL) {
-          if ((GlyphBuf[Index1] == NULL && Cell[Index1].AdvanceX == 0)
+          if (((Glyph[Index1] == NULL || Glyph[Index1]->GlyphBuffer == NULL) && Cell[Index1].AdvanceX == 0)
               || RowInfo[RowIndex].LineWidth == 0) {
             *ColumnInfoArray = (UINTN) ~0;
           } else {
@@ -2212,10 +2558,13 @@ NextLine:
 
 Exit:
 
-  for (Index = 0; Index < StrLength; Index++) {
-    if (GlyphBuf[Index] != NULL) {
-      FreePool (GlyphBuf[Index]);
-    }
+  //
+  // The glyphs of this string are no longer referenced.
+  //
+  TrimGlyphCache (Private);
+
+  if (BltBuffer != NULL) {
+    FreePool (BltBuffer);
   }
   if (StringIn != NULL) {
     FreePool (StringIn);
@@ -2232,15 +2581,12 @@ Exit:
   if (SystemDefault != NULL) {
     FreePool (SystemDefault);
   }
-  if (GlyphBuf != NULL) {
-    FreePool (GlyphBuf);
+  if (Glyph != NULL) {
+    FreePool (Glyph);
   }
   if (Cell != NULL) {
     FreePool (Cell);
   }
-  if (Attributes != NULL) {
-    FreePool (Attributes);
-  }
 
   return Status;
 }
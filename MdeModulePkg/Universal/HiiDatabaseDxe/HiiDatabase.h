@@ -28,6 +28,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Guid/MdeModuleHii.h>
 #include <Guid/VariableFormat.h>
 #include <Guid/PcdDataBaseSignatureGuid.h>
+#include <Guid/HiiGlyphCacheStatistics.h>
 
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
@@ -152,6 +153,16 @@ typedef struct {
 // String Package definitions
 //
 #define HII_STRING_PACKAGE_SIGNATURE    SIGNATURE_32 ('h','i','s','p')
+
+//
+// Location of the string text of a string ID, relative to the string blocks of
+// its string package. TextOffset is zero if the string ID is not indexed.
+//
+typedef struct {
+  UINT32                                BlockOffset;   // offset of the block
+  UINT32                                TextOffset;    // offset in the block
+} HII_STRING_INDEX_ENTRY;
+
 typedef struct _HII_STRING_PACKAGE_INSTANCE {
   UINTN                                 Signature;
   EFI_HII_STRING_PACKAGE_HDR            *StringPkgHdr;
@@ -160,6 +171,7 @@ typedef struct _HII_STRING_PACKAGE_INSTANCE {
   LIST_ENTRY                            FontInfoList;  // local font info list
   UINT8                                 FontId;
   EFI_STRING_ID                         MaxStringId;   // record StringId
+  HII_STRING_INDEX_ENTRY                *StringIndex;  // built on demand
 } HII_STRING_PACKAGE_INSTANCE;
 
 //
@@ -222,6 +234,30 @@ typedef struct _HII_GLOBAL_FONT_INFO {
   EFI_FONT_INFO                         *FontInfo;
 } HII_GLOBAL_FONT_INFO;
 
+//
+// Rendered glyph cache. An entry is identified by the font package the glyph
+// comes from (NULL for the simplified fonts used as system font), the
+// character and the foreground/background colors it was rendered with.
+//
+#define HII_GLYPH_CACHE_BUCKETS         64
+#define HII_GLYPH_CACHE_HASH(FontPackage, Char) \
+  ((((UINTN) (FontPackage) >> 4) ^ (Char)) % HII_GLYPH_CACHE_BUCKETS)
+
+#define HII_GLYPH_CACHE_SIGNATURE       SIGNATURE_32 ('h','g','c','e')
+typedef struct _HII_GLYPH_CACHE_ENTRY {
+  UINTN                                 Signature;
+  LIST_ENTRY                            HashEntry;    // Link to a hash bucket
+  LIST_ENTRY                            LruEntry;     // Link to the LRU list
+  HII_FONT_PACKAGE_INSTANCE             *FontPackage;
+  CHAR16                                Char;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL         Foreground;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL         Background;
+  EFI_HII_GLYPH_INFO                    Cell;
+  UINT8                                 Attributes;
+  UINT8                                 *GlyphBuffer; // 1-bit glyph bitmap
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL         *Bitmap;      // Cell.Width * Cell.Height pixels
+} HII_GLYPH_CACHE_ENTRY;
+
 //
 // Image Package definitions
 //
@@ -321,6 +357,10 @@ typedef struct _HII_DATABASE_PRIVATE_DATA {
   UINTN                                 Attribute;     // default system color
   EFI_GUID                              CurrentLayoutGuid;
   EFI_HII_KEYBOARD_LAYOUT               *CurrentLayout;
+  LIST_ENTRY                            GlyphCacheList;   // most recently used first
+  LIST_ENTRY                            GlyphCacheBucket[HII_GLYPH_CACHE_BUCKETS];
+  UINTN                                 GlyphCacheCount;
+  EDKII_HII_GLYPH_CACHE_STATISTICS      *GlyphCacheStatistics;  // NULL unless collected
 } HII_DATABASE_PRIVATE_DATA;
 
 #define HII_FONT_DATABASE_PRIVATE_DATA_FROM_THIS(a) \
@@ -501,6 +541,34 @@ GetSystemFont (
   );
 
 
+/**
+  Release all rendered glyphs kept by the glyph cache. It must be called
+  whenever a font or simplified font package is added or removed, since the
+  cache refers to font packages and reflects the glyph lookup order.
+
+  @param  Private                 HII database driver private data.
+
+**/
+VOID
+InvalidateGlyphCache (
+  IN HII_DATABASE_PRIVATE_DATA       *Private
+  );
+
+
+/**
+  Discard the string ID index of a string package because its string blocks
+  are about to be replaced or released. FindStringBlock() rebuilds the index
+  when it is needed again.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  );
+
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
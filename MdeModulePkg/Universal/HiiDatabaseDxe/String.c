@@ -227,12 +227,233 @@ GetStringFontInfo (
 }
 
 
+/**
+  Discard the string ID index of a string package because its string blocks
+  are about to be replaced or released. FindStringBlock() rebuilds the index
+  when it is needed again.
+
+  @param  StringPackage           Hii string package instance.
+
+**/
+VOID
+InvalidateStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  if (StringPackage->StringIndex != NULL) {
+    FreePool (StringPackage->StringIndex);
+    StringPackage->StringIndex = NULL;
+  }
+}
+
+
+/**
+  Parse all string blocks of a string package once, and record where the
+  string text of each string ID is, so that FindStringBlock() does not have to
+  parse the string blocks from the start for every string.
+
+  String IDs in skip blocks are not indexed. A string ID of a duplicate block
+  is indexed with the location of the string it duplicates.
+
+  @param  StringPackage           Hii string package instance.
+
+  @retval EFI_SUCCESS             StringPackage->StringIndex has been built.
+  @retval EFI_OUT_OF_RESOURCES    The system is out of resources to accomplish the
+                                  task.
+  @retval EFI_UNSUPPORTED         An unknown string block type was found.
+
+**/
+STATIC
+EFI_STATUS
+BuildStringIndex (
+  IN HII_STRING_PACKAGE_INSTANCE     *StringPackage
+  )
+{
+  HII_STRING_INDEX_ENTRY               *StringIndex;
+  UINT8                                *BlockHdr;
+  UINT8                                *StringTextPtr;
+  UINT32                               CurrentStringId;
+  EFI_STRING_ID                        DuplicateId;
+  UINTN                                BlockSize;
+  UINTN                                StringSize;
+  UINTN                                Index;
+  UINT16                               StringCount;
+  UINT16                               SkipCount;
+  UINT8                                Length8;
+  UINT32                               Length32;
+  EFI_HII_SIBT_EXT2_BLOCK              Ext2;
+  BOOLEAN                              Ascii;
+
+  ASSERT (StringPackage->StringIndex == NULL);
+
+  StringIndex = AllocateZeroPool (
+                  (StringPackage->MaxStringId + 1) * sizeof (HII_STRING_INDEX_ENTRY)
+                  );
+  if (StringIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CurrentStringId = 1;
+  BlockHdr        = StringPackage->StringBlock;
+  while (*BlockHdr != EFI_HII_SIBT_END) {
+    StringCount   = 0;
+    StringTextPtr = NULL;
+    Ascii         = FALSE;
+    BlockSize     = 0;
+
+    switch (*BlockHdr) {
+    case EFI_HII_SIBT_STRING_SCSU:
+      StringCount   = 1;
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_STRING_BLOCK);
+      Ascii         = TRUE;
+      break;
+
+    case EFI_HII_SIBT_STRING_SCSU_FONT:
+      StringCount   = 1;
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRING_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      Ascii         = TRUE;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_BLOCK) - sizeof (UINT8);
+      Ascii         = TRUE;
+      break;
+
+    case EFI_HII_SIBT_STRINGS_SCSU_FONT:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_SCSU_FONT_BLOCK) - sizeof (UINT8);
+      Ascii         = TRUE;
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2:
+      StringCount   = 1;
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_STRING_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_STRING_UCS2_FONT:
+      StringCount   = 1;
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRING_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_STRINGS_UCS2_FONT:
+      CopyMem (&StringCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT16));
+      StringTextPtr = BlockHdr + sizeof (EFI_HII_SIBT_STRINGS_UCS2_FONT_BLOCK) - sizeof (CHAR16);
+      break;
+
+    case EFI_HII_SIBT_DUPLICATE:
+      //
+      // Remember the duplicated string ID for now, with a zero TextOffset;
+      // the entry is resolved below.
+      //
+      CopyMem (&DuplicateId, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (EFI_STRING_ID));
+      if (CurrentStringId <= StringPackage->MaxStringId) {
+        StringIndex[CurrentStringId].BlockOffset = DuplicateId;
+      }
+      CurrentStringId++;
+      BlockSize = sizeof (EFI_HII_SIBT_DUPLICATE_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_SKIP1:
+      SkipCount       = (UINT16) (*(BlockHdr + sizeof (EFI_HII_STRING_BLOCK)));
+      CurrentStringId += SkipCount;
+      BlockSize       = sizeof (EFI_HII_SIBT_SKIP1_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_SKIP2:
+      CopyMem (&SkipCount, BlockHdr + sizeof (EFI_HII_STRING_BLOCK), sizeof (UINT16));
+      CurrentStringId += SkipCount;
+      BlockSize       = sizeof (EFI_HII_SIBT_SKIP2_BLOCK);
+      break;
+
+    case EFI_HII_SIBT_EXT1:
+      CopyMem (&Length8, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT8));
+      BlockSize = Length8;
+      break;
+
+    case EFI_HII_SIBT_EXT2:
+      CopyMem (&Ext2, BlockHdr, sizeof (EFI_HII_SIBT_EXT2_BLOCK));
+      BlockSize = Ext2.Length;
+      break;
+
+    case EFI_HII_SIBT_EXT4:
+      CopyMem (&Length32, BlockHdr + sizeof (EFI_HII_STRING_BLOCK) + sizeof (UINT8), sizeof (UINT32));
+      BlockSize = Length32;
+      break;
+
+    default:
+      break;
+    }
+
+    if (StringTextPtr != NULL) {
+      for (Index = 0; Index < StringCount; Index++) {
+        if (CurrentStringId <= StringPackage->MaxStringId) {
+          StringIndex[CurrentStringId].BlockOffset = (UINT32) (BlockHdr - StringPackage->StringBlock);
+          StringIndex[CurrentStringId].TextOffset  = (UINT32) (StringTextPtr - BlockHdr);
+        }
+        if (Ascii) {
+          StringSize = AsciiStrSize ((CHAR8 *) StringTextPtr);
+        } else {
+          GetUnicodeStringTextOrSize (NULL, StringTextPtr, &StringSize);
+        }
+        StringTextPtr += StringSize;
+        CurrentStringId++;
+      }
+      BlockSize = StringTextPtr - BlockHdr;
+    }
+
+    if (BlockSize == 0) {
+      FreePool (StringIndex);
+      return EFI_UNSUPPORTED;
+    }
+    BlockHdr += BlockSize;
+  }
+
+  //
+  // Point the string IDs of duplicate blocks to the strings they duplicate,
+  // following chains of duplicates. Unresolvable entries stay unindexed.
+  // The counter is wider than EFI_STRING_ID so that the loop ends when
+  // MaxStringId is 0xFFFF.
+  //
+  for (CurrentStringId = 1; CurrentStringId <= StringPackage->MaxStringId; CurrentStringId++) {
+    if (StringIndex[CurrentStringId].TextOffset != 0 ||
+        StringIndex[CurrentStringId].BlockOffset == 0) {
+      continue;
+    }
+    DuplicateId = (EFI_STRING_ID) StringIndex[CurrentStringId].BlockOffset;
+    for (Index = 0; Index < StringPackage->MaxStringId; Index++) {
+      if (DuplicateId == 0 || DuplicateId > StringPackage->MaxStringId ||
+          StringIndex[DuplicateId].TextOffset != 0) {
+        break;
+      }
+      DuplicateId = (EFI_STRING_ID) StringIndex[DuplicateId].BlockOffset;
+    }
+    if (DuplicateId != 0 && DuplicateId <= StringPackage->MaxStringId &&
+        StringIndex[DuplicateId].TextOffset != 0) {
+      StringIndex[CurrentStringId] = StringIndex[DuplicateId];
+    } else {
+      StringIndex[CurrentStringId].BlockOffset = 0;
+    }
+  }
+
+  StringPackage->StringIndex = StringIndex;
+  return EFI_SUCCESS;
+}
+
+
 /**
   Parse all string blocks to find a String block specified by StringId.
   If StringId = (EFI_STRING_ID) (-1), find out all EFI_HII_SIBT_FONT blocks
   within this string package and backup its information. If LastStringId is
   specified, the string id of last string block will also be output.
   If StringId = 0, output the string id of last string block (EFI_HII_SIBT_STRING).
+  A string that exists is looked up in the string ID index of the package,
+  which is built on first use, rather than by parsing the string blocks.
 
   @param  Private                 Hii database private structure.
   @param  StringPackage           Hii string package instance.
@@ -244,6 +465,7 @@ GetStringFontInfo (
                                   the  string text information.
   @param  LastStringId            Output the last string id when StringId = 0 or StringId = -1.
   @param  StartStringId           The first id in the skip block which StringId in the block.
+                                  Only meaningful when EFI_NOT_FOUND is returned.
 
   @retval EFI_SUCCESS             The string text and font is retrieved
                                   successfully.
@@ -285,6 +507,7 @@ FindStringBlock (
   UINT32                               Length32;
   UINTN                                StringSize;
   CHAR16                               Zero;
+  HII_STRING_INDEX_ENTRY               *IndexEntry;
 
   ASSERT (StringPackage != NULL);
   ASSERT (StringPackage->Signature == HII_STRING_PACKAGE_SIGNATURE);
@@ -297,6 +520,23 @@ FindStringBlock (
     if (StringId > StringPackage->MaxStringId) {
       return EFI_NOT_FOUND;
     }
+
+    //
+    // Strings that are not indexed (skipped string IDs) are handled by the
+    // parser below, which also reports where a skip block is.
+    //
+    if (StringPackage->StringIndex == NULL) {
+      BuildStringIndex (StringPackage);
+    }
+    if (StringPackage->StringIndex != NULL) {
+      IndexEntry = &StringPackage->StringIndex[StringId];
+      if (IndexEntry->TextOffset != 0) {
+        *StringBlockAddr  = StringPackage->StringBlock + IndexEntry->BlockOffset;
+        *BlockType        = **StringBlockAddr;
+        *StringTextOffset = IndexEntry->TextOffset;
+        return EFI_SUCCESS;
+      }
+    }
   } else {
     ASSERT (Private != NULL && Private->Signature == HII_DATABASE_PRIVATE_DATA_SIGNATURE);
     if (StringId == 0 && LastStringId != NULL) {
@@ -839,6 +1079,7 @@ InsertLackStringBlock (
   } else {
     *BlockType = EFI_HII_SIBT_STRING_UCS2;
   }
+  InvalidateStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = StringBlock;
   StringPackage->StringPkgHdr->Header.Length += NewBlockSize - OldBlockSize;
@@ -1007,6 +1248,7 @@ SetStringWorker (
       );
 
     ZeroMem (StringPackage->StringBlock, OldBlockSize);
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1041,6 +1283,7 @@ SetStringWorker (
       );
 
     ZeroMem (StringPackage->StringBlock, OldBlockSize);
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = Block;
     StringPackage->StringPkgHdr->Header.Length += (UINT32) (BlockSize - OldBlockSize);
@@ -1093,6 +1336,7 @@ SetStringWorker (
   CopyMem (BlockPtr, StringPackage->StringBlock, OldBlockSize);
 
   ZeroMem (StringPackage->StringBlock, OldBlockSize);
+  InvalidateStringIndex (StringPackage);
   FreePool (StringPackage->StringBlock);
   StringPackage->StringBlock = Block;
   StringPackage->StringPkgHdr->Header.Length += Ext2.Length;
@@ -1279,6 +1523,7 @@ HiiNewString (
       //
       *BlockPtr = EFI_HII_SIBT_END;
       ZeroMem (StringPackage->StringBlock, OldBlockSize);
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1411,6 +1656,7 @@ HiiNewString (
     //
     *BlockPtr = EFI_HII_SIBT_END;
     ZeroMem (StringPackage->StringBlock, OldBlockSize);
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     StringPackage->StringBlock = StringBlock;
     StringPackage->StringPkgHdr->Header.Length += Ucs2BlockSize;
@@ -1454,6 +1700,7 @@ HiiNewString (
       //
       *BlockPtr = EFI_HII_SIBT_END;
       ZeroMem (StringPackage->StringBlock, OldBlockSize);
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += Ucs2FontBlockSize;
@@ -1516,6 +1763,7 @@ HiiNewString (
       //
       *BlockPtr = EFI_HII_SIBT_END;
       ZeroMem (StringPackage->StringBlock, OldBlockSize);
+      InvalidateStringIndex (StringPackage);
       FreePool (StringPackage->StringBlock);
       StringPackage->StringBlock = StringBlock;
       StringPackage->StringPkgHdr->Header.Length += FontBlockSize + Ucs2FontBlockSize;
@@ -1552,6 +1800,7 @@ Done:
       Link = Link->ForwardLink
       ) {
         StringPackage = CR (Link, HII_STRING_PACKAGE_INSTANCE, StringEntry, HII_STRING_PACKAGE_SIGNATURE);
+        InvalidateStringIndex (StringPackage);
         StringPackage->MaxStringId = *StringId;
     }
   } else if (NewStringPackageCreated) {
@@ -1559,6 +1808,7 @@ Done:
     // Free the allocated new string Package when new string can't be added.
     //
     RemoveEntryList (&StringPackage->StringEntry);
+    InvalidateStringIndex (StringPackage);
     FreePool (StringPackage->StringBlock);
     FreePool (StringPackage->StringPkgHdr);
     FreePool (StringPackage);
@@ -0,0 +1,520 @@
+/** @file
+  Unit tests of the string ID index of the HII string packages in String.c
+
+  The tests generate string blocks in memory, with strings, skip and duplicate
+  blocks, and check that FindStringBlock() locates the text of every string ID
+  where the generator wrote it.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../HiiDatabase.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "HII String Index Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_STRING_BLOCK_SIZE    0x1000
+#define TEST_MAX_STRING_ID        0xFFFF
+
+EFI_LOCK                      mHiiDatabaseLock = EFI_INITIALIZE_LOCK_VARIABLE (TPL_NOTIFY);
+BOOLEAN                       gExportAfterReadyToBoot = FALSE;
+
+STATIC UINT8                        mStringBlock[TEST_STRING_BLOCK_SIZE];
+STATIC UINTN                        mStringBlockSize;
+STATIC EFI_STRING_ID                mNextStringId;
+STATIC HII_STRING_PACKAGE_INSTANCE  mStringPackage;
+
+//
+// Offset of the string text of each string ID in mStringBlock, or 0 for the
+// string IDs of skip blocks
+//
+STATIC UINT32                       mTextOffset[TEST_MAX_STRING_ID + 1];
+
+/**
+  Start a new string package.
+
+**/
+STATIC
+VOID
+TestStartPackage (
+  VOID
+  )
+{
+  ZeroMem (mStringBlock, sizeof (mStringBlock));
+  ZeroMem (mTextOffset, sizeof (mTextOffset));
+  mStringBlockSize = 0;
+  mNextStringId    = 1;
+}
+
+/**
+  Append data to the string blocks of the package.
+
+  @param  Data                  The data to append.
+  @param  Size                  The size of Data in bytes.
+
+**/
+STATIC
+VOID
+TestAppend (
+  IN CONST VOID         *Data,
+  IN UINTN              Size
+  )
+{
+  ASSERT (mStringBlockSize + Size < TEST_STRING_BLOCK_SIZE);
+  CopyMem (mStringBlock + mStringBlockSize, Data, Size);
+  mStringBlockSize += Size;
+}
+
+/**
+  Append a block holding one or more UCS-2 strings.
+
+  @param  Count                 The number of strings.
+  @param  Text                  The text of the strings.
+
+**/
+STATIC
+VOID
+TestAddUcs2Strings (
+  IN UINT16             Count,
+  IN CHAR16             **Text
+  )
+{
+  UINT8   BlockType;
+  UINT16  Index;
+
+  if (Count == 1) {
+    BlockType = EFI_HII_SIBT_STRING_UCS2;
+    TestAppend (&BlockType, sizeof (BlockType));
+  } else {
+    BlockType = EFI_HII_SIBT_STRINGS_UCS2;
+    TestAppend (&BlockType, sizeof (BlockType));
+    TestAppend (&Count, sizeof (Count));
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    mTextOffset[mNextStringId++] = (UINT32) mStringBlockSize;
+    TestAppend (Text[Index], StrSize (Text[Index]));
+  }
+}
+
+/**
+  Append a block holding one SCSU string.
+
+  @param  Text                  The text of the string.
+
+**/
+STATIC
+VOID
+TestAddScsuString (
+  IN CHAR8              *Text
+  )
+{
+  UINT8   BlockType;
+
+  BlockType = EFI_HII_SIBT_STRING_SCSU;
+  TestAppend (&BlockType, sizeof (BlockType));
+  mTextOffset[mNextStringId++] = (UINT32) mStringBlockSize;
+  TestAppend (Text, AsciiStrSize (Text));
+}
+
+/**
+  Append a skip block.
+
+  @param  Count                 The number of string IDs to skip.
+
+**/
+STATIC
+VOID
+TestAddSkip (
+  IN UINT16             Count
+  )
+{
+  UINT8   BlockType;
+  UINT8   Count8;
+
+  if (Count <= MAX_UINT8) {
+    BlockType = EFI_HII_SIBT_SKIP1;
+    Count8    = (UINT8) Count;
+    TestAppend (&BlockType, sizeof (BlockType));
+    TestAppend (&Count8, sizeof (Count8));
+  } else {
+    BlockType = EFI_HII_SIBT_SKIP2;
+    TestAppend (&BlockType, sizeof (BlockType));
+    TestAppend (&Count, sizeof (Count));
+  }
+
+  mNextStringId = (EFI_STRING_ID) (mNextStringId + Count);
+}
+
+/**
+  Append a duplicate block.
+
+  @param  StringId              The string ID that is duplicated.
+
+**/
+STATIC
+VOID
+TestAddDuplicate (
+  IN EFI_STRING_ID      StringId
+  )
+{
+  UINT8   BlockType;
+
+  BlockType = EFI_HII_SIBT_DUPLICATE;
+  TestAppend (&BlockType, sizeof (BlockType));
+  TestAppend (&StringId, sizeof (StringId));
+  mTextOffset[mNextStringId++] = mTextOffset[StringId];
+}
+
+/**
+  Terminate the string blocks and set up the string package instance.
+
+**/
+STATIC
+VOID
+TestEndPackage (
+  VOID
+  )
+{
+  UINT8   BlockType;
+
+  BlockType = EFI_HII_SIBT_END;
+  TestAppend (&BlockType, sizeof (BlockType));
+
+  ZeroMem (&mStringPackage, sizeof (mStringPackage));
+  mStringPackage.Signature   = HII_STRING_PACKAGE_SIGNATURE;
+  mStringPackage.StringBlock = mStringBlock;
+  mStringPackage.MaxStringId = (EFI_STRING_ID) (mNextStringId - 1);
+  InitializeListHead (&mStringPackage.FontInfoList);
+}
+
+/**
+  Look up a string ID and check the result against the generated package.
+
+  @param  StringId              The string ID to look up.
+
+  @retval TRUE                  The string text is where it was generated, or the
+                                string ID is not found if it was skipped.
+  @retval FALSE                 The lookup result is wrong.
+
+**/
+STATIC
+BOOLEAN
+TestLookup (
+  IN EFI_STRING_ID      StringId
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       BlockType;
+  UINT8       *BlockAddr;
+  UINTN       TextOffset;
+
+  Status = FindStringBlock (NULL, &mStringPackage, StringId, &BlockType, &BlockAddr, &TextOffset, NULL, NULL);
+  if (mTextOffset[StringId] == 0) {
+    return (BOOLEAN) (Status == EFI_NOT_FOUND);
+  }
+
+  return (BOOLEAN) (!EFI_ERROR (Status) &&
+                    BlockType == *BlockAddr &&
+                    BlockAddr + TextOffset == mStringBlock + mTextOffset[StringId]);
+}
+
+/**
+  Free the index of the generated string package.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+FreeStringIndex (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  InvalidateStringIndex (&mStringPackage);
+}
+
+/**
+  Every string ID of a package mixing all the string, skip and duplicate
+  block types must be found where it was generated.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+MixedBlocksShouldBeIndexed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16        *Ucs2One[]   = { L"One" };
+  CHAR16        *Ucs2Three[] = { L"Two", L"", L"Four" };
+  UINT32        StringId;
+
+  TestStartPackage ();
+  TestAddUcs2Strings (1, Ucs2One);
+  TestAddUcs2Strings (3, Ucs2Three);
+  TestAddScsuString ("Five");
+  TestAddSkip (5);
+  TestAddDuplicate (2);
+  TestAddDuplicate (mNextStringId - 1);
+  TestAddUcs2Strings (3, Ucs2Three);
+  TestAddSkip (300);
+  TestAddScsuString ("");
+  TestAddDuplicate (4);
+  TestEndPackage ();
+
+  for (StringId = 1; StringId <= mStringPackage.MaxStringId; StringId++) {
+    UT_ASSERT_TRUE (TestLookup ((EFI_STRING_ID) StringId));
+  }
+  UT_ASSERT_NOT_NULL (mStringPackage.StringIndex);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A package whose last string ID is 0xFFFF must be indexed. String ID 0xFFFF
+  itself can't be looked up, as FindStringBlock() gives it a special meaning,
+  so the strings and duplicates right below it are checked.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+LastStringIdShouldBeIndexed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16        *First[] = { L"First" };
+  CHAR16        *Last[]  = { L"Last" };
+
+  TestStartPackage ();
+  TestAddUcs2Strings (1, First);
+  TestAddSkip (TEST_MAX_STRING_ID - 4);
+  TestAddUcs2Strings (1, Last);
+  TestAddDuplicate (1);
+  TestAddDuplicate (mNextStringId - 2);
+  TestEndPackage ();
+
+  UT_ASSERT_EQUAL (mStringPackage.MaxStringId, TEST_MAX_STRING_ID);
+
+  UT_ASSERT_TRUE (TestLookup (TEST_MAX_STRING_ID - 1));
+  UT_ASSERT_NOT_NULL (mStringPackage.StringIndex);
+  UT_ASSERT_TRUE (TestLookup (TEST_MAX_STRING_ID - 2));
+  UT_ASSERT_TRUE (TestLookup (TEST_MAX_STRING_ID - 3));
+  UT_ASSERT_TRUE (TestLookup (2));
+  UT_ASSERT_TRUE (TestLookup (1));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  String IDs past the last one of a package must not be found.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+StringIdPastLastShouldNotBeFound (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS    Status;
+  UINT8         BlockType;
+  UINT8         *BlockAddr;
+  UINTN         TextOffset;
+  CHAR16        *Ucs2Three[] = { L"One", L"Two", L"Three" };
+
+  TestStartPackage ();
+  TestAddUcs2Strings (3, Ucs2Three);
+  TestEndPackage ();
+
+  Status = FindStringBlock (NULL, &mStringPackage, 4, &BlockType, &BlockAddr, &TextOffset, NULL, NULL);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_FOUND);
+  UT_ASSERT_TRUE (TestLookup (3));
+
+  return UNIT_TEST_PASSED;
+}
+
+//
+// The string package tests don't use the rest of the HII database.
+//
+
+/**
+  Stub of the HII handle check of Database.c.
+
+  @param  Handle                 Not used.
+
+  @retval FALSE                  Always.
+
+**/
+BOOLEAN
+IsHiiHandleValid (
+  EFI_HII_HANDLE Handle
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the font lookup of Font.c.
+
+  @param  Private                 Not used.
+  @param  FontInfo                Not used.
+  @param  FontInfoMask            Not used.
+  @param  FontHandle              Not used.
+  @param  GlobalFontInfo          Not used.
+
+  @retval FALSE                   Always.
+
+**/
+BOOLEAN
+IsFontInfoExisted (
+  IN  HII_DATABASE_PRIVATE_DATA *Private,
+  IN  EFI_FONT_INFO             *FontInfo,
+  IN  EFI_FONT_INFO_MASK        *FontInfoMask,   OPTIONAL
+  IN  EFI_FONT_HANDLE           FontHandle,      OPTIONAL
+  OUT HII_GLOBAL_FONT_INFO      **GlobalFontInfo OPTIONAL
+  )
+{
+  return FALSE;
+}
+
+/**
+  Stub of the notification of Database.c.
+
+  @param  Private           Not used.
+  @param  NotifyType        Not used.
+  @param  PackageInstance   Not used.
+  @param  PackageType       Not used.
+  @param  Handle            Not used.
+
+  @retval EFI_SUCCESS       Always.
+
+**/
+EFI_STATUS
+InvokeRegisteredFunction (
+  IN HII_DATABASE_PRIVATE_DATA    *Private,
+  IN EFI_HII_DATABASE_NOTIFY_TYPE NotifyType,
+  IN VOID                         *PackageInstance,
+  IN UINT8                        PackageType,
+  IN EFI_HII_HANDLE               Handle
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the database export of Database.c.
+
+  @param  This              Not used.
+
+  @retval EFI_SUCCESS       Always.
+
+**/
+EFI_STATUS
+HiiGetDatabaseInfo (
+  IN CONST EFI_HII_DATABASE_PROTOCOL        *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Stub of the lock acquisition of UefiLib, the tests run single threaded.
+
+  @param  Lock              Not used.
+
+**/
+VOID
+EFIAPI
+EfiAcquireLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+/**
+  Stub of the lock release of UefiLib, the tests run single threaded.
+
+  @param  Lock              Not used.
+
+**/
+VOID
+EFIAPI
+EfiReleaseLock (
+  IN EFI_LOCK  *Lock
+  )
+{
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the string ID
+  index and run them.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      StringIndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&StringIndexTests, Framework, "HII String ID Index Tests", "Hii.StringIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for StringIndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (StringIndexTests, "Mixed blocks should be indexed", "MixedBlocks", MixedBlocksShouldBeIndexed, NULL, FreeStringIndex, NULL);
+  AddTestCase (StringIndexTests, "Package ending at string ID 0xFFFF should be indexed", "LastStringId", LastStringIdShouldBeIndexed, NULL, FreeStringIndex, NULL);
+  AddTestCase (StringIndexTests, "String ID past the last should not be found", "PastLast", StringIdPastLastShouldNotBeFound, NULL, FreeStringIndex, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,481 @@
+/** @file
+  Unit tests of the variable store index of VariableParsing.c
+
+  The tests generate variable stores in memory, with added, deleted and in
+  deleted transition variables of the same names, and check that
+  FindVariableEx() finds the same variable as a walk of the store, after
+  variables are appended, and after the store is reclaimed in place.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../VariableParsing.h"
+
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_APP_NAME        "Variable Store Index Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+#define TEST_STORE_SIZE           SIZE_64KB
+#define TEST_NAME_COUNT           100
+#define TEST_VARIABLE_COUNT       300
+#define TEST_DATA_SIZE            4
+
+//
+// All the variables have the same size, so a store reclaimed in place has
+// variable headers at the offsets the variables had before.
+//
+STATIC UINT32                 mStoreBuffer[TEST_STORE_SIZE / sizeof (UINT32)];
+STATIC UINT32                 mReclaimBuffer[TEST_STORE_SIZE / sizeof (UINT32)];
+STATIC VARIABLE_STORE_HEADER  *mStore = (VARIABLE_STORE_HEADER *) mStoreBuffer;
+STATIC VARIABLE_HEADER        *mNextVariable;
+STATIC UINT32                 mRandomState;
+
+STATIC EFI_GUID  mTestGuid[] = {
+  { 0x8a3e7f21, 0x5d04, 0x4c8b, { 0x9e, 0x16, 0x2b, 0x7d, 0x40, 0xc3, 0x5a, 0x91 } },
+  { 0x1f6c92b8, 0xa35e, 0x47d2, { 0x83, 0x0f, 0xd4, 0x6a, 0x19, 0xe7, 0x2c, 0x58 } }
+};
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Build the name of a test variable.
+
+  @param  Index                 The index of the name.
+  @param  Name                  Output the name, L"Var" followed by three digits.
+
+**/
+STATIC
+VOID
+TestName (
+  IN  UINTN             Index,
+  OUT CHAR16            Name[7]
+  )
+{
+  Name[0] = L'V';
+  Name[1] = L'a';
+  Name[2] = L'r';
+  Name[3] = (CHAR16) (L'0' + (Index / 100) % 10);
+  Name[4] = (CHAR16) (L'0' + (Index / 10) % 10);
+  Name[5] = (CHAR16) (L'0' + Index % 10);
+  Name[6] = L'\0';
+}
+
+/**
+  Start an empty variable store and drop the index of the previous one.
+
+**/
+STATIC
+VOID
+TestStartStore (
+  VOID
+  )
+{
+  SetMem (mStoreBuffer, sizeof (mStoreBuffer), 0xFF);
+  CopyGuid (&mStore->Signature, &gEfiVariableGuid);
+  mStore->Size   = TEST_STORE_SIZE;
+  mStore->Format = VARIABLE_STORE_FORMATTED;
+  mStore->State  = VARIABLE_STORE_HEALTHY;
+  mNextVariable  = GetStartPointer (mStore);
+
+  VariableIndexInvalidate ();
+}
+
+/**
+  Append a variable to the store.
+
+  @param  NameIndex             The index of the variable name.
+  @param  Guid                  The index of the vendor GUID.
+  @param  State                 The state of the variable.
+
+**/
+STATIC
+VOID
+TestAddVariable (
+  IN UINTN              NameIndex,
+  IN UINTN              Guid,
+  IN UINT8              State
+  )
+{
+  VARIABLE_HEADER       *Variable;
+
+  Variable = mNextVariable;
+  Variable->StartId    = VARIABLE_DATA;
+  Variable->State      = State;
+  Variable->Reserved   = 0;
+  Variable->Attributes = EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS;
+  Variable->NameSize   = 7 * sizeof (CHAR16);
+  Variable->DataSize   = TEST_DATA_SIZE;
+  CopyGuid (&Variable->VendorGuid, &mTestGuid[Guid]);
+  TestName (NameIndex, GetVariableNamePtr (Variable, FALSE));
+  SetMem (GetVariableDataPtr (Variable, FALSE), TEST_DATA_SIZE, (UINT8) NameIndex);
+
+  mNextVariable = GetNextVariablePtr (Variable, FALSE);
+  ASSERT ((UINTN) mNextVariable < (UINTN) GetEndPointer (mStore));
+}
+
+/**
+  Append variables of random names and states to the store.
+
+  @param  Count                 The number of variables to append.
+
+**/
+STATIC
+VOID
+TestAddRandomVariables (
+  IN UINTN              Count
+  )
+{
+  UINTN                 Index;
+  UINTN                 Choice;
+  UINT8                 State;
+
+  for (Index = 0; Index < Count; Index++) {
+    Choice = TestRandom () % 10;
+    if (Choice < 6) {
+      State = VAR_ADDED;
+    } else if (Choice < 9) {
+      State = VAR_ADDED & VAR_DELETED;
+    } else {
+      State = VAR_ADDED & VAR_IN_DELETED_TRANSITION;
+    }
+    TestAddVariable (TestRandom () % TEST_NAME_COUNT, TestRandom () % ARRAY_SIZE (mTestGuid), State);
+  }
+}
+
+/**
+  Reclaim the store in place: the variables that are not added are removed
+  and the others are moved to the start of the store, in order.
+
+**/
+STATIC
+VOID
+TestReclaimStore (
+  VOID
+  )
+{
+  VARIABLE_HEADER       *Variable;
+  UINT8                 *Reclaimed;
+  UINTN                 Size;
+
+  SetMem (mReclaimBuffer, sizeof (mReclaimBuffer), 0xFF);
+  CopyMem (mReclaimBuffer, mStoreBuffer, (UINTN) GetStartPointer (mStore) - (UINTN) mStore);
+  Reclaimed = (UINT8 *) mReclaimBuffer + ((UINTN) GetStartPointer (mStore) - (UINTN) mStore);
+
+  for ( Variable = GetStartPointer (mStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mStore))
+      ; Variable = GetNextVariablePtr (Variable, FALSE)
+      ) {
+    if (Variable->State == VAR_ADDED) {
+      Size = (UINTN) GetNextVariablePtr (Variable, FALSE) - (UINTN) Variable;
+      CopyMem (Reclaimed, Variable, Size);
+      Reclaimed += Size;
+    }
+  }
+
+  CopyMem (mStoreBuffer, mReclaimBuffer, sizeof (mStoreBuffer));
+  mNextVariable = (VARIABLE_HEADER *) ((UINTN) mStore + ((UINTN) Reclaimed - (UINTN) mReclaimBuffer));
+}
+
+/**
+  Find a variable by walking the store, as FindVariableEx() does without an
+  index.
+
+  @param  Name                  The variable name.
+  @param  Guid                  The vendor GUID.
+  @param  PtrTrack              Output the variable found.
+
+**/
+STATIC
+VOID
+TestWalkStore (
+  IN  CHAR16                  *Name,
+  IN  EFI_GUID                *Guid,
+  OUT VARIABLE_POINTER_TRACK  *PtrTrack
+  )
+{
+  VARIABLE_HEADER             *Variable;
+  VARIABLE_HEADER             *InDeletedVariable;
+
+  PtrTrack->InDeletedTransitionPtr = NULL;
+  InDeletedVariable                = NULL;
+  for ( Variable = GetStartPointer (mStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mStore))
+      ; Variable = GetNextVariablePtr (Variable, FALSE)
+      ) {
+    if (CompareGuid (Guid, &Variable->VendorGuid) && StrCmp (Name, GetVariableNamePtr (Variable, FALSE)) == 0) {
+      if (Variable->State == VAR_ADDED) {
+        PtrTrack->CurrPtr                = Variable;
+        PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+        return;
+      }
+      if (Variable->State == (VAR_ADDED & VAR_IN_DELETED_TRANSITION)) {
+        InDeletedVariable = Variable;
+      }
+    }
+  }
+
+  PtrTrack->CurrPtr = InDeletedVariable;
+}
+
+/**
+  Check that FindVariableEx() finds every variable name of the test, and a
+  few names that are not in the store, where a walk of the store does.
+
+  @retval UNIT_TEST_PASSED      All the variables were found where expected.
+  @retval UNIT_TEST_ERROR_TEST_FAILED   A variable was not found where expected.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+TestCheckStore (
+  VOID
+  )
+{
+  VARIABLE_POINTER_TRACK      PtrTrack;
+  VARIABLE_POINTER_TRACK      Expected;
+  CHAR16                      Name[7];
+  UINTN                       NameIndex;
+  UINTN                       Guid;
+  EFI_STATUS                  Status;
+
+  for (NameIndex = 0; NameIndex < TEST_NAME_COUNT + 10; NameIndex++) {
+    for (Guid = 0; Guid < ARRAY_SIZE (mTestGuid); Guid++) {
+      TestName (NameIndex, Name);
+      TestWalkStore (Name, &mTestGuid[Guid], &Expected);
+
+      PtrTrack.StartPtr = GetStartPointer (mStore);
+      PtrTrack.EndPtr   = GetEndPointer (mStore);
+      Status = FindVariableEx (Name, &mTestGuid[Guid], FALSE, &PtrTrack, FALSE);
+
+      UT_ASSERT_EQUAL (Status, (Expected.CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS);
+      UT_ASSERT_EQUAL ((UINTN) PtrTrack.CurrPtr, (UINTN) Expected.CurrPtr);
+      UT_ASSERT_EQUAL ((UINTN) PtrTrack.InDeletedTransitionPtr, (UINTN) Expected.InDeletedTransitionPtr);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Variables found through the index must be the ones a walk of the store
+  finds.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+IndexShouldMatchWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mRandomState = 0x10;
+  TestStartStore ();
+  TestAddRandomVariables (TEST_VARIABLE_COUNT);
+
+  return TestCheckStore ();
+}
+
+/**
+  Variables appended and variable states updated after the store was indexed
+  must be found.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+AppendedVariablesShouldBeFound (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS      Status;
+  VARIABLE_HEADER       *Variable;
+
+  mRandomState = 0x20;
+  TestStartStore ();
+  TestAddRandomVariables (TEST_VARIABLE_COUNT);
+  Status = TestCheckStore ();
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  //
+  // Delete the added variables of every other name in place, as
+  // UpdateVariable() does, and append new ones.
+  //
+  for ( Variable = GetStartPointer (mStore)
+      ; IsValidVariableHeader (Variable, GetEndPointer (mStore))
+      ; Variable = GetNextVariablePtr (Variable, FALSE)
+      ) {
+    if (Variable->State == VAR_ADDED && *(UINT8 *) GetVariableDataPtr (Variable, FALSE) % 2 == 0) {
+      Variable->State &= VAR_DELETED;
+    }
+  }
+  TestAddRandomVariables (TEST_VARIABLE_COUNT / 2);
+
+  return TestCheckStore ();
+}
+
+/**
+  Variables must be found after the store was reclaimed in place and the
+  index was invalidated, as Reclaim() does.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+InvalidatedIndexShouldFollowReclaim (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS      Status;
+
+  mRandomState = 0x30;
+  TestStartStore ();
+  TestAddRandomVariables (TEST_VARIABLE_COUNT);
+  Status = TestCheckStore ();
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  TestReclaimStore ();
+  TestAddRandomVariables (TEST_VARIABLE_COUNT);
+  VariableIndexInvalidate ();
+
+  return TestCheckStore ();
+}
+
+/**
+  Variables must be found after the store was reclaimed in place without the
+  index being invalidated, as the runtime caches are by an SMM variable
+  driver that does not count the reclaims, once the index is disabled.
+
+  The store grows past its indexed size again before the search, so the
+  index can't notice the reclaim by itself. This test must be the last one,
+  as the index can't be enabled again.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+DisabledIndexShouldFollowUnnoticedReclaim (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS      Status;
+
+  mRandomState = 0x40;
+  TestStartStore ();
+  TestAddRandomVariables (TEST_VARIABLE_COUNT);
+  Status = TestCheckStore ();
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  TestReclaimStore ();
+  TestAddRandomVariables (TEST_VARIABLE_COUNT);
+  VariableIndexDisable ();
+
+  return TestCheckStore ();
+}
+
+/**
+  Stub of the runtime check of the variable driver, the tests run at boot
+  time.
+
+  @retval FALSE                 Not at runtime.
+
+**/
+BOOLEAN
+AtRuntime (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the variable
+  store index and run them.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "Variable Store Index Tests", "Variable.Index", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for IndexTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Index should match a walk of the store", "Walk", IndexShouldMatchWalk, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Appended variables should be found", "Append", AppendedVariablesShouldBeFound, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Invalidated index should follow a reclaim", "Reclaim", InvalidatedIndexShouldFollowReclaim, NULL, NULL, NULL);
+  AddTestCase (IndexTests, "Disabled index should follow an unnoticed reclaim", "Disable", DisabledIndexShouldFollowUnnoticedReclaim, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
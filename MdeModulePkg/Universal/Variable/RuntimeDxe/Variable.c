@@ -796,6 +796,15 @@ Done:
     ASSERT_EFI_ERROR (Status);
   }
 
+  //
+  // The variables were moved, the index of the stores and of the runtime
+  // caches must be rebuilt.
+  //
+  VariableIndexInvalidate ();
+  if (mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReclaimCount != NULL) {
+    (*(mVariableModuleGlobal->VariableGlobal.VariableRuntimeCacheContext.ReclaimCount))++;
+  }
+
   return Status;
 }
 
@@ -3282,6 +3291,7 @@ FlushHobVariableToFlash (
       }
       if (!AtRuntime ()) {
         FreePool ((VOID *) VariableStoreHeader);
+        VariableIndexInvalidate ();
       }
     }
   }
@@ -437,6 +437,432 @@ VariableCompareTimeStampInternal (
   return (BOOLEAN) (FirstTime->Second <= SecondTime->Second);
 }
 
+//
+// Number of variable stores indexed at the same time, the HOB, volatile and
+// non-volatile stores plus a spare one for the runtime caches.
+//
+#define VARIABLE_INDEX_SLOT_COUNT       4
+
+//
+// Entries allocated when a variable store is first indexed.
+//
+#define VARIABLE_INDEX_MIN_ENTRY_COUNT  64
+
+typedef struct {
+  UINT32                  Offset;     ///< Offset of the variable from the start of the store.
+  UINT32                  Hash;       ///< Hash of the name and vendor GUID of the variable.
+  UINT32                  Next;       ///< Next entry of the bucket plus one, 0 at the end.
+} VARIABLE_INDEX_ENTRY;
+
+//
+// Hash index of the variables of one variable store. The entries are kept in
+// the order of the variables in the store, which is also the order of the
+// entries of every bucket, so the variables are found in the same order as
+// by a walk of the store.
+//
+typedef struct {
+  VARIABLE_HEADER         *StartPtr;
+  UINTN                   IndexedSize;
+  UINT32                  EntryCount;
+  UINT32                  MaxEntryCount;
+  UINT32                  BucketMask;
+  UINT32                  *BucketHead;
+  UINT32                  *BucketTail;
+  VARIABLE_INDEX_ENTRY    *Entries;
+  UINT64                  LastUse;
+  BOOLEAN                 Overflow;
+} VARIABLE_INDEX;
+
+VARIABLE_INDEX  mVariableIndex[VARIABLE_INDEX_SLOT_COUNT];
+UINT64          mVariableIndexUseCount = 0;
+BOOLEAN         mVariableIndexDisabled = FALSE;
+
+/**
+  Compute the index hash of a variable name and vendor GUID.
+
+  @param[in]  Name          Pointer to the variable name.
+  @param[in]  NameSize      Size of the variable name in bytes.
+  @param[in]  VendorGuid    Pointer to the vendor GUID.
+
+  @return The hash of the name and vendor GUID.
+
+**/
+STATIC
+UINT32
+VariableIndexHash (
+  IN CONST VOID         *Name,
+  IN UINTN              NameSize,
+  IN CONST EFI_GUID     *VendorGuid
+  )
+{
+  CONST UINT8   *Buffer;
+  UINT32        Hash;
+  UINTN         Index;
+
+  //
+  // FNV-1a
+  //
+  Hash   = 0x811C9DC5;
+  Buffer = Name;
+  for (Index = 0; Index < NameSize; Index++) {
+    Hash = (Hash ^ Buffer[Index]) * 0x01000193;
+  }
+  Buffer = (CONST UINT8 *) VendorGuid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Buffer[Index]) * 0x01000193;
+  }
+
+  return Hash;
+}
+
+/**
+  Drop all entries of a variable store index, keeping its buffer.
+
+  @param[in, out]  VariableIndex  The variable store index.
+
+**/
+STATIC
+VOID
+VariableIndexReset (
+  IN OUT VARIABLE_INDEX  *VariableIndex
+  )
+{
+  VariableIndex->IndexedSize = 0;
+  VariableIndex->EntryCount  = 0;
+  VariableIndex->Overflow    = FALSE;
+  if (VariableIndex->BucketHead != NULL) {
+    ZeroMem (VariableIndex->BucketHead, (VariableIndex->BucketMask + 1) * 2 * sizeof (UINT32));
+  }
+}
+
+/**
+  Link an entry at the end of its bucket.
+
+  @param[in, out]  VariableIndex  The variable store index.
+  @param[in]       EntryIndex     Index of the entry to link.
+
+**/
+STATIC
+VOID
+VariableIndexLinkEntry (
+  IN OUT VARIABLE_INDEX  *VariableIndex,
+  IN     UINT32          EntryIndex
+  )
+{
+  UINT32  Bucket;
+
+  Bucket = VariableIndex->Entries[EntryIndex].Hash & VariableIndex->BucketMask;
+  VariableIndex->Entries[EntryIndex].Next = 0;
+  if (VariableIndex->BucketTail[Bucket] == 0) {
+    VariableIndex->BucketHead[Bucket] = EntryIndex + 1;
+  } else {
+    VariableIndex->Entries[VariableIndex->BucketTail[Bucket] - 1].Next = EntryIndex + 1;
+  }
+  VariableIndex->BucketTail[Bucket] = EntryIndex + 1;
+}
+
+/**
+  Double the number of entries of a variable store index.
+
+  The buffer is runtime memory and is only allocated before ExitBootServices(),
+  a store whose index is full at runtime is searched linearly.
+
+  @param[in, out]  VariableIndex  The variable store index.
+
+  @retval TRUE      The index was grown.
+  @retval FALSE     The index could not be grown.
+
+**/
+STATIC
+BOOLEAN
+VariableIndexGrow (
+  IN OUT VARIABLE_INDEX  *VariableIndex
+  )
+{
+  UINT32                  MaxEntryCount;
+  VARIABLE_INDEX_ENTRY    *Entries;
+  UINT32                  Index;
+
+  if (AtRuntime () || VariableIndex->MaxEntryCount >= SIZE_1MB) {
+    return FALSE;
+  }
+
+  MaxEntryCount = MAX (VariableIndex->MaxEntryCount * 2, VARIABLE_INDEX_MIN_ENTRY_COUNT);
+  Entries = AllocateRuntimeZeroPool (
+              MaxEntryCount * sizeof (VARIABLE_INDEX_ENTRY) + MaxEntryCount * 2 * sizeof (UINT32)
+              );
+  if (Entries == NULL) {
+    return FALSE;
+  }
+
+  if (VariableIndex->Entries != NULL) {
+    CopyMem (Entries, VariableIndex->Entries, VariableIndex->EntryCount * sizeof (VARIABLE_INDEX_ENTRY));
+    FreePool (VariableIndex->Entries);
+  }
+  VariableIndex->Entries       = Entries;
+  VariableIndex->BucketHead    = (UINT32 *) (Entries + MaxEntryCount);
+  VariableIndex->BucketTail    = VariableIndex->BucketHead + MaxEntryCount;
+  VariableIndex->BucketMask    = MaxEntryCount - 1;
+  VariableIndex->MaxEntryCount = MaxEntryCount;
+
+  for (Index = 0; Index < VariableIndex->EntryCount; Index++) {
+    VariableIndexLinkEntry (VariableIndex, Index);
+  }
+
+  return TRUE;
+}
+
+/**
+  Get the index of a variable store, taking over the least recently used
+  index if the store is not indexed yet.
+
+  @param[in]  StartPtr      Pointer to the first variable of the store.
+
+  @return The index of the variable store.
+
+**/
+STATIC
+VARIABLE_INDEX *
+VariableIndexGetStore (
+  IN VARIABLE_HEADER    *StartPtr
+  )
+{
+  VARIABLE_INDEX  *VariableIndex;
+  UINTN           Index;
+
+  VariableIndex = &mVariableIndex[0];
+  for (Index = 0; Index < VARIABLE_INDEX_SLOT_COUNT; Index++) {
+    if (mVariableIndex[Index].StartPtr == StartPtr) {
+      VariableIndex = &mVariableIndex[Index];
+      break;
+    }
+    if (mVariableIndex[Index].LastUse < VariableIndex->LastUse) {
+      VariableIndex = &mVariableIndex[Index];
+    }
+  }
+
+  if (VariableIndex->StartPtr != StartPtr) {
+    VariableIndexReset (VariableIndex);
+    VariableIndex->StartPtr = StartPtr;
+  }
+  VariableIndex->LastUse = ++mVariableIndexUseCount;
+
+  return VariableIndex;
+}
+
+/**
+  Add the variables appended to a variable store since it was last indexed.
+
+  The state of a variable is not part of the index, so the variables whose
+  state was updated in place do not need to be indexed again.
+
+  @param[in, out]  VariableIndex  The variable store index.
+  @param[in]       EndPtr         Pointer to the end of the variable store.
+  @param[in]       AuthFormat     TRUE indicates authenticated variables are used.
+                                  FALSE indicates authenticated variables are not used.
+
+  @retval TRUE      All the variables of the store are indexed.
+  @retval FALSE     The index is full, the store must be searched linearly.
+
+**/
+STATIC
+BOOLEAN
+VariableIndexUpdate (
+  IN OUT VARIABLE_INDEX   *VariableIndex,
+  IN     VARIABLE_HEADER  *EndPtr,
+  IN     BOOLEAN          AuthFormat
+  )
+{
+  VARIABLE_HEADER       *Variable;
+  VARIABLE_INDEX_ENTRY  *Entry;
+  UINTN                 NameSize;
+
+  //
+  // The store was reclaimed behind our back if the last indexed variable is
+  // gone, start over.
+  //
+  if (VariableIndex->IndexedSize > (UINTN) EndPtr - (UINTN) VariableIndex->StartPtr ||
+      (VariableIndex->EntryCount > 0 &&
+       !IsValidVariableHeader (
+          (VARIABLE_HEADER *) ((UINTN) VariableIndex->StartPtr + VariableIndex->Entries[VariableIndex->EntryCount - 1].Offset),
+          EndPtr
+          ))) {
+    VariableIndexReset (VariableIndex);
+  }
+
+  if (VariableIndex->Overflow) {
+    return FALSE;
+  }
+
+  for ( Variable = (VARIABLE_HEADER *) ((UINTN) VariableIndex->StartPtr + VariableIndex->IndexedSize)
+      ; IsValidVariableHeader (Variable, EndPtr)
+      ; Variable = GetNextVariablePtr (Variable, AuthFormat)
+      ) {
+    NameSize = NameSizeOfVariable (Variable, AuthFormat);
+    if ((UINTN) GetVariableNamePtr (Variable, AuthFormat) + NameSize > (UINTN) EndPtr ||
+        (VariableIndex->EntryCount == VariableIndex->MaxEntryCount && !VariableIndexGrow (VariableIndex))) {
+      VariableIndex->Overflow = TRUE;
+      return FALSE;
+    }
+
+    Entry         = &VariableIndex->Entries[VariableIndex->EntryCount];
+    Entry->Offset = (UINT32) ((UINTN) Variable - (UINTN) VariableIndex->StartPtr);
+    Entry->Hash   = VariableIndexHash (
+                      GetVariableNamePtr (Variable, AuthFormat),
+                      NameSize,
+                      GetVendorGuidPtr (Variable, AuthFormat)
+                      );
+    VariableIndexLinkEntry (VariableIndex, VariableIndex->EntryCount);
+    VariableIndex->EntryCount++;
+  }
+  VariableIndex->IndexedSize = (UINTN) Variable - (UINTN) VariableIndex->StartPtr;
+
+  return TRUE;
+}
+
+/**
+  Find the variable in the specified variable store through the index of the
+  store. The variable found is the same as the one found by FindVariableEx()
+  walking the store.
+
+  @param[in]       VariableName        Name of the variable to be found, not an empty string.
+  @param[in]       VendorGuid          Vendor GUID to be found.
+  @param[in]       IgnoreRtCheck       Ignore EFI_VARIABLE_RUNTIME_ACCESS attribute
+                                       check at runtime when searching variable.
+  @param[in, out]  PtrTrack            Variable Track Pointer structure that contains Variable Information.
+  @param[in]       AuthFormat          TRUE indicates authenticated variables are used.
+                                       FALSE indicates authenticated variables are not used.
+
+  @retval          EFI_SUCCESS         Variable found successfully
+  @retval          EFI_NOT_FOUND       Variable not found
+  @retval          EFI_UNSUPPORTED     The store is not indexed, it must be walked.
+**/
+STATIC
+EFI_STATUS
+FindVariableInIndex (
+  IN     CHAR16                  *VariableName,
+  IN     EFI_GUID                *VendorGuid,
+  IN     BOOLEAN                 IgnoreRtCheck,
+  IN OUT VARIABLE_POINTER_TRACK  *PtrTrack,
+  IN     BOOLEAN                 AuthFormat
+  )
+{
+  VARIABLE_INDEX         *VariableIndex;
+  VARIABLE_INDEX_ENTRY   *Entry;
+  VARIABLE_HEADER        *Variable;
+  VARIABLE_HEADER        *InDeletedVariable;
+  UINT32                 EntryIndex;
+  UINT32                 Hash;
+
+  VariableIndex = VariableIndexGetStore (PtrTrack->StartPtr);
+  if (!VariableIndexUpdate (VariableIndex, PtrTrack->EndPtr, AuthFormat)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  InDeletedVariable = NULL;
+  if (VariableIndex->EntryCount > 0) {
+    Hash = VariableIndexHash (VariableName, StrSize (VariableName), VendorGuid);
+    for (EntryIndex = VariableIndex->BucketHead[Hash & VariableIndex->BucketMask]; EntryIndex != 0; EntryIndex = Entry->Next) {
+      Entry = &VariableIndex->Entries[EntryIndex - 1];
+      if (Entry->Hash != Hash) {
+        continue;
+      }
+
+      Variable = (VARIABLE_HEADER *) ((UINTN) PtrTrack->StartPtr + Entry->Offset);
+      if (Variable->State != VAR_ADDED &&
+          Variable->State != (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+        continue;
+      }
+      if (!IgnoreRtCheck && AtRuntime () && ((Variable->Attributes & EFI_VARIABLE_RUNTIME_ACCESS) == 0)) {
+        continue;
+      }
+      if (!CompareGuid (VendorGuid, GetVendorGuidPtr (Variable, AuthFormat)) ||
+          CompareMem (VariableName, GetVariableNamePtr (Variable, AuthFormat), NameSizeOfVariable (Variable, AuthFormat)) != 0) {
+        continue;
+      }
+
+      if (Variable->State == (VAR_IN_DELETED_TRANSITION & VAR_ADDED)) {
+        InDeletedVariable = Variable;
+      } else {
+        PtrTrack->CurrPtr                = Variable;
+        PtrTrack->InDeletedTransitionPtr = InDeletedVariable;
+        return EFI_SUCCESS;
+      }
+    }
+  }
+
+  PtrTrack->CurrPtr = InDeletedVariable;
+  return (PtrTrack->CurrPtr == NULL) ? EFI_NOT_FOUND : EFI_SUCCESS;
+}
+
+/**
+  Drop the index of all variable stores.
+
+  This must be called whenever variables are removed from or moved inside a
+  variable store, as by a reclaim, or when a variable store is freed. The
+  index of a store is rebuilt on the next search.
+
+**/
+VOID
+VariableIndexInvalidate (
+  VOID
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < VARIABLE_INDEX_SLOT_COUNT; Index++) {
+    VariableIndexReset (&mVariableIndex[Index]);
+    mVariableIndex[Index].StartPtr = NULL;
+  }
+}
+
+/**
+  Stop using the index of the variable stores, which are then always walked.
+
+  This must be called when a variable store may be reclaimed without
+  VariableIndexInvalidate() being called, as the index would then point to
+  other variables than the ones it was built from.
+
+**/
+VOID
+VariableIndexDisable (
+  VOID
+  )
+{
+  mVariableIndexDisabled = TRUE;
+  VariableIndexInvalidate ();
+}
+
+/**
+  Convert the pointers of the variable store index to virtual addresses.
+
+  The index of a variable store that is not runtime memory is dropped.
+
+  @param[in]  ConvertPointer    Function converting a pointer to a virtual address,
+                                EfiConvertPointer() in a runtime driver.
+
+**/
+VOID
+VariableIndexConvertPointers (
+  IN VARIABLE_INDEX_CONVERT_POINTER  ConvertPointer
+  )
+{
+  UINTN   Index;
+
+  for (Index = 0; Index < VARIABLE_INDEX_SLOT_COUNT; Index++) {
+    if (mVariableIndex[Index].StartPtr != NULL &&
+        EFI_ERROR (ConvertPointer (0x0, (VOID **) &mVariableIndex[Index].StartPtr))) {
+      VariableIndexReset (&mVariableIndex[Index]);
+      mVariableIndex[Index].StartPtr = NULL;
+    }
+    if (mVariableIndex[Index].Entries != NULL) {
+      ConvertPointer (0x0, (VOID **) &mVariableIndex[Index].BucketHead);
+      ConvertPointer (0x0, (VOID **) &mVariableIndex[Index].BucketTail);
+      ConvertPointer (0x0, (VOID **) &mVariableIndex[Index].Entries);
+    }
+  }
+}
+
 /**
   Find the variable in the specified variable store.
 
@@ -460,11 +886,19 @@ FindVariableEx (
   IN     BOOLEAN                 AuthFormat
   )
 {
+  EFI_STATUS                     Status;
   VARIABLE_HEADER                *InDeletedVariable;
   VOID                           *Point;
 
   PtrTrack->InDeletedTransitionPtr = NULL;
 
+  if (FeaturePcdGet (PcdVariableIndexEnable) && !mVariableIndexDisabled && VariableName[0] != 0) {
+    Status = FindVariableInIndex (VariableName, VendorGuid, IgnoreRtCheck, PtrTrack, AuthFormat);
+    if (Status != EFI_UNSUPPORTED) {
+      return Status;
+    }
+  }
+
   //
   // Find the variable by walk through HOB, volatile and non-volatile variable store.
   //
@@ -10,8 +10,27 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #ifndef _VARIABLE_PARSING_H_
 #define _VARIABLE_PARSING_H_
 
-#include <Guid/ImageAuthentication.h>
 #include "Variable.h"
+#include <Guid/ImageAuthentication.h>
+
+/**
+  Convert a pointer to a virtual address, as EfiConvertPointer() does.
+
+  @param[in]      DebugDisposition  Supplies type information for the pointer being converted.
+  @param[in, out] Address           The pointer to a pointer that is to be fixed to be the
+                                    value needed for the new virtual address mapping being
+                                    applied.
+
+  @retval EFI_SUCCESS     The pointer was converted.
+  @retval EFI_NOT_FOUND   The pointer is not part of the runtime memory map.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *VARIABLE_INDEX_CONVERT_POINTER) (
+  IN     UINTN  DebugDisposition,
+  IN OUT VOID   **Address
+  );
 
 /**
 
@@ -280,6 +299,46 @@ FindVariableEx (
   IN     BOOLEAN                 AuthFormat
   );
 
+/**
+  Drop the index of all variable stores.
+
+  This must be called whenever variables are removed from or moved inside a
+  variable store, as by a reclaim, or when a variable store is freed. The
+  index of a store is rebuilt on the next search.
+
+**/
+VOID
+VariableIndexInvalidate (
+  VOID
+  );
+
+/**
+  Stop using the index of the variable stores, which are then always walked.
+
+  This must be called when a variable store may be reclaimed without
+  VariableIndexInvalidate() being called, as the index would then point to
+  other variables than the ones it was built from.
+
+**/
+VOID
+VariableIndexDisable (
+  VOID
+  );
+
+/**
+  Convert the pointers of the variable store index to virtual addresses.
+
+  The index of a variable store that is not runtime memory is dropped.
+
+  @param[in]  ConvertPointer    Function converting a pointer to a virtual address,
+                                EfiConvertPointer() in a runtime driver.
+
+**/
+VOID
+VariableIndexConvertPointers (
+  IN VARIABLE_INDEX_CONVERT_POINTER  ConvertPointer
+  );
+
 /**
   This code finds the next available variable.
 
@@ -61,6 +61,8 @@ BOOLEAN                          mVariableRuntimeCachePendingUpdate;
 BOOLEAN                          mVariableRuntimeCacheReadLock;
 BOOLEAN                          mVariableAuthFormat;
 BOOLEAN                          mHobFlushComplete;
+UINT32                           mVariableRuntimeCacheReclaimCount;
+UINT32                           mVariableIndexReclaimCount;
 EFI_LOCK                         mVariableServicesLock;
 EDKII_VARIABLE_LOCK_PROTOCOL     mVariableLock;
 EDKII_VAR_CHECK_PROTOCOL         mVarCheck;
@@ -528,7 +530,8 @@ SyncRuntimeCache (
   Check whether a SMI must be triggered to retrieve pending cache updates.
 
   If the variable HOB was finished being flushed since the last check for a runtime cache update, this function
-  will prevent the HOB cache from being used for future runtime cache hits.
+  will prevent the HOB cache from being used for future runtime cache hits. If a variable store was reclaimed
+  since the last check, the index of the runtime caches is dropped.
 
 **/
 VOID
@@ -549,6 +552,12 @@ CheckForRuntimeCacheSync (
       FreePages (mVariableRuntimeHobCacheBuffer, EFI_SIZE_TO_PAGES (mVariableRuntimeHobCacheBufferSize));
     }
     mVariableRuntimeHobCacheBuffer = NULL;
+    VariableIndexInvalidate ();
+  }
+
+  if (mVariableIndexReclaimCount != mVariableRuntimeCacheReclaimCount) {
+    mVariableIndexReclaimCount = mVariableRuntimeCacheReclaimCount;
+    VariableIndexInvalidate ();
   }
 }
 
@@ -1313,6 +1322,7 @@ VariableAddressChangeEvent (
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeHobCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeNvCacheBuffer);
   EfiConvertPointer (EFI_OPTIONAL_PTR, (VOID **) &mVariableRuntimeVolatileCacheBuffer);
+  VariableIndexConvertPointers (EfiConvertPointer);
 }
 
 /**
@@ -1521,6 +1531,13 @@ SendRuntimeVariableCacheContextToSmm (
   SmmRuntimeVarCacheContext->PendingUpdate = &mVariableRuntimeCachePendingUpdate;
   SmmRuntimeVarCacheContext->ReadLock = &mVariableRuntimeCacheReadLock;
   SmmRuntimeVarCacheContext->HobFlushComplete = &mHobFlushComplete;
+  SmmRuntimeVarCacheContext->ReclaimCount = &mVariableRuntimeCacheReclaimCount;
+
+  //
+  // An SMM driver that counts the reclaims resets the count when it accepts
+  // the context. One built without it leaves it alone.
+  //
+  mVariableRuntimeCacheReclaimCount = MAX_UINT32;
 
   //
   // Send data to SMM.
@@ -1537,6 +1554,17 @@ SendRuntimeVariableCacheContextToSmm (
     goto Done;
   }
 
+  //
+  // The SMM driver updates the runtime caches directly when it reclaims a
+  // variable store. If it does not count the reclaims, the index of the
+  // runtime caches can't tell when to be dropped, so don't use it.
+  //
+  if (mVariableRuntimeCacheReclaimCount == MAX_UINT32) {
+    DEBUG ((DEBUG_INFO, "Variable SMM driver does not count reclaims, runtime cache index disabled.\n"));
+    VariableIndexDisable ();
+  }
+  mVariableIndexReclaimCount = mVariableRuntimeCacheReclaimCount;
+
 Done:
   ReleaseLockOnlyAtBootTime (&mVariableServicesLock);
   return Status;
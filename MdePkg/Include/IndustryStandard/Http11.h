@@ -76,6 +76,21 @@
 ///
 #define HTTP_HEADER_ACCEPT_RANGES      "Accept-Ranges"
 
+///
+/// Range Request Header
+/// The Range request-header field requests only the given byte ranges
+/// of the entity, e.g. "Range: bytes=0-499".
+///
+#define HTTP_HEADER_RANGE              "Range"
+
+///
+/// Content-Range Response Header
+/// The Content-Range entity-header field is sent with a partial entity-body
+/// to specify where in the full entity-body the partial body should be
+/// applied, e.g. "Content-Range: bytes 0-499/1234".
+///
+#define HTTP_HEADER_CONTENT_RANGE      "Content-Range"
+
 
 ///
 /// Accept-Encoding Request Header
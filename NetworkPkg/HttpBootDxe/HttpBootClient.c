@@ -580,21 +580,25 @@ HttpBootHttpIoCallback (
 }
 
 /**
-  Create a HttpIo instance for the file download.
+  Create a HttpIo instance on the HTTP service of the boot NIC.
 
   @param[in]    Private        The pointer to the driver's private data.
+  @param[in]    Callback       Callback function which will be invoked when specified
+                               HTTP_IO_CALLBACK_EVENT happened, could be NULL.
+  @param[out]   HttpIo         The HttpIo instance to be created.
 
   @retval EFI_SUCCESS          Successfully created.
   @retval Others               Failed to create HttpIo.
 
 **/
 EFI_STATUS
-HttpBootCreateHttpIo (
-  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+HttpBootCreateHttpIoInstance (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private,
+  IN     HTTP_IO_CALLBACK             Callback,
+     OUT HTTP_IO                      *HttpIo
   )
 {
   HTTP_IO_CONFIG_DATA          ConfigData;
-  EFI_STATUS                   Status;
   EFI_HANDLE                   ImageHandle;
 
   ASSERT (Private != NULL);
@@ -613,15 +617,36 @@ HttpBootCreateHttpIo (
     ImageHandle = Private->Ip6Nic->ImageHandle;
   }
 
-  Status = HttpIoCreateIo (
-             ImageHandle,
-             Private->Controller,
-             Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
-             &ConfigData,
-             HttpBootHttpIoCallback,
-             (VOID *) Private,
-             &Private->HttpIo
-             );
+  return HttpIoCreateIo (
+           ImageHandle,
+           Private->Controller,
+           Private->UsingIpv6 ? IP_VERSION_6 : IP_VERSION_4,
+           &ConfigData,
+           Callback,
+           (VOID *) Private,
+           HttpIo
+           );
+}
+
+/**
+  Create a HttpIo instance for the file download.
+
+  @param[in]    Private        The pointer to the driver's private data.
+
+  @retval EFI_SUCCESS          Successfully created.
+  @retval Others               Failed to create HttpIo.
+
+**/
+EFI_STATUS
+HttpBootCreateHttpIo (
+  IN     HTTP_BOOT_PRIVATE_DATA       *Private
+  )
+{
+  EFI_STATUS                   Status;
+
+  ASSERT (Private != NULL);
+
+  Status = HttpBootCreateHttpIoInstance (Private, HttpBootHttpIoCallback, &Private->HttpIo);
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -789,6 +814,48 @@ HttpBootGetFileFromCache (
   return EFI_NOT_FOUND;
 }
 
+/**
+  Report received entity data of the boot file to the HTTP Boot Callback Protocol.
+
+  The data already reported by a byte range download that fell back to a single
+  GET request is skipped, so each byte of the file is reported once.
+
+  @param[in]    Private            The pointer to the driver's private data.
+  @param[in]    Data               A pointer to the received data.
+  @param[in]    Length             Length in bytes of the Data.
+
+  @retval EFI_SUCCESS              Continue the download.
+  @retval Others                   The download is aborted by the HTTP Boot Callback Protocol.
+
+**/
+EFI_STATUS
+HttpBootReportEntityBody (
+  IN HTTP_BOOT_PRIVATE_DATA     *Private,
+  IN CHAR8                      *Data,
+  IN UINTN                      Length
+  )
+{
+  UINTN                         Skip;
+
+  if (Private->HttpBootCallback == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  Skip = MIN (Private->RangeReportedSize, Length);
+  Private->RangeReportedSize -= Skip;
+  if (Skip == Length) {
+    return EFI_SUCCESS;
+  }
+
+  return Private->HttpBootCallback->Callback (
+                                      Private->HttpBootCallback,
+                                      HttpBootHttpEntityBody,
+                                      TRUE,
+                                      (UINT32) (Length - Skip),
+                                      Data + Skip
+                                      );
+}
+
 /**
   A callback function to intercept events during message parser.
 
@@ -816,7 +883,6 @@ HttpBootGetBootFileCallback (
   HTTP_BOOT_CALLBACK_DATA      *CallbackData;
   HTTP_BOOT_ENTITY_DATA        *NewEntityData;
   EFI_STATUS                   Status;
-  EFI_HTTP_BOOT_CALLBACK_PROTOCOL   *HttpBootCallback;
 
   //
   // We only care about the entity data.
@@ -826,18 +892,9 @@ HttpBootGetBootFileCallback (
   }
 
   CallbackData = (HTTP_BOOT_CALLBACK_DATA *) Context;
-  HttpBootCallback = CallbackData->Private->HttpBootCallback;
-  if (HttpBootCallback != NULL) {
-    Status = HttpBootCallback->Callback (
-               HttpBootCallback,
-               HttpBootHttpEntityBody,
-               TRUE,
-               (UINT32)Length,
-               Data
-               );
-    if (EFI_ERROR (Status)) {
-      return Status;
-    }
+  Status = HttpBootReportEntityBody (CallbackData->Private, Data, Length);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
   //
   // Copy data if caller has provided a buffer.
@@ -870,6 +927,355 @@ HttpBootGetBootFileCallback (
   return EFI_SUCCESS;
 }
 
+/**
+  Send a GET request for a byte range of the boot file on one connection of a
+  segmented download, and queue the receive of the response header.
+
+  @param[in, out]  Connection      The connection to send the request on.
+  @param[in]       HttpIoHeader    The request headers, the Range header is updated.
+  @param[in]       RequestData     The request data of the GET request.
+  @param[in]       RangeStart      The offset of the first byte to request.
+  @param[in]       RangeLength     The number of bytes to request.
+
+  @retval EFI_SUCCESS              The request is sent and the response is queued.
+  @retval Others                   Unexpected error happened.
+
+**/
+EFI_STATUS
+HttpBootSendRangeRequest (
+  IN OUT HTTP_BOOT_RANGE_CONNECTION   *Connection,
+  IN     HTTP_IO_HEADER               *HttpIoHeader,
+  IN     EFI_HTTP_REQUEST_DATA        *RequestData,
+  IN     UINTN                        RangeStart,
+  IN     UINTN                        RangeLength
+  )
+{
+  EFI_STATUS                 Status;
+  CHAR8                      RangeValue[64];
+
+  AsciiSPrint (
+    RangeValue,
+    sizeof (RangeValue),
+    "bytes=%Lu-%Lu",
+    (UINT64) RangeStart,
+    (UINT64) (RangeStart + RangeLength - 1)
+    );
+  Status = HttpBootSetHeader (
+             HttpIoHeader,
+             HTTP_HEADER_RANGE,
+             RangeValue
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = HttpIoSendRequest (
+             &Connection->HttpIo,
+             RequestData,
+             HttpIoHeader->HeaderCount,
+             HttpIoHeader->Headers,
+             0,
+             NULL
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  ZeroMem (&Connection->ResponseData, sizeof (HTTP_IO_RESPONSE_DATA));
+  Status = HttpIoQueueResponse (
+             &Connection->HttpIo,
+             TRUE,
+             &Connection->ResponseData
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Connection->Busy           = TRUE;
+  Connection->HeaderReceived = FALSE;
+  Connection->RangeStart     = RangeStart;
+  Connection->RangeLength    = RangeLength;
+  Connection->ReceivedSize   = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Download the boot file over several HTTP connections at once, each of them
+  fetching byte ranges of the file (RFC7233) straight into the caller's buffer.
+
+  The file is split in ranges which are handed out to the connections as they
+  complete the previous ones, so a slow connection does not hold back the
+  whole download.
+
+  @param[in]       Private         The pointer to the driver's private data.
+  @param[in]       Url             The URL of the boot file.
+  @param[in]       FileSize        The size of the boot file learnt from the HEAD request.
+  @param[out]      Buffer          The memory buffer to transfer the file to, at least
+                                   FileSize bytes long.
+
+  @retval EFI_SUCCESS              The file was loaded.
+  @retval EFI_UNSUPPORTED          The file could not be loaded in byte ranges, because the
+                                   file is too small, the server doesn't honour the Range
+                                   header or the download failed. The caller should fall
+                                   back to a single GET request.
+  @retval Others                   The download was aborted by the HTTP Boot Callback Protocol.
+
+**/
+EFI_STATUS
+HttpBootGetBootFileRanges (
+  IN     HTTP_BOOT_PRIVATE_DATA   *Private,
+  IN     CHAR16                   *Url,
+  IN     UINTN                    FileSize,
+     OUT UINT8                    *Buffer
+  )
+{
+  EFI_STATUS                   Status;
+  EFI_STATUS                   CallbackStatus;
+  HTTP_BOOT_RANGE_CONNECTION   *Connections;
+  HTTP_BOOT_RANGE_CONNECTION   *Connection;
+  UINTN                        ConnectionCount;
+  UINTN                        Index;
+  UINTN                        RangeSize;
+  UINTN                        NextOffset;
+  UINTN                        ReceivedSize;
+  CHAR8                        *HostName;
+  HTTP_IO_HEADER               *HttpIoHeader;
+  EFI_HTTP_REQUEST_DATA        RequestData;
+  EFI_HTTP_HEADER              *Header;
+  UINTN                        First;
+  UINTN                        Last;
+  UINTN                        Length;
+
+  ConnectionCount = MIN (PcdGet8 (PcdHttpBootParallelConnections), FileSize / HTTP_BOOT_RANGE_MIN_SIZE);
+  if (ConnectionCount < 2) {
+    return EFI_UNSUPPORTED;
+  }
+  RangeSize = MAX (FileSize / (ConnectionCount * HTTP_BOOT_RANGES_PER_CONNECTION), HTTP_BOOT_RANGE_MIN_SIZE);
+
+  Connections = AllocateZeroPool (ConnectionCount * sizeof (HTTP_BOOT_RANGE_CONNECTION));
+  if (Connections == NULL) {
+    return EFI_UNSUPPORTED;
+  }
+  CallbackStatus = EFI_SUCCESS;
+
+  //
+  // Build the request headers shared by all the range requests:
+  //       Host
+  //       Accept
+  //       User-Agent
+  //       Range
+  //
+  HttpIoHeader = HttpBootCreateHeader (4);
+  if (HttpIoHeader == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto ON_EXIT;
+  }
+
+  HostName = NULL;
+  Status = HttpUrlGetHostName (
+             Private->BootFileUri,
+             Private->BootFileUriParser,
+             &HostName
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+  Status = HttpBootSetHeader (
+             HttpIoHeader,
+             HTTP_HEADER_HOST,
+             HostName
+             );
+  FreePool (HostName);
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = HttpBootSetHeader (
+             HttpIoHeader,
+             HTTP_HEADER_ACCEPT,
+             "*/*"
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  Status = HttpBootSetHeader (
+             HttpIoHeader,
+             HTTP_HEADER_USER_AGENT,
+             HTTP_USER_AGENT_EFI_HTTP_BOOT
+             );
+  if (EFI_ERROR (Status)) {
+    goto ON_EXIT;
+  }
+
+  RequestData.Method = HttpMethodGet;
+  RequestData.Url    = Url;
+
+  //
+  // Open the connections. They don't report to the HTTP Boot Callback Protocol
+  // through HttpBootHttpIoCallback(), since the Content-Length of a partial
+  // response is not the file size the callback expects.
+  //
+  for (Index = 0; Index < ConnectionCount; Index++) {
+    Status = HttpBootCreateHttpIoInstance (Private, NULL, &Connections[Index].HttpIo);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+    Connections[Index].Created = TRUE;
+  }
+  if (Index < 2) {
+    goto ON_EXIT;
+  }
+  ConnectionCount = Index;
+
+  //
+  // Send the first range request on each connection.
+  //
+  NextOffset = 0;
+  for (Index = 0; Index < ConnectionCount && NextOffset < FileSize; Index++) {
+    Status = HttpBootSendRangeRequest (
+               &Connections[Index],
+               HttpIoHeader,
+               &RequestData,
+               NextOffset,
+               MIN (RangeSize, FileSize - NextOffset)
+               );
+    if (EFI_ERROR (Status)) {
+      goto ON_EXIT;
+    }
+    NextOffset += Connections[Index].RangeLength;
+  }
+
+  //
+  // Poll all the connections in turn, and queue the next receive or the next
+  // range request on each connection whose previous one completed.
+  //
+  ReceivedSize = 0;
+  while (ReceivedSize < FileSize) {
+    for (Index = 0; Index < ConnectionCount; Index++) {
+      Connection = &Connections[Index];
+      if (!Connection->Busy) {
+        continue;
+      }
+
+      Status = HttpIoPollResponse (&Connection->HttpIo, &Connection->ResponseData);
+      if (Status == EFI_NOT_READY) {
+        continue;
+      }
+      if (EFI_ERROR (Status) || EFI_ERROR (Connection->ResponseData.Status)) {
+        if (!EFI_ERROR (Status)) {
+          Status = Connection->ResponseData.Status;
+        }
+        goto ON_EXIT;
+      }
+
+      if (!Connection->HeaderReceived) {
+        //
+        // The server must answer with exactly the requested range of a file of
+        // the expected size, otherwise it ignores the Range header or the file
+        // has changed since the HEAD request.
+        //
+        Header = NULL;
+        if (Connection->ResponseData.Response.StatusCode == HTTP_STATUS_206_PARTIAL_CONTENT) {
+          Header = HttpFindHeader (
+                     Connection->ResponseData.HeaderCount,
+                     Connection->ResponseData.Headers,
+                     HTTP_HEADER_CONTENT_RANGE
+                     );
+        }
+        if (Header == NULL ||
+            EFI_ERROR (HttpBootParseContentRange (Header->FieldValue, &First, &Last, &Length)) ||
+            First != Connection->RangeStart ||
+            Last != Connection->RangeStart + Connection->RangeLength - 1 ||
+            Length != FileSize) {
+          Status = EFI_UNSUPPORTED;
+        }
+        if (Connection->ResponseData.Headers != NULL) {
+          HttpFreeHeaderFields (Connection->ResponseData.Headers, Connection->ResponseData.HeaderCount);
+          Connection->ResponseData.Headers     = NULL;
+          Connection->ResponseData.HeaderCount = 0;
+        }
+        if (EFI_ERROR (Status)) {
+          goto ON_EXIT;
+        }
+        Connection->HeaderReceived = TRUE;
+      } else {
+        Connection->ReceivedSize += Connection->ResponseData.BodyLength;
+        ReceivedSize             += Connection->ResponseData.BodyLength;
+        if (Private->HttpBootCallback != NULL) {
+          CallbackStatus = Private->HttpBootCallback->Callback (
+                                      Private->HttpBootCallback,
+                                      HttpBootHttpEntityBody,
+                                      TRUE,
+                                      (UINT32) Connection->ResponseData.BodyLength,
+                                      Connection->ResponseData.Body
+                                      );
+          if (EFI_ERROR (CallbackStatus)) {
+            Status = CallbackStatus;
+            goto ON_EXIT;
+          }
+          Private->RangeReportedSize += Connection->ResponseData.BodyLength;
+        }
+      }
+
+      if (Connection->ReceivedSize < Connection->RangeLength) {
+        //
+        // Receive the rest of the range straight into its place in the buffer.
+        //
+        Connection->ResponseData.Body       = (CHAR8 *) Buffer + Connection->RangeStart + Connection->ReceivedSize;
+        Connection->ResponseData.BodyLength = Connection->RangeLength - Connection->ReceivedSize;
+        Status = HttpIoQueueResponse (
+                   &Connection->HttpIo,
+                   FALSE,
+                   &Connection->ResponseData
+                   );
+      } else if (NextOffset < FileSize) {
+        Status = HttpBootSendRangeRequest (
+                   Connection,
+                   HttpIoHeader,
+                   &RequestData,
+                   NextOffset,
+                   MIN (RangeSize, FileSize - NextOffset)
+                   );
+        NextOffset += Connection->RangeLength;
+      } else {
+        Connection->Busy = FALSE;
+        Status = EFI_SUCCESS;
+      }
+      if (EFI_ERROR (Status)) {
+        goto ON_EXIT;
+      }
+    }
+  }
+
+ON_EXIT:
+  for (Index = 0; Index < ConnectionCount; Index++) {
+    Connection = &Connections[Index];
+    if (!Connection->Created) {
+      continue;
+    }
+    if (Connection->Busy) {
+      gBS->SetTimer (Connection->HttpIo.TimeoutEvent, TimerCancel, 0);
+      Connection->HttpIo.Http->Cancel (Connection->HttpIo.Http, NULL);
+    }
+    HttpIoDestroyIo (&Connection->HttpIo);
+  }
+  FreePool (Connections);
+
+  if (HttpIoHeader != NULL) {
+    HttpBootFreeHeader (HttpIoHeader);
+  }
+
+  if (EFI_ERROR (Status) && Status != CallbackStatus) {
+    DEBUG ((DEBUG_INFO, "HttpBootGetBootFileRanges: %r, fall back to a single GET request.\n", Status));
+    Status = EFI_UNSUPPORTED;
+  } else {
+    Private->RangeReportedSize = 0;
+  }
+
+  return Status;
+}
+
 /**
   This function download the boot file by using UEFI HTTP protocol.
 
@@ -920,6 +1326,7 @@ HttpBootGetBootFile (
   CHAR16                     *Url;
   BOOLEAN                    IdentityMode;
   UINTN                      ReceivedSize;
+  EFI_HTTP_HEADER            *Header;
 
   ASSERT (Private != NULL);
   ASSERT (Private->HttpCreated);
@@ -949,6 +1356,24 @@ HttpBootGetBootFile (
     }
   }
 
+  //
+  // Download the file over several connections in byte ranges if the server
+  // accepts them, or with a single GET request otherwise.
+  //
+  Private->RangeReportedSize = 0;
+  if (!HeaderOnly && Buffer != NULL && Private->BootFileAcceptRanges &&
+      Private->BootFileSize != 0 && *BufferSize >= Private->BootFileSize) {
+    Status = HttpBootGetBootFileRanges (Private, Url, Private->BootFileSize, Buffer);
+    if (Status != EFI_UNSUPPORTED) {
+      if (!EFI_ERROR (Status)) {
+        *BufferSize = Private->BootFileSize;
+        *ImageType  = Private->ImageType;
+      }
+      FreePool (Url);
+      return Status;
+    }
+  }
+
   //
   // Not found in cache, try to download it through HTTP.
   //
@@ -1103,6 +1528,19 @@ HttpBootGetBootFile (
     goto ERROR_5;
   }
 
+  //
+  // Remember whether the server accepts byte range requests for the file,
+  // so that it can be downloaded over several connections.
+  //
+  if (HeaderOnly) {
+    Header = HttpFindHeader (
+               ResponseData->HeaderCount,
+               ResponseData->Headers,
+               HTTP_HEADER_ACCEPT_RANGES
+               );
+    Private->BootFileAcceptRanges = (BOOLEAN) (Header != NULL && AsciiStrStr (Header->FieldValue, "bytes") != NULL);
+  }
+
   //
   // 3.2 Cache the response header.
   //
@@ -1177,17 +1615,9 @@ HttpBootGetBootFile (
           goto ERROR_6;
         }
         ReceivedSize += ResponseBody.BodyLength;
-        if (Private->HttpBootCallback != NULL) {
-          Status = Private->HttpBootCallback->Callback (
-                     Private->HttpBootCallback,
-                     HttpBootHttpEntityBody,
-                     TRUE,
-                     (UINT32)ResponseBody.BodyLength,
-                     ResponseBody.Body
-                     );
-          if (EFI_ERROR (Status)) {
-            goto ERROR_6;
-          }
+        Status = HttpBootReportEntityBody (Private, ResponseBody.Body, ResponseBody.BodyLength);
+        if (EFI_ERROR (Status)) {
+          goto ERROR_6;
         }
       }
     } else {
@@ -14,6 +14,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define HTTP_BOOT_RESPONSE_TIMEOUT           5000      // 5 seconds in uints of millisecond.
 #define HTTP_BOOT_BLOCK_SIZE                 1500
 
+//
+// A boot file is only downloaded in byte ranges if each connection gets at
+// least this much of it, and is split in this many ranges per connection so
+// that faster connections pick up the remaining work.
+//
+#define HTTP_BOOT_RANGE_MIN_SIZE             SIZE_1MB
+#define HTTP_BOOT_RANGES_PER_CONNECTION      4
+
 
 
 #define HTTP_USER_AGENT_EFI_HTTP_BOOT        "UefiHttpBoot/1.0"
@@ -40,6 +48,20 @@ typedef struct {
   LIST_ENTRY                 EntityDataList;  // Entity data (message-body)
 } HTTP_BOOT_CACHE_CONTENT;
 
+//
+// State of one connection of a segmented (byte range) boot file download.
+//
+typedef struct {
+  HTTP_IO                    HttpIo;
+  BOOLEAN                    Created;
+  BOOLEAN                    Busy;            // A range request is outstanding.
+  BOOLEAN                    HeaderReceived;  // The 206 header of the range is received.
+  UINTN                      RangeStart;
+  UINTN                      RangeLength;
+  UINTN                      ReceivedSize;
+  HTTP_IO_RESPONSE_DATA      ResponseData;
+} HTTP_BOOT_RANGE_CONNECTION;
+
 //
 // Callback data for HTTP_BODY_PARSER_CALLBACK()
 //
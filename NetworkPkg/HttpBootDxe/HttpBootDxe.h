@@ -183,6 +183,12 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   UINT64                                    ReceivedSize;
   UINT32                                    Percentage;
 
+  //
+  // Size of the boot file already reported to the HTTP Boot Callback Protocol
+  // by a byte range download that fell back to a single GET request
+  //
+  UINTN                                     RangeReportedSize;
+
   //
   // HII callback info block
   //
@@ -208,6 +214,7 @@ struct _HTTP_BOOT_PRIVATE_DATA {
   CHAR8                                     *BootFileUri;
   VOID                                      *BootFileUriParser;
   UINTN                                     BootFileSize;
+  BOOLEAN                                   BootFileAcceptRanges;
   BOOLEAN                                   NoGateway;
   HTTP_BOOT_IMAGE_TYPE                      ImageType;
 
@@ -455,6 +455,7 @@ HttpBootStop (
   Private->BootFileUri = NULL;
   Private->BootFileUriParser = NULL;
   Private->BootFileSize = 0;
+  Private->BootFileAcceptRanges = FALSE;
   Private->SelectIndex = 0;
   Private->SelectProxyType = HttpOfferTypeMax;
 
@@ -719,8 +720,14 @@ HttpBootCallback (
                      );
       if (HttpHeader != NULL) {
         Private->FileSize = AsciiStrDecimalToUintn (HttpHeader->FieldValue);
-        Private->ReceivedSize = 0;
-        Private->Percentage   = 0;
+        //
+        // A GET request that takes over from a byte range download only
+        // reports the rest of the file, so the progress carries on.
+        //
+        if (Private->RangeReportedSize == 0) {
+          Private->ReceivedSize = 0;
+          Private->Percentage   = 0;
+        }
       }
     }
     break;
@@ -944,25 +944,26 @@ HttpIoSendRequest (
 }
 
 /**
-  Synchronously receive a HTTP RESPONSE message from the server.
+  Queue a request to receive a HTTP RESPONSE message from the server, without
+  waiting for it to complete. The caller must call HttpIoPollResponse() until
+  it returns a value other than EFI_NOT_READY.
 
   @param[in]   HttpIo           The HttpIo wrapping the HTTP service.
   @param[in]   RecvMsgHeader    TRUE to receive a new HTTP response (from message header).
                                 FALSE to continue receive the previous response message.
-  @param[out]  ResponseData     Point to a wrapper of the received response data.
+  @param[in]   ResponseData     Point to a wrapper of the response data. Body and
+                                BodyLength describe the buffer to receive the body.
 
-  @retval EFI_SUCCESS            The HTTP response is received.
+  @retval EFI_SUCCESS            The receive request is queued.
   @retval EFI_INVALID_PARAMETER  One or more parameters are invalid.
-  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
-  @retval EFI_DEVICE_ERROR       An unexpected network or system error occurred.
   @retval Others                 Other errors as indicated.
 
 **/
 EFI_STATUS
-HttpIoRecvResponse (
+HttpIoQueueResponse (
   IN      HTTP_IO                  *HttpIo,
   IN      BOOLEAN                  RecvMsgHeader,
-     OUT  HTTP_IO_RESPONSE_DATA    *ResponseData
+  IN      HTTP_IO_RESPONSE_DATA    *ResponseData
   )
 {
   EFI_STATUS                 Status;
@@ -1006,11 +1007,42 @@ HttpIoRecvResponse (
     return Status;
   }
 
-  //
-  // Poll the network until receive finish.
-  //
-  while (!HttpIo->IsRxDone && ((HttpIo->TimeoutEvent == NULL) || EFI_ERROR (gBS->CheckEvent (HttpIo->TimeoutEvent)))) {
+  return EFI_SUCCESS;
+}
+
+/**
+  Poll the network once for the HTTP RESPONSE message queued by
+  HttpIoQueueResponse().
+
+  @param[in]   HttpIo           The HttpIo wrapping the HTTP service.
+  @param[out]  ResponseData     Point to a wrapper of the received response data.
+
+  @retval EFI_SUCCESS            The HTTP response is received.
+  @retval EFI_NOT_READY          The HTTP response has not been received yet.
+  @retval EFI_TIMEOUT            No response arrived in time, the request is cancelled.
+  @retval EFI_INVALID_PARAMETER  One or more parameters are invalid.
+  @retval Others                 Other errors as indicated.
+
+**/
+EFI_STATUS
+HttpIoPollResponse (
+  IN      HTTP_IO                  *HttpIo,
+     OUT  HTTP_IO_RESPONSE_DATA    *ResponseData
+  )
+{
+  EFI_STATUS                 Status;
+  EFI_HTTP_PROTOCOL          *Http;
+
+  if (HttpIo == NULL || HttpIo->Http == NULL || ResponseData == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Http = HttpIo->Http;
+  if (!HttpIo->IsRxDone && ((HttpIo->TimeoutEvent == NULL) || EFI_ERROR (gBS->CheckEvent (HttpIo->TimeoutEvent)))) {
     Http->Poll (Http);
+    if (!HttpIo->IsRxDone) {
+      return EFI_NOT_READY;
+    }
   }
 
   gBS->SetTimer (HttpIo->TimeoutEvent, TimerCancel, 0);
@@ -1028,6 +1060,7 @@ HttpIoRecvResponse (
     HttpIo->IsRxDone = FALSE;
   }
 
+  Status = EFI_SUCCESS;
   if ((HttpIo->Callback != NULL) &&
       (HttpIo->RspToken.Status == EFI_SUCCESS || HttpIo->RspToken.Status == EFI_HTTP_ERROR)) {
     Status = HttpIo->Callback (
@@ -1051,6 +1084,100 @@ HttpIoRecvResponse (
   return Status;
 }
 
+/**
+  Synchronously receive a HTTP RESPONSE message from the server.
+
+  @param[in]   HttpIo           The HttpIo wrapping the HTTP service.
+  @param[in]   RecvMsgHeader    TRUE to receive a new HTTP response (from message header).
+                                FALSE to continue receive the previous response message.
+  @param[out]  ResponseData     Point to a wrapper of the received response data.
+
+  @retval EFI_SUCCESS            The HTTP response is received.
+  @retval EFI_INVALID_PARAMETER  One or more parameters are invalid.
+  @retval EFI_OUT_OF_RESOURCES   Failed to allocate memory.
+  @retval EFI_DEVICE_ERROR       An unexpected network or system error occurred.
+  @retval Others                 Other errors as indicated.
+
+**/
+EFI_STATUS
+HttpIoRecvResponse (
+  IN      HTTP_IO                  *HttpIo,
+  IN      BOOLEAN                  RecvMsgHeader,
+     OUT  HTTP_IO_RESPONSE_DATA    *ResponseData
+  )
+{
+  EFI_STATUS                 Status;
+
+  Status = HttpIoQueueResponse (HttpIo, RecvMsgHeader, ResponseData);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  //
+  // Poll the network until receive finish.
+  //
+  do {
+    Status = HttpIoPollResponse (HttpIo, ResponseData);
+  } while (Status == EFI_NOT_READY);
+
+  return Status;
+}
+
+/**
+  Parse the value of a Content-Range header in the "bytes first-last/length"
+  form, see section 4.2 of RFC7233.
+
+  @param[in]   FieldValue       The value of the Content-Range header.
+  @param[out]  First            The offset of the first byte in the range.
+  @param[out]  Last             The offset of the last byte in the range.
+  @param[out]  Length           The complete length of the representation.
+
+  @retval EFI_SUCCESS            The header value is parsed.
+  @retval EFI_INVALID_PARAMETER  The header value is not a satisfied byte range.
+
+**/
+EFI_STATUS
+HttpBootParseContentRange (
+  IN      CHAR8                  *FieldValue,
+     OUT  UINTN                  *First,
+     OUT  UINTN                  *Last,
+     OUT  UINTN                  *Length
+  )
+{
+  CHAR8                *Ptr;
+
+  if (AsciiStrnCmp (FieldValue, "bytes ", AsciiStrLen ("bytes ")) != 0) {
+    return EFI_INVALID_PARAMETER;
+  }
+  Ptr = FieldValue + AsciiStrLen ("bytes ");
+
+  if (*Ptr < '0' || *Ptr > '9' ||
+      RETURN_ERROR (AsciiStrDecimalToUintnS (Ptr, &Ptr, First)) || *Ptr != '-') {
+    return EFI_INVALID_PARAMETER;
+  }
+  Ptr++;
+
+  if (*Ptr < '0' || *Ptr > '9' ||
+      RETURN_ERROR (AsciiStrDecimalToUintnS (Ptr, &Ptr, Last)) || *Ptr != '/') {
+    return EFI_INVALID_PARAMETER;
+  }
+  Ptr++;
+
+  //
+  // An unknown complete length ("*") is not usable for a segmented download.
+  //
+  if (*Ptr < '0' || *Ptr > '9' ||
+      RETURN_ERROR (AsciiStrDecimalToUintnS (Ptr, &Ptr, Length)) || *Ptr != '\0') {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (*First > *Last || *Last >= *Length) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
   This function checks the HTTP(S) URI scheme.
 
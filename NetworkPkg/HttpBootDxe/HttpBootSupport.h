@@ -359,6 +359,70 @@ HttpIoRecvResponse (
      OUT  HTTP_IO_RESPONSE_DATA    *ResponseData
   );
 
+/**
+  Queue a request to receive a HTTP RESPONSE message from the server, without
+  waiting for it to complete. The caller must call HttpIoPollResponse() until
+  it returns a value other than EFI_NOT_READY.
+
+  @param[in]   HttpIo           The HttpIo wrapping the HTTP service.
+  @param[in]   RecvMsgHeader    TRUE to receive a new HTTP response (from message header).
+                                FALSE to continue receive the previous response message.
+  @param[in]   ResponseData     Point to a wrapper of the response data. Body and
+                                BodyLength describe the buffer to receive the body.
+
+  @retval EFI_SUCCESS            The receive request is queued.
+  @retval EFI_INVALID_PARAMETER  One or more parameters are invalid.
+  @retval Others                 Other errors as indicated.
+
+**/
+EFI_STATUS
+HttpIoQueueResponse (
+  IN      HTTP_IO                  *HttpIo,
+  IN      BOOLEAN                  RecvMsgHeader,
+  IN      HTTP_IO_RESPONSE_DATA    *ResponseData
+  );
+
+/**
+  Poll the network once for the HTTP RESPONSE message queued by
+  HttpIoQueueResponse().
+
+  @param[in]   HttpIo           The HttpIo wrapping the HTTP service.
+  @param[out]  ResponseData     Point to a wrapper of the received response data.
+
+  @retval EFI_SUCCESS            The HTTP response is received.
+  @retval EFI_NOT_READY          The HTTP response has not been received yet.
+  @retval EFI_TIMEOUT            No response arrived in time, the request is cancelled.
+  @retval EFI_INVALID_PARAMETER  One or more parameters are invalid.
+  @retval Others                 Other errors as indicated.
+
+**/
+EFI_STATUS
+HttpIoPollResponse (
+  IN      HTTP_IO                  *HttpIo,
+     OUT  HTTP_IO_RESPONSE_DATA    *ResponseData
+  );
+
+/**
+  Parse the value of a Content-Range header in the "bytes first-last/length"
+  form, see section 4.2 of RFC7233.
+
+  @param[in]   FieldValue       The value of the Content-Range header.
+  @param[out]  First            The offset of the first byte in the range.
+  @param[out]  Last             The offset of the last byte in the range.
+  @param[out]  Length           The complete length of the representation.
+
+  @retval EFI_SUCCESS            The header value is parsed.
+  @retval EFI_INVALID_PARAMETER  The header value is not a satisfied byte range.
+
+**/
+EFI_STATUS
+HttpBootParseContentRange (
+  IN      CHAR8                  *FieldValue,
+     OUT  UINTN                  *First,
+     OUT  UINTN                  *Last,
+     OUT  UINTN                  *Length
+  );
+
 /**
   This function checks the HTTP(S) URI scheme.
 
@@ -14,6 +14,8 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 
+#include "NetChecksum.h"
+
 
 /**
   Allocate and build up the sketch for a NET_BUF.
@@ -1655,10 +1657,23 @@ NetblockChecksum (
   IN UINT32                 Len
   )
 {
-  register UINT32           Sum;
+  UINT64                    Sum;
+  UINT32                    BlockLen;
 
   Sum = 0;
 
+  //
+  // Sum the bulk of the data with the architecture's vector kernel, in blocks
+  // small enough for its partial sums not to overflow. The blocks are an even
+  // number of bytes, so the words of the rest keep their position.
+  //
+  while (Len >= NET_CHECKSUM_BLOCK_ALIGN) {
+    BlockLen = MIN (Len, NET_CHECKSUM_MAX_BLOCK) & ~(NET_CHECKSUM_BLOCK_ALIGN - 1);
+    Sum     += InternalNetblockChecksum (Bulk, BlockLen);
+    Bulk    += BlockLen;
+    Len     -= BlockLen;
+  }
+
   //
   // Add left-over byte, if any
   //
@@ -1673,11 +1688,12 @@ NetblockChecksum (
   }
 
   //
-  // Fold 32-bit sum to 16 bits
+  // Fold 64-bit sum to 16 bits
   //
-  while ((Sum >> 16) != 0) {
-    Sum = (Sum & 0xffff) + (Sum >> 16);
-
+  Sum = (Sum & 0xffffffff) + RShiftU64 (Sum, 32);
+  Sum = (Sum & 0xffffffff) + RShiftU64 (Sum, 32);
+  while (RShiftU64 (Sum, 16) != 0) {
+    Sum = (Sum & 0xffff) + RShiftU64 (Sum, 16);
   }
 
   return (UINT16) Sum;
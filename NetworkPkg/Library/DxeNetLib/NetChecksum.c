@@ -0,0 +1,54 @@
+/** @file
+  Generic C Internet checksum kernel of DxeNetLib.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+
+#include "NetChecksum.h"
+
+/**
+  Sum the 16-bit words of a block of data, without folding the carries.
+
+  @param[in]   Bulk                  Pointer to the data.
+  @param[in]   Len                   Length of the data in bytes, a multiple of
+                                     NET_CHECKSUM_BLOCK_ALIGN and at most
+                                     NET_CHECKSUM_MAX_BLOCK.
+
+  @return    The sum of the 16-bit words of the data.
+
+**/
+UINT64
+EFIAPI
+InternalNetblockChecksum (
+  IN CONST UINT8            *Bulk,
+  IN UINTN                  Len
+  )
+{
+  UINT32                    Sum0;
+  UINT32                    Sum1;
+  UINT32                    Sum2;
+  UINT32                    Sum3;
+
+  //
+  // Four independent accumulators to keep the adds out of one dependency
+  // chain, none of them can overflow within NET_CHECKSUM_MAX_BLOCK bytes.
+  //
+  Sum0 = 0;
+  Sum1 = 0;
+  Sum2 = 0;
+  Sum3 = 0;
+
+  while (Len >= 8) {
+    Sum0 += ((CONST UINT16 *) Bulk)[0];
+    Sum1 += ((CONST UINT16 *) Bulk)[1];
+    Sum2 += ((CONST UINT16 *) Bulk)[2];
+    Sum3 += ((CONST UINT16 *) Bulk)[3];
+    Bulk += 8;
+    Len  -= 8;
+  }
+
+  return (UINT64) Sum0 + Sum1 + Sum2 + Sum3;
+}
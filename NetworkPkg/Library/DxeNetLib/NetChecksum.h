@@ -0,0 +1,40 @@
+/** @file
+  Internal definitions of the Internet checksum kernels of DxeNetLib.
+
+Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _NET_CHECKSUM_H_
+#define _NET_CHECKSUM_H_
+
+//
+// InternalNetblockChecksum() works on blocks which are a multiple of
+// NET_CHECKSUM_BLOCK_ALIGN bytes long, and at most NET_CHECKSUM_MAX_BLOCK
+// bytes so that its 32-bit partial sums cannot overflow.
+//
+#define NET_CHECKSUM_BLOCK_ALIGN    64
+#define NET_CHECKSUM_MAX_BLOCK      SIZE_256KB
+
+/**
+  Sum the 16-bit words of a block of data, without folding the carries.
+
+  The X64 and AARCH64 versions use SSE2 and NEON, the generic C version
+  serves the other architectures.
+
+  @param[in]   Bulk                  Pointer to the data, need not be aligned.
+  @param[in]   Len                   Length of the data in bytes, a multiple of
+                                     NET_CHECKSUM_BLOCK_ALIGN and at most
+                                     NET_CHECKSUM_MAX_BLOCK.
+
+  @return    The sum of the 16-bit words of the data.
+
+**/
+UINT64
+EFIAPI
+InternalNetblockChecksum (
+  IN CONST UINT8            *Bulk,
+  IN UINTN                  Len
+  );
+
+#endif
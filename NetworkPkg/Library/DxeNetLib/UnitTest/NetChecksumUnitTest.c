@@ -0,0 +1,442 @@
+/** @file
+  Unit tests of the Internet checksum of DxeNetLib.
+
+  NetblockChecksum(), NetbufChecksum() and the checksum kernel they are
+  linked with are checked against a plain 16-bit word sum of the same
+  data, for odd lengths, misaligned buffers, lengths around the block sizes
+  of the kernel and data that makes the sum carry a lot.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/NetLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../NetChecksum.h"
+
+#define UNIT_TEST_APP_NAME        "DxeNetLib Checksum Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Data buffer of the tests, large enough for several kernel blocks and the
+// misalignment offsets
+//
+#define TEST_BUFFER_SIZE          (3 * NET_CHECKSUM_MAX_BLOCK + 0x100)
+#define TEST_MAX_MISALIGNMENT     16
+#define TEST_RANDOM_LENGTHS       2000
+#define TEST_FRAGMENT_COUNT       7
+
+//
+// NetBuffer.c refers to the boot services for its queue functions, which
+// the checksum tests don't use.
+//
+EFI_BOOT_SERVICES   *gBS = NULL;
+
+STATIC UINT8        *mBuffer;
+STATIC UINT32       mRandomState;
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Compute the Internet checksum of a block of data one 16-bit word at a time.
+
+  @param  Bulk                  Pointer to the data.
+  @param  Len                   Length of the data in bytes.
+
+  @return The folded 16-bit sum of the data, as NetblockChecksum() returns it.
+
+**/
+STATIC
+UINT16
+TestReferenceChecksum (
+  IN CONST UINT8        *Bulk,
+  IN UINTN              Len
+  )
+{
+  UINT64  Sum;
+  UINTN   Index;
+
+  Sum = 0;
+  for (Index = 0; Index + 1 < Len; Index += 2) {
+    Sum += ReadUnaligned16 ((CONST UINT16 *) (Bulk + Index));
+  }
+
+  if ((Len & 1) != 0) {
+    Sum += Bulk[Len - 1];
+  }
+
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+
+  return (UINT16) Sum;
+}
+
+/**
+  Sum the 16-bit words of a block of data without folding.
+
+  @param  Bulk                  Pointer to the data.
+  @param  Len                   Length of the data in bytes, an even number.
+
+  @return The sum of the 16-bit words of the data.
+
+**/
+STATIC
+UINT64
+TestReferenceSum (
+  IN CONST UINT8        *Bulk,
+  IN UINTN              Len
+  )
+{
+  UINT64  Sum;
+  UINTN   Index;
+
+  Sum = 0;
+  for (Index = 0; Index < Len; Index += 2) {
+    Sum += ReadUnaligned16 ((CONST UINT16 *) (Bulk + Index));
+  }
+
+  return Sum;
+}
+
+/**
+  Fill the test buffer with random data.
+
+  @param  Context               - Not used.
+
+  @retval UNIT_TEST_PASSED      - The buffer is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET - The buffer could not be allocated.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FillRandomBuffer (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Index;
+
+  mBuffer = AllocatePool (TEST_BUFFER_SIZE);
+  if (mBuffer == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  mRandomState = 0x13;
+  for (Index = 0; Index < TEST_BUFFER_SIZE; Index++) {
+    mBuffer[Index] = (UINT8) TestRandom ();
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Fill the test buffer with 0xFF bytes, which gives the largest sums and
+  the most carries.
+
+  @param  Context               - Not used.
+
+  @retval UNIT_TEST_PASSED      - The buffer is ready.
+  @retval UNIT_TEST_ERROR_PREREQUISITE_NOT_MET - The buffer could not be allocated.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+FillOnesBuffer (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mBuffer = AllocatePool (TEST_BUFFER_SIZE);
+  if (mBuffer == NULL) {
+    return UNIT_TEST_ERROR_PREREQUISITE_NOT_MET;
+  }
+
+  SetMem (mBuffer, TEST_BUFFER_SIZE, 0xFF);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free the test buffer.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+FreeBuffer (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FreePool (mBuffer);
+  mBuffer = NULL;
+}
+
+/**
+  The checksum of random data of random length and alignment must match the
+  reference checksum.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+RandomBlocksShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Index;
+  UINTN   Offset;
+  UINTN   Len;
+
+  for (Index = 0; Index < TEST_RANDOM_LENGTHS; Index++) {
+    Offset = TestRandom () % TEST_MAX_MISALIGNMENT;
+    Len    = TestRandom () % 0x1000;
+    UT_ASSERT_EQUAL (
+      NetblockChecksum (mBuffer + Offset, (UINT32) Len),
+      TestReferenceChecksum (mBuffer + Offset, Len)
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The checksum of lengths around the block sizes of the kernel, at every
+  misalignment, must match the reference checksum.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BlockBoundariesShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINTN  Lengths[] = {
+    0, 1, 2, 3,
+    NET_CHECKSUM_BLOCK_ALIGN - 1,
+    NET_CHECKSUM_BLOCK_ALIGN,
+    NET_CHECKSUM_BLOCK_ALIGN + 1,
+    2 * NET_CHECKSUM_BLOCK_ALIGN - 1,
+    2 * NET_CHECKSUM_BLOCK_ALIGN + 3,
+    1500,
+    NET_CHECKSUM_MAX_BLOCK - 1,
+    NET_CHECKSUM_MAX_BLOCK,
+    NET_CHECKSUM_MAX_BLOCK + 1,
+    NET_CHECKSUM_MAX_BLOCK + NET_CHECKSUM_BLOCK_ALIGN + 1,
+    3 * NET_CHECKSUM_MAX_BLOCK - 1
+  };
+  UINTN               Index;
+  UINTN               Offset;
+
+  for (Index = 0; Index < ARRAY_SIZE (Lengths); Index++) {
+    for (Offset = 0; Offset < TEST_MAX_MISALIGNMENT; Offset++) {
+      UT_ASSERT_EQUAL (
+        NetblockChecksum (mBuffer + Offset, (UINT32) Lengths[Index]),
+        TestReferenceChecksum (mBuffer + Offset, Lengths[Index])
+        );
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The kernel must return the exact unfolded sum of the largest block it
+  accepts, whatever its alignment.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+KernelSumShouldNotOverflow (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Len;
+  UINTN   Offset;
+
+  for (Offset = 0; Offset < TEST_MAX_MISALIGNMENT; Offset++) {
+    for (Len = NET_CHECKSUM_BLOCK_ALIGN; Len <= NET_CHECKSUM_MAX_BLOCK; Len *= 2) {
+      UT_ASSERT_EQUAL (
+        InternalNetblockChecksum (mBuffer + Offset, Len),
+        TestReferenceSum (mBuffer + Offset, Len)
+        );
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Free function of the external fragments of the net buffer tests, which
+  point into the test buffer.
+
+  @param  Arg                   Not used.
+
+**/
+STATIC
+VOID
+EFIAPI
+FreeFragments (
+  IN VOID               *Arg
+  )
+{
+}
+
+/**
+  The checksum of a net buffer made of fragments of odd lengths must match
+  the reference checksum of the concatenated data.
+
+  @param  Context               - Not used.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+OddFragmentsShouldMatchReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  NET_FRAGMENT  Fragment[TEST_FRAGMENT_COUNT];
+  NET_BUF       *Nbuf;
+  UINT8         *Data;
+  UINTN         Index;
+  UINTN         Len;
+  UINT16        Checksum;
+
+  Data = mBuffer;
+  Len  = 0;
+  for (Index = 0; Index < TEST_FRAGMENT_COUNT; Index++) {
+    Fragment[Index].Bulk = Data;
+    Fragment[Index].Len  = (UINT32) (TestRandom () % 0x800) | 1;
+    Data += Fragment[Index].Len + 1;
+    Len  += Fragment[Index].Len;
+  }
+
+  Nbuf = NetbufFromExt (Fragment, TEST_FRAGMENT_COUNT, 0, 0, FreeFragments, NULL);
+  UT_ASSERT_NOT_NULL (Nbuf);
+
+  //
+  // Build the reference over the concatenated fragments, after the buffer.
+  //
+  Data = mBuffer + 2 * NET_CHECKSUM_MAX_BLOCK;
+  NetbufCopy (Nbuf, 0, (UINT32) Len, Data);
+  Checksum = NetbufChecksum (Nbuf);
+  NetbufFree (Nbuf);
+
+  UT_ASSERT_EQUAL (Checksum, TestReferenceChecksum (Data, Len));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Stub of the list function of DxeNetLib.c, which the checksum tests don't
+  use.
+
+  @param[in, out]  Head                  Not used.
+
+  @return NULL.
+
+**/
+LIST_ENTRY *
+EFIAPI
+NetListRemoveHead (
+  IN OUT LIST_ENTRY            *Head
+  )
+{
+  ASSERT (FALSE);
+  return NULL;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the Internet
+  checksum and run them.
+
+  @retval EFI_SUCCESS           All test cases were dispatched.
+  @retval EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ChecksumTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ChecksumTests, Framework, "Internet Checksum Tests", "NetLib.Checksum", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ChecksumTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ChecksumTests, "Random blocks should match the reference", "Random", RandomBlocksShouldMatchReference, FillRandomBuffer, FreeBuffer, NULL);
+  AddTestCase (ChecksumTests, "Block boundaries should match the reference", "Boundaries", BlockBoundariesShouldMatchReference, FillRandomBuffer, FreeBuffer, NULL);
+  AddTestCase (ChecksumTests, "Carries should be folded", "Carries", BlockBoundariesShouldMatchReference, FillOnesBuffer, FreeBuffer, NULL);
+  AddTestCase (ChecksumTests, "Kernel sum should not overflow", "Kernel", KernelSumShouldNotOverflow, FillOnesBuffer, FreeBuffer, NULL);
+  AddTestCase (ChecksumTests, "Odd fragments should match the reference", "Fragments", OddFragmentsShouldMatchReference, FillRandomBuffer, FreeBuffer, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
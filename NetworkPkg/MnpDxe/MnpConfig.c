@@ -316,6 +316,7 @@ MnpAllocTxBuf (
   RemoveEntryList (MnpDeviceData->FreeTxBufList.ForwardLink);
   TxBufWrap = NET_LIST_USER_STRUCT_S (Entry, MNP_TX_BUF_WRAP, WrapEntry, MNP_TX_BUF_WRAP_SIGNATURE);
   TxBufWrap->InUse = TRUE;
+  MnpDeviceData->TxBufInUseCount++;
   TxBuf = TxBufWrap->TxBuf;
 
 ON_EXIT:
@@ -366,6 +367,7 @@ MnpFreeTxBuf (
   OldTpl = gBS->RaiseTPL (TPL_CALLBACK);
   InsertTailList (&MnpDeviceData->FreeTxBufList, &TxBufWrap->WrapEntry);
   TxBufWrap->InUse = FALSE;
+  MnpDeviceData->TxBufInUseCount--;
   gBS->RestoreTPL (OldTpl);
 }
 
@@ -512,6 +514,7 @@ MnpInitializeDeviceData (
   InitializeListHead (&MnpDeviceData->FreeTxBufList);
   InitializeListHead (&MnpDeviceData->AllTxBufList);
   MnpDeviceData->TxBufCount = 0;
+  MnpDeviceData->TxBufInUseCount = 0;
 
   //
   // Create the system poll timer.
@@ -624,6 +627,16 @@ MnpDestroyDeviceData (
 
   NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
 
+  DEBUG ((
+    DEBUG_INFO,
+    "MnpDestroyDeviceData: %Lu polls received %Lu packets, %Lu full bursts, max burst %d, %Lu polls out of buffers.\n",
+    MnpDeviceData->RxPollCount,
+    MnpDeviceData->RxPacketCount,
+    MnpDeviceData->RxFullBurstCount,
+    MnpDeviceData->RxMaxBurst,
+    MnpDeviceData->RxNoBufferCount
+    ));
+
   //
   // Free Vlan Config variable name string
   //
@@ -1393,6 +1406,16 @@ MnpFlushRcvdDataQueue (
 
   ASSERT (Instance->RcvdPacketQueueSize == 0);
 
+  if (Instance->RcvdPacketDropCount != 0) {
+    DEBUG ((
+      DEBUG_INFO,
+      "MnpFlushRcvdDataQueue: Instance %p dropped %Lu received packets.\n",
+      Instance,
+      Instance->RcvdPacketDropCount
+      ));
+    Instance->RcvdPacketDropCount = 0;
+  }
+
   gBS->RestoreTPL (OldTpl);
 }
 
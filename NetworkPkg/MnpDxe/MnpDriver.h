@@ -63,6 +63,7 @@ typedef struct {
   LIST_ENTRY                    FreeTxBufList;
   LIST_ENTRY                    AllTxBufList;
   UINT32                        TxBufCount;
+  UINT32                        TxBufInUseCount;
 
   NET_BUF_QUEUE                 FreeNbufQue;
   INTN                          NbufCnt;
@@ -85,6 +86,16 @@ typedef struct {
   UINT32                        BufferLength;
   UINT32                        PaddingSize;
   NET_BUF                       *RxNbufCache;
+
+  //
+  // Receive statistics, to tune PcdMnpRxBurstSize. A poll is a call of
+  // MnpReceivePacket() which received at least one frame.
+  //
+  UINT64                        RxPollCount;
+  UINT64                        RxPacketCount;
+  UINT64                        RxFullBurstCount;   // Polls which hit the burst size.
+  UINT32                        RxMaxBurst;
+  UINT64                        RxNoBufferCount;    // Polls stopped by lack of a NET_BUF.
 } MNP_DEVICE_DATA;
 
 #define MNP_DEVICE_DATA_FROM_THIS(a) \
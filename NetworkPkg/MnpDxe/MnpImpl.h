@@ -62,6 +62,7 @@ typedef struct {
   LIST_ENTRY                      RxDeliveredPacketQueue;
   LIST_ENTRY                      RcvdPacketQueue;
   UINTN                           RcvdPacketQueueSize;
+  UINT64                          RcvdPacketDropCount;
 
   EFI_MANAGED_NETWORK_CONFIG_DATA ConfigData;
 
@@ -415,11 +416,14 @@ MnpRecycleRxData (
   );
 
 /**
-  Try to receive a packet and deliver it.
+  Try to receive a burst of packets and deliver them.
+
+  Up to PcdMnpRxBurstSize packets are drained from SNP and queued to the
+  matched instances, then they are delivered to the instances together.
 
   @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
 
-  @retval EFI_SUCCESS           add return value to function comment
+  @retval EFI_SUCCESS           At least one packet is received.
   @retval EFI_NOT_STARTED       The simple network protocol is not started.
   @retval EFI_NOT_READY         No packet received.
   @retval EFI_DEVICE_ERROR      An unexpected error occurs.
@@ -410,9 +410,14 @@ MnpDeliverPacket (
     NET_CHECK_SIGNATURE (Instance, MNP_INSTANCE_DATA_SIGNATURE);
 
     //
-    // Try to deliver packet for this instance.
+    // Try to deliver the queued packets for this instance, as long as it
+    // has receive tokens.
     //
-    MnpInstanceDeliverPacket (Instance);
+    while (!NetMapIsEmpty (&Instance->RxTokenMap) && !IsListEmpty (&Instance->RcvdPacketQueue)) {
+      if (EFI_ERROR (MnpInstanceDeliverPacket (Instance))) {
+        break;
+      }
+    }
   }
 }
 
@@ -504,6 +509,7 @@ MnpQueueRcvdPacket (
     //
     MnpRecycleRxData (NULL, (VOID *) OldRxDataWrap);
     Instance->RcvdPacketQueueSize--;
+    Instance->RcvdPacketDropCount++;
   }
 
   //
@@ -832,18 +838,20 @@ MnpEnqueuePacket (
 
 
 /**
-  Try to receive a packet and deliver it.
+  Try to receive a packet and queue it to the matched instances, without
+  delivering it.
 
   @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
 
-  @retval EFI_SUCCESS           add return value to function comment
+  @retval EFI_SUCCESS           A packet is received.
   @retval EFI_NOT_STARTED       The simple network protocol is not started.
   @retval EFI_NOT_READY         No packet received.
+  @retval EFI_OUT_OF_RESOURCES  No free NET_BUF to receive the packet in.
   @retval EFI_DEVICE_ERROR      An unexpected error occurs.
 
 **/
 EFI_STATUS
-MnpReceivePacket (
+MnpReceiveFrame (
   IN OUT MNP_DEVICE_DATA   *MnpDeviceData
   )
 {
@@ -878,7 +886,7 @@ MnpReceivePacket (
       //
       // No available buffer in the buffer pool.
       //
-      return EFI_DEVICE_ERROR;
+      return EFI_OUT_OF_RESOURCES;
     }
 
     NetbufAllocSpace (
@@ -900,7 +908,7 @@ MnpReceivePacket (
   if (EFI_ERROR (Status)) {
     DEBUG_CODE (
       if (Status != EFI_NOT_READY) {
-        DEBUG ((EFI_D_WARN, "MnpReceivePacket: Snp->Receive() = %r.\n", Status));
+        DEBUG ((EFI_D_WARN, "MnpReceiveFrame: Snp->Receive() = %r.\n", Status));
       }
     );
 
@@ -913,7 +921,7 @@ MnpReceivePacket (
   if ((HeaderSize != Snp->Mode->MediaHeaderSize) || (BufLen < HeaderSize)) {
     DEBUG (
       (EFI_D_WARN,
-      "MnpReceivePacket: Size error, HL:TL = %d:%d.\n",
+      "MnpReceiveFrame: Size error, HL:TL = %d:%d.\n",
       HeaderSize,
       BufLen)
       );
@@ -970,8 +978,12 @@ MnpReceivePacket (
     Nbuf                       = MnpAllocNbuf (MnpDeviceData);
     MnpDeviceData->RxNbufCache = Nbuf;
     if (Nbuf == NULL) {
-      DEBUG ((EFI_D_ERROR, "MnpReceivePacket: Alloc packet for receiving cache failed.\n"));
-      return EFI_DEVICE_ERROR;
+      DEBUG ((EFI_D_ERROR, "MnpReceiveFrame: Alloc packet for receiving cache failed.\n"));
+      //
+      // The packet is queued, report it received. The next call will try
+      // to allocate the receiving cache again.
+      //
+      return EFI_SUCCESS;
     }
 
     NetbufAllocSpace (Nbuf, MnpDeviceData->BufferLength, NET_BUF_TAIL);
@@ -988,10 +1000,6 @@ MnpReceivePacket (
 
     goto EXIT;
   }
-  //
-  // Deliver the queued packets.
-  //
-  MnpDeliverPacket (MnpServiceData);
 
 EXIT:
 
@@ -1001,6 +1009,80 @@ EXIT:
 }
 
 
+/**
+  Try to receive a burst of packets and deliver them.
+
+  Up to PcdMnpRxBurstSize packets are drained from SNP and queued to the
+  matched instances, then they are delivered to the instances together.
+
+  @param[in, out]  MnpDeviceData        Pointer to the mnp device context data.
+
+  @retval EFI_SUCCESS           At least one packet is received.
+  @retval EFI_NOT_STARTED       The simple network protocol is not started.
+  @retval EFI_NOT_READY         No packet received.
+  @retval EFI_DEVICE_ERROR      An unexpected error occurs.
+
+**/
+EFI_STATUS
+MnpReceivePacket (
+  IN OUT MNP_DEVICE_DATA   *MnpDeviceData
+  )
+{
+  EFI_STATUS                  Status;
+  UINT32                      BurstSize;
+  UINT32                      Received;
+  LIST_ENTRY                  *Entry;
+
+  NET_CHECK_SIGNATURE (MnpDeviceData, MNP_DEVICE_DATA_SIGNATURE);
+
+  //
+  // The burst is queued to the instances before any of it is delivered, so it
+  // must fit in their receive queues.
+  //
+  BurstSize = PcdGet32 (PcdMnpRxBurstSize);
+  BurstSize = MAX (BurstSize, 1);
+  BurstSize = MIN (BurstSize, MNP_MAX_RCVD_PACKET_QUE_SIZE);
+
+  Status = EFI_NOT_READY;
+  for (Received = 0; Received < BurstSize; Received++) {
+    Status = MnpReceiveFrame (MnpDeviceData);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+
+  if (Received == 0) {
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      MnpDeviceData->RxNoBufferCount++;
+      Status = EFI_DEVICE_ERROR;
+    }
+
+    return Status;
+  }
+
+  //
+  // Update the statistics of this poll.
+  //
+  MnpDeviceData->RxPollCount++;
+  MnpDeviceData->RxPacketCount += Received;
+  if (Received == BurstSize) {
+    MnpDeviceData->RxFullBurstCount++;
+  } else if (Status == EFI_OUT_OF_RESOURCES) {
+    MnpDeviceData->RxNoBufferCount++;
+  }
+  MnpDeviceData->RxMaxBurst = MAX (MnpDeviceData->RxMaxBurst, Received);
+
+  //
+  // Deliver the queued packets.
+  //
+  NET_LIST_FOR_EACH (Entry, &MnpDeviceData->ServiceList) {
+    MnpDeliverPacket (MNP_SERVICE_DATA_FROM_LINK (Entry));
+  }
+
+  return EFI_SUCCESS;
+}
+
+
 /**
   Remove the received packets if timeout occurs.
 
@@ -1062,6 +1144,7 @@ MnpCheckPacketTimeout (
           DEBUG ((EFI_D_WARN, "MnpCheckPacketTimeout: Received packet timeout.\n"));
           MnpRecycleRxData (NULL, RxDataWrap);
           Instance->RcvdPacketQueueSize--;
+          Instance->RcvdPacketDropCount++;
         }
       }
 
@@ -1126,6 +1209,14 @@ MnpSystemPoll (
   //
   MnpReceivePacket (MnpDeviceData);
 
+  //
+  // Reclaim the transmitted buffers from Snp in one go, rather than only when
+  // the free TX buffer list runs out.
+  //
+  if (MnpDeviceData->TxBufInUseCount != 0) {
+    MnpRecycleTxBuf (MnpDeviceData);
+  }
+
   //
   // Dispatch the DPC queued by the NotifyFunction of rx token's events.
   //
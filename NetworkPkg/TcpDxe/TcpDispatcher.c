@@ -120,7 +120,7 @@ Tcp4GetMode (
       Option->EnableTimeStamp        = (BOOLEAN) (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_TS));
       Option->EnableWindowScaling    = (BOOLEAN) (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_WS));
 
-      Option->EnableSelectiveAck     = FALSE;
+      Option->EnableSelectiveAck     = (BOOLEAN) (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK));
       Option->EnablePathMtuDiscovery = FALSE;
     }
   }
@@ -198,7 +198,7 @@ Tcp6GetMode (
       Option->EnableTimeStamp        = (BOOLEAN) (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_TS));
       Option->EnableWindowScaling    = (BOOLEAN) (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_WS));
 
-      Option->EnableSelectiveAck     = FALSE;
+      Option->EnableSelectiveAck     = (BOOLEAN) (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK));
       Option->EnablePathMtuDiscovery = FALSE;
     }
   }
@@ -610,17 +610,21 @@ TcpConfigurePcb (
     Option              = (EFI_TCP4_OPTION *) CfgData->Tcp6CfgData.ControlOption;
   }
 
+  //
+  // If the application keeps the default receive buffer size, the buffer
+  // starts at the largest unscaled window and is grown by TCP as the peer
+  // fills it. A size set by the application is never changed.
+  //
+  if ((Option == NULL) ||
+      (Option->ReceiveBufferSize < TCP_RCV_BUF_SIZE_MIN) ||
+      (Option->ReceiveBufferSize > TCP_RCV_BUF_SIZE)) {
+    SET_RCV_BUFFSIZE (Sk, TCP_RCV_BUF_SIZE_INIT);
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_RCV_AUTOTUNE);
+  } else {
+    SET_RCV_BUFFSIZE (Sk, Option->ReceiveBufferSize);
+  }
+
   if (Option != NULL) {
-    SET_RCV_BUFFSIZE (
-      Sk,
-      (UINT32) (TCP_COMP_VAL (
-                  TCP_RCV_BUF_SIZE_MIN,
-                  TCP_RCV_BUF_SIZE,
-                  TCP_RCV_BUF_SIZE,
-                  Option->ReceiveBufferSize
-                  )
-               )
-      );
     SET_SND_BUFFSIZE (
       Sk,
       (UINT32) (TCP_COMP_VAL (
@@ -708,6 +712,10 @@ TcpConfigurePcb (
     if (!Option->EnableWindowScaling) {
       TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_NO_WS);
     }
+
+    if (!Option->EnableSelectiveAck) {
+      TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_NO_SACK);
+    }
   }
 
   //
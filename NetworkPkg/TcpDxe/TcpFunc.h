@@ -360,6 +360,39 @@ TcpRetransmit (
   IN TCP_SEQNO Seq
   );
 
+/**
+  Estimate the amount of data in flight during SACK based loss recovery,
+  the "pipe" of RFC6675.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Left    The first unacknowledged sequence number.
+
+  @return The estimate of the data in flight.
+
+**/
+UINT32
+TcpSackPipe (
+  IN TCP_CB    *Tcb,
+  IN TCP_SEQNO Left
+  );
+
+/**
+  Retransmit the holes of the SACK scoreboard while the data in flight
+  is below the congestion window.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Left    The first unacknowledged sequence number.
+  @param[in]       Force   If TRUE, retransmit the segment at HighRxt even if
+                           the congestion window is full or no hole is known.
+
+**/
+VOID
+TcpSackRetransmit (
+  IN OUT TCP_CB    *Tcb,
+  IN     TCP_SEQNO Left,
+  IN     BOOLEAN   Force
+  );
+
 /**
   Check whether to send data/SYN/FIN and piggyback an ACK.
 
@@ -205,6 +205,284 @@ TcpFastLossRecover (
   }
 }
 
+/**
+  Insert a SACKed block into the SACK scoreboard, merging it with the
+  blocks it overlaps or adjoins. The scoreboard is kept sorted.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Left     The first sequence number of the block.
+  @param[in]       Right    The sequence of the last byte of the block + 1.
+
+**/
+VOID
+TcpSackInsert (
+  IN OUT TCP_CB    *Tcb,
+  IN     TCP_SEQNO Left,
+  IN     TCP_SEQNO Right
+  )
+{
+  UINT8  Index;
+
+  Index = 0;
+
+  while (Index < Tcb->SndSackCount) {
+    if (TCP_SEQ_LT (Tcb->SndSack[Index].Right, Left)) {
+      Index++;
+      continue;
+    }
+
+    if (TCP_SEQ_GT (Tcb->SndSack[Index].Left, Right)) {
+      break;
+    }
+
+    //
+    // Absorb the block into the new one, and remove it.
+    //
+    if (TCP_SEQ_LT (Tcb->SndSack[Index].Left, Left)) {
+      Left = Tcb->SndSack[Index].Left;
+    }
+
+    if (TCP_SEQ_GT (Tcb->SndSack[Index].Right, Right)) {
+      Right = Tcb->SndSack[Index].Right;
+    }
+
+    CopyMem (
+      &Tcb->SndSack[Index],
+      &Tcb->SndSack[Index + 1],
+      (Tcb->SndSackCount - Index - 1) * sizeof (TCP_SACK_BLOCK)
+      );
+    Tcb->SndSackCount--;
+  }
+
+  //
+  // If the scoreboard is full, forget the highest block. It is
+  // safe to do so, the data is only retransmitted needlessly.
+  //
+  if (Tcb->SndSackCount == TCP_SACK_SCOREBOARD_SIZE) {
+    if (Index == TCP_SACK_SCOREBOARD_SIZE) {
+      return;
+    }
+
+    Tcb->SndSackCount--;
+  }
+
+  CopyMem (
+    &Tcb->SndSack[Index + 1],
+    &Tcb->SndSack[Index],
+    (Tcb->SndSackCount - Index) * sizeof (TCP_SACK_BLOCK)
+    );
+
+  Tcb->SndSack[Index].Left  = Left;
+  Tcb->SndSack[Index].Right = Right;
+  Tcb->SndSackCount++;
+}
+
+/**
+  Update the SACK scoreboard with the cumulative ACK and the SACK
+  option of the incoming segment, as specified in RFC6675.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Seg      The incoming segment.
+  @param[in]       Option   The options parsed from the incoming segment.
+
+**/
+VOID
+TcpSackUpdate (
+  IN OUT TCP_CB     *Tcb,
+  IN     TCP_SEG    *Seg,
+  IN     TCP_OPTION *Option
+  )
+{
+  TCP_SEQNO  Left;
+  TCP_SEQNO  Right;
+  UINT8      Index;
+  UINT8      Count;
+
+  //
+  // Drop the blocks that are cumulatively acknowledged.
+  //
+  Count = 0;
+
+  for (Index = 0; Index < Tcb->SndSackCount; Index++) {
+    if (TCP_SEQ_LEQ (Tcb->SndSack[Index].Right, Seg->Ack)) {
+      continue;
+    }
+
+    Tcb->SndSack[Count].Left  = Tcb->SndSack[Index].Left;
+    Tcb->SndSack[Count].Right = Tcb->SndSack[Index].Right;
+
+    if (TCP_SEQ_LT (Tcb->SndSack[Count].Left, Seg->Ack)) {
+      Tcb->SndSack[Count].Left = Seg->Ack;
+    }
+
+    Count++;
+  }
+
+  Tcb->SndSackCount = Count;
+
+  if (TCP_FLG_ON (Option->Flag, TCP_OPTION_RCVD_SACK)) {
+
+    for (Index = 0; Index < Option->SackBlockCount; Index++) {
+      Left  = Option->SackBlock[Index].Left;
+      Right = Option->SackBlock[Index].Right;
+
+      //
+      // Ignore the broken blocks, and the D-SACK blocks of RFC2883
+      // that report data below the cumulative ACK.
+      //
+      if (!TCP_SEQ_LT (Left, Right) ||
+          TCP_SEQ_LEQ (Right, Seg->Ack) ||
+          TCP_SEQ_GT (Right, Tcb->SndNxt)
+          ) {
+
+        continue;
+      }
+
+      if (TCP_SEQ_LT (Left, Seg->Ack)) {
+        Left = Seg->Ack;
+      }
+
+      TcpSackInsert (Tcb, Left, Right);
+    }
+  }
+
+  Tcb->SndSackBytes = 0;
+
+  for (Index = 0; Index < Tcb->SndSackCount; Index++) {
+    Tcb->SndSackBytes += TCP_SUB_SEQ (Tcb->SndSack[Index].Right, Tcb->SndSack[Index].Left);
+  }
+}
+
+/**
+  SACK based loss recovery defined in RFC6675.
+
+  Unlike the NewReno fast recovery, the congestion window isn't inflated
+  by the duplicate ACKs. The holes reported by the SACK scoreboard are
+  retransmitted while the estimate of the data in flight is below CWND.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Seg      Segment that triggers the loss recovery.
+
+**/
+VOID
+TcpSackRecover (
+  IN OUT TCP_CB  *Tcb,
+  IN     TCP_SEG *Seg
+  )
+{
+  UINT32  FlightSize;
+
+  if (Tcb->CongestState != TCP_CONGEST_RECOVER) {
+
+    FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Tcb->SndUna);
+
+    Tcb->Ssthresh     = MAX (FlightSize >> 1, (UINT32) (2 * Tcb->SndMss));
+    Tcb->Recover      = Tcb->SndNxt;
+
+    Tcb->CongestState = TCP_CONGEST_RECOVER;
+    TCP_CLEAR_FLG (Tcb->CtrlFlag, TCP_CTRL_RTT_ON);
+
+    Tcb->CWnd         = Tcb->Ssthresh;
+    Tcb->HighRxt      = Tcb->SndUna;
+
+    TcpSackRetransmit (Tcb, Seg->Ack, TRUE);
+
+    DEBUG (
+      (EFI_D_NET,
+      "TcpSackRecover: enter SACK recovery for TCB %p, recover point is %d, %d bytes SACKed\n",
+      Tcb,
+      Tcb->Recover,
+      Tcb->SndSackBytes)
+      );
+    return;
+  }
+
+  if (TCP_SEQ_GEQ (Seg->Ack, Tcb->Recover)) {
+
+    //
+    // Full ACK: exit the loss recovery.
+    //
+    FlightSize        = TCP_SUB_SEQ (Tcb->SndNxt, Seg->Ack);
+
+    Tcb->CWnd         = MIN (Tcb->Ssthresh, FlightSize + Tcb->SndMss);
+
+    Tcb->CongestState = TCP_CONGEST_OPEN;
+    DEBUG (
+      (EFI_D_NET,
+      "TcpSackRecover: received a full ACK(%d) for TCB %p, exit SACK recovery\n",
+      Seg->Ack,
+      Tcb)
+      );
+
+    return;
+  }
+
+  //
+  // Duplicate or partial ACK: retransmit the holes the pipe allows.
+  // A partial ACK that covers all the retransmitted data means the
+  // segment following it is lost as well, even if the peer doesn't
+  // report it in the SACK option.
+  //
+  TcpSackRetransmit (
+    Tcb,
+    Seg->Ack,
+    (BOOLEAN) (TCP_SEQ_GT (Seg->Ack, Tcb->SndUna) && TCP_SEQ_LEQ (Tcb->HighRxt, Seg->Ack))
+    );
+}
+
+/**
+  Grow the receive buffer when the peer is limited by the receive window.
+
+  If the data received in the last RTT fills more than half of the receive
+  buffer, the buffer is doubled, up to TCP_RCV_BUF_SIZE. The larger buffer
+  is advertised through the window scale option, so the buffer is only
+  grown if the window scale is negotiated. Only the buffers that kept the
+  default size are grown, the size set by the application is honored.
+
+  @param[in, out]  Tcb      Pointer to the TCP_CB of this TCP instance.
+
+**/
+VOID
+TcpRcvBufferAutoTune (
+  IN OUT TCP_CB *Tcb
+  )
+{
+  UINT32  Rtt;
+  UINT32  Received;
+  UINT32  BufSize;
+
+  BufSize = GET_RCV_BUFFSIZE (Tcb->Sk);
+
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCV_AUTOTUNE) ||
+      !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_WS) ||
+      (BufSize >= TCP_RCV_BUF_SIZE)) {
+    return;
+  }
+
+  Rtt = MAX (Tcb->SRtt >> TCP_RTT_SHIFT, 1);
+
+  if (TCP_SUB_TIME (mTcpTick, Tcb->RcvSpaceTime) < Rtt) {
+    return;
+  }
+
+  Received = TCP_SUB_SEQ (Tcb->RcvNxt, Tcb->RcvSpaceSeq);
+
+  if (Received > BufSize / 2) {
+    BufSize = MIN (2 * BufSize, TCP_RCV_BUF_SIZE);
+    SET_RCV_BUFFSIZE (Tcb->Sk, BufSize);
+
+    DEBUG (
+      (EFI_D_NET,
+      "TcpRcvBufferAutoTune: receive buffer of TCB %p grown to %d\n",
+      Tcb,
+      BufSize)
+      );
+  }
+
+  Tcb->RcvSpaceSeq  = Tcb->RcvNxt;
+  Tcb->RcvSpaceTime = mTcpTick;
+}
+
 /**
   Compute the RTT as specified in RFC2988.
 
@@ -759,6 +1037,7 @@ TcpInput (
   TCP_SEQNO   Urg;
   UINT16      Checksum;
   INT32       Usable;
+  BOOLEAN     LossDetected;
 
   ASSERT ((Version == IP_VERSION_4) || (Version == IP_VERSION_6));
 
@@ -1277,10 +1556,27 @@ TcpInput (
     Tcb->DupAck = 0;
   }
 
+  LossDetected = (BOOLEAN) (Tcb->DupAck >= 3);
+
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK)) {
+    TcpSackUpdate (Tcb, Seg, &Option);
+
+    //
+    // RFC6675: the first segment is lost once DupThresh
+    // segments above it are SACKed by the peer.
+    //
+    if ((Seg->Ack == Tcb->SndUna) &&
+        (Tcb->SndSackBytes >= 3 * (UINT32) Tcb->SndMss))
+    {
+
+      LossDetected = TRUE;
+    }
+  }
+
   //
   // Congestion avoidance, fast recovery and fast retransmission.
   //
-  if (((Tcb->CongestState == TCP_CONGEST_OPEN) && (Tcb->DupAck < 3)) ||
+  if (((Tcb->CongestState == TCP_CONGEST_OPEN) && !LossDetected) ||
       (Tcb->CongestState == TCP_CONGEST_LOSS))
   {
 
@@ -1300,6 +1596,9 @@ TcpInput (
     if (Tcb->CongestState == TCP_CONGEST_LOSS) {
       TcpFastLossRecover (Tcb, Seg);
     }
+  } else if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK)) {
+
+    TcpSackRecover (Tcb, Seg);
   } else {
 
     TcpFastRecover (Tcb, Seg);
@@ -1549,6 +1848,14 @@ StepSix:
       goto RESET_THEN_DROP;
     }
 
+    //
+    // Remember the latest out of order segment, its
+    // block is reported first in the SACK option.
+    //
+    if (TCP_SEQ_GT (Seg->Seq, Tcb->RcvNxt)) {
+      Tcb->RcvSackSeq = Seg->Seq;
+    }
+
     if (TcpQueueData (Tcb, Nbuf) == 0) {
       DEBUG (
         (EFI_D_ERROR,
@@ -1563,6 +1870,8 @@ StepSix:
       goto RESET_THEN_DROP;
     }
 
+    TcpRcvBufferAutoTune (Tcb);
+
     if (!IsListEmpty (&Tcb->RcvQue)) {
       TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_ACK_NOW);
     }
@@ -82,6 +82,9 @@ TcpInitTcbLocal (
   Tcb->RcvWndScale  = 0;
   Tcb->RetxmitSeqMax = 0;
 
+  Tcb->SndSackCount = 0;
+  Tcb->SndSackBytes = 0;
+
   Tcb->ProbeTimerOn = FALSE;
 }
 
@@ -137,6 +140,10 @@ TcpInitTcbPeer (
 
   Tcb->RcvWl2 = Tcb->RcvNxt;
 
+  Tcb->RcvSackSeq   = Tcb->RcvNxt;
+  Tcb->RcvSpaceSeq  = Tcb->RcvNxt;
+  Tcb->RcvSpaceTime = mTcpTick;
+
   if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_WS) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_WS)) {
 
     Tcb->SndWndScale  = Opt->WndScale;
@@ -165,6 +172,11 @@ TcpInitTcbPeer (
     //
     Tcb->SndMss -= TCP_OPTION_TS_ALIGNED_LEN;
   }
+
+  if (TCP_FLG_ON (Opt->Flag, TCP_OPTION_RCVD_SACK_PERM) && !TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK)) {
+
+    TCP_SET_FLG (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK);
+  }
 }
 
 /**
@@ -80,7 +80,15 @@ TcpComputeScale (
 
   ASSERT ((Tcb != NULL) && (Tcb->Sk != NULL));
 
-  BufSize = GET_RCV_BUFFSIZE (Tcb->Sk);
+  //
+  // A receive buffer sized by TCP is grown up to TCP_RCV_BUF_SIZE once the
+  // connection is established, so leave room for it in the scale.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCV_AUTOTUNE)) {
+    BufSize = TCP_RCV_BUF_SIZE;
+  } else {
+    BufSize = GET_RCV_BUFFSIZE (Tcb->Sk);
+  }
 
   Scale   = 0;
   while ((Scale < TCP_OPTION_MAX_WS) && ((UINT32) (TCP_OPTION_MAX_WIN << Scale) < BufSize)) {
@@ -159,6 +167,28 @@ TcpSynBuildOption (
     TcpPutUint32 (Data, TCP_OPTION_WS_FAST | TcpComputeScale (Tcb));
   }
 
+  //
+  // Build SACK permitted option, only when SACK isn't
+  // disabled, and either we are doing active open or
+  // we have received SACK permitted option from peer.
+  //
+  if (!TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_NO_SACK) &&
+      (!TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_ACK) ||
+        TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK))
+      ) {
+
+    Data = NetbufAllocSpace (
+             Nbuf,
+             TCP_OPTION_SACK_PERM_ALIGNED_LEN,
+             NET_BUF_HEAD
+             );
+
+    ASSERT (Data != NULL);
+
+    Len += TCP_OPTION_SACK_PERM_ALIGNED_LEN;
+    TcpPutUint32 (Data, TCP_OPTION_SACK_PERM_FAST);
+  }
+
   //
   // Build the MSS option.
   //
@@ -171,6 +201,113 @@ TcpSynBuildOption (
   return Len;
 }
 
+/**
+  Build the SACK option from the out of order data in the reassemble queue.
+
+  The block holding the most recently received segment is reported first,
+  as required by RFC2018, the other blocks follow in sequence order.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Nbuf    Pointer to the buffer to store the options.
+  @param[in]  OptLen  The length of the options already built.
+
+  @return             The length of the SACK option, 0 if none was built.
+
+**/
+UINT16
+TcpBuildSackOption (
+  IN TCP_CB  *Tcb,
+  IN NET_BUF *Nbuf,
+  IN UINT16  OptLen
+  )
+{
+  TCP_SACK_BLOCK  Blocks[TCP_OPTION_MAX_SACK_BLOCK];
+  TCP_SACK_BLOCK  Block;
+  UINT8           MaxBlock;
+  UINT8           Count;
+  BOOLEAN         Found;
+  LIST_ENTRY      *Entry;
+  TCP_SEG         *Seg;
+  UINT8           *Data;
+  UINT16          Len;
+  UINT8           Index;
+
+  MaxBlock = (UINT8) MIN (
+                       TCP_OPTION_MAX_SACK_BLOCK,
+                       (TCP_OPTION_MAX_LEN - OptLen - TCP_OPTION_SACK_ALIGNED_LEN) / TCP_OPTION_SACK_BLOCK_LEN
+                       );
+
+  //
+  // Slot 0 is reserved for the block of the latest segment.
+  //
+  Count = 1;
+  Found = FALSE;
+  Entry = Tcb->RcvQue.ForwardLink;
+
+  while (Entry != &Tcb->RcvQue) {
+    Seg         = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+    Block.Left  = Seg->Seq;
+    Block.Right = Seg->End;
+    Entry       = Entry->ForwardLink;
+
+    //
+    // Coalesce the segments that are contiguous or overlapping.
+    //
+    while (Entry != &Tcb->RcvQue) {
+      Seg = TCPSEG_NETBUF (NET_LIST_USER_STRUCT (Entry, NET_BUF, List));
+
+      if (TCP_SEQ_GT (Seg->Seq, Block.Right)) {
+        break;
+      }
+
+      if (TCP_SEQ_GT (Seg->End, Block.Right)) {
+        Block.Right = Seg->End;
+      }
+
+      Entry = Entry->ForwardLink;
+    }
+
+    if (!Found &&
+        TCP_SEQ_LEQ (Block.Left, Tcb->RcvSackSeq) &&
+        TCP_SEQ_LT (Tcb->RcvSackSeq, Block.Right)
+        ) {
+
+      Blocks[0] = Block;
+      Found     = TRUE;
+    } else if (Count < MaxBlock) {
+      Blocks[Count++] = Block;
+    } else if (Found) {
+      break;
+    }
+  }
+
+  if (!Found) {
+    CopyMem (&Blocks[0], &Blocks[1], (Count - 1) * sizeof (TCP_SACK_BLOCK));
+    Count--;
+  }
+
+  Len = (UINT16) (TCP_OPTION_SACK_ALIGNED_LEN + Count * TCP_OPTION_SACK_BLOCK_LEN);
+
+  //
+  // SndMss already accounts for the timestamp option, if any.
+  //
+  if ((Count == 0) || (Nbuf->TotalSize + Len > (UINT32) (Tcb->SndMss + OptLen))) {
+    return 0;
+  }
+
+  Data = NetbufAllocSpace (Nbuf, Len, NET_BUF_HEAD);
+  ASSERT (Data != NULL);
+
+  TcpPutUint32 (Data, TCP_OPTION_SACK_FAST + Count * TCP_OPTION_SACK_BLOCK_LEN);
+
+  for (Index = 0; Index < Count; Index++) {
+    TcpPutUint32 (Data + 4 + Index * TCP_OPTION_SACK_BLOCK_LEN, Blocks[Index].Left);
+    TcpPutUint32 (Data + 8 + Index * TCP_OPTION_SACK_BLOCK_LEN, Blocks[Index].Right);
+  }
+
+  return Len;
+}
+
 /**
   Build the TCP option in synchronized states.
 
@@ -213,6 +350,20 @@ TcpBuildOption (
     TcpPutUint32 (Data + 8, Tcb->TsRecent);
   }
 
+  //
+  // Build the SACK option if SACK is negotiated and there is
+  // out of order data in the reassemble queue. The blocks are
+  // only added if they fit in the segment without exceeding
+  // the MSS, that is, to the ACKs and to the short segments.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) &&
+      !TCP_FLG_ON (TCPSEG_NETBUF (Nbuf)->Flag, TCP_FLG_RST) &&
+      !IsListEmpty (&Tcb->RcvQue)
+      ) {
+
+    Len = (UINT16) (Len + TcpBuildSackOption (Tcb, Nbuf, Len));
+  }
+
   return Len;
 }
 
@@ -238,10 +389,12 @@ TcpParseOption (
   UINT8 Cur;
   UINT8 Type;
   UINT8 Len;
+  UINT8 Index;
 
   ASSERT ((Tcp != NULL) && (Option != NULL));
 
-  Option->Flag  = 0;
+  Option->Flag           = 0;
+  Option->SackBlockCount = 0;
 
   TotalLen      = (UINT8) ((Tcp->HeadLen << 2) - sizeof (TCP_HEAD));
   if (TotalLen <= 0) {
@@ -313,6 +466,44 @@ TcpParseOption (
       Cur += TCP_OPTION_TS_LEN;
       break;
 
+    case TCP_OPTION_SACK_PERM:
+      Len = Head[Cur + 1];
+
+      if ((Len != TCP_OPTION_SACK_PERM_LEN) || (TotalLen - Cur < TCP_OPTION_SACK_PERM_LEN)) {
+
+        return -1;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK_PERM);
+
+      Cur += TCP_OPTION_SACK_PERM_LEN;
+      break;
+
+    case TCP_OPTION_SACK:
+      Len = Head[Cur + 1];
+
+      if ((Len < TCP_OPTION_SACK_LEN + TCP_OPTION_SACK_BLOCK_LEN) ||
+          ((Len - TCP_OPTION_SACK_LEN) % TCP_OPTION_SACK_BLOCK_LEN != 0) ||
+          (TotalLen - Cur < Len)) {
+
+        return -1;
+      }
+
+      for (Index = 0; Index < (Len - TCP_OPTION_SACK_LEN) / TCP_OPTION_SACK_BLOCK_LEN; Index++) {
+        if (Option->SackBlockCount == TCP_OPTION_MAX_SACK_BLOCK) {
+          break;
+        }
+
+        Option->SackBlock[Option->SackBlockCount].Left  = TcpGetUint32 (&Head[Cur + 2 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        Option->SackBlock[Option->SackBlockCount].Right = TcpGetUint32 (&Head[Cur + 6 + Index * TCP_OPTION_SACK_BLOCK_LEN]);
+        Option->SackBlockCount++;
+      }
+
+      TCP_SET_FLG (Option->Flag, TCP_OPTION_RCVD_SACK);
+
+      Cur = (UINT8) (Cur + Len);
+      break;
+
     case TCP_OPTION_NOP:
       Cur++;
       break;
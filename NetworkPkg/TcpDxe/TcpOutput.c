@@ -177,6 +177,7 @@ TcpDataToSend (
   UINT32  Len;
   UINT32  Left;
   UINT32  Limit;
+  UINT32  Pipe;
 
   Sk = Tcb->Sk;
   ASSERT (Sk != NULL);
@@ -196,6 +197,25 @@ TcpDataToSend (
     Limit = Tcb->SndUna + Tcb->CWnd;
   }
 
+  //
+  // During SACK based loss recovery the congestion window
+  // isn't inflated, new data is sent as long as the estimate
+  // of the data in flight (RFC6675 pipe) is below CWND.
+  //
+  if (TCP_FLG_ON (Tcb->CtrlFlag, TCP_CTRL_RCVD_SACK) &&
+      (Tcb->CongestState == TCP_CONGEST_RECOVER)
+      ) {
+
+    Pipe  = TcpSackPipe (Tcb, Tcb->SndUna);
+    Limit = Tcb->SndWl2 + Tcb->SndWnd;
+
+    if (Pipe >= Tcb->CWnd) {
+      Limit = Tcb->SndNxt;
+    } else if (TCP_SEQ_GT (Limit, Tcb->SndNxt + (Tcb->CWnd - Pipe))) {
+      Limit = Tcb->SndNxt + (Tcb->CWnd - Pipe);
+    }
+  }
+
   if (TCP_SEQ_GT (Limit, Tcb->SndNxt)) {
     Win = TCP_SUB_SEQ (Limit, Tcb->SndNxt);
   }
@@ -641,19 +661,21 @@ TcpGetSegment (
 }
 
 /**
-  Retransmit the segment from sequence Seq.
+  Retransmit at most Limit bytes from sequence Seq.
 
   @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
   @param[in]  Seq     The sequence number of the segment to be retransmitted.
+  @param[in]  Limit   The maximum number of bytes to retransmit.
 
-  @retval 0       Retransmission succeeded.
-  @retval -1      Error condition occurred.
+  @return The number of sequence numbers retransmitted, 0 if the send window
+          is too small, or -1 if an error condition occurred.
 
 **/
 INTN
-TcpRetransmit (
+TcpRetransmitLimit (
   IN TCP_CB    *Tcb,
-  IN TCP_SEQNO Seq
+  IN TCP_SEQNO Seq,
+  IN UINT32    Limit
   )
 {
   NET_BUF *Nbuf;
@@ -662,7 +684,7 @@ TcpRetransmit (
   //
   // Compute the maximum length of retransmission. It is
   // limited by three factors:
-  // 1. Less than SndMss
+  // 1. Less than SndMss and Limit
   // 2. Must in the current send window
   // 3. Will not change the boundaries of queued segments.
   //
@@ -696,7 +718,7 @@ TcpRetransmit (
     return 0;
   }
 
-  Len = MIN (Len, Tcb->SndMss);
+  Len = MIN (Len, MIN (Limit, Tcb->SndMss));
 
   Nbuf = TcpGetSegmentSndQue (Tcb, Seq, Len);
   if (Nbuf == NULL) {
@@ -715,6 +737,8 @@ TcpRetransmit (
     Tcb->RetxmitSeqMax = Seq;
   }
 
+  Len = TCP_SUB_SEQ (TCPSEG_NETBUF (Nbuf)->End, Seq);
+
   //
   // The retransmitted buffer may be on the SndQue,
   // trim TCP head because all the buffers on SndQue
@@ -725,7 +749,7 @@ TcpRetransmit (
   Nbuf->Tcp = NULL;
 
   NetbufFree (Nbuf);
-  return 0;
+  return (INTN) Len;
 
 OnError:
   if (Nbuf != NULL) {
@@ -735,6 +759,162 @@ OnError:
   return -1;
 }
 
+/**
+  Retransmit the segment from sequence Seq.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Seq     The sequence number of the segment to be retransmitted.
+
+  @retval 0       Retransmission succeeded.
+  @retval -1      Error condition occurred.
+
+**/
+INTN
+TcpRetransmit (
+  IN TCP_CB    *Tcb,
+  IN TCP_SEQNO Seq
+  )
+{
+  if (TcpRetransmitLimit (Tcb, Seq, Tcb->SndMss) < 0) {
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+  Find the next hole in the SACK scoreboard, that is, the next range
+  of data that isn't SACKed by the peer and is below a SACKed block.
+
+  @param[in]       Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in, out]  Seq     On input, the sequence to start from. On output,
+                           the first sequence of the hole.
+  @param[out]      Len     The length of the hole.
+
+  @retval TRUE     A hole is found.
+  @retval FALSE    There is no hole at or above Seq.
+
+**/
+BOOLEAN
+TcpSackNextHole (
+  IN     TCP_CB    *Tcb,
+  IN OUT TCP_SEQNO *Seq,
+     OUT UINT32    *Len
+  )
+{
+  UINT8  Index;
+
+  for (Index = 0; Index < Tcb->SndSackCount; Index++) {
+    if (TCP_SEQ_LEQ (Tcb->SndSack[Index].Right, *Seq)) {
+      continue;
+    }
+
+    if (TCP_SEQ_LEQ (Tcb->SndSack[Index].Left, *Seq)) {
+      *Seq = Tcb->SndSack[Index].Right;
+      continue;
+    }
+
+    *Len = TCP_SUB_SEQ (Tcb->SndSack[Index].Left, *Seq);
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+/**
+  Estimate the amount of data in flight during SACK based loss recovery,
+  the "pipe" of RFC6675.
+
+  The data SACKed by the peer and the holes below the highest SACKed block
+  that aren't retransmitted yet are considered to have left the network.
+
+  @param[in]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]  Left    The first unacknowledged sequence number.
+
+  @return The estimate of the data in flight.
+
+**/
+UINT32
+TcpSackPipe (
+  IN TCP_CB    *Tcb,
+  IN TCP_SEQNO Left
+  )
+{
+  TCP_SEQNO  Seq;
+  UINT32     Outstanding;
+  UINT32     Lost;
+  UINT32     Len;
+
+  Outstanding = TCP_SUB_SEQ (Tcb->SndNxt, Left);
+  Lost        = 0;
+  Seq         = TCP_SEQ_GT (Tcb->HighRxt, Left) ? Tcb->HighRxt : Left;
+
+  while (TcpSackNextHole (Tcb, &Seq, &Len)) {
+    Lost += Len;
+    Seq  += Len;
+  }
+
+  if (Outstanding <= Tcb->SndSackBytes + Lost) {
+    return 0;
+  }
+
+  return Outstanding - Tcb->SndSackBytes - Lost;
+}
+
+/**
+  Retransmit the holes of the SACK scoreboard while the data in flight
+  is below the congestion window, as RFC6675 does in the loss recovery.
+
+  @param[in, out]  Tcb     Pointer to the TCP_CB of this TCP instance.
+  @param[in]       Left    The first unacknowledged sequence number.
+  @param[in]       Force   If TRUE, retransmit the segment at HighRxt even if
+                           the congestion window is full or no hole is known.
+
+**/
+VOID
+TcpSackRetransmit (
+  IN OUT TCP_CB    *Tcb,
+  IN     TCP_SEQNO Left,
+  IN     BOOLEAN   Force
+  )
+{
+  TCP_SEQNO  Seq;
+  UINT32     Len;
+  UINT32     Pipe;
+  INTN       Sent;
+
+  if (TCP_SEQ_LT (Tcb->HighRxt, Left)) {
+    Tcb->HighRxt = Left;
+  }
+
+  Pipe = TcpSackPipe (Tcb, Left);
+
+  while (Force || (Pipe < Tcb->CWnd)) {
+    Seq = Tcb->HighRxt;
+
+    if (!TcpSackNextHole (Tcb, &Seq, &Len)) {
+      if (!Force) {
+        break;
+      }
+
+      Len = Tcb->SndMss;
+    }
+
+    if (TCP_SEQ_GEQ (Seq, Tcb->SndNxt)) {
+      break;
+    }
+
+    Sent = TcpRetransmitLimit (Tcb, Seq, Len);
+    if (Sent <= 0) {
+      break;
+    }
+
+    Tcb->HighRxt = Seq + (UINT32) Sent;
+    Pipe        += (UINT32) Sent;
+    Force        = FALSE;
+  }
+}
+
 /**
   Verify that all the segments in SndQue are in good shape.
 
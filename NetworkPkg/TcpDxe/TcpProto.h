@@ -72,6 +72,9 @@
 #define TCP_CTRL_TIMER_ON        0x1000 ///< At least one of the timer is on.
 #define TCP_CTRL_RTT_ON          0x2000 ///< The RTT measurement is on.
 #define TCP_CTRL_ACK_NOW         0x4000 ///< Send the ACK now, don't delay.
+#define TCP_CTRL_NO_SACK         0x8000 ///< Disable SACK option.
+#define TCP_CTRL_RCVD_SACK       0x10000 ///< Received a SACK permitted option in syn.
+#define TCP_CTRL_RCV_AUTOTUNE    0x20000 ///< The receive buffer is sized by TCP.
 
 //
 // Timer related values
@@ -113,8 +116,10 @@
 //
 #define TCP_RCV_BUF_SIZE         (2 * 1024 * 1024)
 #define TCP_RCV_BUF_SIZE_MIN     (8 * 1024)
+#define TCP_RCV_BUF_SIZE_INIT    (64 * 1024)
 #define TCP_SND_BUF_SIZE         (2 * 1024 * 1024)
 #define TCP_SND_BUF_SIZE_MIN     (8 * 1024)
+#define TCP_SACK_SCOREBOARD_SIZE 16
 #define TCP_BACKLOG              10
 #define TCP_BACKLOG_MIN          5
 #define TCP_MAX_LOSS_MIN         6
@@ -219,6 +224,14 @@ typedef struct _TCP_SEG {
   UINT32    Wnd;  ///< TCP window size field.
 } TCP_SEG;
 
+///
+/// A block of data received by the peer, reported in a SACK option.
+///
+typedef struct _TCP_SACK_BLOCK {
+  TCP_SEQNO Left;   ///< First sequence number of the block.
+  TCP_SEQNO Right;  ///< The sequence of the last byte + 1.
+} TCP_SACK_BLOCK;
+
 ///
 /// Network endpoint, IP plus Port structure.
 ///
@@ -309,6 +322,22 @@ struct _TCP_CONTROL_BLOCK {
   UINT8             LossTimes;    ///< Number of retxmit timeouts in a row.
   TCP_SEQNO         LossRecover;  ///< Recover point for retxmit.
 
+  //
+  // RFC2018 and RFC6675 variables.
+  // Selective acknowledgment + SACK based loss recovery.
+  //
+  TCP_SACK_BLOCK    SndSack[TCP_SACK_SCOREBOARD_SIZE]; ///< Blocks SACKed by the peer, sorted.
+  UINT8             SndSackCount; ///< Number of blocks in SndSack.
+  UINT32            SndSackBytes; ///< Number of bytes SACKed by the peer.
+  TCP_SEQNO         HighRxt;      ///< Highest sequence retxmitted in recovery.
+  TCP_SEQNO         RcvSackSeq;   ///< Seq of the latest out of order segment.
+
+  //
+  // Receive buffer auto-tuning.
+  //
+  TCP_SEQNO         RcvSpaceSeq;  ///< RcvNxt when the measurement started.
+  UINT32            RcvSpaceTime; ///< mTcpTick when the measurement started.
+
   //
   // RFC7323
   // Addressing Window Retraction for TCP Window Scale Option.
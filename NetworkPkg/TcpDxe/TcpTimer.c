@@ -203,6 +203,13 @@ TcpRexmitTimeout (
   Tcb->CWnd         = Tcb->SndMss;
   Tcb->LossRecover  = Tcb->SndNxt;
 
+  //
+  // The peer may have discarded the data it SACKed,
+  // forget the SACK scoreboard as RFC6675 suggests.
+  //
+  Tcb->SndSackCount = 0;
+  Tcb->SndSackBytes = 0;
+
   Tcb->LossTimes++;
   if ((Tcb->LossTimes > Tcb->MaxRexmit) && !TCP_TIMER_ON (Tcb->EnabledTimer, TCP_TIMER_CONNECT)) {
 
@@ -101,7 +101,7 @@ typedef struct {
   volatile UINT16 *Idx;
 
   volatile UINT16 *Ring;      // QueueSize elements
-  volatile UINT16 *UsedEvent; // unused as per negotiation
+  volatile UINT16 *UsedEvent; // only with VIRTIO_F_RING_EVENT_IDX
 } VRING_AVAIL;
 
 
@@ -121,7 +121,7 @@ typedef struct {
   volatile UINT16          *Flags;
   volatile UINT16          *Idx;
   volatile VRING_USED_ELEM *UsedElem;   // QueueSize elements
-  volatile UINT16          *AvailEvent; // unused as per negotiation
+  volatile UINT16          *AvailEvent; // only with VIRTIO_F_RING_EVENT_IDX
 } VRING_USED;
 
 
@@ -130,7 +130,7 @@ typedef struct {
 //
 #define VRING_DESC_F_NEXT     BIT0 // more descriptors in this request
 #define VRING_DESC_F_WRITE    BIT1 // buffer to be written *by the host*
-#define VRING_DESC_F_INDIRECT BIT2 // unused
+#define VRING_DESC_F_INDIRECT BIT2 // buffer is a table of descriptors
 
 #pragma pack(1)
 typedef struct {
@@ -141,6 +141,12 @@ typedef struct {
 } VRING_DESC;
 #pragma pack()
 
+//
+// With a packed virtqueue (VirtIo 1.1), Desc points to the descriptor ring,
+// Avail.Flags to the driver event suppression structure and Used.Flags to the
+// device event suppression structure; the other pointers are NULL. The
+// trailing fields track the driver's progress around a packed ring.
+//
 typedef struct {
   UINTN               NumPages;
   VOID                *Base;     // deallocate only this field
@@ -148,6 +154,10 @@ typedef struct {
   VRING_AVAIL         Avail;
   VRING_USED          Used;
   UINT16              QueueSize;
+  BOOLEAN             Packed;
+  UINT16              NextAvailIdx; // packed only, free-running
+  UINT16              LastUsedIdx;  // free-running
+  UINT16              *ChainLength; // packed only, indexed by buffer ID
 } VRING;
 
 //
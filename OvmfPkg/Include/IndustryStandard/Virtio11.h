@@ -0,0 +1,52 @@
+/** @file
+  Definitions from the VirtIo 1.1 specification: packed virtqueues.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef _VIRTIO_1_1_H_
+#define _VIRTIO_1_1_H_
+
+#include <IndustryStandard/Virtio10.h>
+
+//
+// VirtIo 1.1, 2.7.1 Driver and Device Ring Wrap Counters, and 2.7.5 Element
+// Address and Length. The VRING_DESC_F_NEXT, VRING_DESC_F_WRITE and
+// VRING_DESC_F_INDIRECT flags keep their split virtqueue values.
+//
+#define VRING_PACKED_DESC_F_AVAIL BIT7
+#define VRING_PACKED_DESC_F_USED  BIT15
+
+#pragma pack (1)
+typedef struct {
+  UINT64 Addr;
+  UINT32 Len;
+  UINT16 Id;
+  UINT16 Flags;
+} VRING_PACKED_DESC;
+#pragma pack ()
+
+//
+// VirtIo 1.1, 2.7.14 Event Suppression Structure Format
+//
+#define VRING_PACKED_EVENT_FLAG_ENABLE  0x0
+#define VRING_PACKED_EVENT_FLAG_DISABLE 0x1
+#define VRING_PACKED_EVENT_FLAG_DESC    0x2
+
+#define VRING_PACKED_EVENT_WRAP         BIT15
+
+#pragma pack (1)
+typedef struct {
+  UINT16 OffWrap;
+  UINT16 Flags;
+} VRING_PACKED_EVENT;
+#pragma pack ()
+
+//
+// VirtIo 1.1 reserved (device-independent) feature bits
+//
+#define VIRTIO_F_RING_PACKED BIT34
+
+#endif // _VIRTIO_1_1_H_
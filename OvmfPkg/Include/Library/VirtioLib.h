@@ -100,6 +100,85 @@ VirtioRingUninit (
   );
 
 
+/**
+
+  Configure a packed virtqueue.
+
+  This function is the VirtIo 1.1 counterpart of VirtioRingInit(), see
+  "2.7 Packed Virtqueues". The descriptor ring, the driver event suppression
+  structure and the device event suppression structure are laid out in the
+  same shared pages; Ring->Desc, Ring->Avail.Flags and Ring->Used.Flags point
+  to them, respectively, which is what VirtIo->SetQueueAddress() expects.
+  Driver notifications (interrupts) are disabled from the start.
+
+  The caller must have negotiated VIRTIO_F_RING_PACKED, after checking the
+  queue with VirtioPackedRingCheckQueue().
+
+  @param[in]  VirtIo            The virtio device which will use the ring.
+
+  @param[in]  QueueSize         The number of descriptors to allocate for the
+                                virtio ring, as requested by the host. It must
+                                be a power of two, so that free-running UINT16
+                                indices can track the ring wrap counters.
+
+  @param[out] Ring              The virtio ring to set up.
+
+  @retval EFI_UNSUPPORTED       QueueSize is not a power of two.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Status codes propagated from
+                                VirtIo->AllocateSharedPages().
+
+  @retval EFI_SUCCESS           Allocation and setup successful. Release the
+                                ring with VirtioRingUninit().
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioPackedRingInit (
+  IN  VIRTIO_DEVICE_PROTOCOL *VirtIo,
+  IN  UINT16                 QueueSize,
+  OUT VRING                  *Ring
+  );
+
+
+/**
+
+  Fall back to a split ring if a queue cannot be set up as a packed ring.
+
+  VirtioPackedRingInit() needs a queue size that is a power of two, while
+  the device may offer VIRTIO_F_RING_PACKED with a queue of any size. Call
+  this function for each queue the driver sets up, before the features are
+  written to the device, so that VIRTIO_F_RING_PACKED is not accepted for a
+  queue VirtioPackedRingInit() would reject.
+
+  The function changes the queue selected in the device.
+
+  @param[in]     VirtIo      The virtio device.
+
+  @param[in]     QueueIndex  The index of the queue to check.
+
+  @param[in,out] Features    The features the driver is going to accept. If
+                             VIRTIO_F_RING_PACKED is set and the size of the
+                             queue is not a power of two, it is cleared.
+
+  @return                    Status codes propagated from
+                             VirtIo->SetQueueSel() and
+                             VirtIo->GetQueueNumMax().
+
+  @retval EFI_SUCCESS        Features is up to date.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioPackedRingCheckQueue (
+  IN     VIRTIO_DEVICE_PROTOCOL *VirtIo,
+  IN     UINT16                 QueueIndex,
+  IN OUT UINT64                 *Features
+  );
+
+
 //
 // Internal use structure for tracking the submission of a multi-descriptor
 // request.
@@ -142,8 +221,8 @@ VirtioPrepare (
   request submission. It is the calling driver's responsibility to verify the
   ring size in advance.
 
-  The caller is responsible for initializing *Indices with VirtioPrepare()
-  first.
+  The caller is responsible for initializing *Indices with VirtioPrepare() or
+  VirtioStartChain() first.
 
   @param[in,out] Ring               The virtio ring to append the buffer to,
                                     as a descriptor.
@@ -156,10 +235,14 @@ VirtioPrepare (
   @param[in] Flags                  A bitmask of VRING_DESC_F_* flags. The
                                     caller computes this mask dependent on
                                     further buffers to append and transfer
-                                    direction. VRING_DESC_F_INDIRECT is
-                                    unsupported. The VRING_DESC.Next field is
-                                    always set, but the host only interprets
-                                    it dependent on VRING_DESC_F_NEXT.
+                                    direction. VRING_DESC_F_INDIRECT may only
+                                    be set if VIRTIO_F_RING_INDIRECT_DESC has
+                                    been negotiated, and never together with
+                                    VRING_DESC_F_NEXT. The VRING_DESC.Next
+                                    field is always set, but the host only
+                                    interprets it dependent on
+                                    VRING_DESC_F_NEXT. In a packed ring, the
+                                    chain continues in ring order instead.
 
   @param[in,out] Indices            Indices->HeadDescIdx is not accessed.
                                     On input, Indices->NextDescIdx identifies
@@ -217,6 +300,150 @@ VirtioFlush (
   );
 
 
+/**
+
+  Prepare for appending the descriptors of a new buffer to a virtio ring that
+  has multiple buffers in flight.
+
+  With a split ring, the caller manages the descriptor table and chooses the
+  head descriptor. With a packed ring, descriptors are consumed in ring order,
+  and the chain starts at the next available position.
+
+  @param[in] Ring          The virtio ring we intend to append descriptors to.
+
+  @param[in] HeadDescIdx   The head descriptor of the chain (split ring only).
+
+  @param[out] Indices      The DESC_INDICES structure to initialize, for
+                           VirtioAppendDesc() and VirtioMakeAvailable().
+
+**/
+VOID
+EFIAPI
+VirtioStartChain (
+  IN  VRING        *Ring,
+  IN  UINT16       HeadDescIdx,
+  OUT DESC_INDICES *Indices
+  );
+
+
+/**
+
+  Make the descriptor chain just built available to the device, without
+  notifying it.
+
+  This function implements virtio-0.9.5, 2.4.1.2 Updating the Available Ring
+  and 2.4.1.3 Updating the Index Field for split rings, and VirtIo 1.1, 2.7.13
+  Supplying Buffers to The Device for packed rings.
+
+  @param[in,out] Ring      The virtio ring with descriptors to submit.
+
+  @param[in] Indices       The chain built with VirtioStartChain() (or
+                           VirtioPrepare()) and VirtioAppendDesc().
+
+  @param[in] BufferId      The identifier that VirtioPeekUsed() reports when
+                           the device has used the buffer. It must be smaller
+                           than the queue size. With a split ring, the device
+                           reports the head descriptor index instead, so the
+                           caller must pass Indices->HeadDescIdx.
+
+**/
+VOID
+EFIAPI
+VirtioMakeAvailable (
+  IN OUT VRING        *Ring,
+  IN     DESC_INDICES *Indices,
+  IN     UINT16       BufferId
+  );
+
+
+/**
+
+  Check whether the device has used the next buffer in the order the device
+  returns them, without consuming it.
+
+  This function implements virtio-0.9.5, 2.4.2 Receiving Used Buffers From
+  the Device for split rings, and VirtIo 1.1, 2.7.9 In-order use of
+  descriptors (in its general, out-of-order form) for packed rings.
+
+  @param[in] Ring       The virtio ring to check.
+
+  @param[out] BufferId  The identifier of the used buffer; see
+                        VirtioMakeAvailable(). May be NULL.
+
+  @param[out] UsedLen   The number of bytes the device wrote into the buffer.
+                        May be NULL.
+
+  @retval EFI_SUCCESS    A used buffer is available. Consume it with
+                         VirtioReleaseUsed().
+
+  @retval EFI_NOT_READY  The device has not used any further buffers.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioPeekUsed (
+  IN  VRING  *Ring,
+  OUT UINT16 *BufferId OPTIONAL,
+  OUT UINT32 *UsedLen  OPTIONAL
+  );
+
+
+/**
+
+  Consume the used buffer most recently reported by VirtioPeekUsed(), which
+  must have succeeded. The buffer's descriptors may be reused afterwards.
+
+  @param[in,out] Ring  The virtio ring the buffer was used from.
+
+**/
+VOID
+EFIAPI
+VirtioReleaseUsed (
+  IN OUT VRING *Ring
+  );
+
+
+/**
+
+  Notify the device about the buffers made available since the last
+  notification, unless the device has told us it does not need one.
+
+  With VIRTIO_F_RING_EVENT_IDX, the device publishes the available index after
+  which it wants to be notified (virtio-1.0, 2.4.7.2 Notifications, and
+  VirtIo 1.1, 2.7.10 Driver notifications); otherwise it may set a flag that
+  suppresses notifications altogether. Gratuitous notifications are harmless,
+  so the function errs on the side of notifying.
+
+  @param[in] VirtIo                The target virtio device to notify.
+
+  @param[in] VirtQueueId           Identifies the queue for the target device.
+
+  @param[in] Ring                  The virtio ring with buffers made available.
+
+  @param[in] EventIdx              TRUE iff VIRTIO_F_RING_EVENT_IDX has been
+                                   negotiated.
+
+  @param[in,out] NotifiedAvailIdx  On input, the available index at the last
+                                   notification (zero initially). On output,
+                                   the current available index, unless
+                                   notifying the device failed.
+
+  @return              Error code from VirtIo->SetQueueNotify() if it fails.
+
+  @retval EFI_SUCCESS  The device has been notified, or needs no notification.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioKick (
+  IN     VIRTIO_DEVICE_PROTOCOL *VirtIo,
+  IN     UINT16                 VirtQueueId,
+  IN     VRING                  *Ring,
+  IN     BOOLEAN                EventIdx,
+  IN OUT UINT16                 *NotifiedAvailIdx
+  );
+
+
 /**
 
   Report the feature bits to the VirtIo 1.0 device that the VirtIo 1.0 driver
@@ -13,10 +13,27 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 
 #include <Library/VirtioLib.h>
 
+//
+// The wrap counter (TRUE for 1) that belongs to the free-running index Idx of
+// a packed ring. The queue size is a power of two, so the counter flips
+// every QueueSize positions, and an even number of times as Idx wraps around
+// after 0xFFFF.
+//
+#define VIRTIO_PACKED_WRAP(Ring, Idx) \
+        ((BOOLEAN) ((((Idx) / (Ring)->QueueSize) & 1) == 0))
+
+//
+// "vring_need_event" from virtio-1.0, 2.4.7.2 Notifications: whether moving
+// the available index from Old to New passes the index Event.
+//
+#define VIRTIO_NEED_EVENT(Event, New, Old) \
+        ((UINT16) ((New) - (Event) - 1) < (UINT16) ((New) - (Old)))
+
 
 /**
 
@@ -118,7 +135,178 @@ VirtioRingInit (
   Ring->Used.AvailEvent = (volatile VOID *) RingPagesPtr;
   RingPagesPtr += sizeof *Ring->Used.AvailEvent;
 
-  Ring->QueueSize = QueueSize;
+  Ring->QueueSize    = QueueSize;
+  Ring->Packed       = FALSE;
+  Ring->NextAvailIdx = 0;
+  Ring->LastUsedIdx  = 0;
+  Ring->ChainLength  = NULL;
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Configure a packed virtqueue.
+
+  This function is the VirtIo 1.1 counterpart of VirtioRingInit(), see
+  "2.7 Packed Virtqueues". The descriptor ring, the driver event suppression
+  structure and the device event suppression structure are laid out in the
+  same shared pages; Ring->Desc, Ring->Avail.Flags and Ring->Used.Flags point
+  to them, respectively, which is what VirtIo->SetQueueAddress() expects.
+  Driver notifications (interrupts) are disabled from the start.
+
+  The caller must have negotiated VIRTIO_F_RING_PACKED, after checking the
+  queue with VirtioPackedRingCheckQueue().
+
+  @param[in]  VirtIo            The virtio device which will use the ring.
+
+  @param[in]  QueueSize         The number of descriptors to allocate for the
+                                virtio ring, as requested by the host. It must
+                                be a power of two, so that free-running UINT16
+                                indices can track the ring wrap counters.
+
+  @param[out] Ring              The virtio ring to set up.
+
+  @retval EFI_UNSUPPORTED       QueueSize is not a power of two.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Status codes propagated from
+                                VirtIo->AllocateSharedPages().
+
+  @retval EFI_SUCCESS           Allocation and setup successful. Release the
+                                ring with VirtioRingUninit().
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioPackedRingInit (
+  IN  VIRTIO_DEVICE_PROTOCOL *VirtIo,
+  IN  UINT16                 QueueSize,
+  OUT VRING                  *Ring
+  )
+{
+  EFI_STATUS     Status;
+  UINTN          RingSize;
+  volatile UINT8 *RingPagesPtr;
+
+  if (QueueSize == 0 || (QueueSize & (QueueSize - 1)) != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  RingSize = sizeof (VRING_PACKED_DESC) * QueueSize +
+             sizeof (VRING_PACKED_EVENT) * 2;
+
+  Ring->ChainLength = AllocateZeroPool (
+                        QueueSize * sizeof *Ring->ChainLength
+                        );
+  if (Ring->ChainLength == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Allocate a shared ring buffer
+  //
+  Ring->NumPages = EFI_SIZE_TO_PAGES (RingSize);
+  Status = VirtIo->AllocateSharedPages (
+                     VirtIo,
+                     Ring->NumPages,
+                     &Ring->Base
+                     );
+  if (EFI_ERROR (Status)) {
+    FreePool (Ring->ChainLength);
+    Ring->ChainLength = NULL;
+    return Status;
+  }
+  SetMem (Ring->Base, EFI_PAGES_TO_SIZE (Ring->NumPages), 0x00);
+  RingPagesPtr = Ring->Base;
+
+  Ring->Desc = (volatile VOID *) RingPagesPtr;
+  RingPagesPtr += sizeof (VRING_PACKED_DESC) * QueueSize;
+
+  Ring->Avail.Flags = (volatile VOID *) RingPagesPtr;
+  RingPagesPtr += sizeof (VRING_PACKED_EVENT);
+
+  Ring->Used.Flags = (volatile VOID *) RingPagesPtr;
+  RingPagesPtr += sizeof (VRING_PACKED_EVENT);
+
+  Ring->Avail.Idx        = NULL;
+  Ring->Avail.Ring       = NULL;
+  Ring->Avail.UsedEvent  = NULL;
+  Ring->Used.Idx         = NULL;
+  Ring->Used.UsedElem    = NULL;
+  Ring->Used.AvailEvent  = NULL;
+
+  //
+  // We poll the used buffers; the device should not send interrupts.
+  //
+  ((volatile VRING_PACKED_EVENT *) Ring->Avail.Flags)->Flags =
+    VRING_PACKED_EVENT_FLAG_DISABLE;
+
+  Ring->QueueSize    = QueueSize;
+  Ring->Packed       = TRUE;
+  Ring->NextAvailIdx = 0;
+  Ring->LastUsedIdx  = 0;
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Fall back to a split ring if a queue cannot be set up as a packed ring.
+
+  VirtioPackedRingInit() needs a queue size that is a power of two, while
+  the device may offer VIRTIO_F_RING_PACKED with a queue of any size. Call
+  this function for each queue the driver sets up, before the features are
+  written to the device, so that VIRTIO_F_RING_PACKED is not accepted for a
+  queue VirtioPackedRingInit() would reject.
+
+  The function changes the queue selected in the device.
+
+  @param[in]     VirtIo      The virtio device.
+
+  @param[in]     QueueIndex  The index of the queue to check.
+
+  @param[in,out] Features    The features the driver is going to accept. If
+                             VIRTIO_F_RING_PACKED is set and the size of the
+                             queue is not a power of two, it is cleared.
+
+  @return                    Status codes propagated from
+                             VirtIo->SetQueueSel() and
+                             VirtIo->GetQueueNumMax().
+
+  @retval EFI_SUCCESS        Features is up to date.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioPackedRingCheckQueue (
+  IN     VIRTIO_DEVICE_PROTOCOL *VirtIo,
+  IN     UINT16                 QueueIndex,
+  IN OUT UINT64                 *Features
+  )
+{
+  EFI_STATUS Status;
+  UINT16     QueueSize;
+
+  if ((*Features & VIRTIO_F_RING_PACKED) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Status = VirtIo->SetQueueSel (VirtIo, QueueIndex);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+  Status = VirtIo->GetQueueNumMax (VirtIo, &QueueSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (QueueSize == 0 || (QueueSize & (QueueSize - 1)) != 0) {
+    DEBUG ((DEBUG_INFO, "%a: queue %d has %d entries, using a split ring\n",
+      __FUNCTION__, QueueIndex, QueueSize));
+    *Features &= ~(UINT64)VIRTIO_F_RING_PACKED;
+  }
   return EFI_SUCCESS;
 }
 
@@ -144,6 +332,9 @@ VirtioRingUninit (
   )
 {
   VirtIo->FreeSharedPages (VirtIo, Ring->NumPages, Ring->Base);
+  if (Ring->ChainLength != NULL) {
+    FreePool (Ring->ChainLength);
+  }
   SetMem (Ring, sizeof *Ring, 0x00);
 }
 
@@ -167,6 +358,15 @@ VirtioPrepare (
   OUT    DESC_INDICES *Indices
   )
 {
+  //
+  // A packed ring (see VirtioPackedRingInit()) has interrupts disabled from
+  // the start, and the chain starts wherever the previous one ended.
+  //
+  if (Ring->Packed) {
+    VirtioStartChain (Ring, 0, Indices);
+    return;
+  }
+
   //
   // Prepare for virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device.
   // We're going to poll the answer, the host should not send an interrupt.
@@ -195,8 +395,8 @@ VirtioPrepare (
   request submission. It is the calling driver's responsibility to verify the
   ring size in advance.
 
-  The caller is responsible for initializing *Indices with VirtioPrepare()
-  first.
+  The caller is responsible for initializing *Indices with VirtioPrepare() or
+  VirtioStartChain() first.
 
   @param[in,out] Ring               The virtio ring to append the buffer to,
                                     as a descriptor.
@@ -209,10 +409,14 @@ VirtioPrepare (
   @param[in] Flags                  A bitmask of VRING_DESC_F_* flags. The
                                     caller computes this mask dependent on
                                     further buffers to append and transfer
-                                    direction. VRING_DESC_F_INDIRECT is
-                                    unsupported. The VRING_DESC.Next field is
-                                    always set, but the host only interprets
-                                    it dependent on VRING_DESC_F_NEXT.
+                                    direction. VRING_DESC_F_INDIRECT may only
+                                    be set if VIRTIO_F_RING_INDIRECT_DESC has
+                                    been negotiated, and never together with
+                                    VRING_DESC_F_NEXT. The VRING_DESC.Next
+                                    field is always set, but the host only
+                                    interprets it dependent on
+                                    VRING_DESC_F_NEXT. In a packed ring, the
+                                    chain continues in ring order instead.
 
   @param[in,out] Indices            Indices->HeadDescIdx is not accessed.
                                     On input, Indices->NextDescIdx identifies
@@ -231,7 +435,31 @@ VirtioAppendDesc (
   IN OUT DESC_INDICES *Indices
   )
 {
-  volatile VRING_DESC *Desc;
+  volatile VRING_DESC        *Desc;
+  volatile VRING_PACKED_DESC *PackedDesc;
+  UINT16                     WrapFlags;
+
+  if (Ring->Packed) {
+    //
+    // VirtIo 1.1, 2.7.13.1 Placing Available Buffers Into The Descriptor
+    // Ring. The head descriptor gets the wrap flags of a used descriptor, so
+    // the device ignores the chain until VirtioMakeAvailable().
+    //
+    WrapFlags  = VIRTIO_PACKED_WRAP (Ring, Indices->NextDescIdx) ?
+                 VRING_PACKED_DESC_F_AVAIL :
+                 VRING_PACKED_DESC_F_USED;
+    if (Indices->NextDescIdx == Indices->HeadDescIdx) {
+      WrapFlags ^= VRING_PACKED_DESC_F_AVAIL | VRING_PACKED_DESC_F_USED;
+    }
+
+    PackedDesc        = &((volatile VRING_PACKED_DESC *) Ring->Desc)[
+                           Indices->NextDescIdx++ % Ring->QueueSize];
+    PackedDesc->Addr  = BufferDeviceAddress;
+    PackedDesc->Len   = BufferSize;
+    PackedDesc->Id    = 0;
+    PackedDesc->Flags = Flags | WrapFlags;
+    return;
+  }
 
   Desc        = &Ring->Desc[Indices->NextDescIdx++ % Ring->QueueSize];
   Desc->Addr  = BufferDeviceAddress;
@@ -283,6 +511,30 @@ VirtioFlush (
   EFI_STATUS Status;
   UINTN      PollPeriodUsecs;
 
+  if (Ring->Packed) {
+    //
+    // Only one chain is ever in flight, so it can use buffer ID 0.
+    //
+    VirtioMakeAvailable (Ring, Indices, 0);
+
+    MemoryFence ();
+    Status = VirtIo->SetQueueNotify (VirtIo, VirtQueueId);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    PollPeriodUsecs = 1;
+    while (VirtioPeekUsed (Ring, NULL, UsedLen) == EFI_NOT_READY) {
+      gBS->Stall (PollPeriodUsecs); // calls AcpiTimerLib::MicroSecondDelay
+
+      if (PollPeriodUsecs < 1024) {
+        PollPeriodUsecs *= 2;
+      }
+    }
+    VirtioReleaseUsed (Ring);
+    return EFI_SUCCESS;
+  }
+
   //
   // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
   //
@@ -348,6 +600,316 @@ VirtioFlush (
 }
 
 
+/**
+
+  Prepare for appending the descriptors of a new buffer to a virtio ring that
+  has multiple buffers in flight.
+
+  With a split ring, the caller manages the descriptor table and chooses the
+  head descriptor. With a packed ring, descriptors are consumed in ring order,
+  and the chain starts at the next available position.
+
+  @param[in] Ring          The virtio ring we intend to append descriptors to.
+
+  @param[in] HeadDescIdx   The head descriptor of the chain (split ring only).
+
+  @param[out] Indices      The DESC_INDICES structure to initialize, for
+                           VirtioAppendDesc() and VirtioMakeAvailable().
+
+**/
+VOID
+EFIAPI
+VirtioStartChain (
+  IN  VRING        *Ring,
+  IN  UINT16       HeadDescIdx,
+  OUT DESC_INDICES *Indices
+  )
+{
+  Indices->HeadDescIdx = Ring->Packed ? Ring->NextAvailIdx : HeadDescIdx;
+  Indices->NextDescIdx = Indices->HeadDescIdx;
+}
+
+
+/**
+
+  Make the descriptor chain just built available to the device, without
+  notifying it.
+
+  This function implements virtio-0.9.5, 2.4.1.2 Updating the Available Ring
+  and 2.4.1.3 Updating the Index Field for split rings, and VirtIo 1.1, 2.7.13
+  Supplying Buffers to The Device for packed rings.
+
+  @param[in,out] Ring      The virtio ring with descriptors to submit.
+
+  @param[in] Indices       The chain built with VirtioStartChain() (or
+                           VirtioPrepare()) and VirtioAppendDesc().
+
+  @param[in] BufferId      The identifier that VirtioPeekUsed() reports when
+                           the device has used the buffer. It must be smaller
+                           than the queue size. With a split ring, the device
+                           reports the head descriptor index instead, so the
+                           caller must pass Indices->HeadDescIdx.
+
+**/
+VOID
+EFIAPI
+VirtioMakeAvailable (
+  IN OUT VRING        *Ring,
+  IN     DESC_INDICES *Indices,
+  IN     UINT16       BufferId
+  )
+{
+  volatile VRING_PACKED_DESC *PackedDesc;
+  UINT16                     AvailIdx;
+
+  if (!Ring->Packed) {
+    ASSERT (BufferId == Indices->HeadDescIdx % Ring->QueueSize);
+
+    //
+    // the available index is never written by the host, we can read it back
+    // without a barrier
+    //
+    AvailIdx = *Ring->Avail.Idx;
+    Ring->Avail.Ring[AvailIdx++ % Ring->QueueSize] =
+      Indices->HeadDescIdx % Ring->QueueSize;
+
+    MemoryFence ();
+    *Ring->Avail.Idx = AvailIdx;
+    return;
+  }
+
+  ASSERT (BufferId < Ring->QueueSize);
+  ASSERT (Indices->HeadDescIdx == Ring->NextAvailIdx);
+  ASSERT ((UINT16)(Indices->NextDescIdx - Indices->HeadDescIdx) > 0);
+  ASSERT ((UINT16)(Indices->NextDescIdx - Indices->HeadDescIdx) <=
+          Ring->QueueSize);
+
+  //
+  // The device reads the buffer ID from the last descriptor of the chain.
+  // VirtioAppendDesc() wrote the head descriptor's flags such that it does
+  // not look available yet; flipping both wrap bits publishes the chain.
+  //
+  PackedDesc = (volatile VRING_PACKED_DESC *) Ring->Desc;
+  PackedDesc[(UINT16)(Indices->NextDescIdx - 1) % Ring->QueueSize].Id =
+    BufferId;
+  Ring->ChainLength[BufferId] =
+    (UINT16)(Indices->NextDescIdx - Indices->HeadDescIdx);
+
+  MemoryFence ();
+  PackedDesc[Indices->HeadDescIdx % Ring->QueueSize].Flags ^=
+    VRING_PACKED_DESC_F_AVAIL | VRING_PACKED_DESC_F_USED;
+  Ring->NextAvailIdx = Indices->NextDescIdx;
+}
+
+
+/**
+
+  Check whether the device has used the next buffer in the order the device
+  returns them, without consuming it.
+
+  This function implements virtio-0.9.5, 2.4.2 Receiving Used Buffers From
+  the Device for split rings, and VirtIo 1.1, 2.7.9 In-order use of
+  descriptors (in its general, out-of-order form) for packed rings.
+
+  @param[in] Ring       The virtio ring to check.
+
+  @param[out] BufferId  The identifier of the used buffer; see
+                        VirtioMakeAvailable(). May be NULL.
+
+  @param[out] UsedLen   The number of bytes the device wrote into the buffer.
+                        May be NULL.
+
+  @retval EFI_SUCCESS    A used buffer is available. Consume it with
+                         VirtioReleaseUsed().
+
+  @retval EFI_NOT_READY  The device has not used any further buffers.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioPeekUsed (
+  IN  VRING  *Ring,
+  OUT UINT16 *BufferId OPTIONAL,
+  OUT UINT32 *UsedLen  OPTIONAL
+  )
+{
+  volatile VRING_PACKED_DESC     *PackedDesc;
+  volatile CONST VRING_USED_ELEM *UsedElem;
+  UINT16                         Flags;
+  UINT16                         WrapFlags;
+
+  MemoryFence ();
+  if (!Ring->Packed) {
+    if (*Ring->Used.Idx == Ring->LastUsedIdx) {
+      return EFI_NOT_READY;
+    }
+    MemoryFence ();
+
+    UsedElem = &Ring->Used.UsedElem[Ring->LastUsedIdx % Ring->QueueSize];
+    if (BufferId != NULL) {
+      *BufferId = (UINT16) UsedElem->Id;
+    }
+    if (UsedLen != NULL) {
+      *UsedLen = UsedElem->Len;
+    }
+    return EFI_SUCCESS;
+  }
+
+  //
+  // A descriptor is used when its AVAIL and USED flags both match the used
+  // wrap counter for its position.
+  //
+  PackedDesc = &((volatile VRING_PACKED_DESC *) Ring->Desc)[
+                  Ring->LastUsedIdx % Ring->QueueSize];
+  Flags      = PackedDesc->Flags &
+               (VRING_PACKED_DESC_F_AVAIL | VRING_PACKED_DESC_F_USED);
+  WrapFlags  = (VIRTIO_PACKED_WRAP (Ring, Ring->LastUsedIdx)) ?
+               (VRING_PACKED_DESC_F_AVAIL | VRING_PACKED_DESC_F_USED) :
+               0;
+  if (Flags != WrapFlags) {
+    return EFI_NOT_READY;
+  }
+  MemoryFence ();
+
+  if (BufferId != NULL) {
+    *BufferId = PackedDesc->Id;
+  }
+  if (UsedLen != NULL) {
+    *UsedLen = PackedDesc->Len;
+  }
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Consume the used buffer most recently reported by VirtioPeekUsed(), which
+  must have succeeded. The buffer's descriptors may be reused afterwards.
+
+  @param[in,out] Ring  The virtio ring the buffer was used from.
+
+**/
+VOID
+EFIAPI
+VirtioReleaseUsed (
+  IN OUT VRING *Ring
+  )
+{
+  UINT16 BufferId;
+
+  if (!Ring->Packed) {
+    Ring->LastUsedIdx++;
+    return;
+  }
+
+  BufferId = ((volatile VRING_PACKED_DESC *) Ring->Desc)[
+               Ring->LastUsedIdx % Ring->QueueSize].Id;
+  ASSERT (BufferId < Ring->QueueSize);
+  ASSERT (Ring->ChainLength[BufferId] > 0);
+  Ring->LastUsedIdx += Ring->ChainLength[BufferId];
+}
+
+
+/**
+
+  Notify the device about the buffers made available since the last
+  notification, unless the device has told us it does not need one.
+
+  With VIRTIO_F_RING_EVENT_IDX, the device publishes the available index after
+  which it wants to be notified (virtio-1.0, 2.4.7.2 Notifications, and
+  VirtIo 1.1, 2.7.10 Driver notifications); otherwise it may set a flag that
+  suppresses notifications altogether. Gratuitous notifications are harmless,
+  so the function errs on the side of notifying.
+
+  @param[in] VirtIo                The target virtio device to notify.
+
+  @param[in] VirtQueueId           Identifies the queue for the target device.
+
+  @param[in] Ring                  The virtio ring with buffers made available.
+
+  @param[in] EventIdx              TRUE iff VIRTIO_F_RING_EVENT_IDX has been
+                                   negotiated.
+
+  @param[in,out] NotifiedAvailIdx  On input, the available index at the last
+                                   notification (zero initially). On output,
+                                   the current available index, unless
+                                   notifying the device failed.
+
+  @return              Error code from VirtIo->SetQueueNotify() if it fails.
+
+  @retval EFI_SUCCESS  The device has been notified, or needs no notification.
+
+**/
+EFI_STATUS
+EFIAPI
+VirtioKick (
+  IN     VIRTIO_DEVICE_PROTOCOL *VirtIo,
+  IN     UINT16                 VirtQueueId,
+  IN     VRING                  *Ring,
+  IN     BOOLEAN                EventIdx,
+  IN OUT UINT16                 *NotifiedAvailIdx
+  )
+{
+  volatile VRING_PACKED_EVENT *DeviceEvent;
+  UINT16                      AvailIdx;
+  UINT16                      EventOffWrap;
+  UINT16                      Event;
+  BOOLEAN                     NeedNotify;
+  EFI_STATUS                  Status;
+
+  AvailIdx = Ring->Packed ? Ring->NextAvailIdx : *Ring->Avail.Idx;
+  if (AvailIdx == *NotifiedAvailIdx) {
+    return EFI_SUCCESS;
+  }
+
+  MemoryFence ();
+  if (!Ring->Packed) {
+    NeedNotify = EventIdx ?
+                 VIRTIO_NEED_EVENT (*Ring->Used.AvailEvent, AvailIdx,
+                   *NotifiedAvailIdx) :
+                 ((*Ring->Used.Flags & VRING_USED_F_NO_NOTIFY) == 0);
+  } else {
+    DeviceEvent = (volatile VRING_PACKED_EVENT *) Ring->Used.Flags;
+    switch (DeviceEvent->Flags) {
+    case VRING_PACKED_EVENT_FLAG_DISABLE:
+      NeedNotify = FALSE;
+      break;
+    case VRING_PACKED_EVENT_FLAG_DESC:
+      if (!EventIdx) {
+        NeedNotify = TRUE;
+        break;
+      }
+      //
+      // Turn the ring position and wrap counter that the device published
+      // into a free-running index in the lap of AvailIdx, or the lap before.
+      //
+      EventOffWrap = DeviceEvent->OffWrap;
+      Event = (UINT16)(AvailIdx - AvailIdx % Ring->QueueSize +
+                       (EventOffWrap & ~VRING_PACKED_EVENT_WRAP));
+      if (((EventOffWrap & VRING_PACKED_EVENT_WRAP) != 0) !=
+          VIRTIO_PACKED_WRAP (Ring, AvailIdx)) {
+        Event -= Ring->QueueSize;
+      }
+      NeedNotify = VIRTIO_NEED_EVENT (Event, AvailIdx, *NotifiedAvailIdx);
+      break;
+    default:
+      NeedNotify = TRUE;
+      break;
+    }
+  }
+
+  if (NeedNotify) {
+    Status = VirtIo->SetQueueNotify (VirtIo, VirtQueueId);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  *NotifiedAvailIdx = AvailIdx;
+  return EFI_SUCCESS;
+}
+
+
 /**
 
   Report the feature bits to the VirtIo 1.0 device that the VirtIo 1.0 driver
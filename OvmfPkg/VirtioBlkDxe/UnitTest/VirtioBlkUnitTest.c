@@ -0,0 +1,1155 @@
+/** @file
+  Unit tests of the request queue of VirtioBlkDxe
+
+  The tests bind the driver to a virtio-blk device model with a split ring
+  and a RAM disk. The model checks every virtio-blk request against the limits
+  the device advertises, and completes it a fixed time after the driver
+  notifies the device; time only advances in the Stall() boot service. The
+  tests check the data read and written against a shadow copy of the disk,
+  that large transfers keep many virtio-blk requests in flight, and that
+  Block I/O 2 tokens are completed by the poll timer.
+
+  Copyright (c) 2026, 3mdeb. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <IndustryStandard/Virtio10.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UefiLib.h>
+#include <Library/UnitTestLib.h>
+#include <Protocol/VirtioDevice.h>
+
+#include "../VirtioBlk.h"
+
+#define UNIT_TEST_APP_NAME        "VirtioBlkDxe Unit Tests"
+#define UNIT_TEST_APP_VERSION     "1.0"
+
+//
+// Device model
+//
+#define TEST_DISK_SIZE            SIZE_16MB
+#define TEST_QUEUE_SIZE           256
+#define TEST_SIZE_MAX             SIZE_64KB
+#define TEST_SEG_MAX              8
+#define TEST_LATENCY_USECS        100
+
+//
+// Longer than any chain the driver builds, so that requests which break the
+// limits of the device model can still be parsed and completed
+//
+#define TEST_MAX_CHAIN            64
+
+#define TEST_RANDOM_STEP_COUNT    400
+#define TEST_RANDOM_MAX_BLOCKS    4096
+#define TEST_TOKEN_COUNT          32
+#define TEST_TOKEN_READ_COUNT     1000
+
+//
+// A virtio-blk request that the device model has taken from the avail ring
+//
+typedef struct {
+  UINT16                  Head;
+  UINT64                  Due;
+  UINT32                  Type;
+  UINT64                  Sector;
+  UINT32                  DataCount;
+  UINT64                  DataAddress[TEST_MAX_CHAIN];
+  UINT32                  DataLength[TEST_MAX_CHAIN];
+  UINT8                   *HostStatus;
+} TEST_DEVICE_REQUEST;
+
+//
+// An event created through the boot services of the test
+//
+typedef struct {
+  UINT32                  Type;
+  EFI_TPL                 NotifyTpl;
+  EFI_EVENT_NOTIFY        NotifyFunction;
+  VOID                    *NotifyContext;
+  BOOLEAN                 Signaled;
+  UINT64                  TriggerTime;
+  UINT64                  TimerPeriod;
+} TEST_EVENT;
+
+EFI_BOOT_SERVICES         MockBoot;
+
+STATIC VIRTIO_DEVICE_PROTOCOL       mVirtIo;
+STATIC EFI_DRIVER_BINDING_PROTOCOL  mDriverBinding;
+STATIC EFI_HANDLE                   mDeviceHandle = (EFI_HANDLE) &mVirtIo;
+STATIC EFI_BLOCK_IO_PROTOCOL        *mBlockIo;
+STATIC EFI_BLOCK_IO2_PROTOCOL       *mBlockIo2;
+
+STATIC UINT64                 mDeviceFeatures;
+STATIC UINT64                 mGuestFeatures;
+STATIC UINT8                  mDeviceStatus;
+STATIC VRING                  *mRing;
+STATIC UINT16                 mLastAvailIdx;
+STATIC TEST_DEVICE_REQUEST    mPending[TEST_QUEUE_SIZE];
+STATIC UINTN                  mPendingCount;
+STATIC BOOLEAN                mDeviceError;
+
+STATIC EFI_BLOCK_IO2_TOKEN    mTokens[TEST_TOKEN_COUNT];
+STATIC EFI_LBA                mTokenLbas[TEST_TOKEN_COUNT];
+
+STATIC UINT8                  *mDisk;
+STATIC UINT8                  *mShadow;
+STATIC UINT8                  *mBuffer;
+STATIC UINT32                 mRandomState;
+
+STATIC EFI_TPL                mTpl = TPL_APPLICATION;
+STATIC UINT64                 mNow;
+STATIC TEST_EVENT             *mTimer;
+
+//
+// Statistics of the device model
+//
+STATIC UINTN                  mNotifyCount;
+STATIC UINTN                  mRequestCount;
+STATIC UINTN                  mRingDescCount;
+STATIC UINTN                  mMaxInFlight;
+
+/**
+  Return the next value of the pseudo random sequence of the test.
+
+  @return A pseudo random value in the range 0 - 0x7FFF.
+
+**/
+STATIC
+UINTN
+TestRandom (
+  VOID
+  )
+{
+  mRandomState = mRandomState * 1103515245 + 12345;
+  return (mRandomState >> 16) & 0x7FFF;
+}
+
+/**
+  Complete the virtio-blk requests that are due, in the order the device
+  model has taken them.
+
+**/
+STATIC
+VOID
+TestCompleteRequests (
+  VOID
+  )
+{
+  TEST_DEVICE_REQUEST  *Request;
+  UINT64               Offset;
+  UINT32               Written;
+  UINT32               Index;
+  UINT16               UsedIdx;
+
+  while ((mPendingCount > 0) && (mPending[0].Due <= mNow)) {
+    Request = &mPending[0];
+    Offset  = MultU64x32 (Request->Sector, 512);
+    Written = 0;
+    for (Index = 0; Index < Request->DataCount; Index++) {
+      if ((Offset + Request->DataLength[Index]) > TEST_DISK_SIZE) {
+        mDeviceError = TRUE;
+        break;
+      }
+
+      if (Request->Type == VIRTIO_BLK_T_OUT) {
+        CopyMem (mDisk + Offset, (VOID *) (UINTN) Request->DataAddress[Index], Request->DataLength[Index]);
+      } else {
+        CopyMem ((VOID *) (UINTN) Request->DataAddress[Index], mDisk + Offset, Request->DataLength[Index]);
+        Written += Request->DataLength[Index];
+      }
+      Offset += Request->DataLength[Index];
+    }
+
+    *Request->HostStatus = VIRTIO_BLK_S_OK;
+
+    UsedIdx                                              = *mRing->Used.Idx;
+    mRing->Used.UsedElem[UsedIdx % mRing->QueueSize].Id  = Request->Head;
+    mRing->Used.UsedElem[UsedIdx % mRing->QueueSize].Len = Written + 1;
+    MemoryFence ();
+    *mRing->Used.Idx = (UINT16) (UsedIdx + 1);
+
+    mPendingCount--;
+    CopyMem (&mPending[0], &mPending[1], mPendingCount * sizeof mPending[0]);
+  }
+}
+
+/**
+  Run the notification function of the poll timer of the driver while it is
+  due and the TPL allows.
+
+**/
+STATIC
+VOID
+TestRunTimer (
+  VOID
+  )
+{
+  EFI_TPL  OldTpl;
+
+  while ((mTimer != NULL) && (mTimer->TimerPeriod != 0) &&
+         (mTimer->TriggerTime <= mNow) && (mTpl < mTimer->NotifyTpl))
+  {
+    mTimer->TriggerTime += mTimer->TimerPeriod;
+    OldTpl               = mTpl;
+    mTpl                 = mTimer->NotifyTpl;
+    mTimer->NotifyFunction ((EFI_EVENT) mTimer, mTimer->NotifyContext);
+    mTpl = OldTpl;
+  }
+}
+
+//
+// Boot services of the test
+//
+
+STATIC
+EFI_TPL
+EFIAPI
+TestRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  EFI_TPL  OldTpl;
+
+  ASSERT (NewTpl >= mTpl);
+  OldTpl = mTpl;
+  mTpl   = NewTpl;
+  return OldTpl;
+}
+
+STATIC
+VOID
+EFIAPI
+TestRestoreTpl (
+  IN EFI_TPL  OldTpl
+  )
+{
+  ASSERT (OldTpl <= mTpl);
+  mTpl = OldTpl;
+  TestRunTimer ();
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestStall (
+  IN UINTN  Microseconds
+  )
+{
+  mNow += Microseconds;
+  TestCompleteRequests ();
+  TestRunTimer ();
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,
+  IN  VOID              *NotifyContext,
+  OUT EFI_EVENT         *Event
+  )
+{
+  TEST_EVENT  *TestEvent;
+
+  TestEvent = AllocateZeroPool (sizeof *TestEvent);
+  if (TestEvent == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  TestEvent->Type           = Type;
+  TestEvent->NotifyTpl      = NotifyTpl;
+  TestEvent->NotifyFunction = NotifyFunction;
+  TestEvent->NotifyContext  = NotifyContext;
+  if ((Type & EVT_TIMER) != 0) {
+    mTimer = TestEvent;
+  }
+
+  *Event = TestEvent;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetTimer (
+  IN EFI_EVENT        Event,
+  IN EFI_TIMER_DELAY  Type,
+  IN UINT64           TriggerTime
+  )
+{
+  TEST_EVENT  *TestEvent;
+
+  TestEvent = Event;
+  ASSERT (Type != TimerRelative);
+  if (Type == TimerCancel) {
+    TestEvent->TimerPeriod = 0;
+  } else {
+    TestEvent->TimerPeriod = MAX (DivU64x32 (TriggerTime, 10), 1);
+    TestEvent->TriggerTime = mNow + TestEvent->TimerPeriod;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSignalEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  ((TEST_EVENT *) Event)->Signaled = TRUE;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestCloseEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  if (Event == (EFI_EVENT) mTimer) {
+    mTimer = NULL;
+  }
+
+  FreePool (Event);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestOpenProtocol (
+  IN  EFI_HANDLE  Handle,
+  IN  EFI_GUID    *Protocol,
+  OUT VOID        **Interface OPTIONAL,
+  IN  EFI_HANDLE  AgentHandle,
+  IN  EFI_HANDLE  ControllerHandle,
+  IN  UINT32      Attributes
+  )
+{
+  if (CompareGuid (Protocol, &gVirtioDeviceProtocolGuid)) {
+    *Interface = &mVirtIo;
+  } else if (CompareGuid (Protocol, &gEfiBlockIoProtocolGuid) && (mBlockIo != NULL)) {
+    *Interface = mBlockIo;
+  } else {
+    return EFI_UNSUPPORTED;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestCloseProtocol (
+  IN EFI_HANDLE  Handle,
+  IN EFI_GUID    *Protocol,
+  IN EFI_HANDLE  AgentHandle,
+  IN EFI_HANDLE  ControllerHandle
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestInstallMultipleProtocolInterfaces (
+  IN OUT EFI_HANDLE  *Handle,
+  ...
+  )
+{
+  VA_LIST   Args;
+  EFI_GUID  *Protocol;
+  VOID      *Interface;
+
+  VA_START (Args, Handle);
+  for (Protocol = VA_ARG (Args, EFI_GUID *); Protocol != NULL; Protocol = VA_ARG (Args, EFI_GUID *)) {
+    Interface = VA_ARG (Args, VOID *);
+    if (CompareGuid (Protocol, &gEfiBlockIoProtocolGuid)) {
+      mBlockIo = Interface;
+    } else if (CompareGuid (Protocol, &gEfiBlockIo2ProtocolGuid)) {
+      mBlockIo2 = Interface;
+    }
+  }
+
+  VA_END (Args);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestUninstallMultipleProtocolInterfaces (
+  IN EFI_HANDLE  Handle,
+  ...
+  )
+{
+  mBlockIo  = NULL;
+  mBlockIo2 = NULL;
+  return EFI_SUCCESS;
+}
+
+//
+// UefiLib functions that VirtioBlk.c refers to outside of the code under test
+//
+
+EFI_STATUS
+EFIAPI
+EfiLibInstallDriverBindingComponentName2 (
+  IN CONST EFI_HANDLE                    ImageHandle,
+  IN CONST EFI_SYSTEM_TABLE              *SystemTable,
+  IN EFI_DRIVER_BINDING_PROTOCOL         *DriverBinding,
+  IN EFI_HANDLE                          DriverBindingHandle,
+  IN CONST EFI_COMPONENT_NAME_PROTOCOL   *ComponentName        OPTIONAL,
+  IN CONST EFI_COMPONENT_NAME2_PROTOCOL  *ComponentName2       OPTIONAL
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+LookupUnicodeString2 (
+  IN CONST CHAR8                     *Language,
+  IN CONST CHAR8                     *SupportedLanguages,
+  IN CONST EFI_UNICODE_STRING_TABLE  *UnicodeStringTable,
+  OUT CHAR16                         **UnicodeString,
+  IN BOOLEAN                         Iso639Language
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+//
+// VirtIo Device Protocol of the device model
+//
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestGetDeviceFeatures (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  OUT UINT64                  *DeviceFeatures
+  )
+{
+  *DeviceFeatures = mDeviceFeatures;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetGuestFeatures (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT64                  Features
+  )
+{
+  if ((Features & ~mDeviceFeatures) != 0) {
+    mDeviceError = TRUE;
+  }
+
+  mGuestFeatures = Features;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetQueueAddress (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN VRING                   *Ring,
+  IN UINT64                  RingBaseShift
+  )
+{
+  mRing         = Ring;
+  mLastAvailIdx = 0;
+  mPendingCount = 0;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetQueue16 (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT16                  Value
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetQueue32 (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT32                  Value
+  )
+{
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestGetQueueNumMax (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  OUT UINT16                  *QueueNumMax
+  )
+{
+  *QueueNumMax = TEST_QUEUE_SIZE;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestGetDeviceStatus (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  OUT UINT8                   *DeviceStatus
+  )
+{
+  *DeviceStatus = mDeviceStatus;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetDeviceStatus (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT8                   DeviceStatus
+  )
+{
+  mDeviceStatus = DeviceStatus;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestWriteDevice (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINTN                   FieldOffset,
+  IN UINTN                   FieldSize,
+  IN UINT64                  Value
+  )
+{
+  return EFI_ACCESS_DENIED;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestReadDevice (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  IN  UINTN                   FieldOffset,
+  IN  UINTN                   FieldSize,
+  IN  UINTN                   BufferSize,
+  OUT VOID                    *Buffer
+  )
+{
+  UINT64  Value;
+
+  if (FieldOffset == OFFSET_OF (VIRTIO_BLK_CONFIG, Capacity)) {
+    Value = TEST_DISK_SIZE / 512;
+  } else if (FieldOffset == OFFSET_OF (VIRTIO_BLK_CONFIG, SizeMax)) {
+    Value = TEST_SIZE_MAX;
+  } else if (FieldOffset == OFFSET_OF (VIRTIO_BLK_CONFIG, SegMax)) {
+    Value = TEST_SEG_MAX;
+  } else {
+    Value = 0;
+  }
+
+  CopyMem (Buffer, &Value, MIN (BufferSize, sizeof Value));
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestAllocateSharedPages (
+  IN  VIRTIO_DEVICE_PROTOCOL  *This,
+  IN  UINTN                   Pages,
+  OUT VOID                    **HostAddress
+  )
+{
+  *HostAddress = AllocateAlignedPages (Pages, EFI_PAGE_SIZE);
+  if (*HostAddress == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (*HostAddress, EFI_PAGES_TO_SIZE (Pages));
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+EFIAPI
+TestFreeSharedPages (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINTN                   Pages,
+  IN VOID                    *HostAddress
+  )
+{
+  FreeAlignedPages (HostAddress, Pages);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestMapSharedBuffer (
+  IN     VIRTIO_DEVICE_PROTOCOL  *This,
+  IN     VIRTIO_MAP_OPERATION    Operation,
+  IN     VOID                    *HostAddress,
+  IN OUT UINTN                   *NumberOfBytes,
+  OUT    EFI_PHYSICAL_ADDRESS    *DeviceAddress,
+  OUT    VOID                    **Mapping
+  )
+{
+  *DeviceAddress = (EFI_PHYSICAL_ADDRESS) (UINTN) HostAddress;
+  *Mapping       = HostAddress;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestUnmapSharedBuffer (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN VOID                    *Mapping
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  Take the chains the driver has made available, check them against the
+  limits of the device model, and schedule their completion.
+
+  @param[in]  This              The VirtIo Device Protocol of the model.
+  @param[in]  Index             The queue to process, always zero.
+
+  @retval EFI_SUCCESS           Always.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+TestSetQueueNotify (
+  IN VIRTIO_DEVICE_PROTOCOL  *This,
+  IN UINT16                  Index
+  )
+{
+  TEST_DEVICE_REQUEST  *Request;
+  volatile VRING_DESC  *Table;
+  VRING_DESC           Chain[TEST_MAX_CHAIN];
+  UINT32               ChainLength;
+  UINT16               DescIndex;
+  UINT32               Limit;
+  VIRTIO_BLK_REQ       *Header;
+  UINT32               DataIndex;
+  UINT16               DataFlags;
+
+  mNotifyCount++;
+
+  while (mLastAvailIdx != *mRing->Avail.Idx) {
+    ASSERT (mPendingCount < TEST_QUEUE_SIZE);
+    Request       = &mPending[mPendingCount];
+    Request->Head = mRing->Avail.Ring[mLastAvailIdx % mRing->QueueSize];
+    mLastAvailIdx++;
+
+    //
+    // Collect the chain, following an indirect table if there is one
+    //
+    Table       = mRing->Desc;
+    Limit       = mRing->QueueSize;
+    DescIndex   = Request->Head;
+    ChainLength = 0;
+    for ( ; ;) {
+      if ((DescIndex >= Limit) || (ChainLength == TEST_MAX_CHAIN)) {
+        ASSERT (FALSE);
+        mDeviceError = TRUE;
+        return EFI_DEVICE_ERROR;
+      }
+
+      if (Table == mRing->Desc) {
+        mRingDescCount++;
+      }
+
+      if ((Table[DescIndex].Flags & VRING_DESC_F_INDIRECT) != 0) {
+        if (((mGuestFeatures & VIRTIO_F_RING_INDIRECT_DESC) == 0) || (Table != mRing->Desc) ||
+            ((Table[DescIndex].Flags & VRING_DESC_F_NEXT) != 0))
+        {
+          ASSERT (FALSE);
+          mDeviceError = TRUE;
+          return EFI_DEVICE_ERROR;
+        }
+
+        Limit     = Table[DescIndex].Len / sizeof (VRING_DESC);
+        Table     = (volatile VRING_DESC *) (UINTN) Table[DescIndex].Addr;
+        DescIndex = 0;
+        continue;
+      }
+
+      CopyMem (&Chain[ChainLength++], (VOID *) &Table[DescIndex], sizeof Chain[0]);
+      if ((Table[DescIndex].Flags & VRING_DESC_F_NEXT) == 0) {
+        break;
+      }
+
+      DescIndex = Table[DescIndex].Next;
+    }
+
+    //
+    // A device readable header, at most TEST_SEG_MAX data descriptors of at
+    // most TEST_SIZE_MAX bytes each, and a device writable status byte
+    //
+    if ((ChainLength < 2) || (Chain[0].Len != sizeof (VIRTIO_BLK_REQ)) ||
+        ((Chain[0].Flags & VRING_DESC_F_WRITE) != 0) ||
+        (Chain[ChainLength - 1].Len != 1) ||
+        ((Chain[ChainLength - 1].Flags & VRING_DESC_F_WRITE) == 0))
+    {
+      ASSERT (FALSE);
+      mDeviceError = TRUE;
+      return EFI_DEVICE_ERROR;
+    }
+
+    if (ChainLength - 2 > TEST_SEG_MAX) {
+      mDeviceError = TRUE;
+    }
+
+    Header              = (VIRTIO_BLK_REQ *) (UINTN) Chain[0].Addr;
+    Request->Type       = Header->Type;
+    Request->Sector     = Header->Sector;
+    Request->DataCount  = ChainLength - 2;
+    Request->HostStatus = (UINT8 *) (UINTN) Chain[ChainLength - 1].Addr;
+    DataFlags           = (Request->Type == VIRTIO_BLK_T_IN) ? VRING_DESC_F_WRITE : 0;
+
+    if ((Request->Type == VIRTIO_BLK_T_FLUSH) != (Request->DataCount == 0)) {
+      mDeviceError = TRUE;
+    }
+
+    for (DataIndex = 0; DataIndex < Request->DataCount; DataIndex++) {
+      if ((Chain[DataIndex + 1].Len == 0) || (Chain[DataIndex + 1].Len > TEST_SIZE_MAX) ||
+          (Chain[DataIndex + 1].Len % 512 != 0) ||
+          ((Chain[DataIndex + 1].Flags & VRING_DESC_F_WRITE) != DataFlags))
+      {
+        mDeviceError = TRUE;
+      }
+
+      Request->DataAddress[DataIndex] = Chain[DataIndex + 1].Addr;
+      Request->DataLength[DataIndex]  = Chain[DataIndex + 1].Len;
+    }
+
+    Request->Due = mNow + TEST_LATENCY_USECS;
+    mPendingCount++;
+    mRequestCount++;
+    mMaxInFlight = MAX (mMaxInFlight, mPendingCount);
+  }
+
+  if ((mGuestFeatures & VIRTIO_F_RING_EVENT_IDX) != 0) {
+    *mRing->Used.AvailEvent = mLastAvailIdx;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Bind the driver to a fresh device model that offers the given features.
+
+  @param[in]  Features          The features the device model offers, in
+                                addition to VIRTIO_F_VERSION_1, SIZE_MAX,
+                                SEG_MAX and FLUSH.
+
+  @retval UNIT_TEST_PASSED      The driver produced Block I/O and Block I/O 2.
+  @retval UNIT_TEST_ERROR_TEST_FAILED The driver failed to bind.
+
+**/
+STATIC
+UNIT_TEST_STATUS
+TestStartDevice (
+  IN UINT64  Features
+  )
+{
+  UINTN  Offset;
+
+  mDeviceFeatures = VIRTIO_F_VERSION_1 | VIRTIO_BLK_F_SIZE_MAX |
+                    VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_FLUSH | Features;
+  mDeviceStatus  = 0;
+  mDeviceError   = FALSE;
+  mRandomState   = 1;
+  mNow           = 0;
+  mNotifyCount   = 0;
+  mRequestCount  = 0;
+  mRingDescCount = 0;
+  mMaxInFlight   = 0;
+
+  for (Offset = 0; Offset < TEST_DISK_SIZE; Offset += sizeof (UINT32)) {
+    *(UINT32 *) (mDisk + Offset) = (UINT32) (Offset * 2654435761U);
+  }
+  CopyMem (mShadow, mDisk, TEST_DISK_SIZE);
+
+  UT_ASSERT_NOT_EFI_ERROR (VirtioBlkDriverBindingStart (&mDriverBinding, mDeviceHandle, NULL));
+  UT_ASSERT_NOT_NULL (mBlockIo);
+  UT_ASSERT_NOT_NULL (mBlockIo2);
+  UT_ASSERT_EQUAL (mBlockIo->Media->LastBlock, TEST_DISK_SIZE / 512 - 1);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Unbind the driver from the device model after the test case, and close the
+  events of the Block I/O 2 tokens, which the driver may still have signaled
+  while stopping.
+
+  @param[in]  Context           Unused.
+
+**/
+VOID
+EFIAPI
+TestStopDevice (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  if (mBlockIo != NULL) {
+    VirtioBlkDriverBindingStop (&mDriverBinding, mDeviceHandle, 0, NULL);
+  }
+
+  for (Index = 0; Index < TEST_TOKEN_COUNT; Index++) {
+    if (mTokens[Index].Event != NULL) {
+      gBS->CloseEvent (mTokens[Index].Event);
+      mTokens[Index].Event = NULL;
+    }
+  }
+}
+
+/**
+  Read and write random block ranges, some of them larger than a single
+  virtio-blk request can transfer, and flush now and then. Check the data
+  read against the shadow copy of the disk, and every virtio-blk request
+  against the limits of the device.
+
+  @param[in]  Context           The ring features the device model offers.
+
+  @retval UNIT_TEST_PASSED      The disk and the data read match the shadow.
+  @retval UNIT_TEST_ERROR_TEST_FAILED Data mismatch, or a request broke the
+                                limits of the device.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RandomReadWriteShouldMatchShadow (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINTN             Step;
+  EFI_LBA           Lba;
+  UINTN             BlockCount;
+  UINTN             Size;
+  UINTN             Index;
+
+  Status = TestStartDevice ((UINT64) (UINTN) Context);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  for (Step = 0; Step < TEST_RANDOM_STEP_COUNT; Step++) {
+    BlockCount = 1 + (TestRandom () * TEST_RANDOM_MAX_BLOCKS) / 0x8000;
+    Lba        = (TestRandom () * 0x8000 + TestRandom ()) % (TEST_DISK_SIZE / 512 - BlockCount + 1);
+    Size       = BlockCount * 512;
+
+    switch (TestRandom () % 8) {
+      case 0:
+        UT_ASSERT_NOT_EFI_ERROR (mBlockIo->FlushBlocks (mBlockIo));
+        break;
+
+      case 1:
+      case 2:
+      case 3:
+        for (Index = 0; Index < Size; Index++) {
+          mBuffer[Index] = (UINT8) TestRandom ();
+        }
+        UT_ASSERT_NOT_EFI_ERROR (mBlockIo->WriteBlocks (mBlockIo, mBlockIo->Media->MediaId, Lba, Size, mBuffer));
+        CopyMem (mShadow + Lba * 512, mBuffer, Size);
+        break;
+
+      default:
+        UT_ASSERT_NOT_EFI_ERROR (mBlockIo->ReadBlocks (mBlockIo, mBlockIo->Media->MediaId, Lba, Size, mBuffer));
+        UT_ASSERT_MEM_EQUAL (mBuffer, mShadow + Lba * 512, Size);
+        break;
+    }
+
+    UT_ASSERT_FALSE (mDeviceError);
+  }
+
+  UT_ASSERT_MEM_EQUAL (mDisk, mShadow, TEST_DISK_SIZE);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Read the whole disk with a single ReadBlocks() call, and check that it is
+  split into virtio-blk requests that are in flight at the same time, and
+  that each of them takes a single ring descriptor with indirect descriptors.
+
+  @param[in]  Context           The ring features the device model offers.
+
+  @retval UNIT_TEST_PASSED      The requests overlapped.
+  @retval UNIT_TEST_ERROR_TEST_FAILED The requests were sent one by one, or
+                                took more ring descriptors than expected.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LargeReadShouldKeepRequestsInFlight (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+  UINT64            Features;
+
+  Features = (UINT64) (UINTN) Context;
+  Status   = TestStartDevice (Features);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  mNotifyCount   = 0;
+  mRequestCount  = 0;
+  mRingDescCount = 0;
+  mMaxInFlight   = 0;
+  mNow           = 0;
+
+  UT_ASSERT_NOT_EFI_ERROR (mBlockIo->ReadBlocks (mBlockIo, mBlockIo->Media->MediaId, 0, TEST_DISK_SIZE, mBuffer));
+  UT_ASSERT_MEM_EQUAL (mBuffer, mShadow, TEST_DISK_SIZE);
+  UT_ASSERT_FALSE (mDeviceError);
+
+  //
+  // Each virtio-blk request is limited to TEST_SEG_MAX segments of
+  // TEST_SIZE_MAX bytes with indirect descriptors, and to a single segment
+  // without them
+  //
+  if ((Features & VIRTIO_F_RING_INDIRECT_DESC) != 0) {
+    UT_ASSERT_EQUAL (mRequestCount, TEST_DISK_SIZE / (TEST_SEG_MAX * TEST_SIZE_MAX));
+    UT_ASSERT_EQUAL (mRingDescCount, mRequestCount);
+  } else {
+    UT_ASSERT_EQUAL (mRequestCount, TEST_DISK_SIZE / TEST_SIZE_MAX);
+    UT_ASSERT_EQUAL (mRingDescCount, 3 * mRequestCount);
+  }
+
+  UT_ASSERT_EQUAL (mMaxInFlight, MIN (mRequestCount, VBLK_MAX_IN_FLIGHT));
+
+  //
+  // All the requests that fit are made available before the first
+  // notification, so the whole read takes a few device latencies instead of
+  // one per request
+  //
+  UT_ASSERT_TRUE (mNotifyCount < mRequestCount);
+  UT_ASSERT_TRUE (mNow < (mRequestCount + VBLK_MAX_IN_FLIGHT - 1) / VBLK_MAX_IN_FLIGHT * 3 * TEST_LATENCY_USECS);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Keep TEST_TOKEN_COUNT Block I/O 2 reads outstanding, and check that the
+  poll timer completes all of them with the right data.
+
+  @param[in]  Context           The ring features the device model offers.
+
+  @retval UNIT_TEST_PASSED      All the tokens were signaled with the data.
+  @retval UNIT_TEST_ERROR_TEST_FAILED A token was not completed, or completed
+                                with wrong data.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TokensShouldCompleteFromPollTimer (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS     Status;
+  UINTN                Issued;
+  UINTN                Completed;
+  UINTN                Index;
+  TEST_EVENT           *Event;
+  UINT8                *Buffer;
+
+  Status = TestStartDevice ((UINT64) (UINTN) Context);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  mMaxInFlight = 0;
+
+  for (Index = 0; Index < TEST_TOKEN_COUNT; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (gBS->CreateEvent (0, TPL_CALLBACK, NULL, NULL, &mTokens[Index].Event));
+  }
+
+  Issued    = 0;
+  Completed = 0;
+  while (Completed < TEST_TOKEN_READ_COUNT) {
+    for (Index = 0; Index < TEST_TOKEN_COUNT; Index++) {
+      Event  = mTokens[Index].Event;
+      Buffer = mBuffer + Index * SIZE_4KB;
+      if (Issued > Index) {
+        if (!Event->Signaled) {
+          continue;
+        }
+
+        Event->Signaled = FALSE;
+        Completed++;
+        UT_ASSERT_NOT_EFI_ERROR (mTokens[Index].TransactionStatus);
+        UT_ASSERT_MEM_EQUAL (Buffer, mShadow + mTokenLbas[Index] * 512, SIZE_4KB);
+      }
+
+      if (Issued < TEST_TOKEN_READ_COUNT) {
+        mTokenLbas[Index] = ((TestRandom () * 0x8000 + TestRandom ()) % (TEST_DISK_SIZE / SIZE_4KB)) * (SIZE_4KB / 512);
+        UT_ASSERT_NOT_EFI_ERROR (mBlockIo2->ReadBlocksEx (mBlockIo2, mBlockIo->Media->MediaId, mTokenLbas[Index], &mTokens[Index], SIZE_4KB, Buffer));
+        Issued++;
+      }
+    }
+
+    gBS->Stall (10);
+    UT_ASSERT_TRUE (mNow < TEST_TOKEN_READ_COUNT * TEST_LATENCY_USECS);
+  }
+
+  //
+  // The reads overlap, so they take less time than one device latency each,
+  // even though the poll timer only completes them once per period
+  //
+  UT_ASSERT_EQUAL (mMaxInFlight, TEST_TOKEN_COUNT);
+  UT_ASSERT_TRUE (mNow < TEST_TOKEN_READ_COUNT * TEST_LATENCY_USECS / 2);
+  UT_ASSERT_FALSE (mDeviceError);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the request
+  queue of VirtioBlkDxe and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      QueueTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
+
+  MockBoot.RaiseTPL                            = TestRaiseTpl;
+  MockBoot.RestoreTPL                          = TestRestoreTpl;
+  MockBoot.Stall                               = TestStall;
+  MockBoot.CreateEvent                         = TestCreateEvent;
+  MockBoot.SetTimer                            = TestSetTimer;
+  MockBoot.SignalEvent                         = TestSignalEvent;
+  MockBoot.CloseEvent                          = TestCloseEvent;
+  MockBoot.OpenProtocol                        = TestOpenProtocol;
+  MockBoot.CloseProtocol                       = TestCloseProtocol;
+  MockBoot.InstallMultipleProtocolInterfaces   = TestInstallMultipleProtocolInterfaces;
+  MockBoot.UninstallMultipleProtocolInterfaces = TestUninstallMultipleProtocolInterfaces;
+
+  mVirtIo.Revision            = VIRTIO_SPEC_REVISION (1, 0, 0);
+  mVirtIo.SubSystemDeviceId   = VIRTIO_SUBSYSTEM_BLOCK_DEVICE;
+  mVirtIo.GetDeviceFeatures   = TestGetDeviceFeatures;
+  mVirtIo.SetGuestFeatures    = TestSetGuestFeatures;
+  mVirtIo.SetQueueAddress     = TestSetQueueAddress;
+  mVirtIo.SetQueueSel         = TestSetQueue16;
+  mVirtIo.SetQueueNotify      = TestSetQueueNotify;
+  mVirtIo.SetQueueAlign       = TestSetQueue32;
+  mVirtIo.SetPageSize         = TestSetQueue32;
+  mVirtIo.GetQueueNumMax      = TestGetQueueNumMax;
+  mVirtIo.SetQueueNum         = TestSetQueue16;
+  mVirtIo.GetDeviceStatus     = TestGetDeviceStatus;
+  mVirtIo.SetDeviceStatus     = TestSetDeviceStatus;
+  mVirtIo.WriteDevice         = TestWriteDevice;
+  mVirtIo.ReadDevice          = TestReadDevice;
+  mVirtIo.AllocateSharedPages = TestAllocateSharedPages;
+  mVirtIo.FreeSharedPages     = TestFreeSharedPages;
+  mVirtIo.MapSharedBuffer     = TestMapSharedBuffer;
+  mVirtIo.UnmapSharedBuffer   = TestUnmapSharedBuffer;
+
+  mDriverBinding.DriverBindingHandle = (EFI_HANDLE) &mDriverBinding;
+
+  mDisk   = AllocatePool (TEST_DISK_SIZE);
+  mShadow = AllocatePool (TEST_DISK_SIZE);
+  mBuffer = AllocatePool (TEST_DISK_SIZE);
+  if ((mDisk == NULL) || (mShadow == NULL) || (mBuffer == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_APP_NAME, gEfiCallerBaseName, UNIT_TEST_APP_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&QueueTests, Framework, "VirtioBlk Request Queue Tests", "VirtioBlk.Queue", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for QueueTests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (QueueTests, "Random read/write should match the shadow disk", "Random", RandomReadWriteShouldMatchShadow, NULL, TestStopDevice, (UNIT_TEST_CONTEXT) (UINTN) (VIRTIO_F_RING_INDIRECT_DESC | VIRTIO_F_RING_EVENT_IDX));
+  AddTestCase (QueueTests, "Random read/write without indirect descriptors should match the shadow disk", "RandomDirect", RandomReadWriteShouldMatchShadow, NULL, TestStopDevice, (UNIT_TEST_CONTEXT) (UINTN) 0);
+  AddTestCase (QueueTests, "Large read should keep requests in flight", "LargeRead", LargeReadShouldKeepRequestsInFlight, NULL, TestStopDevice, (UNIT_TEST_CONTEXT) (UINTN) (VIRTIO_F_RING_INDIRECT_DESC | VIRTIO_F_RING_EVENT_IDX));
+  AddTestCase (QueueTests, "Large read without indirect descriptors should keep requests in flight", "LargeReadDirect", LargeReadShouldKeepRequestsInFlight, NULL, TestStopDevice, (UNIT_TEST_CONTEXT) (UINTN) 0);
+  AddTestCase (QueueTests, "Block I/O 2 tokens should complete from the poll timer", "Tokens", TokensShouldCompleteFromPollTimer, NULL, TestStopDevice, (UNIT_TEST_CONTEXT) (UINTN) (VIRTIO_F_RING_INDIRECT_DESC | VIRTIO_F_RING_EVENT_IDX));
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+  if (mBuffer != NULL) {
+    FreePool (mBuffer);
+  }
+  if (mShadow != NULL) {
+    FreePool (mShadow);
+  }
+  if (mDisk != NULL) {
+    FreePool (mDisk);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -1,14 +1,25 @@
 /** @file
 
-  This driver produces Block I/O Protocol instances for virtio-blk devices.
+  This driver produces Block I/O and Block I/O 2 Protocol instances for
+  virtio-blk devices.
 
   The implementation is basic:
 
   - No attach/detach (ie. removable media).
 
-  - Although the non-blocking interfaces of EFI_BLOCK_IO2_PROTOCOL could be a
-    good match for multiple in-flight virtio-blk requests, we stick to
-    synchronous requests and EFI_BLOCK_IO_PROTOCOL for now.
+  - Requests (blocking and non-blocking alike) are queued, split into
+    virtio-blk requests of at most MaxTransfer bytes, and handed to the device
+    as request slots become free, so that many virtio-blk requests are in
+    flight at the same time. The used ring is polled: by blocking requests
+    while they wait, and by a periodic timer while non-blocking requests are
+    outstanding.
+
+  - Indirect descriptors (VIRTIO_F_RING_INDIRECT_DESC) let each in-flight
+    request occupy a single descriptor of the ring, and VIRTIO_F_RING_EVENT_IDX
+    lets us skip notifications the device does not need.
+
+  - Virtio 1.0 devices that offer VIRTIO_F_RING_PACKED get a packed
+    virtqueue.
 
   Copyright (C) 2012, Red Hat, Inc.
   Copyright (c) 2012 - 2018, Intel Corporation. All rights reserved.<BR>
@@ -18,6 +29,8 @@
 
 **/
 
+#include <Uefi.h>
+
 #include <IndustryStandard/VirtioBlk.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
@@ -178,279 +191,589 @@ VerifyReadWriteRequest (
 
 /**
 
-  Format a read / write / flush request as three consecutive virtio
-  descriptors, push them to the host, and poll for the response.
+  Append a descriptor to the virtio-blk request being built in a request slot:
+  to the slot's indirect table with VIRTIO_F_RING_INDIRECT_DESC, otherwise
+  directly to the ring.
 
-  This is the main workhorse function. Two use cases are supported, read/write
-  and flush. The function may only be called after the request parameters have
-  been verified by
-  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks(), and
-  - VerifyReadWriteRequest() (for read/write only).
+  @param[in] Dev                   The virtio-blk device.
 
-  Parameters handled commonly:
+  @param[in out] Shared            The request slot's shared area.
 
-    @param[in] Dev             The virtio-blk device the request is targeted
-                               at.
+  @param[in out] Indices           The chain being built in the ring.
 
-  Flush request:
+  @param[in out] DescCount         The number of descriptors appended so far;
+                                   incremented.
 
-    @param[in] Lba             Must be zero.
+  @param[in] BufferDeviceAddress   (Bus master device) start address of the
+                                   buffer.
 
-    @param[in] BufferSize      Must be zero.
+  @param[in] BufferSize            Number of bytes in the buffer.
 
-    @param[in out] Buffer      Ignored by the function.
+  @param[in] Flags                 VRING_DESC_F_NEXT and/or VRING_DESC_F_WRITE.
 
-    @param[in] RequestIsWrite  Must be TRUE.
+**/
+STATIC
+VOID
+AppendSlotDesc (
+  IN     VBLK_DEV         *Dev,
+  IN OUT VBLK_SHARED_SLOT *Shared,
+  IN OUT DESC_INDICES     *Indices,
+  IN OUT UINT16           *DescCount,
+  IN     UINT64           BufferDeviceAddress,
+  IN     UINT32           BufferSize,
+  IN     UINT16           Flags
+  )
+{
+  VRING_DESC        *Desc;
+  VRING_PACKED_DESC *PackedDesc;
 
-  Read/Write request:
+  if (!Dev->Indirect) {
+    VirtioAppendDesc (
+      &Dev->Ring,
+      BufferDeviceAddress,
+      BufferSize,
+      Flags,
+      Indices
+      );
+  } else if (Dev->Ring.Packed) {
+    //
+    // In a packed indirect table, the descriptors are chained implicitly.
+    //
+    PackedDesc        = &Shared->Indirect.Packed[*DescCount];
+    PackedDesc->Addr  = BufferDeviceAddress;
+    PackedDesc->Len   = BufferSize;
+    PackedDesc->Id    = 0;
+    PackedDesc->Flags = (UINT16)(Flags & ~VRING_DESC_F_NEXT);
+  } else {
+    Desc        = &Shared->Indirect.Split[*DescCount];
+    Desc->Addr  = BufferDeviceAddress;
+    Desc->Len   = BufferSize;
+    Desc->Flags = Flags;
+    Desc->Next  = (UINT16)(*DescCount + 1);
+  }
+  (*DescCount)++;
+}
 
-    @param[in] Lba             Logical Block Address: number of logical blocks
-                               to skip from the beginning of the device.
 
-    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
-                               is responsible to ensure this parameter is
-                               positive.
+/**
 
-    @param[in out] Buffer      The guest side area to read data from the device
-                               into, or write data to the device from.
+  Format the next virtio-blk request of a queued Block I/O request in a free
+  request slot.
 
-    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
-                               device.
+  The virtio-blk request header goes into the first descriptor, the data area
+  (if any) is described by one or more data descriptors of at most
+  Dev->SegmentSize bytes each, and the host status byte goes into the last
+  descriptor. With VIRTIO_F_RING_INDIRECT_DESC, these descriptors form the
+  indirect table of the slot, and the slot occupies a single descriptor of the
+  ring. Otherwise the slot's chain takes three descriptors of the ring.
 
-  Return values are common to both use cases, and are appropriate to be
-  forwarded by the EFI_BLOCK_IO_PROTOCOL functions (ReadBlocks(),
-  WriteBlocks(), FlushBlocks()).
+  The chain is made available to the device under the buffer ID returned by
+  VBLK_SLOT_BUFFER_ID(), but the device is not notified.
 
+  @param[in out] Dev      The virtio-blk device. The caller is responsible for
+                          raising the TPL to TPL_NOTIFY.
 
-  @retval EFI_SUCCESS          Transfer complete.
+  @param[in out] Request  The queued request to format the next virtio-blk
+                          request of. Request->SubmittedSize and
+                          Request->AllSubmitted are advanced.
 
-  @retval EFI_DEVICE_ERROR     Failed to notify host side via VirtIo write, or
-                               unable to parse host response, or host response
-                               is not VIRTIO_BLK_S_OK or failed to map Buffer
-                               for a bus master operation.
+  @param[in] Slot         The free request slot to use.
 
 **/
-
 STATIC
-EFI_STATUS
-EFIAPI
-SynchronousRequest (
-  IN              VBLK_DEV *Dev,
-  IN              EFI_LBA  Lba,
-  IN              UINTN    BufferSize,
-  IN OUT volatile VOID     *Buffer,
-  IN              BOOLEAN  RequestIsWrite
+VOID
+PrepareSlot (
+  IN OUT VBLK_DEV     *Dev,
+  IN OUT VBLK_REQUEST *Request,
+  IN     UINT16       Slot
   )
 {
-  UINT32                  BlockSize;
-  volatile VIRTIO_BLK_REQ Request;
-  volatile UINT8          *HostStatus;
-  VOID                    *HostStatusBuffer;
-  DESC_INDICES            Indices;
-  VOID                    *RequestMapping;
-  VOID                    *StatusMapping;
-  VOID                    *BufferMapping;
-  EFI_PHYSICAL_ADDRESS    BufferDeviceAddress;
-  EFI_PHYSICAL_ADDRESS    HostStatusDeviceAddress;
-  EFI_PHYSICAL_ADDRESS    RequestDeviceAddress;
-  EFI_STATUS              Status;
-  EFI_STATUS              UnmapStatus;
+  UINT32               BlockSize;
+  VBLK_SHARED_SLOT     *Shared;
+  EFI_PHYSICAL_ADDRESS SharedDeviceAddress;
+  DESC_INDICES         Indices;
+  UINT16               DescCount;
+  UINTN                Offset;
+  UINTN                Length;
+  UINT32               SegmentLength;
 
-  BlockSize = Dev->BlockIoMedia.BlockSize;
+  BlockSize           = Dev->BlockIoMedia.BlockSize;
+  Shared              = &Dev->Shared[Slot];
+  SharedDeviceAddress = Dev->SharedDeviceAddress + Slot * sizeof *Shared;
+  Offset              = Request->SubmittedSize;
+  Length              = MIN (Request->BufferSize - Offset, Dev->MaxTransfer);
 
   //
-  // Set BufferMapping and BufferDeviceAddress to suppress incorrect
-  // compiler/analyzer warnings.
+  // ensured by VirtioBlkInit() and QueueRequest()
   //
-  BufferMapping       = NULL;
-  BufferDeviceAddress = 0;
+  ASSERT (Offset % BlockSize == 0);
+  ASSERT (Length % BlockSize == 0);
 
   //
-  // ensured by VirtioBlkInit()
+  // Prepare virtio-blk request header, setting zero size for flush.
+  // IO Priority is homogeneously 0.
   //
-  ASSERT (BlockSize > 0);
-  ASSERT (BlockSize % 512 == 0);
+  Shared->Header.Type   = Request->RequestIsWrite ?
+                          (Request->BufferSize == 0 ?
+                           VIRTIO_BLK_T_FLUSH :
+                           VIRTIO_BLK_T_OUT) :
+                          VIRTIO_BLK_T_IN;
+  Shared->Header.IoPrio = 0;
+  Shared->Header.Sector = MultU64x32 (
+                            Request->Lba + Offset / BlockSize,
+                            BlockSize / 512
+                            );
 
   //
-  // ensured by contract above, plus VerifyReadWriteRequest()
+  // preset a host status for ourselves that we do not accept as success
   //
-  ASSERT (BufferSize % BlockSize == 0);
+  Shared->HostStatus = VIRTIO_BLK_S_IOERR;
+
+  VirtioStartChain (&Dev->Ring, VBLK_SLOT_BUFFER_ID (Dev, Slot), &Indices);
 
   //
-  // Prepare virtio-blk request header, setting zero size for flush.
-  // IO Priority is homogeneously 0.
+  // virtio-blk header in first desc
   //
-  Request.Type   = RequestIsWrite ?
-                   (BufferSize == 0 ? VIRTIO_BLK_T_FLUSH : VIRTIO_BLK_T_OUT) :
-                   VIRTIO_BLK_T_IN;
-  Request.IoPrio = 0;
-  Request.Sector = MultU64x32(Lba, BlockSize / 512);
+  DescCount = 0;
+  AppendSlotDesc (
+    Dev,
+    Shared,
+    &Indices,
+    &DescCount,
+    SharedDeviceAddress + OFFSET_OF (VBLK_SHARED_SLOT, Header),
+    sizeof Shared->Header,
+    VRING_DESC_F_NEXT
+    );
 
   //
-  // Host status is bi-directional (we preset with a value and expect the
-  // device to update it). Allocate a host status buffer which can be mapped
-  // to access equally by both processor and the device.
-  //
-  Status = Dev->VirtIo->AllocateSharedPages (
-                          Dev->VirtIo,
-                          EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                          &HostStatusBuffer
-                          );
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
-  }
+  // data buffer for read/write in the following descriptors; VRING_DESC_F_WRITE
+  // is interpreted from the host's point of view.
+  //
+  while (Length > 0) {
+    SegmentLength = (UINT32)MIN (Length, Dev->SegmentSize);
+    AppendSlotDesc (
+      Dev,
+      Shared,
+      &Indices,
+      &DescCount,
+      Request->BufferDeviceAddress + Offset,
+      SegmentLength,
+      (UINT16)(VRING_DESC_F_NEXT |
+               (Request->RequestIsWrite ? 0 : VRING_DESC_F_WRITE))
+      );
 
-  HostStatus = HostStatusBuffer;
+    Offset += SegmentLength;
+    Length -= SegmentLength;
+  }
 
   //
-  // Map virtio-blk request header (must be done after request header is
-  // populated)
+  // host status in last desc
   //
-  Status = VirtioMapAllBytesInSharedBuffer (
-             Dev->VirtIo,
-             VirtioOperationBusMasterRead,
-             (VOID *) &Request,
-             sizeof Request,
-             &RequestDeviceAddress,
-             &RequestMapping
-             );
-  if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto FreeHostStatusBuffer;
-  }
+  AppendSlotDesc (
+    Dev,
+    Shared,
+    &Indices,
+    &DescCount,
+    SharedDeviceAddress + OFFSET_OF (VBLK_SHARED_SLOT, HostStatus),
+    sizeof Shared->HostStatus,
+    VRING_DESC_F_WRITE
+    );
 
   //
-  // Map data buffer
+  // ensured by VirtioBlkInit()
   //
-  if (BufferSize > 0) {
-    Status = VirtioMapAllBytesInSharedBuffer (
-               Dev->VirtIo,
-               (RequestIsWrite ?
-                VirtioOperationBusMasterRead :
-                VirtioOperationBusMasterWrite),
-               (VOID *) Buffer,
-               BufferSize,
-               &BufferDeviceAddress,
-               &BufferMapping
-               );
-    if (EFI_ERROR (Status)) {
-      Status = EFI_DEVICE_ERROR;
-      goto UnmapRequestBuffer;
-    }
+  ASSERT (DescCount <=
+          (Dev->Indirect ? ARRAY_SIZE (Shared->Indirect.Split) : 3));
+
+  if (Dev->Indirect) {
+    VirtioAppendDesc (
+      &Dev->Ring,
+      SharedDeviceAddress + OFFSET_OF (VBLK_SHARED_SLOT, Indirect),
+      (UINT32)(DescCount * sizeof (VRING_DESC)),
+      VRING_DESC_F_INDIRECT,
+      &Indices
+      );
   }
 
-  //
-  // preset a host status for ourselves that we do not accept as success
-  //
-  *HostStatus = VIRTIO_BLK_S_IOERR;
+  Request->SubmittedSize = Offset;
+  Request->AllSubmitted  = (BOOLEAN)(Offset == Request->BufferSize);
+  Request->InFlight++;
+  Dev->SlotRequest[Slot] = Request;
+
+  VirtioMakeAvailable (&Dev->Ring, &Indices, VBLK_SLOT_BUFFER_ID (Dev, Slot));
+}
+
+
+/**
+
+  Hand as many virtio-blk requests of the queued Block I/O requests to the
+  device as there are free request slots, in queue order, and notify the
+  device if it asked for that.
+
+  A flush request is only submitted when all requests queued before it have
+  been completed, and no request queued after it is submitted before it.
+
+  @param[in out] Dev  The virtio-blk device. The caller is responsible for
+                      raising the TPL to TPL_NOTIFY.
+
+**/
+STATIC
+VOID
+SubmitRequests (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  LIST_ENTRY   *Entry;
+  VBLK_REQUEST *Request;
+  UINT16       Slot;
+  EFI_STATUS   Status;
+
+  for (Entry = GetFirstNode (&Dev->RequestList);
+       !IsNull (&Dev->RequestList, Entry) && Dev->FreeSlotCount > 0;
+       Entry = GetNextNode (&Dev->RequestList, Entry)) {
+    Request = VBLK_REQUEST_FROM_LINK (Entry);
+    if (Request->AllSubmitted) {
+      continue;
+    }
+    if (Request->BufferSize == 0 && Dev->FreeSlotCount < Dev->SlotCount) {
+      break;
+    }
+
+    while (Dev->FreeSlotCount > 0 && !Request->AllSubmitted) {
+      Slot = Dev->FreeSlotStack[--Dev->FreeSlotCount];
+      PrepareSlot (Dev, Request, Slot);
+    }
+  }
 
   //
-  // Map the Status Buffer with VirtioOperationBusMasterCommonBuffer so that
-  // both processor and device can access it.
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device. If the notification fails, it
+  // is retried the next time we come here.
   //
-  Status = VirtioMapAllBytesInSharedBuffer (
+  Status = VirtioKick (
              Dev->VirtIo,
-             VirtioOperationBusMasterCommonBuffer,
-             HostStatusBuffer,
-             sizeof *HostStatus,
-             &HostStatusDeviceAddress,
-             &StatusMapping
+             0,
+             &Dev->Ring,
+             Dev->EventIdx,
+             &Dev->NotifiedAvailIdx
              );
   if (EFI_ERROR (Status)) {
-    Status = EFI_DEVICE_ERROR;
-    goto UnmapDataBuffer;
+    DEBUG ((DEBUG_ERROR, "%a: SetQueueNotify(): %r\n", __FUNCTION__, Status));
   }
+}
 
-  VirtioPrepare (&Dev->Ring, &Indices);
 
-  //
-  // ensured by VirtioBlkInit() -- this predicate, in combination with the
-  // lock-step progress, ensures we don't have to track free descriptors.
-  //
-  ASSERT (Dev->Ring.QueueSize >= 3);
+/**
+
+  Finish a Block I/O request whose virtio-blk requests have all been completed
+  by the device: unmap its data buffer and remove it from the queue.
+
+  A non-blocking request is freed after its token is signaled. A blocking
+  request is only marked completed; its submitter frees it.
+
+  @param[in out] Dev      The virtio-blk device. The caller is responsible for
+                          raising the TPL to TPL_NOTIFY.
+
+  @param[in out] Request  The request to finish.
+
+**/
+STATIC
+VOID
+CompleteRequest (
+  IN OUT VBLK_DEV     *Dev,
+  IN OUT VBLK_REQUEST *Request
+  )
+{
+  EFI_STATUS UnmapStatus;
+
+  if (Request->BufferSize > 0) {
+    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (
+                                 Dev->VirtIo,
+                                 Request->BufferMapping
+                                 );
+    if (EFI_ERROR (UnmapStatus) && !Request->RequestIsWrite) {
+      //
+      // Data from the bus master may not reach the caller; fail the request.
+      //
+      Request->Status = EFI_DEVICE_ERROR;
+    }
+  }
+
+  RemoveEntryList (&Request->Link);
+
+  if (Request->Token == NULL) {
+    Request->Completed = TRUE;
+    return;
+  }
+
+  Request->Token->TransactionStatus = Request->Status;
+  gBS->SignalEvent (Request->Token->Event);
+  FreePool (Request);
+}
+
+
+/**
+
+  Collect the virtio-blk requests that the device has completed since the last
+  call, release their request slots, finish the Block I/O requests that are
+  done, and submit further virtio-blk requests into the freed slots.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+STATIC
+VOID
+ProcessRequests (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  EFI_TPL      OldTpl;
+  UINT16       BufferId;
+  UINT16       Slot;
+  VBLK_REQUEST *Request;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
 
   //
-  // virtio-blk header in first desc
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
   //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    RequestDeviceAddress,
-    sizeof Request,
-    VRING_DESC_F_NEXT,
-    &Indices
-    );
+  while (!EFI_ERROR (VirtioPeekUsed (&Dev->Ring, &BufferId, NULL))) {
+    VirtioReleaseUsed (&Dev->Ring);
+    Slot = (UINT16)(Dev->Indirect ? BufferId : BufferId / 3);
+    ASSERT (Slot < Dev->SlotCount);
+
+    Request = Dev->SlotRequest[Slot];
+    ASSERT (Request != NULL);
+    if (Dev->Shared[Slot].HostStatus != VIRTIO_BLK_S_OK) {
+      Request->Status = EFI_DEVICE_ERROR;
+    }
+
+    Dev->SlotRequest[Slot] = NULL;
+    Dev->FreeSlotStack[Dev->FreeSlotCount++] = Slot;
+
+    ASSERT (Request->InFlight > 0);
+    Request->InFlight--;
+    if (Request->AllSubmitted && Request->InFlight == 0) {
+      CompleteRequest (Dev, Request);
+    }
+  }
 
   //
-  // data buffer for read/write in second desc
+  // With VIRTIO_F_RING_EVENT_IDX, keep UsedEvent far enough ahead of the used
+  // ring that the device never reaches it, and so never interrupts us. A
+  // packed ring has interrupts disabled altogether.
   //
-  if (BufferSize > 0) {
-    //
-    // From virtio-0.9.5, 2.3.2 Descriptor Table:
-    // "no descriptor chain may be more than 2^32 bytes long in total".
-    //
-    // The predicate is ensured by the call contract above (for flush), or
-    // VerifyReadWriteRequest() (for read/write). It also implies that
-    // converting BufferSize to UINT32 will not truncate it.
-    //
-    ASSERT (BufferSize <= SIZE_1GB);
+  if (Dev->EventIdx && !Dev->Ring.Packed) {
+    *Dev->Ring.Avail.UsedEvent =
+      (UINT16)(Dev->Ring.LastUsedIdx + VBLK_USED_EVENT_DISTANCE);
+  }
 
-    //
-    // VRING_DESC_F_WRITE is interpreted from the host's point of view.
-    //
-    VirtioAppendDesc (
-      &Dev->Ring,
-      BufferDeviceAddress,
-      (UINT32) BufferSize,
-      VRING_DESC_F_NEXT | (RequestIsWrite ? 0 : VRING_DESC_F_WRITE),
-      &Indices
-      );
+  SubmitRequests (Dev);
+
+  gBS->RestoreTPL (OldTpl);
+}
+
+
+/**
+
+  Timer notification function that drives non-blocking requests to
+  completion. The timer cancels itself when no requests are left.
+
+  @param[in] Event    Event whose notification function is being invoked.
+
+  @param[in] Context  Pointer to the VBLK_DEV structure.
+
+**/
+STATIC
+VOID
+EFIAPI
+VirtioBlkPoll (
+  IN  EFI_EVENT Event,
+  IN  VOID      *Context
+  )
+{
+  VBLK_DEV *Dev;
+
+  Dev = Context;
+  ProcessRequests (Dev);
+  if (IsListEmpty (&Dev->RequestList)) {
+    gBS->SetTimer (Dev->PollTimer, TimerCancel, 0);
   }
+}
+
+
+/**
+
+  Poll the device until a condition is met, slowing down until a poll period
+  of slightly above 1 ms is reached (the same way VirtioFlush() does).
+
+  @param[in out] Dev      The virtio-blk device.
+
+  @param[in] Request      If not NULL, a blocking request to wait for.
+                          Otherwise wait until no requests are queued.
+
+**/
+STATIC
+VOID
+WaitForRequests (
+  IN OUT   VBLK_DEV     *Dev,
+  IN CONST VBLK_REQUEST *Request OPTIONAL
+  )
+{
+  UINTN PollPeriodUsecs;
+
+  PollPeriodUsecs = 1;
+  for (;;) {
+    ProcessRequests (Dev);
+    if (Request != NULL ?
+        Request->Completed :
+        IsListEmpty (&Dev->RequestList)) {
+      break;
+    }
+
+    gBS->Stall (PollPeriodUsecs); // calls AcpiTimerLib::MicroSecondDelay
+
+    if (PollPeriodUsecs < 1024) {
+      PollPeriodUsecs *= 2;
+    }
+  }
+}
+
+
+/**
+
+  Queue a read / write / flush request and, unless it is non-blocking, wait
+  until the device has completed it.
+
+  This is the main workhorse function. Two use cases are supported, read/write
+  and flush. The function may only be called after the request parameters have
+  been verified by
+  - specific checks in ReadBlocks() / WriteBlocks() / FlushBlocks() and their
+    Ex variants, and
+  - VerifyReadWriteRequest() (for read/write only).
+
+  Parameters handled commonly:
+
+    @param[in] Dev             The virtio-blk device the request is targeted
+                               at.
+
+    @param[in out] Token       If NULL, the request is blocking. Otherwise the
+                               function returns as soon as the request is
+                               queued, and Token->Event is signaled after
+                               Token->TransactionStatus has been set.
+
+  Flush request:
+
+    @param[in] Lba             Must be zero.
+
+    @param[in] BufferSize      Must be zero.
+
+    @param[in out] Buffer      Ignored by the function.
+
+    @param[in] RequestIsWrite  Must be TRUE.
+
+  Read/Write request:
+
+    @param[in] Lba             Logical Block Address: number of logical blocks
+                               to skip from the beginning of the device.
+
+    @param[in] BufferSize      Size of buffer to transfer, in bytes. The caller
+                               is responsible to ensure this parameter is
+                               positive.
+
+    @param[in out] Buffer      The guest side area to read data from the device
+                               into, or write data to the device from.
+
+    @param[in] RequestIsWrite  TRUE iff data transfer goes from guest to
+                               device.
+
+  Return values are common to both use cases, and are appropriate to be
+  forwarded by the EFI_BLOCK_IO_PROTOCOL and EFI_BLOCK_IO2_PROTOCOL functions.
+
+
+  @retval EFI_SUCCESS           Transfer complete (blocking request), or
+                                request queued (non-blocking request).
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @retval EFI_DEVICE_ERROR      Unable to parse host response, or host
+                                response is not VIRTIO_BLK_S_OK, or failed to
+                                map Buffer for a bus master operation.
+
+**/
+STATIC
+EFI_STATUS
+QueueRequest (
+  IN     VBLK_DEV            *Dev,
+  IN     EFI_LBA             Lba,
+  IN     UINTN               BufferSize,
+  IN OUT VOID                *Buffer,
+  IN     BOOLEAN             RequestIsWrite,
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token OPTIONAL
+  )
+{
+  VBLK_REQUEST *Request;
+  EFI_STATUS   Status;
+  EFI_TPL      OldTpl;
 
   //
-  // host status in last (second or third) desc
+  // ensured by VirtioBlkInit()
   //
-  VirtioAppendDesc (
-    &Dev->Ring,
-    HostStatusDeviceAddress,
-    sizeof *HostStatus,
-    VRING_DESC_F_WRITE,
-    &Indices
-    );
+  ASSERT (Dev->BlockIoMedia.BlockSize > 0);
+  ASSERT (Dev->BlockIoMedia.BlockSize % 512 == 0);
 
   //
-  // virtio-blk's only virtqueue is #0, called "requestq" (see Appendix D).
+  // ensured by contract above, plus VerifyReadWriteRequest()
   //
-  if (VirtioFlush (Dev->VirtIo, 0, &Dev->Ring, &Indices,
-        NULL) == EFI_SUCCESS &&
-      *HostStatus == VIRTIO_BLK_S_OK) {
-    Status = EFI_SUCCESS;
-  } else {
-    Status = EFI_DEVICE_ERROR;
+  ASSERT (BufferSize % Dev->BlockIoMedia.BlockSize == 0);
+  ASSERT (BufferSize <= SIZE_1GB);
+
+  Request = AllocateZeroPool (sizeof *Request);
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
   }
 
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, StatusMapping);
+  Request->Signature      = VBLK_REQ_SIG;
+  Request->Token          = Token;
+  Request->Lba            = Lba;
+  Request->BufferSize     = BufferSize;
+  Request->RequestIsWrite = RequestIsWrite;
+  Request->Status         = EFI_SUCCESS;
 
-UnmapDataBuffer:
+  //
+  // Map data buffer
+  //
   if (BufferSize > 0) {
-    UnmapStatus = Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, BufferMapping);
-    if (EFI_ERROR (UnmapStatus) && !RequestIsWrite && !EFI_ERROR (Status)) {
-      //
-      // Data from the bus master may not reach the caller; fail the request.
-      //
-      Status = EFI_DEVICE_ERROR;
+    Status = VirtioMapAllBytesInSharedBuffer (
+               Dev->VirtIo,
+               (RequestIsWrite ?
+                VirtioOperationBusMasterRead :
+                VirtioOperationBusMasterWrite),
+               Buffer,
+               BufferSize,
+               &Request->BufferDeviceAddress,
+               &Request->BufferMapping
+               );
+    if (EFI_ERROR (Status)) {
+      FreePool (Request);
+      return EFI_DEVICE_ERROR;
     }
   }
 
-UnmapRequestBuffer:
-  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, RequestMapping);
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  InsertTailList (&Dev->RequestList, &Request->Link);
+  if (Token != NULL) {
+    gBS->SetTimer (Dev->PollTimer, TimerPeriodic, VBLK_POLL_PERIOD);
+  }
+  SubmitRequests (Dev);
+  gBS->RestoreTPL (OldTpl);
 
-FreeHostStatusBuffer:
-  Dev->VirtIo->FreeSharedPages (
-                 Dev->VirtIo,
-                 EFI_SIZE_TO_PAGES (sizeof *HostStatus),
-                 HostStatusBuffer
-                 );
+  if (Token != NULL) {
+    return EFI_SUCCESS;
+  }
 
+  WaitForRequests (Dev, Request);
+  Status = Request->Status;
+  FreePool (Request);
   return Status;
 }
 
@@ -466,7 +789,7 @@ FreeHostStatusBuffer:
     ReadBlocksEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and QueueRequest().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -501,12 +824,13 @@ VirtioBlkReadBlocks (
     return Status;
   }
 
-  return SynchronousRequest (
+  return QueueRequest (
            Dev,
            Lba,
            BufferSize,
            Buffer,
-           FALSE       // RequestIsWrite
+           FALSE,      // RequestIsWrite
+           NULL        // Token
            );
 }
 
@@ -521,7 +845,7 @@ VirtioBlkReadBlocks (
     WriteBlockEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and QueueRequest().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -556,12 +880,13 @@ VirtioBlkWriteBlocks (
     return Status;
   }
 
-  return SynchronousRequest (
+  return QueueRequest (
            Dev,
            Lba,
            BufferSize,
            Buffer,
-           TRUE        // RequestIsWrite
+           TRUE,       // RequestIsWrite
+           NULL        // Token
            );
 }
 
@@ -593,17 +918,206 @@ VirtioBlkFlushBlocks (
 
   Dev = VIRTIO_BLK_FROM_BLOCK_IO (This);
   return Dev->BlockIoMedia.WriteCaching ?
-           SynchronousRequest (
+           QueueRequest (
              Dev,
              0,    // Lba
              0,    // BufferSize
              NULL, // Buffer
-             TRUE  // RequestIsWrite
+             TRUE, // RequestIsWrite
+             NULL  // Token
              ) :
            EFI_SUCCESS;
 }
 
 
+//
+// UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol
+//
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  WaitForRequests (VIRTIO_BLK_FROM_BLOCK_IO2 (This), NULL);
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  Complete a Block I/O 2 request that needs no device access.
+
+  @param[in out] Token  The token passed to the Ex function, or NULL.
+
+  @retval EFI_SUCCESS  Always.
+
+**/
+STATIC
+EFI_STATUS
+CompleteEmptyRequest (
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token OPTIONAL
+  )
+{
+  if (Token != NULL && Token->Event != NULL) {
+    Token->TransactionStatus = EFI_SUCCESS;
+    gBS->SignalEvent (Token->Event);
+  }
+  return EFI_SUCCESS;
+}
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.2. ReadBlocks() and
+    ReadBlocksEx() Implementation.
+
+  If Token is NULL, or Token->Event is NULL, the request is blocking, and
+  behaves like ReadBlocks(). Otherwise the request is queued, and
+  Token->Event is signaled once Token->TransactionStatus has been set.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  VBLK_DEV   *Dev;
+  EFI_STATUS Status;
+
+  if (BufferSize == 0) {
+    return CompleteEmptyRequest (Token);
+  }
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             FALSE               // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return QueueRequest (
+           Dev,
+           Lba,
+           BufferSize,
+           Buffer,
+           FALSE,      // RequestIsWrite
+           (Token != NULL && Token->Event != NULL) ? Token : NULL
+           );
+}
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.3 WriteBlocks() and
+    WriteBlockEx() Implementation.
+
+  Token is handled as in ReadBlocksEx().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  VBLK_DEV   *Dev;
+  EFI_STATUS Status;
+
+  if (BufferSize == 0) {
+    return CompleteEmptyRequest (Token);
+  }
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  Status = VerifyReadWriteRequest (
+             &Dev->BlockIoMedia,
+             Lba,
+             BufferSize,
+             TRUE                // RequestIsWrite
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return QueueRequest (
+           Dev,
+           Lba,
+           BufferSize,
+           Buffer,
+           TRUE,       // RequestIsWrite
+           (Token != NULL && Token->Event != NULL) ? Token : NULL
+           );
+}
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.4 FlushBlocks() and
+    FlushBlocksEx() Implementation.
+
+  The flush is submitted to the device only after all requests queued before
+  it have completed. Token is handled as in ReadBlocksEx().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  )
+{
+  VBLK_DEV *Dev;
+
+  Dev = VIRTIO_BLK_FROM_BLOCK_IO2 (This);
+  if (!Dev->BlockIoMedia.WriteCaching) {
+    return CompleteEmptyRequest (Token);
+  }
+
+  return QueueRequest (
+           Dev,
+           0,    // Lba
+           0,    // BufferSize
+           NULL, // Buffer
+           TRUE, // RequestIsWrite
+           (Token != NULL && Token->Event != NULL) ? Token : NULL
+           );
+}
+
+
 /**
 
   Device probe function for this driver.
@@ -685,6 +1199,150 @@ VirtioBlkDriverBindingSupported (
 }
 
 
+/**
+
+  Allocate and map the memory that is shared with the device for the request
+  slots, and set up the bookkeeping of free slots.
+
+  @param[in out] Dev  The virtio-blk device. Dev->Ring, Dev->Indirect and
+                      Dev->SegmentCount must have been set up.
+
+  @retval EFI_SUCCESS           Setup complete.
+
+  @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+
+  @return                       Error codes from AllocateSharedPages() or
+                                VirtioMapAllBytesInSharedBuffer().
+
+**/
+STATIC
+EFI_STATUS
+VirtioBlkInitSlots (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  EFI_STATUS Status;
+  VOID       *SharedBuffer;
+  UINTN      SharedSize;
+  UINT16     Slot;
+
+  //
+  // Without indirect descriptors, every slot owns three consecutive
+  // descriptors of the ring.
+  //
+  Dev->SlotCount = (UINT16)MIN (
+                             (Dev->Indirect ?
+                              Dev->Ring.QueueSize :
+                              Dev->Ring.QueueSize / 3),
+                             VBLK_MAX_IN_FLIGHT
+                             );
+  ASSERT (Dev->SlotCount > 0);
+
+  Dev->FreeSlotStack = AllocatePool (
+                         Dev->SlotCount * sizeof *Dev->FreeSlotStack
+                         );
+  Dev->SlotRequest   = AllocateZeroPool (
+                         Dev->SlotCount * sizeof *Dev->SlotRequest
+                         );
+  if (Dev->FreeSlotStack == NULL || Dev->SlotRequest == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeBookkeeping;
+  }
+
+  //
+  // The request headers and the indirect descriptor tables are read by the
+  // device, and the host status bytes are written by it; map them with
+  // VirtioOperationBusMasterCommonBuffer.
+  //
+  SharedSize = Dev->SlotCount * sizeof *Dev->Shared;
+  Status = Dev->VirtIo->AllocateSharedPages (
+                          Dev->VirtIo,
+                          EFI_SIZE_TO_PAGES (SharedSize),
+                          &SharedBuffer
+                          );
+  if (EFI_ERROR (Status)) {
+    goto FreeBookkeeping;
+  }
+  ZeroMem (SharedBuffer, SharedSize);
+
+  Status = VirtioMapAllBytesInSharedBuffer (
+             Dev->VirtIo,
+             VirtioOperationBusMasterCommonBuffer,
+             SharedBuffer,
+             SharedSize,
+             &Dev->SharedDeviceAddress,
+             &Dev->SharedMap
+             );
+  if (EFI_ERROR (Status)) {
+    goto FreeSharedBuffer;
+  }
+  Dev->Shared = SharedBuffer;
+
+  for (Slot = 0; Slot < Dev->SlotCount; Slot++) {
+    Dev->FreeSlotStack[Slot] = (UINT16)(Dev->SlotCount - 1 - Slot);
+  }
+  Dev->FreeSlotCount    = Dev->SlotCount;
+  Dev->NotifiedAvailIdx = 0;
+
+  //
+  // We poll the used ring; the device need not interrupt us. With
+  // VIRTIO_F_RING_EVENT_IDX the device ignores this flag, and looks at
+  // UsedEvent instead; see ProcessRequests(). VirtioPackedRingInit() has
+  // disabled interrupts of a packed ring already.
+  //
+  if (!Dev->Ring.Packed) {
+    *Dev->Ring.Avail.Flags = (UINT16)VRING_AVAIL_F_NO_INTERRUPT;
+    if (Dev->EventIdx) {
+      *Dev->Ring.Avail.UsedEvent = VBLK_USED_EVENT_DISTANCE;
+    }
+  }
+  return EFI_SUCCESS;
+
+FreeSharedBuffer:
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (SharedSize),
+                 SharedBuffer
+                 );
+
+FreeBookkeeping:
+  if (Dev->SlotRequest != NULL) {
+    FreePool (Dev->SlotRequest);
+    Dev->SlotRequest = NULL;
+  }
+  if (Dev->FreeSlotStack != NULL) {
+    FreePool (Dev->FreeSlotStack);
+    Dev->FreeSlotStack = NULL;
+  }
+  return Status;
+}
+
+
+/**
+
+  Release the resources set up by VirtioBlkInitSlots(). The device must have
+  been reset, or must not have been started yet.
+
+  @param[in out] Dev  The virtio-blk device.
+
+**/
+STATIC
+VOID
+VirtioBlkUninitSlots (
+  IN OUT VBLK_DEV *Dev
+  )
+{
+  Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->SharedMap);
+  Dev->VirtIo->FreeSharedPages (
+                 Dev->VirtIo,
+                 EFI_SIZE_TO_PAGES (Dev->SlotCount * sizeof *Dev->Shared),
+                 Dev->Shared
+                 );
+  FreePool (Dev->SlotRequest);
+  FreePool (Dev->FreeSlotStack);
+}
+
+
 /**
 
   Set up all BlockIo and virtio-blk aspects of this driver for the specified
@@ -723,10 +1381,14 @@ VirtioBlkInit (
   UINT32     OptIoSize;
   UINT16     QueueSize;
   UINT64     RingBaseShift;
+  UINT32     SizeMax;
+  UINT32     SegMax;
 
   PhysicalBlockExp = 0;
   AlignmentOffset = 0;
   OptIoSize = 0;
+  SizeMax = MAX_UINT32;
+  SegMax = MAX_UINT32;
 
   //
   // Execute virtio-0.9.5, 2.2.1 Device Initialization Sequence.
@@ -815,9 +1477,33 @@ VirtioBlkInit (
     }
   }
 
+  if (Features & VIRTIO_BLK_F_SIZE_MAX) {
+    Status = VIRTIO_CFG_READ (Dev, SizeMax, &SizeMax);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
+  }
+
+  if (Features & VIRTIO_BLK_F_SEG_MAX) {
+    Status = VIRTIO_CFG_READ (Dev, SegMax, &SegMax);
+    if (EFI_ERROR (Status)) {
+      goto Failed;
+    }
+  }
+
   Features &= VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_TOPOLOGY | VIRTIO_BLK_F_RO |
-              VIRTIO_BLK_F_FLUSH | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_BLK_F_FLUSH | VIRTIO_BLK_F_SIZE_MAX |
+              VIRTIO_BLK_F_SEG_MAX | VIRTIO_F_RING_INDIRECT_DESC |
+              VIRTIO_F_RING_EVENT_IDX | VIRTIO_F_VERSION_1 |
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_F_RING_PACKED;
+
+  //
+  // A packed ring needs a queue size that is a power of two.
+  //
+  Status = VirtioPackedRingCheckQueue (Dev->VirtIo, 0, &Features);
+  if (EFI_ERROR (Status)) {
+    goto Failed;
+  }
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -841,12 +1527,43 @@ VirtioBlkInit (
   if (EFI_ERROR (Status)) {
     goto Failed;
   }
-  if (QueueSize < 3) { // SynchronousRequest() uses at most three descriptors
+  if (QueueSize < 3) { // a request without indirect descriptors uses three
+    Status = EFI_UNSUPPORTED;
+    goto Failed;
+  }
+
+  //
+  // Work out how a virtio-blk request describes its data area: with indirect
+  // descriptors, in up to VBLK_MAX_DATA_SEGMENTS descriptors (bounded by the
+  // device's limits, and by the queue size for the whole chain), otherwise in
+  // a single descriptor. Each descriptor covers at most SizeMax bytes.
+  //
+  Dev->Indirect     = (BOOLEAN)((Features & VIRTIO_F_RING_INDIRECT_DESC) != 0);
+  Dev->EventIdx     = (BOOLEAN)((Features & VIRTIO_F_RING_EVENT_IDX) != 0);
+  Dev->SegmentSize  = MIN (SizeMax, VBLK_MAX_TRANSFER);
+  Dev->SegmentCount = Dev->Indirect ?
+                      (UINT16)MIN (MIN (SegMax, VBLK_MAX_DATA_SEGMENTS),
+                                QueueSize - 2) :
+                      1;
+  if (Dev->SegmentCount == 0) {
+    Dev->SegmentCount = 1;
+  }
+  Dev->MaxTransfer  = MIN (Dev->SegmentSize * Dev->SegmentCount,
+                        VBLK_MAX_TRANSFER);
+  Dev->MaxTransfer -= Dev->MaxTransfer % BlockSize;
+  if (Dev->MaxTransfer == 0) {
+    //
+    // The device cannot transfer a single logical block in one request.
+    //
     Status = EFI_UNSUPPORTED;
     goto Failed;
   }
 
-  Status = VirtioRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
+  if ((Features & VIRTIO_F_RING_PACKED) != 0) {
+    Status = VirtioPackedRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
+  } else {
+    Status = VirtioRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
+  }
   if (EFI_ERROR (Status)) {
     goto Failed;
   }
@@ -864,18 +1581,26 @@ VirtioBlkInit (
     goto ReleaseQueue;
   }
 
+  //
+  // If anything fails from here on, we must also release the request slots.
+  //
+  Status = VirtioBlkInitSlots (Dev);
+  if (EFI_ERROR (Status)) {
+    goto UnmapQueue;
+  }
+
   //
   // Additional steps for MMIO: align the queue appropriately, and set the
-  // size. If anything fails from here on, we must unmap the ring resources.
+  // size.
   //
   Status = Dev->VirtIo->SetQueueNum (Dev->VirtIo, QueueSize);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto ReleaseSlots;
   }
 
   Status = Dev->VirtIo->SetQueueAlign (Dev->VirtIo, EFI_PAGE_SIZE);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto ReleaseSlots;
   }
 
   //
@@ -887,7 +1612,7 @@ VirtioBlkInit (
                           RingBaseShift
                           );
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto ReleaseSlots;
   }
 
 
@@ -895,10 +1620,11 @@ VirtioBlkInit (
   // step 5 -- Report understood features.
   //
   if (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) {
-    Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
+    Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM |
+                          VIRTIO_F_RING_PACKED);
     Status = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
-      goto UnmapQueue;
+      goto ReleaseSlots;
     }
   }
 
@@ -908,7 +1634,7 @@ VirtioBlkInit (
   NextDevStat |= VSTAT_DRIVER_OK;
   Status = Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, NextDevStat);
   if (EFI_ERROR (Status)) {
-    goto UnmapQueue;
+    goto ReleaseSlots;
   }
 
   //
@@ -921,6 +1647,11 @@ VirtioBlkInit (
   Dev->BlockIo.ReadBlocks            = &VirtioBlkReadBlocks;
   Dev->BlockIo.WriteBlocks           = &VirtioBlkWriteBlocks;
   Dev->BlockIo.FlushBlocks           = &VirtioBlkFlushBlocks;
+  Dev->BlockIo2.Media                = &Dev->BlockIoMedia;
+  Dev->BlockIo2.Reset                = &VirtioBlkResetEx;
+  Dev->BlockIo2.ReadBlocksEx         = &VirtioBlkReadBlocksEx;
+  Dev->BlockIo2.WriteBlocksEx        = &VirtioBlkWriteBlocksEx;
+  Dev->BlockIo2.FlushBlocksEx        = &VirtioBlkFlushBlocksEx;
   Dev->BlockIoMedia.MediaId          = 0;
   Dev->BlockIoMedia.RemovableMedia   = FALSE;
   Dev->BlockIoMedia.MediaPresent     = TRUE;
@@ -935,6 +1666,9 @@ VirtioBlkInit (
   DEBUG ((DEBUG_INFO, "%a: LbaSize=0x%x[B] NumBlocks=0x%Lx[Lba]\n",
     __FUNCTION__, Dev->BlockIoMedia.BlockSize,
     Dev->BlockIoMedia.LastBlock + 1));
+  DEBUG ((DEBUG_INFO, "%a: InFlight=%u MaxTransfer=0x%x[B] Indirect=%d "
+    "EventIdx=%d\n", __FUNCTION__, Dev->SlotCount, Dev->MaxTransfer,
+    Dev->Indirect, Dev->EventIdx));
 
   if (Features & VIRTIO_BLK_F_TOPOLOGY) {
     Dev->BlockIo.Revision = EFI_BLOCK_IO_PROTOCOL_REVISION3;
@@ -951,6 +1685,9 @@ VirtioBlkInit (
   }
   return EFI_SUCCESS;
 
+ReleaseSlots:
+  VirtioBlkUninitSlots (Dev);
+
 UnmapQueue:
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
 
@@ -992,10 +1729,12 @@ VirtioBlkUninit (
   //
   Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
 
+  VirtioBlkUninitSlots (Dev);
   Dev->VirtIo->UnmapSharedBuffer (Dev->VirtIo, Dev->RingMap);
   VirtioRingUninit (Dev->VirtIo, &Dev->Ring);
 
   SetMem (&Dev->BlockIo,      sizeof Dev->BlockIo,      0x00);
+  SetMem (&Dev->BlockIo2,     sizeof Dev->BlockIo2,     0x00);
   SetMem (&Dev->BlockIoMedia, sizeof Dev->BlockIoMedia, 0x00);
 }
 
@@ -1051,7 +1790,8 @@ VirtioBlkExitBoot (
 
   @retval EFI_SUCCESS           Driver instance has been created and
                                 initialized  for the virtio-blk device, it
-                                is now accessible via EFI_BLOCK_IO_PROTOCOL.
+                                is now accessible via EFI_BLOCK_IO_PROTOCOL
+                                and EFI_BLOCK_IO2_PROTOCOL.
 
   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
@@ -1084,6 +1824,8 @@ VirtioBlkDriverBindingStart (
     goto FreeVirtioBlk;
   }
 
+  InitializeListHead (&Dev->RequestList);
+
   //
   // VirtIo access granted, configure virtio-blk device.
   //
@@ -1098,19 +1840,30 @@ VirtioBlkDriverBindingStart (
     goto UninitDev;
   }
 
+  Status = gBS->CreateEvent (EVT_TIMER | EVT_NOTIFY_SIGNAL, TPL_NOTIFY,
+                  &VirtioBlkPoll, Dev, &Dev->PollTimer);
+  if (EFI_ERROR (Status)) {
+    goto CloseExitBoot;
+  }
+
   //
-  // Setup complete, attempt to export the driver instance's BlockIo interface.
+  // Setup complete, attempt to export the driver instance's BlockIo and
+  // BlockIo2 interfaces.
   //
   Dev->Signature = VBLK_SIG;
-  Status = gBS->InstallProtocolInterface (&DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, EFI_NATIVE_INTERFACE,
-                  &Dev->BlockIo);
+  Status = gBS->InstallMultipleProtocolInterfaces (&DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
-    goto CloseExitBoot;
+    goto ClosePollTimer;
   }
 
   return EFI_SUCCESS;
 
+ClosePollTimer:
+  gBS->CloseEvent (Dev->PollTimer);
+
 CloseExitBoot:
   gBS->CloseEvent (Dev->ExitBoot);
 
@@ -1181,12 +1934,21 @@ VirtioBlkDriverBindingStop (
   //
   // Handle Stop() requests for in-use driver instances gracefully.
   //
-  Status = gBS->UninstallProtocolInterface (DeviceHandle,
-                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo);
+  Status = gBS->UninstallMultipleProtocolInterfaces (DeviceHandle,
+                  &gEfiBlockIoProtocolGuid, &Dev->BlockIo,
+                  &gEfiBlockIo2ProtocolGuid, &Dev->BlockIo2,
+                  NULL);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
+  //
+  // Let non-blocking requests queued earlier complete before tearing down the
+  // ring; their tokens still get signaled.
+  //
+  WaitForRequests (Dev, NULL);
+  gBS->CloseEvent (Dev->PollTimer);
+
   gBS->CloseEvent (Dev->ExitBoot);
 
   VirtioBlkUninit (Dev);
@@ -1,7 +1,7 @@
 /** @file
 
   Internal definitions for the virtio-blk driver, which produces Block I/O
-  Protocol instances for virtio-blk devices.
+  and Block I/O 2 Protocol instances for virtio-blk devices.
 
   Copyright (C) 2012, Red Hat, Inc.
 
@@ -13,13 +13,88 @@
 #define _VIRTIO_BLK_DXE_H_
 
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/ComponentName.h>
 #include <Protocol/DriverBinding.h>
 
 #include <IndustryStandard/Virtio.h>
+#include <IndustryStandard/VirtioBlk.h>
 
 
-#define VBLK_SIG SIGNATURE_32 ('V', 'B', 'L', 'K')
+#define VBLK_SIG     SIGNATURE_32 ('V', 'B', 'L', 'K')
+#define VBLK_REQ_SIG SIGNATURE_32 ('V', 'B', 'R', 'Q')
+
+//
+// Upper limit on the number of bytes a single virtio-blk request transfers.
+// Block I/O requests larger than this are split into several virtio-blk
+// requests, which are then in flight at the same time.
+//
+#define VBLK_MAX_TRANSFER SIZE_1MB
+
+//
+// Upper limit on the number of virtio-blk requests in flight.
+//
+#define VBLK_MAX_IN_FLIGHT 64
+
+//
+// Upper limit on the number of data descriptors in the indirect descriptor
+// table of a single virtio-blk request.
+//
+#define VBLK_MAX_DATA_SEGMENTS 16
+
+//
+// With VIRTIO_F_RING_EVENT_IDX, distance between the last used index we have
+// processed and the UsedEvent index we publish. It exceeds the number of
+// requests that can be in flight, so the device never triggers an interrupt.
+//
+#define VBLK_USED_EVENT_DISTANCE 0x8000
+
+//
+// Period of the timer that completes non-blocking requests, in 100ns units.
+//
+#define VBLK_POLL_PERIOD EFI_TIMER_PERIOD_MILLISECONDS (1)
+
+//
+// The request header, the host status byte, and (with
+// VIRTIO_F_RING_INDIRECT_DESC) the indirect descriptor table of a single
+// virtio-blk request in flight. An array of these is shared with the device;
+// the size of the structure is a multiple of 16 bytes so that every Indirect
+// table in the array stays suitably aligned. The table has the descriptor
+// format of the ring (split or packed).
+//
+typedef struct {
+  union {
+    VRING_DESC        Split[VBLK_MAX_DATA_SEGMENTS + 2];
+    VRING_PACKED_DESC Packed[VBLK_MAX_DATA_SEGMENTS + 2];
+  }              Indirect;
+  VIRTIO_BLK_REQ Header;
+  UINT8          HostStatus;
+  UINT8          Padding[15];
+} VBLK_SHARED_SLOT;
+
+//
+// A single ReadBlocks(), WriteBlocks() or FlushBlocks() request (or its Ex
+// variant), queued on VBLK_DEV.RequestList until all of its virtio-blk
+// requests have been completed by the device.
+//
+typedef struct {
+  UINT32               Signature;
+  LIST_ENTRY           Link;
+  EFI_BLOCK_IO2_TOKEN  *Token;              // NULL for blocking requests
+  EFI_LBA              Lba;
+  UINTN                BufferSize;          // zero for flush
+  VOID                 *BufferMapping;
+  EFI_PHYSICAL_ADDRESS BufferDeviceAddress;
+  BOOLEAN              RequestIsWrite;
+  UINTN                SubmittedSize;       // bytes handed to the device
+  BOOLEAN              AllSubmitted;
+  UINT16               InFlight;            // virtio-blk requests on the ring
+  BOOLEAN              Completed;           // blocking requests only
+  EFI_STATUS           Status;
+} VBLK_REQUEST;
+
+#define VBLK_REQUEST_FROM_LINK(LinkPointer) \
+        CR (LinkPointer, VBLK_REQUEST, Link, VBLK_REQ_SIG)
 
 typedef struct {
   //
@@ -32,15 +107,41 @@ typedef struct {
   UINT32                 Signature;            // DriverBindingStart  0
   VIRTIO_DEVICE_PROTOCOL *VirtIo;              // DriverBindingStart  0
   EFI_EVENT              ExitBoot;             // DriverBindingStart  0
+  EFI_EVENT              PollTimer;            // DriverBindingStart  0
+  LIST_ENTRY             RequestList;          // DriverBindingStart  0
   VRING                  Ring;                 // VirtioRingInit      2
   EFI_BLOCK_IO_PROTOCOL  BlockIo;              // VirtioBlkInit       1
+  EFI_BLOCK_IO2_PROTOCOL BlockIo2;             // VirtioBlkInit       1
   EFI_BLOCK_IO_MEDIA     BlockIoMedia;         // VirtioBlkInit       1
+  BOOLEAN                Indirect;             // VirtioBlkInit       1
+  BOOLEAN                EventIdx;             // VirtioBlkInit       1
+  UINT32                 SegmentSize;          // VirtioBlkInit       1
+  UINT16                 SegmentCount;         // VirtioBlkInit       1
+  UINT32                 MaxTransfer;          // VirtioBlkInit       1
   VOID                   *RingMap;             // VirtioRingMap       2
+  UINT16                 SlotCount;            // VirtioBlkInitSlots  2
+  UINT16                 FreeSlotCount;        // VirtioBlkInitSlots  2
+  UINT16                 *FreeSlotStack;       // VirtioBlkInitSlots  2
+  VBLK_REQUEST           **SlotRequest;        // VirtioBlkInitSlots  2
+  VBLK_SHARED_SLOT       *Shared;              // VirtioBlkInitSlots  2
+  EFI_PHYSICAL_ADDRESS   SharedDeviceAddress;  // VirtioBlkInitSlots  2
+  VOID                   *SharedMap;           // VirtioBlkInitSlots  2
+  UINT16                 NotifiedAvailIdx;     // VirtioBlkInitSlots  2
 } VBLK_DEV;
 
+//
+// The buffer ID under which the virtio-blk request in a request slot is made
+// available; it is also the head descriptor index for a split ring.
+//
+#define VBLK_SLOT_BUFFER_ID(Dev, Slot) \
+        ((UINT16)((Dev)->Indirect ? (Slot) : (Slot) * 3))
+
 #define VIRTIO_BLK_FROM_BLOCK_IO(BlockIoPointer) \
         CR (BlockIoPointer, VBLK_DEV, BlockIo, VBLK_SIG)
 
+#define VIRTIO_BLK_FROM_BLOCK_IO2(BlockIo2Pointer) \
+        CR (BlockIo2Pointer, VBLK_DEV, BlockIo2, VBLK_SIG)
+
 
 /**
 
@@ -106,7 +207,8 @@ VirtioBlkDriverBindingSupported (
 
   @retval EFI_SUCCESS           Driver instance has been created and
                                 initialized  for the virtio-blk device, it
-                                is now accessible via EFI_BLOCK_IO_PROTOCOL.
+                                is now accessible via EFI_BLOCK_IO_PROTOCOL
+                                and EFI_BLOCK_IO2_PROTOCOL.
 
   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
 
@@ -127,7 +229,8 @@ VirtioBlkDriverBindingStart (
 
 /**
 
-  Stop driving a virtio-blk device and remove its BlockIo interface.
+  Stop driving a virtio-blk device and remove its BlockIo and BlockIo2
+  interfaces.
 
   This function replays the success path of DriverBindingStart() in reverse.
   The host side virtio-blk device is reset, so that the OS boot loader or the
@@ -182,7 +285,7 @@ VirtioBlkReset (
     ReadBlocksEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and QueueRequest().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -211,7 +314,7 @@ VirtioBlkReadBlocks (
     WriteBlockEx() Implementation.
 
   Parameter checks and conformant return values are implemented in
-  VerifyReadWriteRequest() and SynchronousRequest().
+  VerifyReadWriteRequest() and QueueRequest().
 
   A zero BufferSize doesn't seem to be prohibited, so do nothing in that case,
   successfully.
@@ -253,6 +356,103 @@ VirtioBlkFlushBlocks (
   );
 
 
+/**
+
+  ResetEx() operation for virtio-blk.
+
+  See UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+  EFI_BLOCK_IO2_PROTOCOL.Reset().
+
+  The device needs no reset; the function waits until all non-blocking
+  requests queued earlier have completed.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkResetEx (
+  IN EFI_BLOCK_IO2_PROTOCOL *This,
+  IN BOOLEAN                ExtendedVerification
+  );
+
+
+/**
+
+  ReadBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.ReadBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.2. ReadBlocks() and
+    ReadBlocksEx() Implementation.
+
+  If Token is NULL, or Token->Event is NULL, the request is blocking, and
+  behaves like ReadBlocks(). Otherwise the request is queued, and
+  Token->Event is signaled once Token->TransactionStatus has been set.
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkReadBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  );
+
+
+/**
+
+  WriteBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.WriteBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.3 WriteBlocks() and
+    WriteBlockEx() Implementation.
+
+  Token is handled as in ReadBlocksEx().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkWriteBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN     UINT32                 MediaId,
+  IN     EFI_LBA                Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  );
+
+
+/**
+
+  FlushBlocksEx() operation for virtio-blk.
+
+  See
+  - UEFI Spec 2.3.1 + Errata C, 12.9 EFI Block I/O 2 Protocol,
+    EFI_BLOCK_IO2_PROTOCOL.FlushBlocksEx().
+  - Driver Writer's Guide for UEFI 2.3.1 v1.01, 24.2.4 FlushBlocks() and
+    FlushBlocksEx() Implementation.
+
+  The flush is submitted to the device only after all requests queued before
+  it have completed. Token is handled as in ReadBlocksEx().
+
+**/
+
+EFI_STATUS
+EFIAPI
+VirtioBlkFlushBlocksEx (
+  IN     EFI_BLOCK_IO2_PROTOCOL *This,
+  IN OUT EFI_BLOCK_IO2_TOKEN    *Token
+  );
+
+
 //
 // The purpose of the following scaffolding (EFI_COMPONENT_NAME_PROTOCOL and
 // EFI_COMPONENT_NAME2_PROTOCOL implementation) is to format the driver's name
@@ -43,7 +43,6 @@ VirtioNetIsPacketAvailable (
   // DWG-2.3.1, but WaitForKey does have some.
   //
   VNET_DEV *Dev;
-  UINT16   RxCurUsed;
 
   Dev = Context;
   if (Dev->Snm.State != EfiSimpleNetworkInitialized) {
@@ -53,11 +52,7 @@ VirtioNetIsPacketAvailable (
   //
   // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
   //
-  MemoryFence ();
-  RxCurUsed = *Dev->RxRing.Used.Idx;
-  MemoryFence ();
-
-  if (Dev->RxLastUsed != RxCurUsed) {
+  if (!EFI_ERROR (VirtioPeekUsed (&Dev->RxRing, NULL, NULL))) {
     gBS->SignalEvent (Dev->Snp.WaitForPacket);
   }
 }
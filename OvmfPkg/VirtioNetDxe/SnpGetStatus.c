@@ -58,8 +58,9 @@ VirtioNetGetStatus (
   VNET_DEV             *Dev;
   EFI_TPL              OldTpl;
   EFI_STATUS           Status;
-  UINT16               RxCurUsed;
-  UINT16               TxCurUsed;
+  BOOLEAN              RxUsed;
+  BOOLEAN              TxUsed;
+  UINT16               DescIdx;
   EFI_PHYSICAL_ADDRESS DeviceAddress;
 
   if (This == NULL) {
@@ -96,10 +97,9 @@ VirtioNetGetStatus (
   //
   // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
   //
-  MemoryFence ();
-  RxCurUsed = *Dev->RxRing.Used.Idx;
-  TxCurUsed = *Dev->TxRing.Used.Idx;
-  MemoryFence ();
+  RxUsed = (BOOLEAN) !EFI_ERROR (VirtioPeekUsed (&Dev->RxRing, NULL, NULL));
+  TxUsed = (BOOLEAN) !EFI_ERROR (VirtioPeekUsed (&Dev->TxRing, &DescIdx,
+                                   NULL));
 
   if (InterruptStatus != NULL) {
     //
@@ -107,23 +107,20 @@ VirtioNetGetStatus (
     // report the transmit interrupt if we have transmitted at least one buffer
     //
     *InterruptStatus = 0;
-    if (Dev->RxLastUsed != RxCurUsed) {
+    if (RxUsed) {
       *InterruptStatus |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
     }
-    if (Dev->TxLastUsed != TxCurUsed) {
+    if (TxUsed) {
       ASSERT (Dev->TxCurPending > 0);
       *InterruptStatus |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
     }
   }
 
   if (TxBuf != NULL) {
-    if (Dev->TxLastUsed == TxCurUsed) {
+    if (!TxUsed) {
       *TxBuf = NULL;
     }
     else {
-      UINT16 UsedElemIdx;
-      UINT32 DescIdx;
-
       //
       // fetch the first descriptor among those that the hypervisor reports
       // completed
@@ -131,20 +128,19 @@ VirtioNetGetStatus (
       ASSERT (Dev->TxCurPending > 0);
       ASSERT (Dev->TxCurPending <= Dev->TxMaxPending);
 
-      UsedElemIdx = Dev->TxLastUsed++ % Dev->TxRing.QueueSize;
-      DescIdx = Dev->TxRing.Used.UsedElem[UsedElemIdx].Id;
+      VirtioNetReleaseUsed (Dev, &Dev->TxRing);
       ASSERT (DescIdx < (UINT32) (2 * Dev->TxMaxPending - 1));
 
       //
       // get the device address that has been enqueued for the caller's
       // transmit buffer
       //
-      DeviceAddress = Dev->TxRing.Desc[DescIdx + 1].Addr;
+      DeviceAddress = Dev->TxBufDeviceAddress[DescIdx / 2];
 
       //
       // now this descriptor can be used again to enqueue a transmit buffer
       //
-      Dev->TxFreeStack[--Dev->TxCurPending] = (UINT16) DescIdx;
+      Dev->TxFreeStack[--Dev->TxCurPending] = DescIdx;
 
       //
       // Unmap the device address and perform the reverse mapping to find the
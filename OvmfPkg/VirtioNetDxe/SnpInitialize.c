@@ -28,6 +28,8 @@
                            EfiSimpleNetworkInitialized state.
   @param[in]     Selector  Identifies the transfer direction (virtio queue) of
                            the network device.
+  @param[in]     Features  The features negotiated with the device. A packed
+                           ring is set up if VIRTIO_F_RING_PACKED is set.
   @param[out]    Ring      The virtio-ring inside the VNET_DEV structure,
                            corresponding to Selector.
   @param[out]    Mapping   A resulting token to pass to VirtioNetUninitRing()
@@ -35,8 +37,8 @@
   @retval EFI_UNSUPPORTED  The queue size reported by the virtio-net device is
                            too small.
   @return                  Status codes from VIRTIO_CFG_WRITE(),
-                           VIRTIO_CFG_READ(), VirtioRingInit() and
-                           VirtioRingMap().
+                           VIRTIO_CFG_READ(), VirtioRingInit(),
+                           VirtioPackedRingInit() and VirtioRingMap().
   @retval EFI_SUCCESS      Ring initialized.
 */
 
@@ -46,6 +48,7 @@ EFIAPI
 VirtioNetInitRing (
   IN OUT VNET_DEV *Dev,
   IN     UINT16   Selector,
+  IN     UINT64   Features,
   OUT    VRING    *Ring,
   OUT    VOID     **Mapping
   )
@@ -74,7 +77,11 @@ VirtioNetInitRing (
   if (QueueSize < 2) {
     return EFI_UNSUPPORTED;
   }
-  Status = VirtioRingInit (Dev->VirtIo, QueueSize, Ring);
+  if ((Features & VIRTIO_F_RING_PACKED) != 0) {
+    Status = VirtioPackedRingInit (Dev->VirtIo, QueueSize, Ring);
+  } else {
+    Status = VirtioRingInit (Dev->VirtIo, QueueSize, Ring);
+  }
   if (EFI_ERROR (Status)) {
     return Status;
   }
@@ -156,10 +163,8 @@ VirtioNetInitTx (
   IN OUT VNET_DEV *Dev
   )
 {
-  UINTN                 TxSharedReqSize;
   UINTN                 PktIdx;
   EFI_STATUS            Status;
-  EFI_PHYSICAL_ADDRESS  DeviceAddress;
   VOID                  *TxSharedReqBuffer;
 
   Dev->TxMaxPending = (UINT16) MIN (Dev->TxRing.QueueSize / 2,
@@ -171,13 +176,20 @@ VirtioNetInitTx (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  Dev->TxBufDeviceAddress = AllocatePool (Dev->TxMaxPending *
+                              sizeof *Dev->TxBufDeviceAddress);
+  if (Dev->TxBufDeviceAddress == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto FreeTxFreeStack;
+  }
+
   Dev->TxBufCollection = OrderedCollectionInit (
                            VirtioNetTxBufMapInfoCompare,
                            VirtioNetTxBufDeviceAddressCompare
                            );
   if (Dev->TxBufCollection == NULL) {
     Status = EFI_OUT_OF_RESOURCES;
-    goto FreeTxFreeStack;
+    goto FreeTxBufDeviceAddress;
   }
 
   //
@@ -200,7 +212,7 @@ VirtioNetInitTx (
              VirtioOperationBusMasterCommonBuffer,
              TxSharedReqBuffer,
              sizeof *(Dev->TxSharedReq),
-             &DeviceAddress,
+             &Dev->TxSharedReqDeviceAddress,
              &Dev->TxSharedReqMap
              );
   if (EFI_ERROR (Status)) {
@@ -212,32 +224,22 @@ VirtioNetInitTx (
 
   //
   // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
+  // VIRTIO_NET_F_MRG_RXBUF.
   //
-  TxSharedReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                    sizeof (Dev->TxSharedReq->V0_9_5) :
-                    sizeof *Dev->TxSharedReq;
+  Dev->TxSharedReqSize = (Dev->VirtIo->Revision <
+                          VIRTIO_SPEC_REVISION (1, 0, 0) &&
+                          !Dev->MergeRxBuf) ?
+                         sizeof (Dev->TxSharedReq->V0_9_5) :
+                         sizeof *Dev->TxSharedReq;
 
+  //
+  // Each possibly pending packet takes a two-part descriptor chain: the
+  // common (unmodified by the host) virtio-net request header, and the
+  // packet data. VirtioNetTransmit() builds the chain on the fly, and uses
+  // the head descriptor index of a split ring as its buffer ID.
+  //
   for (PktIdx = 0; PktIdx < Dev->TxMaxPending; ++PktIdx) {
-    UINT16 DescIdx;
-
-    DescIdx = (UINT16) (2 * PktIdx);
-    Dev->TxFreeStack[PktIdx] = DescIdx;
-
-    //
-    // For each possibly pending packet, lay out the descriptor for the common
-    // (unmodified by the host) virtio-net request header.
-    //
-    Dev->TxRing.Desc[DescIdx].Addr  = DeviceAddress;
-    Dev->TxRing.Desc[DescIdx].Len   = (UINT32) TxSharedReqSize;
-    Dev->TxRing.Desc[DescIdx].Flags = VRING_DESC_F_NEXT;
-    Dev->TxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
-
-    //
-    // The second descriptor of each pending TX packet is updated on the fly,
-    // but it always terminates the descriptor chain of the packet.
-    //
-    Dev->TxRing.Desc[DescIdx + 1].Flags = 0;
+    Dev->TxFreeStack[PktIdx] = (UINT16) (2 * PktIdx);
   }
 
   //
@@ -247,21 +249,22 @@ VirtioNetInitTx (
   Dev->TxSharedReq->V0_9_5.GsoType = VIRTIO_NET_HDR_GSO_NONE;
 
   //
-  // For VirtIo 1.0 only -- the field exists, but it is unused
+  // For VirtIo 1.0 and VIRTIO_NET_F_MRG_RXBUF only -- the field exists, but
+  // it is unused
   //
   Dev->TxSharedReq->NumBuffers = 0;
 
   //
-  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  // want no interrupt when a transmit completes (VirtioPackedRingInit() has
+  // disabled interrupts of a packed ring already)
   //
-  MemoryFence ();
-  Dev->TxLastUsed = *Dev->TxRing.Used.Idx;
-  ASSERT (Dev->TxLastUsed == 0);
-
-  //
-  // want no interrupt when a transmit completes
-  //
-  *Dev->TxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  if (!Dev->TxRing.Packed) {
+    *Dev->TxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+    if (Dev->EventIdx) {
+      *Dev->TxRing.Avail.UsedEvent = VNET_USED_EVENT_DISTANCE;
+    }
+  }
+  Dev->TxNotifiedAvailIdx = 0;
 
   return EFI_SUCCESS;
 
@@ -275,6 +278,9 @@ FreeTxSharedReqBuffer:
 UninitTxBufCollection:
   OrderedCollectionUninit (Dev->TxBufCollection);
 
+FreeTxBufDeviceAddress:
+  FreePool (Dev->TxBufDeviceAddress);
+
 FreeTxFreeStack:
   FreePool (Dev->TxFreeStack);
 
@@ -313,37 +319,37 @@ VirtioNetInitRx (
   )
 {
   EFI_STATUS            Status;
-  UINTN                 VirtioNetReqSize;
-  UINTN                 RxBufSize;
   UINT16                RxAlwaysPending;
   UINTN                 PktIdx;
-  UINT16                DescIdx;
   UINTN                 NumBytes;
-  EFI_PHYSICAL_ADDRESS  RxBufDeviceAddress;
   VOID                  *RxBuffer;
 
   //
   // In VirtIo 1.0, the NumBuffers field is mandatory. In 0.9.5, it depends on
-  // VIRTIO_NET_F_MRG_RXBUF, which we never negotiate.
+  // VIRTIO_NET_F_MRG_RXBUF.
   //
-  VirtioNetReqSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) ?
-                     sizeof (VIRTIO_NET_REQ) :
-                     sizeof (VIRTIO_1_0_NET_REQ);
+  Dev->RxHdrSize = (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0) &&
+                    !Dev->MergeRxBuf) ?
+                   sizeof (VIRTIO_NET_REQ) :
+                   sizeof (VIRTIO_1_0_NET_REQ);
 
   //
-  // For each incoming packet we must supply two descriptors:
-  // - the recipient for the virtio-net request header, plus
-  // - the recipient for the network data (which consists of Ethernet header
-  //   and Ethernet payload).
+  // Each incoming packet needs room for the virtio-net request header and the
+  // network data (which consists of Ethernet header and Ethernet payload).
+  // With VIRTIO_NET_F_MRG_RXBUF, the device lays them out back to back in a
+  // buffer described by a single descriptor; otherwise we must supply two
+  // descriptors, one for each. The buffer is big enough for any packet, so
+  // the device never needs to merge buffers.
   //
-  RxBufSize = VirtioNetReqSize +
-              (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
+  Dev->RxBufSize    = Dev->RxHdrSize +
+                      (Dev->Snm.MediaHeaderSize + Dev->Snm.MaxPacketSize);
+  Dev->RxDescPerBuf = Dev->MergeRxBuf ? 1 : 2;
 
   //
-  // Limit the number of pending RX packets if the queue is big. The division
-  // by two is due to the above "two descriptors per packet" trait.
+  // Limit the number of pending RX packets if the queue is big.
   //
-  RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / 2, VNET_MAX_PENDING);
+  RxAlwaysPending = (UINT16) MIN (Dev->RxRing.QueueSize / Dev->RxDescPerBuf,
+                               VNET_MAX_PENDING);
 
   //
   // The RxBuf is shared between guest and hypervisor, use
@@ -351,7 +357,7 @@ VirtioNetInitRx (
   // BusMasterCommonBuffer so that it can be accessed by both guest and
   // hypervisor.
   //
-  NumBytes = RxAlwaysPending * RxBufSize;
+  NumBytes = RxAlwaysPending * Dev->RxBufSize;
   Dev->RxBufNrPages = EFI_SIZE_TO_PAGES (NumBytes);
   Status = Dev->VirtIo->AllocateSharedPages (
                           Dev->VirtIo,
@@ -378,64 +384,45 @@ VirtioNetInitRx (
 
   Dev->RxBuf = RxBuffer;
 
-  //
-  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
-  //
-  MemoryFence ();
-  Dev->RxLastUsed = *Dev->RxRing.Used.Idx;
-  ASSERT (Dev->RxLastUsed == 0);
-
   //
   // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device:
   // the host should not send interrupts, we'll poll in VirtioNetReceive()
-  // and VirtioNetIsPacketAvailable().
+  // and VirtioNetIsPacketAvailable(). VirtioPackedRingInit() has disabled
+  // interrupts of a packed ring already.
   //
-  *Dev->RxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+  if (!Dev->RxRing.Packed) {
+    *Dev->RxRing.Avail.Flags = (UINT16) VRING_AVAIL_F_NO_INTERRUPT;
+    if (Dev->EventIdx) {
+      *Dev->RxRing.Avail.UsedEvent = VNET_USED_EVENT_DISTANCE;
+    }
+  }
 
   //
-  // now set up a separate, two-part descriptor chain for each RX packet, and
-  // link each chain into (from) the available ring as well
+  // now set up a separate descriptor chain for each RX packet, and make each
+  // chain available to the device
   //
-  DescIdx = 0;
-  RxBufDeviceAddress = Dev->RxBufDeviceBase;
   for (PktIdx = 0; PktIdx < RxAlwaysPending; ++PktIdx) {
-    //
-    // virtio-0.9.5, 2.4.1.2 Updating the Available Ring
-    // invisible to the host until we update the Index Field
-    //
-    Dev->RxRing.Avail.Ring[PktIdx] = DescIdx;
-
-    //
-    // virtio-0.9.5, 2.4.1.1 Placing Buffers into the Descriptor Table
-    //
-    Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) VirtioNetReqSize;
-    Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE | VRING_DESC_F_NEXT;
-    Dev->RxRing.Desc[DescIdx].Next  = (UINT16) (DescIdx + 1);
-    RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
-
-    Dev->RxRing.Desc[DescIdx].Addr  = RxBufDeviceAddress;
-    Dev->RxRing.Desc[DescIdx].Len   = (UINT32) (RxBufSize - VirtioNetReqSize);
-    Dev->RxRing.Desc[DescIdx].Flags = VRING_DESC_F_WRITE;
-    RxBufDeviceAddress += Dev->RxRing.Desc[DescIdx++].Len;
+    VirtioNetPostRxBuf (Dev, (UINT16) (Dev->RxDescPerBuf * PktIdx));
   }
 
-  //
-  // virtio-0.9.5, 2.4.1.3 Updating the Index Field
-  //
-  MemoryFence ();
-  *Dev->RxRing.Avail.Idx = RxAlwaysPending;
-
   //
   // At this point reception may already be running. In order to make it sure,
   // kick the hypervisor. If we fail to kick it, we must first abort reception
   // before tearing down anything, because reception may have been already
   // running even without the kick.
   //
-  // virtio-0.9.5, 2.4.1.4 Notifying the Device
+  // virtio-0.9.5, 2.4.1.4 Notifying the Device. The device has not had a
+  // chance to suppress this first notification.
   //
-  MemoryFence ();
-  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
+  Dev->RxNotifiedAvailIdx = 0;
+  Dev->RxDropBuffers      = 0;
+  Status = VirtioKick (
+             Dev->VirtIo,
+             VIRTIO_NET_Q_RX,
+             &Dev->RxRing,
+             Dev->EventIdx,
+             &Dev->RxNotifiedAvailIdx
+             );
   if (EFI_ERROR (Status)) {
     Dev->VirtIo->SetDeviceStatus (Dev->VirtIo, 0);
     goto UnmapSharedBuffer;
@@ -556,8 +543,29 @@ VirtioNetInitialize (
   ASSERT (Dev->Snm.MediaPresentSupported ==
     !!(Features & VIRTIO_NET_F_STATUS));
 
+  //
+  // VIRTIO_NET_F_CSUM is not negotiated: the Simple Network Protocol hands us
+  // complete frames, with the checksums already filled in by the stack.
+  //
   Features &= VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_F_RING_PACKED |
+              VIRTIO_NET_F_MRG_RXBUF | VIRTIO_NET_F_GUEST_CSUM |
+              VIRTIO_F_RING_EVENT_IDX;
+  Dev->MergeRxBuf = (BOOLEAN) ((Features & VIRTIO_NET_F_MRG_RXBUF) != 0);
+  Dev->GuestCsum  = (BOOLEAN) ((Features & VIRTIO_NET_F_GUEST_CSUM) != 0);
+  Dev->EventIdx   = (BOOLEAN) ((Features & VIRTIO_F_RING_EVENT_IDX) != 0);
+
+  //
+  // A packed ring needs queue sizes that are powers of two.
+  //
+  Status = VirtioPackedRingCheckQueue (Dev->VirtIo, VIRTIO_NET_Q_RX, &Features);
+  if (EFI_ERROR (Status)) {
+    goto DeviceFailed;
+  }
+  Status = VirtioPackedRingCheckQueue (Dev->VirtIo, VIRTIO_NET_Q_TX, &Features);
+  if (EFI_ERROR (Status)) {
+    goto DeviceFailed;
+  }
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -576,6 +584,7 @@ VirtioNetInitialize (
   Status = VirtioNetInitRing (
              Dev,
              VIRTIO_NET_Q_RX,
+             Features,
              &Dev->RxRing,
              &Dev->RxRingMap
              );
@@ -586,6 +595,7 @@ VirtioNetInitialize (
   Status = VirtioNetInitRing (
              Dev,
              VIRTIO_NET_Q_TX,
+             Features,
              &Dev->TxRing,
              &Dev->TxRingMap
              );
@@ -597,7 +607,8 @@ VirtioNetInitialize (
   // step 5 -- keep only the features we want
   //
   if (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) {
-    Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
+    Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM |
+                          VIRTIO_F_RING_PACKED);
     Status = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
       goto ReleaseTxRing;
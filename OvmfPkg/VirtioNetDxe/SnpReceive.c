@@ -15,6 +15,90 @@
 
 #include "VirtioNet.h"
 
+/**
+  Complete the partial checksum of a packet that the device has delivered with
+  VIRTIO_NET_HDR_F_NEEDS_CSUM set.
+
+  The checksum field at CsumStart + CsumOffset holds the (pseudo-header) sum
+  that the sender has seeded it with. The Internet checksum of the bytes from
+  CsumStart to the end of the packet is stored in the field, in network byte
+  order.
+
+  @param[in,out] Packet      The packet, starting with the Ethernet header.
+  @param[in]     PacketLen   The size of the packet, in bytes.
+  @param[in]     CsumStart   The offset of the checksummed area in the packet.
+  @param[in]     CsumOffset  The offset of the checksum field in the
+                             checksummed area.
+
+  @retval EFI_SUCCESS       The checksum has been completed.
+  @retval EFI_DEVICE_ERROR  The checksum field is not inside the packet.
+**/
+STATIC
+EFI_STATUS
+VirtioNetCompleteChecksum (
+  IN OUT UINT8  *Packet,
+  IN     UINTN  PacketLen,
+  IN     UINT16 CsumStart,
+  IN     UINT16 CsumOffset
+  )
+{
+  UINTN  Index;
+  UINT32 Sum;
+  UINT16 Checksum;
+
+  if ((UINTN) CsumStart + CsumOffset + sizeof (UINT16) > PacketLen) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Sum = 0;
+  for (Index = CsumStart; Index + 1 < PacketLen; Index += 2) {
+    Sum += (UINT32) ((Packet[Index] << 8) | Packet[Index + 1]);
+  }
+  if (Index < PacketLen) {
+    Sum += (UINT32) (Packet[Index] << 8);
+  }
+  while ((Sum >> 16) != 0) {
+    Sum = (Sum & 0xFFFF) + (Sum >> 16);
+  }
+
+  //
+  // A zero UDP checksum would mean "no checksum"; the ones' complement
+  // equivalent is always acceptable.
+  //
+  Checksum = (UINT16) ~Sum;
+  if (Checksum == 0) {
+    Checksum = 0xFFFF;
+  }
+  Packet[CsumStart + CsumOffset]     = (UINT8) (Checksum >> 8);
+  Packet[CsumStart + CsumOffset + 1] = (UINT8) Checksum;
+  return EFI_SUCCESS;
+}
+
+
+/**
+  Recycle the buffers that follow the first buffer of a dropped packet, as far
+  as the device has returned them.
+
+  @param[in,out] Dev  The VNET_DEV driver instance. Dev->RxDropBuffers counts
+                      the buffers that are still to be recycled.
+**/
+STATIC
+VOID
+VirtioNetDropRxBuffers (
+  IN OUT VNET_DEV *Dev
+  )
+{
+  UINT16 DescIdx;
+
+  while (Dev->RxDropBuffers > 0 &&
+         !EFI_ERROR (VirtioPeekUsed (&Dev->RxRing, &DescIdx, NULL))) {
+    VirtioNetReleaseUsed (Dev, &Dev->RxRing);
+    VirtioNetPostRxBuf (Dev, DescIdx);
+    --Dev->RxDropBuffers;
+  }
+}
+
+
 /**
   Receives a packet from a network interface.
 
@@ -65,18 +149,16 @@ VirtioNetReceive (
   OUT UINT16                     *Protocol   OPTIONAL
   )
 {
-  VNET_DEV   *Dev;
-  EFI_TPL    OldTpl;
-  EFI_STATUS Status;
-  UINT16     RxCurUsed;
-  UINT16     UsedElemIdx;
-  UINT32     DescIdx;
-  UINT32     RxLen;
-  UINTN      OrigBufferSize;
-  UINT8      *RxPtr;
-  UINT16     AvailIdx;
-  EFI_STATUS NotifyStatus;
-  UINTN      RxBufOffset;
+  VNET_DEV           *Dev;
+  EFI_TPL            OldTpl;
+  EFI_STATUS         Status;
+  UINT16             DescIdx;
+  VIRTIO_1_0_NET_REQ *RxHdr;
+  UINT32             RxLen;
+  UINTN              OrigBufferSize;
+  UINT8              *RxPtr;
+  EFI_STATUS         NotifyStatus;
+  UINTN              RxBufOffset;
 
   if (This == NULL || BufferSize == NULL || Buffer == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -96,30 +178,59 @@ VirtioNetReceive (
   }
 
   //
-  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  // The device may return the buffers of a packet we dropped over several
+  // calls. Recycle the rest of them first, so that none is taken for the
+  // start of a packet.
   //
-  MemoryFence ();
-  RxCurUsed = *Dev->RxRing.Used.Idx;
-  MemoryFence ();
+  if (Dev->RxDropBuffers > 0) {
+    VirtioNetDropRxBuffers (Dev);
+    Status = VirtioKick (
+               Dev->VirtIo,
+               VIRTIO_NET_Q_RX,
+               &Dev->RxRing,
+               Dev->EventIdx,
+               &Dev->RxNotifiedAvailIdx
+               );
+    if (EFI_ERROR (Status)) {
+      goto Exit;
+    }
+    if (Dev->RxDropBuffers > 0) {
+      Status = EFI_NOT_READY;
+      goto Exit;
+    }
+  }
 
-  if (Dev->RxLastUsed == RxCurUsed) {
-    Status = EFI_NOT_READY;
+  //
+  // virtio-0.9.5, 2.4.2 Receiving Used Buffers From the Device
+  //
+  Status = VirtioPeekUsed (&Dev->RxRing, &DescIdx, &RxLen);
+  if (EFI_ERROR (Status)) {
     goto Exit;
   }
 
-  UsedElemIdx = Dev->RxLastUsed % Dev->RxRing.QueueSize;
-  DescIdx = Dev->RxRing.Used.UsedElem[UsedElemIdx].Id;
-  RxLen   = Dev->RxRing.Used.UsedElem[UsedElemIdx].Len;
+  RxBufOffset  = (DescIdx / Dev->RxDescPerBuf) * Dev->RxBufSize;
+  RxHdr        = (VIRTIO_1_0_NET_REQ *) (Dev->RxBuf + RxBufOffset);
+
+  //
+  // Our RX buffers fit any packet, so a device that merges buffers with
+  // VIRTIO_NET_F_MRG_RXBUF should never spread a packet over several. Drop
+  // such a packet along with exactly NumBuffers buffers.
+  //
+  if (Dev->MergeRxBuf && RxHdr->NumBuffers != 1) {
+    Dev->RxDropBuffers = (RxHdr->NumBuffers > 1) ? RxHdr->NumBuffers - 1 : 0;
+    Status = EFI_DEVICE_ERROR;
+    goto RecycleDesc;
+  }
 
   //
   // the virtio-net request header must be complete; we skip it
   //
-  ASSERT (RxLen >= Dev->RxRing.Desc[DescIdx].Len);
-  RxLen -= Dev->RxRing.Desc[DescIdx].Len;
+  ASSERT (RxLen >= Dev->RxHdrSize);
+  RxLen -= (UINT32) Dev->RxHdrSize;
   //
   // the host must not have filled in more data than requested
   //
-  ASSERT (RxLen <= Dev->RxRing.Desc[DescIdx + 1].Len);
+  ASSERT (RxLen <= Dev->RxBufSize - Dev->RxHdrSize);
 
   OrigBufferSize = *BufferSize;
   *BufferSize = RxLen;
@@ -138,9 +249,25 @@ VirtioNetReceive (
     *HeaderSize = Dev->Snm.MediaHeaderSize;
   }
 
-  RxBufOffset = (UINTN)(Dev->RxRing.Desc[DescIdx + 1].Addr -
-                        Dev->RxBufDeviceBase);
-  RxPtr = Dev->RxBuf + RxBufOffset;
+  RxPtr = Dev->RxBuf + RxBufOffset + Dev->RxHdrSize;
+
+  //
+  // With VIRTIO_NET_F_GUEST_CSUM, the device may leave it to us to complete
+  // the transport checksum, for example of packets sent by the host itself.
+  //
+  if (Dev->GuestCsum &&
+      (RxHdr->V0_9_5.Flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0) {
+    Status = VirtioNetCompleteChecksum (
+               RxPtr,
+               RxLen,
+               RxHdr->V0_9_5.CsumStart,
+               RxHdr->V0_9_5.CsumOffset
+               );
+    if (EFI_ERROR (Status)) {
+      goto RecycleDesc; // drop malformed packet
+    }
+  }
+
   CopyMem (Buffer, RxPtr, RxLen);
 
   if (DestAddr != NULL) {
@@ -161,20 +288,17 @@ VirtioNetReceive (
   Status = EFI_SUCCESS;
 
 RecycleDesc:
-  ++Dev->RxLastUsed;
-
-  //
-  // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
-  //
-  AvailIdx = *Dev->RxRing.Avail.Idx;
-  Dev->RxRing.Avail.Ring[AvailIdx++ % Dev->RxRing.QueueSize] =
-    (UINT16) DescIdx;
-
-  MemoryFence ();
-  *Dev->RxRing.Avail.Idx = AvailIdx;
+  VirtioNetReleaseUsed (Dev, &Dev->RxRing);
+  VirtioNetPostRxBuf (Dev, DescIdx);
+  VirtioNetDropRxBuffers (Dev);
 
-  MemoryFence ();
-  NotifyStatus = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_RX);
+  NotifyStatus = VirtioKick (
+                   Dev->VirtIo,
+                   VIRTIO_NET_Q_RX,
+                   &Dev->RxRing,
+                   Dev->EventIdx,
+                   &Dev->RxNotifiedAvailIdx
+                   );
   if (!EFI_ERROR (Status)) { // earlier error takes precedence
     Status = NotifyStatus;
   }
@@ -80,6 +80,7 @@ VirtioNetShutdownTx (
   }
   OrderedCollectionUninit (Dev->TxBufCollection);
 
+  FreePool (Dev->TxBufDeviceAddress);
   FreePool (Dev->TxFreeStack);
 }
 
@@ -104,6 +105,94 @@ VirtioNetUninitRing (
 }
 
 
+/**
+  Make an RX packet buffer available to the device, without notifying it.
+
+  Each RX packet buffer of Dev->RxBufSize bytes receives the virtio-net
+  request header, followed by the network data (which consists of Ethernet
+  header and Ethernet payload). With VIRTIO_NET_F_MRG_RXBUF, a single
+  descriptor covers the whole buffer. Otherwise the buffer is described by a
+  two-part descriptor chain: the recipient for the header, and the recipient
+  for the network data. The buffer ID of the chain identifies the packet
+  buffer.
+
+  @param[in,out] Dev      The VNET_DEV driver instance owning the RX ring.
+  @param[in]     DescIdx  The buffer ID of the RX packet buffer; its index in
+                          Dev->RxBuf, multiplied by Dev->RxDescPerBuf.
+*/
+VOID
+EFIAPI
+VirtioNetPostRxBuf (
+  IN OUT VNET_DEV *Dev,
+  IN     UINT16   DescIdx
+  )
+{
+  EFI_PHYSICAL_ADDRESS RxBufDeviceAddress;
+  DESC_INDICES         Indices;
+
+  RxBufDeviceAddress = Dev->RxBufDeviceBase +
+                       (DescIdx / Dev->RxDescPerBuf) * Dev->RxBufSize;
+
+  //
+  // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
+  //
+  VirtioStartChain (&Dev->RxRing, DescIdx, &Indices);
+  if (Dev->RxDescPerBuf == 1) {
+    VirtioAppendDesc (
+      &Dev->RxRing,
+      RxBufDeviceAddress,
+      (UINT32) Dev->RxBufSize,
+      VRING_DESC_F_WRITE,
+      &Indices
+      );
+    VirtioMakeAvailable (&Dev->RxRing, &Indices, DescIdx);
+    return;
+  }
+
+  VirtioAppendDesc (
+    &Dev->RxRing,
+    RxBufDeviceAddress,
+    (UINT32) Dev->RxHdrSize,
+    VRING_DESC_F_WRITE | VRING_DESC_F_NEXT,
+    &Indices
+    );
+  VirtioAppendDesc (
+    &Dev->RxRing,
+    RxBufDeviceAddress + Dev->RxHdrSize,
+    (UINT32) (Dev->RxBufSize - Dev->RxHdrSize),
+    VRING_DESC_F_WRITE,
+    &Indices
+    );
+  VirtioMakeAvailable (&Dev->RxRing, &Indices, DescIdx);
+}
+
+
+/**
+  Consume the used buffer most recently reported by VirtioPeekUsed() on an RX
+  or TX ring.
+
+  With VIRTIO_F_RING_EVENT_IDX, the device ignores VRING_AVAIL_F_NO_INTERRUPT
+  on a split ring; keep the UsedEvent index far enough ahead that the device
+  never reaches it.
+
+  @param[in]     Dev   The VNET_DEV driver instance owning the ring.
+  @param[in,out] Ring  Dev->RxRing or Dev->TxRing.
+*/
+VOID
+EFIAPI
+VirtioNetReleaseUsed (
+  IN     VNET_DEV *Dev,
+  IN OUT VRING    *Ring
+  )
+{
+  VirtioReleaseUsed (Ring);
+  if (Dev->EventIdx && !Ring->Packed) {
+    *Ring->Avail.UsedEvent =
+      (UINT16) (Ring->LastUsedIdx + VNET_USED_EVENT_DISTANCE);
+  }
+}
+
+
 /**
   Map Caller-supplied TxBuf buffer to the device-mapped address
 
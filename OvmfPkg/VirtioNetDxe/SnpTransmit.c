@@ -71,7 +71,7 @@ VirtioNetTransmit (
   EFI_TPL               OldTpl;
   EFI_STATUS            Status;
   UINT16                DescIdx;
-  UINT16                AvailIdx;
+  DESC_INDICES          Indices;
   EFI_PHYSICAL_ADDRESS  DeviceAddress;
 
   if (This == NULL || BufferSize == 0 || Buffer == NULL) {
@@ -156,21 +156,38 @@ VirtioNetTransmit (
   // virtio-0.9.5, 2.4.1 Supplying Buffers to The Device
   //
   DescIdx = Dev->TxFreeStack[Dev->TxCurPending++];
-  Dev->TxRing.Desc[DescIdx + 1].Addr  = DeviceAddress;
-  Dev->TxRing.Desc[DescIdx + 1].Len   = (UINT32) BufferSize;
+  Dev->TxBufDeviceAddress[DescIdx / 2] = DeviceAddress;
+
+  VirtioStartChain (&Dev->TxRing, DescIdx, &Indices);
+  VirtioAppendDesc (
+    &Dev->TxRing,
+    Dev->TxSharedReqDeviceAddress,
+    Dev->TxSharedReqSize,
+    VRING_DESC_F_NEXT,
+    &Indices
+    );
+  VirtioAppendDesc (
+    &Dev->TxRing,
+    DeviceAddress,
+    (UINT32) BufferSize,
+    0,
+    &Indices
+    );
+  VirtioMakeAvailable (&Dev->TxRing, &Indices, DescIdx);
 
   //
-  // the available index is never written by the host, we can read it back
-  // without a barrier
+  // While the device is still working through the TX ring, it has told us
+  // (with VIRTIO_F_RING_EVENT_IDX or VRING_USED_F_NO_NOTIFY) that it will
+  // pick up this packet without a notification. This batches the kicks of
+  // back-to-back transmissions.
   //
-  AvailIdx = *Dev->TxRing.Avail.Idx;
-  Dev->TxRing.Avail.Ring[AvailIdx++ % Dev->TxRing.QueueSize] = DescIdx;
-
-  MemoryFence ();
-  *Dev->TxRing.Avail.Idx = AvailIdx;
-
-  MemoryFence ();
-  Status = Dev->VirtIo->SetQueueNotify (Dev->VirtIo, VIRTIO_NET_Q_TX);
+  Status = VirtioKick (
+             Dev->VirtIo,
+             VIRTIO_NET_Q_TX,
+             &Dev->TxRing,
+             Dev->EventIdx,
+             &Dev->TxNotifiedAvailIdx
+             );
 
 Exit:
   gBS->RestoreTPL (OldTpl);
@@ -27,7 +27,14 @@
 //
 // maximum number of pending packets, separately for each direction
 //
-#define VNET_MAX_PENDING 64
+#define VNET_MAX_PENDING 256
+
+//
+// With VIRTIO_F_RING_EVENT_IDX, distance between the last used index we have
+// processed and the UsedEvent index we publish on a split ring. It exceeds
+// the number of pending packets, so the device never triggers an interrupt.
+//
+#define VNET_USED_EVENT_DISTANCE 0x8000
 
 //
 // State diagram:
@@ -76,12 +83,19 @@ typedef struct {
   EFI_EVENT                   ExitBoot;          // VirtioNetSnpPopulate
   EFI_DEVICE_PATH_PROTOCOL    *MacDevicePath;    // VirtioNetDriverBindingStart
   EFI_HANDLE                  MacHandle;         // VirtioNetDriverBindingStart
+  BOOLEAN                     MergeRxBuf;        // VirtioNetInitialize
+  BOOLEAN                     GuestCsum;         // VirtioNetInitialize
+  BOOLEAN                     EventIdx;          // VirtioNetInitialize
 
   VRING                       RxRing;            // VirtioNetInitRing
   VOID                        *RxRingMap;        // VirtioRingMap and
                                                  // VirtioNetInitRing
   UINT8                       *RxBuf;            // VirtioNetInitRx
-  UINT16                      RxLastUsed;        // VirtioNetInitRx
+  UINTN                       RxHdrSize;         // VirtioNetInitRx
+  UINTN                       RxBufSize;         // VirtioNetInitRx
+  UINT16                      RxDescPerBuf;      // VirtioNetInitRx
+  UINT16                      RxNotifiedAvailIdx; // VirtioNetInitRx
+  UINT16                      RxDropBuffers;     // VirtioNetInitRx
   UINTN                       RxBufNrPages;      // VirtioNetInitRx
   EFI_PHYSICAL_ADDRESS        RxBufDeviceBase;   // VirtioNetInitRx
   VOID                        *RxBufMap;         // VirtioNetInitRx
@@ -94,7 +108,10 @@ typedef struct {
   UINT16                      *TxFreeStack;      // VirtioNetInitTx
   VIRTIO_1_0_NET_REQ          *TxSharedReq;      // VirtioNetInitTx
   VOID                        *TxSharedReqMap;   // VirtioNetInitTx
-  UINT16                      TxLastUsed;        // VirtioNetInitTx
+  EFI_PHYSICAL_ADDRESS        TxSharedReqDeviceAddress; // VirtioNetInitTx
+  UINT32                      TxSharedReqSize;   // VirtioNetInitTx
+  EFI_PHYSICAL_ADDRESS        *TxBufDeviceAddress; // VirtioNetInitTx
+  UINT16                      TxNotifiedAvailIdx; // VirtioNetInitTx
   ORDERED_COLLECTION          *TxBufCollection;  // VirtioNetInitTx
 } VNET_DEV;
 
@@ -276,6 +293,20 @@ VirtioNetUninitRing (
   IN     VOID     *RingMap
   );
 
+VOID
+EFIAPI
+VirtioNetPostRxBuf (
+  IN OUT VNET_DEV *Dev,
+  IN     UINT16   DescIdx
+  );
+
+VOID
+EFIAPI
+VirtioNetReleaseUsed (
+  IN     VNET_DEV *Dev,
+  IN OUT VRING    *Ring
+  );
+
 //
 // utility functions to map caller-supplied Tx buffer system physical address
 // to a device address and vice versa
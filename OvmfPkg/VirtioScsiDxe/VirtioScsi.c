@@ -1020,7 +1020,15 @@ VirtioScsiInit (
   }
 
   Features &= VIRTIO_SCSI_F_INOUT | VIRTIO_F_VERSION_1 |
-              VIRTIO_F_IOMMU_PLATFORM;
+              VIRTIO_F_IOMMU_PLATFORM | VIRTIO_F_RING_PACKED;
+
+  //
+  // A packed ring needs a queue size that is a power of two.
+  //
+  Status = VirtioPackedRingCheckQueue (Dev->VirtIo, VIRTIO_SCSI_REQUEST_QUEUE, &Features);
+  if (EFI_ERROR (Status)) {
+    goto Failed;
+  }
 
   //
   // In virtio-1.0, feature negotiation is expected to complete before queue
@@ -1052,7 +1060,11 @@ VirtioScsiInit (
     goto Failed;
   }
 
-  Status = VirtioRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
+  if ((Features & VIRTIO_F_RING_PACKED) != 0) {
+    Status = VirtioPackedRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
+  } else {
+    Status = VirtioRingInit (Dev->VirtIo, QueueSize, &Dev->Ring);
+  }
   if (EFI_ERROR (Status)) {
     goto Failed;
   }
@@ -1100,7 +1112,8 @@ VirtioScsiInit (
   // step 5 -- Report understood features and guest-tuneables.
   //
   if (Dev->VirtIo->Revision < VIRTIO_SPEC_REVISION (1, 0, 0)) {
-    Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM);
+    Features &= ~(UINT64)(VIRTIO_F_VERSION_1 | VIRTIO_F_IOMMU_PLATFORM |
+                          VIRTIO_F_RING_PACKED);
     Status = Dev->VirtIo->SetGuestFeatures (Dev->VirtIo, Features);
     if (EFI_ERROR (Status)) {
       goto UnmapQueue;